@@ -0,0 +1,23 @@
+#!/bin/bash
+#
+#	Certificates for owgw_sim. The gateway must use sim-ca-cert.pem as its root CA and issuer certificate, and its
+#	simulatorid must be the simulator CN below. Every simulated device then connects with sim-cert.pem.
+#
+
+hn=$(hostname)
+simulatorid=${1:-53494d000000}
+cert_life=365
+subject="/C=CA/ST=British Columbia/L=Vancouver/O=Arilia Wireless/OU=Engineering"
+
+openssl genrsa -out sim-ca-key.pem 2048
+openssl req -x509 -new -key sim-ca-key.pem -subj "$subject/CN=owgw-sim-ca" -days $cert_life -out sim-ca-cert.pem
+
+openssl genrsa -out sim-server-key.pem 2048
+openssl req -new -key sim-server-key.pem -subj "$subject/CN=$hn" -out sim-server.csr
+openssl x509 -req -days $cert_life -in sim-server.csr -CA sim-ca-cert.pem -CAkey sim-ca-key.pem -CAcreateserial -out sim-server-cert.pem
+
+openssl genrsa -out sim-key.pem 2048
+openssl req -new -key sim-key.pem -subj "$subject/CN=$simulatorid" -out sim.csr
+openssl x509 -req -days $cert_life -in sim.csr -CA sim-ca-cert.pem -CAkey sim-ca-key.pem -CAcreateserial -out sim-cert.pem
+
+rm -f sim-server.csr sim.csr
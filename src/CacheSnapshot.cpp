@@ -0,0 +1,236 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+#include "Poco/Checksum.h"
+#include "Poco/DateTimeFormat.h"
+#include "Poco/DateTimeFormatter.h"
+#include "Poco/File.h"
+#include "Poco/SharedMemory.h"
+
+#include "CacheSnapshot.h"
+#include "ConfigurationCache.h"
+#include "SerialNumberCache.h"
+#include "StorageService.h"
+#include "framework/Metrics.h"
+
+namespace OpenWifi {
+
+	//	Snapshot layout, native byte order (the file never leaves the host that wrote it):
+	//		header | SNs | Reverse SNs | (serial number, configuration UUID) pairs | black listed serial numbers |
+	//		Offsets[BlackListOthers+1] | other black listed serial numbers
+	//	Checksum is the CRC32 of everything after the header.
+	struct CacheSnapshotHeader {
+		char 		Magic[8];
+		uint32_t 	Version;
+		uint32_t 	Checksum;
+		uint64_t 	Created;
+		Storage::CacheMarker	Marker;
+		uint64_t 	SerialNumbers;
+		uint64_t 	ReverseSerialNumbers;
+		uint64_t 	Configurations;
+		uint64_t 	BlackListSerials;
+		uint64_t 	BlackListOthers;
+		uint64_t 	StringBytes;
+	};
+	static const char CacheSnapshotMagic[8] = {'O','W','G','W','C','S','N','P'};
+	static constexpr uint32_t CacheSnapshotVersion = 3;
+
+	typedef std::pair<uint64_t,uint64_t>	ConfigurationEntry;
+
+	CacheSnapshot::CacheSnapshot() noexcept:
+		SubSystemServer("CacheSnapshot", "CACHE-SNAPSHOT", "cachesnapshot")
+	{
+		Metrics::Registry()->AddGauge("owgw_cache_load_seconds", "Time taken to fill the device caches at startup.", {},
+									  [this] { return LoadSeconds_; });
+		Metrics::Registry()->AddGauge("owgw_cache_warm_start", "1 when the device caches came from the snapshot at startup.", {},
+									  [this] { return WarmStart_ ? 1.0 : 0.0; });
+	}
+
+	int CacheSnapshot::Start() {
+		Enabled_ = MicroService::instance().ConfigGetBool("openwifi.cachesnapshot.enable", true);
+		auto Interval = MicroService::instance().ConfigGetInt("openwifi.cachesnapshot.interval", 300);
+		FileName_ = MicroService::instance().DataDir() + "/cache_snapshot.bin";
+
+		auto Started = std::chrono::steady_clock::now();
+		WarmStart_ = Enabled_ && Load(FileName_);
+		if(!WarmStart_) {
+			StorageService()->InitializeBlackListCache();
+			StorageService()->UpdateSerialNumberCache();
+		}
+		LoadSeconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - Started).count();
+		Logger().information(fmt::format("Caches loaded from the {} in {:.3f}s: {} serial numbers, {} configurations, {} black listed devices.",
+										 WarmStart_ ? "snapshot" : "database", LoadSeconds_, SerialNumberCache()->Size(),
+										 ConfigurationCache::instance().Size(), StorageService()->GetBlackListDeviceCount()));
+
+		if(Enabled_ && Interval>0) {
+			SaverCallBack_ = std::make_unique<Poco::TimerCallback<CacheSnapshot>>(*this, &CacheSnapshot::onTimer);
+			Timer_.setStartInterval(Interval * 1000);
+			Timer_.setPeriodicInterval(Interval * 1000);
+			Timer_.start(*SaverCallBack_);
+		}
+		return 0;
+	}
+
+	void CacheSnapshot::Stop() {
+		Logger().notice("Stopping.");
+		Timer_.stop();
+		if(Enabled_ && !Save(FileName_))
+			Logger().warning("Could not save the cache snapshot.");
+	}
+
+	void CacheSnapshot::onTimer([[maybe_unused]] Poco::Timer &timer) {
+		if(!Save(FileName_))
+			Logger().warning("Could not save the cache snapshot.");
+	}
+
+	bool CacheSnapshot::Save(const std::string &FileName) {
+		std::lock_guard	Guard(Mutex_);
+		try {
+			Storage::CacheMarker	Marker;
+			std::vector<uint64_t>	SNs, Reverse_SNs, BlackListSerials;
+			std::vector<ConfigurationEntry>	Configurations;
+			std::vector<std::string>	BlackListOthers;
+			{
+				//	no writer sits between its database change and its cache update while the caches are copied
+				std::unique_lock	CacheGuard(StorageService()->CacheMutex());
+				if(!StorageService()->GetCacheMarker(Marker))
+					return false;
+				SerialNumberCache()->GetNumbers(SNs, Reverse_SNs);
+				ConfigurationCache::instance().Get(Configurations);
+				StorageService()->GetBlackListCache(BlackListSerials, BlackListOthers);
+			}
+
+			std::vector<uint64_t>	Offsets;
+			std::string 			Strings;
+			Offsets.reserve(BlackListOthers.size()+1);
+			for(const auto &Serial:BlackListOthers) {
+				Offsets.push_back(Strings.size());
+				Strings += Serial;
+			}
+			Offsets.push_back(Strings.size());
+
+			const std::pair<const char *, std::size_t>	Sections[] = {
+				{(const char *)SNs.data(), SNs.size() * sizeof(uint64_t)},
+				{(const char *)Reverse_SNs.data(), Reverse_SNs.size() * sizeof(uint64_t)},
+				{(const char *)Configurations.data(), Configurations.size() * sizeof(ConfigurationEntry)},
+				{(const char *)BlackListSerials.data(), BlackListSerials.size() * sizeof(uint64_t)},
+				{(const char *)Offsets.data(), Offsets.size() * sizeof(uint64_t)},
+				{Strings.data(), Strings.size()}};
+
+			CacheSnapshotHeader	Header{};
+			std::memcpy(Header.Magic, CacheSnapshotMagic, sizeof(Header.Magic));
+			Header.Version = CacheSnapshotVersion;
+			Header.Created = OpenWifi::Now();
+			Header.Marker = Marker;
+			Header.SerialNumbers = SNs.size();
+			Header.ReverseSerialNumbers = Reverse_SNs.size();
+			Header.Configurations = Configurations.size();
+			Header.BlackListSerials = BlackListSerials.size();
+			Header.BlackListOthers = BlackListOthers.size();
+			Header.StringBytes = Strings.size();
+			Poco::Checksum	CRC(Poco::Checksum::TYPE_CRC32);
+			for(const auto &[Data,Size]:Sections)
+				CRC.update(Data, (unsigned int) Size);
+			Header.Checksum = CRC.checksum();
+
+			auto TmpFileName = FileName + ".tmp";
+			std::ofstream OS(TmpFileName, std::ios::binary | std::ios::trunc);
+			OS.write((const char *)&Header, sizeof(Header));
+			for(const auto &[Data,Size]:Sections)
+				OS.write(Data, (std::streamsize) Size);
+			OS.close();
+			if(!OS)
+				return false;
+			Poco::File(TmpFileName).renameTo(FileName);
+			Logger().debug(fmt::format("Cache snapshot saved: {} serial numbers, {} configurations, {} black listed devices.",
+									   SNs.size(), Configurations.size(), BlackListSerials.size() + BlackListOthers.size()));
+			return true;
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
+		}
+		return false;
+	}
+
+	bool CacheSnapshot::Load(const std::string &FileName) {
+		try {
+			Poco::File	F(FileName);
+			if(!F.exists())
+				return false;
+			auto FileSize = F.getSize();
+			if(FileSize < sizeof(CacheSnapshotHeader))
+				return false;
+
+			Storage::CacheMarker	Current;
+			if(!StorageService()->GetCacheMarker(Current))
+				return false;
+
+			Poco::SharedMemory	Mapped(F, Poco::SharedMemory::AM_READ);
+			const char *Data = Mapped.begin();
+			CacheSnapshotHeader	Header{};
+			std::memcpy(&Header, Data, sizeof(Header));
+			if(std::memcmp(Header.Magic, CacheSnapshotMagic, sizeof(Header.Magic))!=0 || Header.Version!=CacheSnapshotVersion) {
+				Logger().information("Cache snapshot ignored: unknown format.");
+				return false;
+			}
+			if(!(Header.Marker == Current)) {
+				Logger().information(fmt::format("Cache snapshot ignored: the database changed since {}.",
+												 Poco::DateTimeFormatter::format(Poco::Timestamp::fromEpochTime((std::time_t) Header.Created),
+																				 Poco::DateTimeFormat::ISO8601_FORMAT)));
+				return false;
+			}
+
+			uint64_t Expected = sizeof(Header) +
+								(Header.SerialNumbers + Header.ReverseSerialNumbers + Header.BlackListSerials +
+								 Header.BlackListOthers + 1) * sizeof(uint64_t) +
+								Header.Configurations * sizeof(ConfigurationEntry) + Header.StringBytes;
+			if(Expected != FileSize) {
+				Logger().information("Cache snapshot ignored: truncated.");
+				return false;
+			}
+			Poco::Checksum	CRC(Poco::Checksum::TYPE_CRC32);
+			CRC.update(Data + sizeof(Header), (unsigned int) (FileSize - sizeof(Header)));
+			if(CRC.checksum() != Header.Checksum) {
+				Logger().information("Cache snapshot ignored: bad checksum.");
+				return false;
+			}
+
+			const char *Cur = Data + sizeof(Header);
+			auto Read = [&Cur](auto &V, uint64_t Count) {
+				V.resize(Count);
+				std::memcpy(V.data(), Cur, Count * sizeof(V[0]));
+				Cur += Count * sizeof(V[0]);
+			};
+			std::vector<uint64_t>	SNs, Reverse_SNs, BlackListSerials, Offsets;
+			std::vector<ConfigurationEntry>	Configurations;
+			Read(SNs, Header.SerialNumbers);
+			Read(Reverse_SNs, Header.ReverseSerialNumbers);
+			Read(Configurations, Header.Configurations);
+			Read(BlackListSerials, Header.BlackListSerials);
+			Read(Offsets, Header.BlackListOthers + 1);
+
+			std::vector<std::string>	BlackListOthers;
+			BlackListOthers.reserve(Header.BlackListOthers);
+			for(uint64_t i=0;i<Header.BlackListOthers;++i) {
+				if(Offsets[i]>Offsets[i+1] || Offsets[i+1]>Header.StringBytes)
+					return false;
+				BlackListOthers.emplace_back(Cur + Offsets[i], Offsets[i+1]-Offsets[i]);
+			}
+
+			SerialNumberCache()->SetNumbers(std::move(SNs), std::move(Reverse_SNs));
+			ConfigurationCache::instance().Load(Configurations);
+			StorageService()->SetBlackListCache(std::move(BlackListSerials), std::move(BlackListOthers));
+			return true;
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
+		}
+		return false;
+	}
+}
@@ -0,0 +1,48 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#pragma once
+
+#include "framework/MicroService.h"
+#include "Poco/Timer.h"
+
+namespace OpenWifi {
+
+	//	Fills the serial number, configuration and black list caches at startup. They are saved to a binary snapshot
+	//	periodically and on shutdown, and the snapshot is mapped back at the next start instead of scanning the
+	//	database, as long as the database marker stored in it is still the current one.
+	class CacheSnapshot : public SubSystemServer {
+	  public:
+
+		static auto instance() {
+			static auto instance_ = new CacheSnapshot;
+			return instance_;
+		}
+
+		int Start() override;
+		void Stop() override;
+
+		void onTimer(Poco::Timer & timer);
+
+		[[nodiscard]] bool Save(const std::string &FileName);
+		[[nodiscard]] bool Load(const std::string &FileName);
+		[[nodiscard]] inline bool WarmStart() const { return WarmStart_; }
+
+	  private:
+		bool 				Enabled_ = true;
+		bool 				WarmStart_ = false;
+		double 				LoadSeconds_ = 0.0;
+		std::string 		FileName_;
+		Poco::Timer         Timer_;
+		std::unique_ptr<Poco::TimerCallback<CacheSnapshot>>   SaverCallBack_;
+
+		CacheSnapshot() noexcept;
+	};
+
+	inline auto CacheSnapshot() { return CacheSnapshot::instance(); }
+
+}
@@ -7,6 +7,7 @@
 //
 
 #include <algorithm>
+#include <map>
 
 #include "Poco/JSON/Parser.h"
 
@@ -14,69 +15,107 @@
 #include "DeviceRegistry.h"
 #include "StorageService.h"
 #include "framework/MicroService.h"
+#include "framework/Metrics.h"
 #include "framework/ow_constants.h"
 
+#include "nlohmann/json.hpp"
+
 namespace OpenWifi {
 
-	void CommandManager::run() {
-		Running_ = true;
-		Poco::AutoPtr<Poco::Notification>	NextMsg(ResponseQueue_.waitDequeueNotification());
-		while(NextMsg && Running_) {
-			auto Resp = dynamic_cast<RPCResponseNotification*>(NextMsg.get());
+	//	The registry lookup takes a lock and builds the labels, so each method's metric is looked up once and its
+	//	reference kept. Methods are the protocol's command names, a short list. Callers hold CommandManager::Mutex_.
+	static Metrics::Histogram & CommandLatency(const std::string &Method) {
+		static std::map<std::string, Metrics::Histogram *>	Histograms;
+		auto &H = Histograms[Method];
+		if(H==nullptr)
+			H = &Metrics::GetHistogram("owgw_command_duration_seconds",
+									   "Time from sending a command to a device to receiving its answer, by method.",
+									   {{"method", Method}});
+		return *H;
+	}
 
-			if(Resp!= nullptr) {
-				const Poco::JSON::Object & Payload = Resp->Payload_;
-				const std::string & SerialNumber = Resp->SerialNumber_;
+	static Metrics::Counter & CommandTimeouts(const std::string &Method) {
+		static std::map<std::string, Metrics::Counter *>	Counters;
+		auto &C = Counters[Method];
+		if(C==nullptr)
+			C = &Metrics::GetCounter("owgw_command_timeouts_total", "Commands that never got an answer, by method.",
+									 {{"method", Method}});
+		return *C;
+	}
 
-				std::ostringstream SS;
-				Payload.stringify(SS);
+	void CommandManager::CompleteRPC(const RPCResponseNotification &Resp) {
+		const Poco::JSON::Object & Payload = Resp.Payload_;
+		const std::string & SerialNumber = Resp.SerialNumber_;
 
+		std::ostringstream SS;
+		Payload.stringify(SS);
+
+		// std::cout << SerialNumber << ": " << __LINE__ << std::endl;
+		// std::cout << "Got RPC Answer: " << SerialNumber << "   Payload:" << SS.str() << std::endl;
+		Logger().debug(fmt::format("({}): RPC Response received.", SerialNumber));
+		if(!Payload.has(uCentralProtocol::ID)){
+			// std::cout << SerialNumber << ": " << __LINE__ << std::endl;
+			Logger().error(fmt::format("({}): Invalid RPC response.", SerialNumber));
+		} else {
+			uint64_t ID = Payload.get(uCentralProtocol::ID);
+			if (ID < 2) {
 				// std::cout << SerialNumber << ": " << __LINE__ << std::endl;
-				// std::cout << "Got RPC Answer: " << SerialNumber << "   Payload:" << SS.str() << std::endl;
-				Logger().debug(fmt::format("({}): RPC Response received.", SerialNumber));
-				if(!Payload.has(uCentralProtocol::ID)){
+				Logger().debug(fmt::format("({}): Ignoring RPC response.", SerialNumber));
+			} else {
+				auto Idx = CommandTagIndex{.Id = ID, .SerialNumber = SerialNumber};
+				std::lock_guard G(Mutex_);
+				auto RPC = OutStandingRequests_.find(Idx);
+				if (RPC == OutStandingRequests_.end()) {
 					// std::cout << SerialNumber << ": " << __LINE__ << std::endl;
-					Logger().error(fmt::format("({}): Invalid RPC response.", SerialNumber));
+					Logger().warning(
+						fmt::format("({}): Outdated RPC {}", SerialNumber, ID));
 				} else {
-					uint64_t ID = Payload.get(uCentralProtocol::ID);
-					if (ID < 2) {
+					// std::cout << SerialNumber << ": " << __LINE__ << std::endl;
+					std::chrono::duration<double, std::milli> rpc_execution_time =
+						std::chrono::high_resolution_clock::now() - RPC->second->submitted;
+					CommandLatency(RPC->second->method).Add((uint64_t) (rpc_execution_time.count() * 1000.0));
+					StorageService()->CommandCompleted(RPC->second->uuid, Payload,
+													   rpc_execution_time, true);
+					// std::cout << SerialNumber << ": " << __LINE__ << std::endl;
+					if (RPC->second->rpc_entry) {
 						// std::cout << SerialNumber << ": " << __LINE__ << std::endl;
-						Logger().debug(fmt::format("({}): Ignoring RPC response.", SerialNumber));
-					} else {
-						auto Idx = CommandTagIndex{.Id = ID, .SerialNumber = SerialNumber};
-						std::lock_guard G(Mutex_);
-						auto RPC = OutStandingRequests_.find(Idx);
-						if (RPC == OutStandingRequests_.end()) {
-							// std::cout << SerialNumber << ": " << __LINE__ << std::endl;
-							Logger().warning(
-								fmt::format("({}): Outdated RPC {}", SerialNumber, ID));
-						} else {
-							// std::cout << SerialNumber << ": " << __LINE__ << std::endl;
-							std::chrono::duration<double, std::milli> rpc_execution_time =
-								std::chrono::high_resolution_clock::now() - RPC->second->submitted;
-							StorageService()->CommandCompleted(RPC->second->uuid, Payload,
-															   rpc_execution_time, true);
-							// std::cout << SerialNumber << ": " << __LINE__ << std::endl;
-							if (RPC->second->rpc_entry) {
-								// std::cout << SerialNumber << ": " << __LINE__ << std::endl;
-								RPC->second->rpc_entry->set_value(Payload);
-							}
-							// std::cout << SerialNumber << ": " << __LINE__ << std::endl;
-							OutstandingUUIDs_.erase(RPC->second->uuid);
-							OutStandingRequests_.erase(Idx);
-							Logger().information(
-								fmt::format("({}): Received RPC answer {}", SerialNumber, ID));
-							// std::cout << SerialNumber << ": " << __LINE__ << std::endl;
-						}
+						RPC->second->rpc_entry->set_value(Payload);
 					}
+					// std::cout << SerialNumber << ": " << __LINE__ << std::endl;
+					OutstandingUUIDs_.erase(RPC->second->uuid);
+					OutStandingRequests_.erase(Idx);
+					Logger().information(
+						fmt::format("({}): Received RPC answer {}", SerialNumber, ID));
+					// std::cout << SerialNumber << ": " << __LINE__ << std::endl;
 				}
 			}
+		}
+	}
+
+	void CommandManager::run() {
+		Running_ = true;
+		Poco::AutoPtr<Poco::Notification>	NextMsg(ResponseQueue_.waitDequeueNotification());
+		while(NextMsg && Running_) {
+			auto Resp = dynamic_cast<RPCResponseNotification*>(NextMsg.get());
+			if(Resp!= nullptr)
+				CompleteRPC(*Resp);
 			NextMsg = ResponseQueue_.waitDequeueNotification();
 		}
+
+		//	answers that arrived before the stop are still recorded
+		if(!NextMsg)
+			NextMsg = ResponseQueue_.dequeueNotification();
+		while(NextMsg) {
+			auto Resp = dynamic_cast<RPCResponseNotification*>(NextMsg.get());
+			if(Resp!= nullptr)
+				CompleteRPC(*Resp);
+			NextMsg = ResponseQueue_.dequeueNotification();
+		}
    	}
 
     int CommandManager::Start() {
         Logger().notice("Starting...");
+		ConfigPatch_ = MicroService::instance().ConfigGetBool("openwifi.configpatch.enable", true);
 		ManagerThread.setStackSize(2000000);
 		ManagerThread.setName("CMD-MGR");
         ManagerThread.start(*this);
@@ -122,6 +161,7 @@ namespace OpenWifi {
 			std::chrono::duration<double, std::milli> delta = now - i->second->submitted;
 			if(delta > 6000000ms) {
 				Logger().debug(fmt::format("{}: Timed out.", i->second->uuid));
+				CommandTimeouts(i->second->method).Add();
 				OutstandingUUIDs_.erase(i->second->uuid);
 				i = OutStandingRequests_.erase(i);
 			} else {
@@ -174,6 +214,59 @@ namespace OpenWifi {
 		}
 	}
 
+	static Metrics::Counter & PushBytes(const char *Form) {
+		return Metrics::GetCounter("owgw_configuration_push_bytes_total",
+								   "Configuration sent to devices with configure, as a whole configuration or as a patch.",
+								   {{"form", Form}});
+	}
+
+	bool CommandManager::ConfigurationDiff(const std::string &Base, const std::string &Target, std::string &Patch) {
+		try {
+			Patch = nlohmann::json::diff(nlohmann::json::parse(Base), nlohmann::json::parse(Target)).dump();
+			return true;
+		} catch (const nlohmann::json::exception &) {
+		}
+		return false;
+	}
+
+	bool CommandManager::PatchConfiguration(const std::string &SerialNumber, const Poco::JSON::Object &Params,
+											Poco::JSON::Object &Patched) {
+		static auto &FullBytes = PushBytes("full");
+		static auto &PatchBytes = PushBytes("patch");
+		static auto &SavedBytes = Metrics::GetCounter("owgw_configuration_patch_saved_bytes_total",
+													  "Configuration bytes devices did not have to receive thanks to patches.");
+		if (!Params.isObject(uCentralProtocol::CONFIG))
+			return false;
+
+		std::ostringstream OS;
+		Poco::JSON::Stringifier::condense(Params.getObject(uCentralProtocol::CONFIG), OS);
+		auto Target = OS.str();
+		auto UUID = Params.optValue<uint64_t>(uCentralProtocol::UUID, 0);
+
+		//	the base must be what the device runs now: one it was only sent may never have been applied
+		GWObjects::ConnectionState	State;
+		std::string Base, Patch;
+		if (!ConfigPatch_ || !DeviceRegistry()->GetState(SerialNumber, State) || !State.configPatch ||
+			State.runningUUID == 0 || State.runningUUID == UUID ||
+			!StorageService()->GetDeviceConfiguration(SerialNumber, State.runningUUID, Base) ||
+			!ConfigurationDiff(Base, Target, Patch) || Patch.size() >= Target.size()) {
+			FullBytes.Add(Target.size());
+			return false;
+		}
+
+		Poco::JSON::Parser	P;
+		for (const auto &[Key, Value] : Params)
+			if (Key != uCentralProtocol::CONFIG)
+				Patched.set(Key, Value);
+		Patched.set(uCentralProtocol::BASE, State.runningUUID);
+		Patched.set(uCentralProtocol::PATCH, P.parse(Patch).extract<Poco::JSON::Array::Ptr>());
+		PatchBytes.Add(Patch.size());
+		SavedBytes.Add(Target.size() - Patch.size());
+		Logger().debug(fmt::format("{}: configuration {} sent as a {} byte patch of {} instead of {} bytes.", SerialNumber,
+								   UUID, Patch.size(), State.runningUUID, Target.size()));
+		return true;
+	}
+
 	std::shared_ptr<CommandManager::promise_type_t> CommandManager::PostCommand(const std::string &SerialNumber,
 							  			const std::string &Method,
 										const Poco::JSON::Object &Params,
@@ -183,10 +276,18 @@ namespace OpenWifi {
 										bool & Sent) {
 
 		Sent=false;
+		if(MicroService::instance().Draining()) {
+			Logger().information(fmt::format("{}-{}: Not sending command {}, the gateway is draining.", SerialNumber, UUID, Method));
+			return nullptr;
+		}
 		if(!DeviceRegistry()->Connected(SerialNumber)) {
 			return nullptr;
 		}
 
+		//	firmware that asks for it gets a configuration as a patch of the one it runs
+		Poco::JSON::Object	Patched;
+		bool UsePatch = Method == uCentralProtocol::CONFIGURE && PatchConfiguration(SerialNumber, Params, Patched);
+
 		std::stringstream 	ToSend;
 		auto Object = std::make_shared<RpcObject>();
 
@@ -203,13 +304,14 @@ namespace OpenWifi {
 			CompleteRPC.set(uCentralProtocol::JSONRPC, uCentralProtocol::JSONRPC_VERSION);
 			CompleteRPC.set(uCentralProtocol::ID, Idx.Id);
 			CompleteRPC.set(uCentralProtocol::METHOD, Method);
-			CompleteRPC.set(uCentralProtocol::PARAMS, Params);
+			CompleteRPC.set(uCentralProtocol::PARAMS, UsePatch ? Patched : Params);
 			Poco::JSON::Stringifier::stringify(CompleteRPC, ToSend);
 			Logger().information(
 				fmt::format("{}-{}: Sending command {}, ID: {}", SerialNumber, UUID, Method, Idx.Id));
 
 			Object->submitted = std::chrono::high_resolution_clock::now();
 			Object->uuid = UUID;
+			Object->method = Method;
 			if(disk_only) {
 				Object->rpc_entry = nullptr;
 			} else {
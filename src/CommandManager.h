@@ -63,6 +63,7 @@ namespace OpenWifi {
 		  	typedef std::promise<objtype_t> promise_type_t;
 			struct RpcObject {
 				std::string uuid;
+				std::string method;
 				std::chrono::time_point<std::chrono::high_resolution_clock> submitted = std::chrono::high_resolution_clock::now();
 				std::shared_ptr<promise_type_t> rpc_entry;
 			};
@@ -149,6 +150,14 @@ namespace OpenWifi {
 			}
 
 			inline bool Running() const { return Running_; }
+			//	commands sent and still waiting for the device's answer
+			[[nodiscard]] inline uint64_t Outstanding() {
+				std::lock_guard	G(Mutex_);
+				return OutStandingRequests_.size();
+			}
+			//	RFC 6902 patch turning the Base configuration into Target
+			static bool ConfigurationDiff(const std::string &Base, const std::string &Target, std::string &Patch);
+
 			void onJanitorTimer(Poco::Timer & timer);
 			void onCommandRunnerTimer(Poco::Timer & timer);
 			void onRPCAnswer(bool& b);
@@ -165,6 +174,10 @@ namespace OpenWifi {
 			std::unique_ptr<Poco::TimerCallback<CommandManager>>   CommandRunnerCallback_;
 			// std::unique_ptr<FIFO<RPCResponse>>		RPCResponseQueue_=std::make_unique<FIFO<RPCResponse>>(100);
 			Poco::NotificationQueue					ResponseQueue_;
+			bool 									ConfigPatch_ = true;
+
+			void CompleteRPC(const RPCResponseNotification &Resp);
+			bool PatchConfiguration(const std::string &SerialNumber, const Poco::JSON::Object &Params, Poco::JSON::Object &Patched);
 
 			std::shared_ptr<promise_type_t> PostCommand(
 				const std::string &SerialNumber,
@@ -7,6 +7,8 @@
 #include <map>
 #include <string>
 #include <mutex>
+#include <utility>
+#include <vector>
 #include "framework/MicroService.h"
 
 namespace OpenWifi {
@@ -31,7 +33,27 @@ namespace OpenWifi {
 			Cache_[SerialNumber]=Id;
 		}
 
+		//	sorted by serial number
+		inline void Get(std::vector<std::pair<uint64_t,uint64_t>> &Entries) {
+			std::lock_guard	G(Mutex_);
+			Entries.assign(Cache_.begin(),Cache_.end());
+		}
+
+		//	bulk load at startup, entries already in the cache are more recent and kept
+		inline void Load(const std::vector<std::pair<uint64_t,uint64_t>> &Entries) {
+			std::lock_guard	G(Mutex_);
+			for(const auto &Entry:Entries)
+				Cache_.insert(Cache_.end(),Entry);
+		}
+
+		[[nodiscard]] inline std::size_t Size() {
+			std::lock_guard	G(Mutex_);
+			return Cache_.size();
+		}
+
 	  private:
+		ConfigurationCache() = default;
+
 		std::recursive_mutex					Mutex_;
 		std::map<uint64_t,uint64_t>	Cache_;
 	};
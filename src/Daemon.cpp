@@ -10,10 +10,14 @@
 #include "Poco/Util/Option.h"
 #include "Poco/Environment.h"
 
+#include "CacheSnapshot.h"
 #include "CommandManager.h"
 #include "Daemon.h"
 #include "DeviceRegistry.h"
+#include "DeviceStatisticsNotifier.h"
 #include "FileUploader.h"
+#include "FrameRecorder.h"
+#include "IngressLimiter.h"
 #include "OUIServer.h"
 #include "SerialNumberCache.h"
 #include "StorageArchiver.h"
@@ -36,8 +40,10 @@ namespace OpenWifi {
 								   SubSystemVec{
 										StorageService(),
 										SerialNumberCache(),
+										CacheSnapshot(),
 										ConfigurationValidator(),
 								   		WebSocketClientServer(),
+										DeviceStatisticsNotifier(),
 										OUIServer(),
 										FindCountryFromIP(),
 										DeviceRegistry(),
@@ -46,6 +52,8 @@ namespace OpenWifi {
 										StorageArchiver(),
 										TelemetryStream(),
 										RTTYS_server(),
+										FrameRecorder(),
+										IngressLimiter(),
 										WebSocketServer(),
 								   		RADIUS_proxy_server()
 							   });
@@ -102,6 +110,8 @@ namespace OpenWifi {
     }
 }
 
+//	owgw_bench links the whole gateway and brings its own main
+#ifndef OWGW_BENCHMARK
 int main(int argc, char **argv) {
 	try {
 
@@ -115,4 +125,6 @@ int main(int argc, char **argv) {
 	}
 }
 
+#endif
+
 // end of namespace
\ No newline at end of file
@@ -139,6 +139,30 @@ namespace OpenWifi {
 		return false;
 	}
 
+	bool DeviceRegistry::Disconnect(uint64_t SerialNumber) {
+		std::lock_guard		Guard(Mutex_);
+		auto Device = Devices_.find(SerialNumber);
+		if(Device!=Devices_.end() && Device->second->WSConn_!= nullptr) {
+			try {
+				Device->second->WSConn_->Close();
+				return true;
+			} catch (...) {
+				Logger().debug(fmt::format("Could not close the connection of device '{}'", SerialNumber));
+			}
+		}
+		return false;
+	}
+
+	std::vector<uint64_t> DeviceRegistry::ConnectedDevices() {
+		std::lock_guard		Guard(Mutex_);
+		std::vector<uint64_t>	Serials;
+		for(const auto &[Serial,Device]:Devices_) {
+			if(Device->WSConn_!= nullptr)
+				Serials.push_back(Serial);
+		}
+		return Serials;
+	}
+
 	bool DeviceRegistry::SendRadiusAccountingData(const std::string & SerialNumber, const unsigned char * buffer, std::size_t size) {
 		std::lock_guard		Guard(Mutex_);
 		auto Device = 		Devices_.find(Utils::SerialNumberToInt(SerialNumber));
@@ -85,6 +85,10 @@ namespace OpenWifi {
 
 		bool SendFrame(uint64_t SerialNumber, const std::string & Payload);
 
+		//	asks a device to close its connection, it answers and the connection goes away on its own reactor
+		bool Disconnect(uint64_t SerialNumber);
+		std::vector<uint64_t> ConnectedDevices();
+
 		inline void SetPendingUUID(const std::string & SerialNumber, uint64_t PendingUUID) {
 			return SetPendingUUID(Utils::SerialNumberToInt(SerialNumber), PendingUUID);
 		}
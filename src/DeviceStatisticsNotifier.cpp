@@ -0,0 +1,108 @@
+//
+// Created by stephane bourque on 2022-06-20.
+//
+
+#include "DeviceStatisticsNotifier.h"
+
+namespace OpenWifi {
+
+	int DeviceStatisticsNotifier::Start() {
+		//	An interval of 0 sends one device_statistics notification per STATE message, like before.
+		Interval_ = MicroService::instance().ConfigGetInt("websocketclients.statistics.interval",1);
+		Single_ = MicroService::instance().ConfigGetBool("websocketclients.statistics.single",true);
+		if(Interval_==0) {
+			Logger().information("Coalescing disabled.");
+			return 0;
+		}
+		LastReport_ = OpenWifi::Now();
+		FlushCallBack_ = std::make_unique<Poco::TimerCallback<DeviceStatisticsNotifier>>(*this, &DeviceStatisticsNotifier::onTimer);
+		Timer_.setStartInterval(Interval_ * 1000);
+		Timer_.setPeriodicInterval(Interval_ * 1000);
+		Timer_.start(*FlushCallBack_);
+		return 0;
+	}
+
+	void DeviceStatisticsNotifier::Stop() {
+		if(Interval_) {
+			Timer_.stop();
+		}
+	}
+
+	void DeviceStatisticsNotifier::Update(uint64_t SerialNumber, uint64_t ConnectionId, const std::string &SerialNumberStr,
+										  const std::string &Venue, const GWObjects::ConnectionState &State) {
+		if(Interval_==0) {
+			WebSocketClientNotificationDeviceStatistics(SerialNumberStr, Venue);
+			return;
+		}
+
+		std::lock_guard	G(Mutex_);
+		auto &E = Devices_[SerialNumber];
+		if(E.SerialNumber.empty() || E.ConnectionId!=ConnectionId) {
+			//	a new connection starts its counters again
+			E.SerialNumber = SerialNumberStr;
+			E.ConnectionId = ConnectionId;
+			E.ReportedRX = State.RX;
+			E.ReportedTX = State.TX;
+		}
+		E.Venue = Venue;
+		E.Associations_2G = State.Associations_2G;
+		E.Associations_5G = State.Associations_5G;
+		E.RX = State.RX;
+		E.TX = State.TX;
+		E.LastContact = State.LastContact;
+		E.Updates++;
+		E.Dirty = true;
+	}
+
+	void DeviceStatisticsNotifier::Remove(uint64_t SerialNumber, uint64_t ConnectionId) {
+		if(Interval_==0)
+			return;
+		std::lock_guard	G(Mutex_);
+		auto Hint = Devices_.find(SerialNumber);
+		if(Hint!=Devices_.end() && Hint->second.ConnectionId==ConnectionId)
+			Devices_.erase(Hint);
+	}
+
+	void DeviceStatisticsNotifier::onTimer([[maybe_unused]] Poco::Timer & timer) {
+		std::vector<WebNotificationDeviceStatistics>			Items;
+		std::vector<std::pair<std::string,std::string>>			Keys;
+		{
+			std::lock_guard	G(Mutex_);
+			for(auto &[SerialNumber,E]:Devices_) {
+				if(!E.Dirty)
+					continue;
+				WebNotificationDeviceStatistics	Item{
+					.serialNumber = E.SerialNumber,
+					.associations_2G = E.Associations_2G,
+					.associations_5G = E.Associations_5G,
+					.rxBytes = E.RX - std::min(E.RX,E.ReportedRX),
+					.txBytes = E.TX - std::min(E.TX,E.ReportedTX),
+					.updates = E.Updates,
+					.lastContact = E.LastContact };
+				Items.push_back(Item);
+				Keys.emplace_back(E.SerialNumber,E.Venue);
+				E.ReportedRX = E.RX;
+				E.ReportedTX = E.TX;
+				E.Updates = 0;
+				E.Dirty = false;
+			}
+		}
+
+		if(!Items.empty()) {
+			WebSocketClientServer()->SendNotificationBatch("device_statistics_batch", Items, Keys);
+			if(Single_) {
+				for(const auto &[SerialNumber,Venue]:Keys)
+					WebSocketClientNotificationDeviceStatistics(SerialNumber, Venue);
+			}
+			Batches_++;
+			Items_ += Items.size();
+		}
+
+		auto now = OpenWifi::Now();
+		if((now-LastReport_)>=60) {
+			Logger().debug(fmt::format("Last {} seconds: {} batches carrying {} device updates.", now-LastReport_, Batches_, Items_));
+			LastReport_ = now;
+			Batches_ = Items_ = 0;
+		}
+	}
+}
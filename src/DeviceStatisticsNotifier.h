@@ -0,0 +1,67 @@
+//
+// Created by stephane bourque on 2022-06-20.
+//
+
+#pragma once
+
+#include "framework/MicroService.h"
+#include "framework/WebSocketClientNotifications.h"
+#include "RESTObjects/RESTAPI_GWobjects.h"
+#include "Poco/Timer.h"
+
+namespace OpenWifi {
+
+	//	Collapses the STATE driven device_statistics notifications so that UI clients get one
+	//	device_statistics_batch message per interval instead of one message per device per state. Unless
+	//	websocketclients.statistics.single is false, every device that changed also gets its device_statistics
+	//	notification, once per interval, for the clients that only know that one.
+	class DeviceStatisticsNotifier : public SubSystemServer {
+	  public:
+
+		static auto instance() {
+		    static auto instance_ = new DeviceStatisticsNotifier;
+			return instance_;
+		}
+
+		int Start() override;
+		void Stop() override;
+
+		void onTimer(Poco::Timer & timer);
+
+		void Update(uint64_t SerialNumber, uint64_t ConnectionId, const std::string &SerialNumberStr, const std::string &Venue,
+					const GWObjects::ConnectionState &State);
+		//	only when the entry is still the one of that connection: the device may have reconnected already
+		void Remove(uint64_t SerialNumber, uint64_t ConnectionId);
+
+	  private:
+		struct DeviceEntry {
+			std::string 	SerialNumber;
+			std::string 	Venue;
+			uint64_t 		Associations_2G = 0;
+			uint64_t 		Associations_5G = 0;
+			uint64_t 		RX = 0, TX = 0;
+			uint64_t 		ReportedRX = 0, ReportedTX = 0;
+			uint64_t 		LastContact = 0;
+			uint64_t 		Updates = 0;
+			uint64_t 		ConnectionId = 0;
+			bool 			Dirty = false;
+		};
+
+		uint64_t 								Interval_ = 1;
+		bool 									Single_ = true;
+		std::map<uint64_t,DeviceEntry>			Devices_;
+		Poco::Timer								Timer_;
+		std::unique_ptr<Poco::TimerCallback<DeviceStatisticsNotifier>>   FlushCallBack_;
+		uint64_t 								LastReport_ = 0;
+		uint64_t 								Batches_ = 0;
+		uint64_t 								Items_ = 0;
+
+		DeviceStatisticsNotifier() noexcept:
+			SubSystemServer("DeviceStatisticsNotifier", "WS-STATS-NOTIFY", "websocketclients.statistics")
+		{
+		}
+	};
+
+	inline auto DeviceStatisticsNotifier() { return DeviceStatisticsNotifier::instance(); }
+
+}
@@ -0,0 +1,85 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#include <array>
+
+#include "Poco/File.h"
+#include "Poco/FileStream.h"
+
+#include "FileStore.h"
+
+namespace OpenWifi {
+
+	bool LocalFileStore::FileName(const std::string &UUID, std::string &Directory, std::string &Name) const {
+		//	UUIDs are generated by us, but they come back in upload URLs: never let one escape the store.
+		if(UUID.size()<4 || UUID.find_first_not_of("0123456789abcdefABCDEF-")!=std::string::npos)
+			return false;
+		Directory = Root_ + "/" + UUID.substr(0,2) + "/" + UUID.substr(2,2);
+		Name = Directory + "/" + UUID;
+		return true;
+	}
+
+	bool LocalFileStore::Store(const std::string &UUID, std::istream &In, uint64_t MaxSize, uint64_t &Size) {
+		std::string Directory, Name;
+		if(!FileName(UUID,Directory,Name))
+			return false;
+
+		Poco::File(Directory).createDirectories();
+		Poco::File	Partial(Name + ".part");
+		Size = 0;
+		//	a failed or interrupted upload must not leave its .part behind
+		try {
+			{
+				Poco::FileOutputStream	Out(Partial.path(), std::ios::binary | std::ios::trunc);
+				std::array<char, 64 * 1024>	Buffer{};
+				while(In) {
+					In.read(Buffer.data(), Buffer.size());
+					auto Count = (uint64_t) In.gcount();
+					if(Count==0)
+						break;
+					Size += Count;
+					if(Size>MaxSize)
+						break;
+					Out.write(Buffer.data(), (std::streamsize) Count);
+				}
+				Out.close();
+				if(Size<=MaxSize && Out.good()) {
+					Partial.renameTo(Name);
+					return true;
+				}
+			}
+		} catch (...) {
+			if(Partial.exists())
+				Partial.remove();
+			throw;
+		}
+		Partial.remove();
+		return false;
+	}
+
+	std::unique_ptr<std::istream> LocalFileStore::Open(const std::string &UUID, uint64_t &Size) {
+		std::string Directory, Name;
+		if(!FileName(UUID,Directory,Name))
+			return nullptr;
+		Poco::File	F(Name);
+		if(!F.exists())
+			return nullptr;
+		Size = F.getSize();
+		return std::make_unique<Poco::FileInputStream>(Name, std::ios::binary);
+	}
+
+	bool LocalFileStore::Remove(const std::string &UUID) {
+		std::string Directory, Name;
+		if(!FileName(UUID,Directory,Name))
+			return false;
+		Poco::File	F(Name);
+		if(!F.exists())
+			return false;
+		F.remove();
+		return true;
+	}
+}
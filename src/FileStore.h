@@ -0,0 +1,48 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#pragma once
+
+#include <istream>
+#include <memory>
+#include <string>
+
+namespace OpenWifi {
+
+	//	Where uploaded files (traces, ...) live. The database only keeps their metadata, the content is streamed to
+	//	and from the store without ever being held in memory as a whole.
+	class FileStore {
+	  public:
+		virtual ~FileStore() = default;
+
+		//	Copy In to the store under UUID. Fails, leaving nothing behind, if the content is larger than MaxSize.
+		virtual bool Store(const std::string &UUID, std::istream &In, uint64_t MaxSize, uint64_t &Size) = 0;
+
+		//	A stream positioned at the start of the content, nullptr if there is no such file.
+		virtual std::unique_ptr<std::istream> Open(const std::string &UUID, uint64_t &Size) = 0;
+
+		virtual bool Remove(const std::string &UUID) = 0;
+	};
+
+	//	Files kept in a local directory, sharded by the first characters of their UUID so no single directory
+	//	collects every upload.
+	class LocalFileStore : public FileStore {
+	  public:
+		explicit LocalFileStore(std::string Root) :
+			Root_(std::move(Root)) {
+		}
+
+		bool Store(const std::string &UUID, std::istream &In, uint64_t MaxSize, uint64_t &Size) final;
+		std::unique_ptr<std::istream> Open(const std::string &UUID, uint64_t &Size) final;
+		bool Remove(const std::string &UUID) final;
+
+	  private:
+		std::string 	Root_;
+
+		[[nodiscard]] bool FileName(const std::string &UUID, std::string &Directory, std::string &Name) const;
+	};
+}
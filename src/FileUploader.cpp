@@ -18,6 +18,7 @@
 #include "Poco/Net/MultipartReader.h"
 #include "Poco/CountingStream.h"
 #include "Poco/StreamCopier.h"
+#include "Poco/NullStream.h"
 #include "Poco/Exception.h"
 
 #include "FileUploader.h"
@@ -41,6 +42,7 @@ namespace OpenWifi {
         		Path_ = "/tmp";
         	}
         }
+		Store_ = std::make_unique<LocalFileStore>(Path_);
 
         for(const auto & Svr: ConfigServersList_) {
 			if(MicroService::instance().NoAPISecurity()) {
@@ -218,18 +220,24 @@ namespace OpenWifi {
 
 							const auto PartContentType = Hdr.get("Content-Type", "");
 							if (PartContentType == "application/octet-stream") {
-								std::stringstream FileContent;
-								Poco::StreamCopier::copyStream(Reader.stream(), FileContent);
+								uint64_t Size = 0;
+								if (!FileUploader()->Store().Store(UUID_, Reader.stream(), FileUploader()->MaxSize(), Size)) {
+									Logger().warning(fmt::format("{}: Trace file is too large or could not be written.", UUID_));
+									break;
+								}
+								if (!StorageService()->AttachFileDataToCommand(UUID_, Size)) {
+									FileUploader()->Store().Remove(UUID_);
+									break;
+								}
 								Answer.set("filename", UUID_);
 								Answer.set("error", 0);
-								Logger().debug(fmt::format("{}: Trace file uploaded.", UUID_));
-								StorageService()->AttachFileDataToCommand(UUID_, FileContent);
+								Logger().debug(fmt::format("{}: Trace file uploaded ({} bytes).", UUID_, Size));
 								std::ostream &ResponseStream = Response.send();
 								Poco::JSON::Stringifier::stringify(Answer, ResponseStream);
 								return;
 							} else {
-								std::stringstream OO;
-								Poco::StreamCopier::copyStream(Reader.stream(), OO);
+								Poco::NullOutputStream Discard;
+								Poco::StreamCopier::copyStream(Reader.stream(), Discard);
 							}
 
 							if (!Reader.hasNextPart())
@@ -14,6 +14,7 @@
 #include "Poco/Net/HTTPServerRequest.h"
 
 #include "framework/MicroService.h"
+#include "FileStore.h"
 
 namespace OpenWifi {
 
@@ -34,6 +35,7 @@ namespace OpenWifi {
         }
 
 		[[nodiscard]] inline uint64_t MaxSize() const { return MaxSize_; }
+		[[nodiscard]] inline FileStore & Store() { return *Store_; }
 
     private:
         std::vector<std::unique_ptr<Poco::Net::HTTPServer>>   Servers_;
@@ -41,6 +43,7 @@ namespace OpenWifi {
         std::map<std::string,uint64_t>  OutStandingUploads_;
         std::string                     Path_;
 		uint64_t 						MaxSize_=10000000;
+		std::unique_ptr<FileStore>		Store_;
 
 		explicit FileUploader() noexcept:
 			SubSystemServer("FileUploader", "FILE-UPLOAD", "openwifi.fileuploader")
@@ -0,0 +1,91 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+
+//	The capture file format written by FrameRecorder and read by owgw_replay. It only depends on the standard library
+//	so the tools can use it without the gateway framework.
+//
+//	file:	"OWCAP001" record*
+//	record:	timestamp (uint64, microseconds since the epoch), payload size (uint32), frame flags (uint16),
+//			serial size (uint8), serial, payload. Integers are little endian.
+namespace OpenWifi::FrameCapture {
+
+	static const char 			Magic[] = "OWCAP001";
+	static constexpr std::size_t MagicSize = 8;
+	static constexpr uint32_t 	MaxPayloadSize = 64 * 1024 * 1024;
+
+	struct Record {
+		uint64_t 		Timestamp = 0;
+		uint16_t 		Flags = 0;			//	WebSocket frame flags and opcode, as received
+		std::string 	Serial;				//	empty for frames received before the device said who it is
+		std::string 	Payload;
+	};
+
+	inline void WriteHeader(std::ostream &OS) {
+		OS.write(Magic, MagicSize);
+	}
+
+	inline bool ReadHeader(std::istream &IS) {
+		char Buffer[MagicSize];
+		IS.read(Buffer, MagicSize);
+		return IS.gcount()==(std::streamsize)MagicSize && std::memcmp(Buffer, Magic, MagicSize)==0;
+	}
+
+	inline void WriteInteger(std::ostream &OS, uint64_t Value, std::size_t Size) {
+		char Buffer[8];
+		for(std::size_t i=0;i<Size;i++)
+			Buffer[i] = (char) ((Value >> (8*i)) & 0xff);
+		OS.write(Buffer, (std::streamsize) Size);
+	}
+
+	inline bool ReadInteger(std::istream &IS, uint64_t &Value, std::size_t Size) {
+		unsigned char Buffer[8];
+		IS.read((char *)Buffer, (std::streamsize) Size);
+		if(IS.gcount()!=(std::streamsize)Size)
+			return false;
+		Value = 0;
+		for(std::size_t i=0;i<Size;i++)
+			Value |= ((uint64_t) Buffer[i]) << (8*i);
+		return true;
+	}
+
+	//	returns the number of bytes written
+	inline uint64_t Write(std::ostream &OS, const Record &R) {
+		auto SerialSize = std::min(R.Serial.size(), (std::size_t) 255);
+		WriteInteger(OS, R.Timestamp, 8);
+		WriteInteger(OS, R.Payload.size(), 4);
+		WriteInteger(OS, R.Flags, 2);
+		WriteInteger(OS, SerialSize, 1);
+		OS.write(R.Serial.data(), (std::streamsize) SerialSize);
+		OS.write(R.Payload.data(), (std::streamsize) R.Payload.size());
+		return 15 + SerialSize + R.Payload.size();
+	}
+
+	//	false at the end of the file, or on a truncated record (a capture cut short by a crash)
+	inline bool Read(std::istream &IS, Record &R) {
+		uint64_t PayloadSize, Flags, SerialSize;
+		if(!ReadInteger(IS, R.Timestamp, 8) || !ReadInteger(IS, PayloadSize, 4) || !ReadInteger(IS, Flags, 2) ||
+			!ReadInteger(IS, SerialSize, 1) || PayloadSize>MaxPayloadSize)
+			return false;
+		R.Flags = (uint16_t) Flags;
+		R.Serial.resize(SerialSize);
+		IS.read(R.Serial.data(), (std::streamsize) SerialSize);
+		if(IS.gcount()!=(std::streamsize)SerialSize)
+			return false;
+		R.Payload.resize(PayloadSize);
+		IS.read(R.Payload.data(), (std::streamsize) PayloadSize);
+		return IS.gcount()==(std::streamsize)PayloadSize;
+	}
+}
@@ -0,0 +1,196 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#include <random>
+
+#include "Poco/DirectoryIterator.h"
+#include "Poco/File.h"
+#include "Poco/Path.h"
+
+#include "FrameRecorder.h"
+
+namespace OpenWifi {
+
+	static const std::string CaptureExtension{"owcap"};
+
+	static inline uint64_t Fnv1a(const std::string &S, uint64_t Seed) {
+		uint64_t H = 14695981039346656037ULL ^ Seed;
+		for(const auto &c:S) {
+			H ^= (unsigned char) c;
+			H *= 1099511628211ULL;
+		}
+		return H;
+	}
+
+	int FrameRecorder::Start() {
+		if(!MicroService::instance().ConfigGetBool("openwifi.capture.enable", false))
+			return 0;
+
+		Path_ = MicroService::instance().ConfigPath("openwifi.capture.path", MicroService::instance().DataDir() + "/capture");
+		MaxFileSize_ = MicroService::instance().ConfigGetInt("openwifi.capture.maxfilesize", 64) * 1024 * 1024;
+		MaxFiles_ = std::max((uint64_t)1, (uint64_t)MicroService::instance().ConfigGetInt("openwifi.capture.maxfiles", 16));
+		MaxQueue_ = MicroService::instance().ConfigGetInt("openwifi.capture.queue", 100000);
+		Anonymize_ = MicroService::instance().ConfigGetBool("openwifi.capture.anonymize", true);
+		//	the same salt maps a serial number to the same anonymous one across restarts, a random one does not
+		auto Salt = MicroService::instance().ConfigGetString("openwifi.capture.salt", "");
+		Salt_ = Salt.empty() ? ((uint64_t) std::random_device{}() << 32) | std::random_device{}() : Fnv1a(Salt, 0);
+
+		Poco::File(Path_).createDirectories();
+		Logger().notice(fmt::format("Capturing device frames to {} ({} files of {}MB, anonymized: {}).", Path_, MaxFiles_,
+									MaxFileSize_ / (1024 * 1024), Anonymize_));
+		Running_ = true;
+		Worker_.setName("FRAME-RECORDER");
+		Worker_.start(*this);
+		Enabled_ = true;
+		return 0;
+	}
+
+	void FrameRecorder::Stop() {
+		if(!Enabled_)
+			return;
+		Logger().notice("Stopping...");
+		Enabled_ = false;
+		Running_ = false;
+		Queue_.wakeUpAll();
+		Worker_.join();
+	}
+
+	void FrameRecorder::Record(const std::string &Serial, int Flags, const std::string &Payload) {
+		if(Queue_.size() >= MaxQueue_) {
+			if((Dropped_++ % 10000) == 0)
+				Logger().warning(fmt::format("Capture is falling behind, {} frames dropped so far.", Dropped_.load()));
+			return;
+		}
+		FrameCapture::Record	R{
+			.Timestamp = (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(
+							 std::chrono::system_clock::now().time_since_epoch()).count(),
+			.Flags = (uint16_t) Flags,
+			.Serial = Serial,
+			.Payload = Payload};
+		Queue_.enqueueNotification(new CapturedFrameNotification(std::move(R)));
+	}
+
+	//	Simulator serial numbers (53494d...) that always stand for the same device, so a replay keeps each device's
+	//	history together and can connect with a simulator certificate. Only 24 bits are left for the device, so an
+	//	alias already given to another device is skipped and the next hash is tried: two devices never share one. With
+	//	a configured salt, a device gets the same alias after a restart unless it collided.
+	const std::string & FrameRecorder::Anonymous(const std::string &Serial) {
+		auto Hint = Aliases_.find(Serial);
+		if(Hint!=Aliases_.end())
+			return Hint->second;
+		std::string Alias;
+		for(uint64_t Probe=0;;Probe++) {
+			Alias = fmt::format("53494d{:06x}", Fnv1a(Serial, Salt_ + Probe) & 0xffffff);
+			if(UsedAliases_.insert(Alias).second)
+				break;
+		}
+		return Aliases_.emplace(Serial, Alias).first->second;
+	}
+
+	void FrameRecorder::Anonymize(FrameCapture::Record &R) {
+		if(R.Serial.empty()) {
+			static const std::string SerialField{"\"serial\":\""};
+			auto Start = R.Payload.find(SerialField);
+			if(Start==std::string::npos)
+				return;
+			Start += SerialField.size();
+			auto End = R.Payload.find('"', Start);
+			if(End==std::string::npos)
+				return;
+			R.Serial = R.Payload.substr(Start, End - Start);
+		}
+		if(R.Serial.size()!=12)
+			return;
+
+		//	the serial number is also the base MAC address of most devices
+		auto Replacement = Anonymous(R.Serial);
+		auto AsMAC = [](const std::string &S) {
+			return fmt::format("{}:{}:{}:{}:{}:{}", S.substr(0,2), S.substr(2,2), S.substr(4,2), S.substr(6,2), S.substr(8,2), S.substr(10,2));
+		};
+		for(const auto &[From,To]:{std::make_pair(R.Serial, Replacement), std::make_pair(AsMAC(R.Serial), AsMAC(Replacement))}) {
+			for(auto Pos = R.Payload.find(From); Pos!=std::string::npos; Pos = R.Payload.find(From, Pos + To.size()))
+				R.Payload.replace(Pos, From.size(), To);
+		}
+		R.Serial = Replacement;
+	}
+
+	void FrameRecorder::RemoveOldFiles() {
+		std::vector<std::string>	Files;
+		for(Poco::DirectoryIterator It(Path_), End; It!=End; ++It) {
+			if(It->isFile() && Poco::Path(It->path()).getExtension()==CaptureExtension)
+				Files.push_back(It->path());
+		}
+		if(Files.size()<=MaxFiles_)
+			return;
+		std::sort(Files.begin(), Files.end());
+		for(std::size_t i=0;i<Files.size()-MaxFiles_;i++) {
+			try {
+				Poco::File(Files[i]).remove();
+			} catch (const Poco::Exception &E) {
+				Logger().log(E);
+			}
+		}
+	}
+
+	//	When the file cannot be opened or written, frames are dropped and another file is tried 10 seconds later.
+	void FrameRecorder::OpenNextFile() {
+		if(File_.is_open())
+			File_.close();
+		File_.clear();
+		//	names sort in the order the files were written
+		auto Name = fmt::format("{}/owgw-{:012}-{:06}.{}", Path_, OpenWifi::Now(), FileSequence_++, CaptureExtension);
+		File_.open(Name, std::ios::binary | std::ios::trunc);
+		if(File_.is_open())
+			FrameCapture::WriteHeader(File_);
+		if(!File_.is_open() || !File_) {
+			Logger().error(fmt::format("Cannot write capture file {}, frames are dropped.", Name));
+			File_.close();
+			FileSize_ = MaxFileSize_;
+			RetryOpen_ = OpenWifi::Now() + 10;
+			return;
+		}
+		FileSize_ = FrameCapture::MagicSize;
+		RemoveOldFiles();
+	}
+
+	void FrameRecorder::Write(const Poco::AutoPtr<Poco::Notification> &Next) {
+		auto Frame = dynamic_cast<CapturedFrameNotification *>(Next.get());
+		if(Frame==nullptr)
+			return;
+		if(FileSize_>=MaxFileSize_ && OpenWifi::Now()>=RetryOpen_)
+			OpenNextFile();
+		if(!File_.is_open()) {
+			Dropped_++;
+			return;
+		}
+		if(Anonymize_)
+			Anonymize(Frame->Record_);
+		FileSize_ += FrameCapture::Write(File_, Frame->Record_);
+		if(!File_) {
+			Logger().error("Capture file write failed, frames are dropped.");
+			File_.close();
+			FileSize_ = MaxFileSize_;
+			RetryOpen_ = OpenWifi::Now() + 10;
+		}
+	}
+
+	void FrameRecorder::run() {
+		OpenNextFile();
+		while(Running_) {
+			Poco::AutoPtr<Poco::Notification>	Next(Queue_.waitDequeueNotification(1000));
+			if(Next.isNull()) {
+				File_.flush();
+				continue;
+			}
+			Write(Next);
+		}
+		//	what was captured before the gateway stopped is worth keeping
+		for(Poco::AutoPtr<Poco::Notification> Next(Queue_.dequeueNotification()); !Next.isNull(); Next = Queue_.dequeueNotification())
+			Write(Next);
+		File_.close();
+	}
+}
@@ -0,0 +1,82 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#pragma once
+
+#include <fstream>
+#include <map>
+#include <set>
+
+#include "Poco/Notification.h"
+#include "Poco/NotificationQueue.h"
+
+#include "framework/MicroService.h"
+#include "FrameCapture.h"
+
+namespace OpenWifi {
+
+	class CapturedFrameNotification: public Poco::Notification {
+	  public:
+		explicit CapturedFrameNotification(FrameCapture::Record &&R) :
+			Record_(std::move(R)) {
+		}
+		FrameCapture::Record	Record_;
+	};
+
+	//	Captures what devices send, to replay it later with owgw_replay. Frames are queued by the connection and
+	//	written by a single thread to rotating capture files, so recording never waits on the disk. Frames are dropped,
+	//	and counted, when the writer falls behind.
+	class FrameRecorder : public SubSystemServer, Poco::Runnable {
+	  public:
+		static auto instance() {
+			static auto instance_ = new FrameRecorder;
+			return instance_;
+		}
+
+		int Start() override;
+		void Stop() override;
+		void run() override;
+
+		[[nodiscard]] inline bool Enabled() const { return Enabled_; }
+
+		//	Serial may be empty before the device has sent its connect message: it is then looked up in the payload.
+		void Record(const std::string &Serial, int Flags, const std::string &Payload);
+
+	  private:
+		std::atomic_bool 			Enabled_ = false;
+		std::atomic_bool 			Running_ = false;
+		Poco::Thread				Worker_;
+		Poco::NotificationQueue		Queue_;
+		std::string 				Path_;
+		uint64_t 					MaxFileSize_ = 64 * 1024 * 1024;
+		uint64_t 					MaxFiles_ = 16;
+		uint64_t 					MaxQueue_ = 100000;
+		bool 						Anonymize_ = true;
+		uint64_t 					Salt_ = 0;
+		std::ofstream				File_;
+		uint64_t 					FileSize_ = 0;
+		uint64_t 					FileSequence_ = 0;
+		uint64_t 					RetryOpen_ = 0;
+		std::atomic_uint64_t 		Dropped_ = 0;
+		//	only used by the writer thread
+		std::map<std::string,std::string>	Aliases_;
+		std::set<std::string>		UsedAliases_;
+
+		[[nodiscard]] const std::string & Anonymous(const std::string &Serial);
+		void Anonymize(FrameCapture::Record &R);
+		void OpenNextFile();
+		void Write(const Poco::AutoPtr<Poco::Notification> &Next);
+		void RemoveOldFiles();
+
+		FrameRecorder() noexcept:
+			SubSystemServer("FrameRecorder", "FRAME-REC", "openwifi.capture")
+		{
+		}
+	};
+
+	inline auto FrameRecorder() { return FrameRecorder::instance(); }
+}
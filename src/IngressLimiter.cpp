@@ -0,0 +1,237 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#include "IngressLimiter.h"
+#include "framework/Metrics.h"
+
+namespace OpenWifi {
+
+	//	in MessageClass order, with the defaults of each class
+	static const struct {
+		const char 				*Name;
+		IngressLimiter::Limit 	Default;
+	} Classes[IngressLimiter::CLASSES] = {
+		{"state", {.Rate = 12, .Burst = 20, .Sample = 0}},
+		{"healthcheck", {.Rate = 12, .Burst = 20, .Sample = 0}},
+		{"log", {.Rate = 120, .Burst = 300, .Sample = 10}},
+		{"telemetry", {.Rate = 600, .Burst = 1200, .Sample = 0}}};
+
+	void IngressLimiter::Buckets::SetProfile(const Profile &P, uint64_t NowMs) {
+		bool First = Profile_ == nullptr;
+		Profile_ = &P;
+		if (!First)
+			return;
+		//	a new connection starts with full buckets
+		for (std::size_t i = 0; i < CLASSES; i++) {
+			Buckets_[i].Tokens = P[i].Burst * TokenScale;
+			Buckets_[i].Last = NowMs;
+		}
+		LastReport_ = NowMs;
+	}
+
+	IngressLimiter::Decision IngressLimiter::Buckets::Admit(MessageClass C, uint64_t NowMs) {
+		if (C >= CLASSES || Profile_ == nullptr)
+			return ACCEPT;
+		const auto &L = (*Profile_)[C];
+		if (L.Rate == 0)
+			return ACCEPT;
+
+		auto &B = Buckets_[C];
+		auto Capacity = L.Burst * TokenScale;
+		if (NowMs > B.Last) {
+			B.Tokens = std::min(Capacity, B.Tokens + (NowMs - B.Last) * L.Rate);
+			B.Last = NowMs;
+		} else {
+			//	the device type profile may have a smaller burst than the one the connection started with
+			B.Tokens = std::min(Capacity, B.Tokens);
+		}
+		if (B.Tokens >= TokenScale) {
+			B.Tokens -= TokenScale;
+			return ACCEPT;
+		}
+
+		if (LastExcess_ == 0 || NowMs - LastExcess_ >= EpisodeGapMs)
+			NewEpisode_ = true;
+		LastExcess_ = NowMs;
+		LastClass_ = C;
+		if (L.Sample && (B.Excess++ % L.Sample) == 0) {
+			Sampled_++;
+			return SAMPLE;
+		}
+		Dropped_++;
+		return DROP;
+	}
+
+	IngressLimiter::Excess IngressLimiter::Buckets::Take(uint64_t NowMs) {
+		Excess E{.Dropped = Dropped_, .Sampled = Sampled_, .Class = LastClass_, .NewEpisode = NewEpisode_};
+		Dropped_ = Sampled_ = 0;
+		NewEpisode_ = false;
+		LastReport_ = NowMs;
+		return E;
+	}
+
+	IngressLimiter::IngressLimiter() noexcept:
+		SubSystemServer("IngressLimiter", "INGRESS-LIMITER", "ingress.limiter")
+	{
+		for (std::size_t i = 0; i < CLASSES; i++) {
+			Default_[i] = Classes[i].Default;
+			Limited_[i][0] = &Metrics::GetCounter("owgw_ingress_limited_total", "Device messages over their rate limit, by class and outcome.",
+												  {{"class", Classes[i].Name}, {"outcome", "dropped"}});
+			Limited_[i][1] = &Metrics::GetCounter("owgw_ingress_limited_total", "Device messages over their rate limit, by class and outcome.",
+												  {{"class", Classes[i].Name}, {"outcome", "sampled"}});
+		}
+		Metrics::Registry()->AddGauge("owgw_ingress_repeat_offenders", "Devices flagged for repeatedly going over their rate limits.", {},
+									  [this] { return (double) RepeatOffenders_.load(); });
+	}
+
+	void IngressLimiter::ReadProfile(const std::string &Root, Profile &P) {
+		for (std::size_t i = 0; i < CLASSES; i++) {
+			auto Prefix = Root + Classes[i].Name + ".";
+			P[i].Rate = MicroService::instance().ConfigGetInt(Prefix + "rate", P[i].Rate);
+			P[i].Burst = std::max((uint64_t) 1, (uint64_t) MicroService::instance().ConfigGetInt(Prefix + "burst", P[i].Burst));
+			P[i].Sample = MicroService::instance().ConfigGetInt(Prefix + "sample", P[i].Sample);
+		}
+	}
+
+	int IngressLimiter::Start() {
+		if (!MicroService::instance().ConfigGetBool("openwifi.ingress.enable", true)) {
+			for (auto &L : Default_)
+				L.Rate = 0;
+			Logger().information("Ingress rate limits disabled.");
+			return 0;
+		}
+
+		ReadProfile("openwifi.ingress.", Default_);
+		//	device types start from the global profile and override what they need
+		for (auto i = 0;; i++) {
+			auto Root = fmt::format("openwifi.ingress.devicetype.{}.", i);
+			auto DeviceType = MicroService::instance().ConfigGetString(Root + "compatible", "");
+			if (DeviceType.empty())
+				break;
+			auto &P = DeviceTypes_[DeviceType] = Default_;
+			ReadProfile(Root, P);
+		}
+		RepeatEpisodes_ = std::max((uint64_t) 1, (uint64_t) MicroService::instance().ConfigGetInt("openwifi.ingress.offender.episodes", 3));
+		RepeatWindow_ = MicroService::instance().ConfigGetInt("openwifi.ingress.offender.window", 3600);
+		Retention_ = MicroService::instance().ConfigGetInt("openwifi.ingress.offender.retention", 86400);
+
+		for (std::size_t i = 0; i < CLASSES; i++)
+			Logger().information(fmt::format("Ingress limit for {}: {} per minute, burst {}, {}.", Classes[i].Name,
+											 Default_[i].Rate, Default_[i].Burst,
+											 Default_[i].Sample ? fmt::format("keeping 1 in {} over the limit", Default_[i].Sample)
+															   : std::string("dropping over the limit")));
+		if (!DeviceTypes_.empty())
+			Logger().information(fmt::format("Ingress limits for {} device types.", DeviceTypes_.size()));
+		return 0;
+	}
+
+	void IngressLimiter::Stop() {
+		Logger().notice("Stopping.");
+	}
+
+	IngressLimiter::MessageClass IngressLimiter::ClassOf(uCentralProtocol::Events::EVENT_MSG Event) {
+		using namespace uCentralProtocol::Events;
+		switch (Event) {
+			case ET_STATE: return STATE;
+			case ET_HEALTHCHECK: return HEALTHCHECK;
+			case ET_LOG:
+			case ET_CRASHLOG: return LOG;
+			case ET_TELEMETRY: return TELEMETRY;
+			default: return CLASSES;
+		}
+	}
+
+	const char * IngressLimiter::ClassName(MessageClass C) {
+		return C < CLASSES ? Classes[C].Name : "";
+	}
+
+	const IngressLimiter::Profile & IngressLimiter::ProfileFor(const std::string &DeviceType) const {
+		auto Hint = DeviceTypes_.find(DeviceType);
+		return Hint == DeviceTypes_.end() ? Default_ : Hint->second;
+	}
+
+	void IngressLimiter::Count(MessageClass C, Decision D) {
+		if (C < CLASSES && D != ACCEPT)
+			Limited_[C][D == SAMPLE]->Add();
+	}
+
+	void IngressLimiter::Report(const std::string &SerialNumber, const std::string &DeviceType, const Excess &E) {
+		std::lock_guard G(Mutex_);
+		auto Now = OpenWifi::Now();
+		Prune(Now);
+
+		auto &O = Offenders_[SerialNumber];
+		if (O.Info.serialNumber.empty()) {
+			O.Info.serialNumber = SerialNumber;
+			O.Info.firstSeen = Now;
+			O.WindowStart = Now;
+		}
+		O.Info.deviceType = DeviceType;
+		O.Info.lastClass = ClassName(E.Class);
+		O.Info.dropped += E.Dropped;
+		O.Info.sampled += E.Sampled;
+		O.Info.lastSeen = Now;
+		if (!E.NewEpisode)
+			return;
+
+		O.Info.episodes++;
+		if (Now - O.WindowStart > RepeatWindow_) {
+			O.WindowStart = Now;
+			O.WindowEpisodes = 0;
+		}
+		if (++O.WindowEpisodes >= RepeatEpisodes_ && !O.Info.repeatOffender) {
+			O.Info.repeatOffender = true;
+			RepeatOffenders_++;
+			Logger().warning(fmt::format("INGRESS-LIMIT({}): {} went over its {} limit {} times within {} seconds.", SerialNumber,
+										 DeviceType.empty() ? "device" : DeviceType, O.Info.lastClass, O.WindowEpisodes,
+										 RepeatWindow_));
+		} else {
+			Logger().information(fmt::format("INGRESS-LIMIT({}): over its {} limit.", SerialNumber, O.Info.lastClass));
+		}
+	}
+
+	//	forgets devices that stayed within their limits for Retention_ seconds
+	void IngressLimiter::Prune(uint64_t Now) {
+		if (Now - LastPrune_ < 60)
+			return;
+		LastPrune_ = Now;
+		for (auto i = Offenders_.begin(); i != Offenders_.end();) {
+			if (Now - i->second.Info.lastSeen > Retention_) {
+				if (i->second.Info.repeatOffender)
+					RepeatOffenders_--;
+				i = Offenders_.erase(i);
+			} else {
+				++i;
+			}
+		}
+	}
+
+	void IngressLimiter::GetOffenders(std::vector<GWObjects::IngressOffender> &Offenders, bool RepeatOnly) {
+		std::lock_guard G(Mutex_);
+		Prune(OpenWifi::Now());
+		for (const auto &[SerialNumber, O] : Offenders_)
+			if (!RepeatOnly || O.Info.repeatOffender)
+				Offenders.push_back(O.Info);
+	}
+
+	bool IngressLimiter::RemoveOffender(const std::string &SerialNumber) {
+		std::lock_guard G(Mutex_);
+		auto Hint = Offenders_.find(SerialNumber);
+		if (Hint == Offenders_.end())
+			return false;
+		if (Hint->second.Info.repeatOffender)
+			RepeatOffenders_--;
+		Offenders_.erase(Hint);
+		return true;
+	}
+
+	void IngressLimiter::ClearOffenders() {
+		std::lock_guard G(Mutex_);
+		Offenders_.clear();
+		RepeatOffenders_ = 0;
+	}
+}
@@ -0,0 +1,123 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#pragma once
+
+#include <array>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "framework/MicroService.h"
+#include "framework/ow_constants.h"
+#include "RESTObjects/RESTAPI_GWobjects.h"
+
+namespace OpenWifi {
+
+	//	Limits how fast a single device may send each class of event. Every connection holds one token bucket per
+	//	class, refilled at the rate of its device type's profile, so admitting a message costs a few integer operations
+	//	on the connection's own reactor thread. Messages over the limit are dropped, or one in N is kept. Devices that
+	//	keep going over their limits are remembered so they can be listed through the REST API.
+	class IngressLimiter : public SubSystemServer {
+	  public:
+		enum MessageClass { STATE = 0, HEALTHCHECK, LOG, TELEMETRY, CLASSES };
+		enum Decision { ACCEPT, DROP, SAMPLE };
+
+		struct Limit {
+			uint64_t 	Rate = 0;			//	messages per minute, 0 for no limit
+			uint64_t 	Burst = 1;			//	messages accepted back to back after a quiet period
+			uint64_t 	Sample = 0;			//	keep one in Sample of the messages over the limit, 0 drops them all
+		};
+		typedef std::array<Limit, CLASSES>	Profile;
+
+		//	what a connection refused since it last reported
+		struct Excess {
+			uint64_t 		Dropped = 0;
+			uint64_t 		Sampled = 0;
+			MessageClass 	Class = CLASSES;
+			bool 			NewEpisode = false;
+		};
+
+		//	The buckets of one connection. Only its reactor thread uses them.
+		class Buckets {
+		  public:
+			void SetProfile(const Profile &P, uint64_t NowMs);
+			Decision Admit(MessageClass C, uint64_t NowMs);
+
+			[[nodiscard]] inline bool Pending() const { return Dropped_ || Sampled_; }
+			//	the limiter hears about each episode at once, and then every ReportIntervalMs while it lasts
+			[[nodiscard]] inline bool ReportDue(uint64_t NowMs) const {
+				return Pending() && (NewEpisode_ || NowMs - LastReport_ >= ReportIntervalMs);
+			}
+			Excess Take(uint64_t NowMs);
+
+		  private:
+			static constexpr uint64_t	TokenScale = 60000;		//	a rate per minute then adds a whole number of tokens every ms
+			static constexpr uint64_t	EpisodeGapMs = 60000;	//	a minute within the limits ends an episode
+			static constexpr uint64_t	ReportIntervalMs = 10000;
+
+			struct Bucket {
+				uint64_t	Tokens = 0;
+				uint64_t	Last = 0;
+				uint64_t	Excess = 0;
+			};
+
+			const Profile 				*Profile_ = nullptr;
+			std::array<Bucket, CLASSES>	Buckets_{};
+			uint64_t 					Dropped_ = 0, Sampled_ = 0;
+			uint64_t 					LastExcess_ = 0, LastReport_ = 0;
+			MessageClass 				LastClass_ = CLASSES;
+			bool 						NewEpisode_ = false;
+		};
+
+		static auto instance() {
+			static auto instance_ = new IngressLimiter;
+			return instance_;
+		}
+
+		int Start() override;
+		void Stop() override;
+
+		static MessageClass ClassOf(uCentralProtocol::Events::EVENT_MSG Event);
+		static const char * ClassName(MessageClass C);
+
+		//	the profile of a device type, the global one when the type has none
+		[[nodiscard]] const Profile & ProfileFor(const std::string &DeviceType) const;
+		void Count(MessageClass C, Decision D);
+		void Report(const std::string &SerialNumber, const std::string &DeviceType, const Excess &E);
+
+		void GetOffenders(std::vector<GWObjects::IngressOffender> &Offenders, bool RepeatOnly);
+		bool RemoveOffender(const std::string &SerialNumber);
+		void ClearOffenders();
+
+	  private:
+		struct Offender {
+			GWObjects::IngressOffender	Info;
+			uint64_t 					WindowStart = 0;
+			uint64_t 					WindowEpisodes = 0;
+		};
+
+		Profile 							Default_{};
+		std::map<std::string, Profile>		DeviceTypes_;
+		uint64_t 							RepeatEpisodes_ = 3;
+		uint64_t 							RepeatWindow_ = 3600;
+		uint64_t 							Retention_ = 86400;
+		std::map<std::string, Offender>		Offenders_;
+		uint64_t 							LastPrune_ = 0;
+		std::atomic_uint64_t 				RepeatOffenders_ = 0;
+		std::array<std::array<Metrics::Counter *, 2>, CLASSES>	Limited_{};
+
+		void ReadProfile(const std::string &Root, Profile &P);
+		void Prune(uint64_t Now);
+
+		IngressLimiter() noexcept;
+	};
+
+	inline auto IngressLimiter() { return IngressLimiter::instance(); }
+
+}
@@ -4,6 +4,7 @@
 #include <thread>
 #include <fstream>
 #include <vector>
+#include <cstring>
 
 #include "OUIServer.h"
 
@@ -13,6 +14,7 @@
 #include "Poco/StreamCopier.h"
 #include "Poco/URI.h"
 #include "Poco/File.h"
+#include "Poco/SharedMemory.h"
 
 #include "OUIServer.h"
 #include "framework/MicroService.h"
@@ -23,6 +25,16 @@ namespace OpenWifi {
 		Running_ = true;
 		LatestOUIFileName_ =  MicroService::instance().DataDir() + "/newOUIFile.txt";
 		CurrentOUIFileName_ = MicroService::instance().DataDir() + "/current_oui.txt";
+		SnapshotFileName_ = MicroService::instance().DataDir() + "/current_oui.bin";
+
+		//	the binary snapshot makes lookups available immediately instead of after the first timer run
+		if(!Initialized_ && Poco::File(SnapshotFileName_).exists()) {
+			auto Table = LoadSnapshot(SnapshotFileName_, CurrentOUIFileName_);
+			if(Table) {
+				Publish(Table);
+				Initialized_ = true;
+			}
+		}
 
 		UpdaterCallBack_ = std::make_unique<Poco::TimerCallback<OUIServer>>(*this, &OUIServer::onTimer);
 		Timer_.setStartInterval(30 * 1000);  // first run in 5 minutes
@@ -97,6 +109,164 @@ namespace OpenWifi {
 		return false;
 	}
 
+	std::shared_ptr<const OUITable> OUIServer::BuildTable(const OUIMap &Map) {
+		auto Table = std::make_shared<OUITable>();
+		std::map<std::string,uint32_t>	Interned;
+		Table->KeyStore.reserve(Map.size());
+		Table->IndexStore.reserve(Map.size());
+		Table->OffsetStore.push_back(0);
+		for(const auto &[OUI,Vendor]:Map) {
+			auto Hint = Interned.find(Vendor);
+			if(Hint==Interned.end()) {
+				Hint = Interned.emplace(Vendor, (uint32_t) Table->OffsetStore.size() - 1).first;
+				Table->NameStore += Vendor;
+				Table->OffsetStore.push_back((uint32_t) Table->NameStore.size());
+			}
+			Table->KeyStore.push_back(OUI);
+			Table->IndexStore.push_back(Hint->second);
+		}
+		Table->Entries = Table->KeyStore.size();
+		Table->Vendors = Table->OffsetStore.size() - 1;
+		Table->Keys = Table->KeyStore.data();
+		Table->VendorIndex = Table->IndexStore.data();
+		Table->Offsets = Table->OffsetStore.data();
+		Table->Names = Table->NameStore.data();
+		return Table;
+	}
+
+	//	Snapshot layout, native byte order (the file never leaves the host that wrote it):
+	//		header | Keys[Entries] | VendorIndex[Entries] | Offsets[Vendors+1] | vendor names
+	//	The size and modification time of the text file it was built from tell whether it is still current.
+	struct OUISnapshotHeader {
+		char 		Magic[8];
+		uint32_t 	Entries;
+		uint32_t 	Vendors;
+		uint32_t 	StringBytes;
+		uint32_t 	Reserved;
+		uint64_t 	SourceSize;
+		int64_t 	SourceModified;		//	microseconds
+	};
+	static const char OUISnapshotMagic[8] = {'O','W','G','W','O','U','I','2'};
+
+	static bool SourceVersion(const std::string &SourceFileName, uint64_t &Size, int64_t &Modified) {
+		Poco::File	F(SourceFileName);
+		if(!F.exists())
+			return false;
+		Size = F.getSize();
+		Modified = F.getLastModified().epochMicroseconds();
+		return true;
+	}
+
+	bool OUIServer::SaveSnapshot(const OUITable &Table, const std::string &FileName, const std::string &SourceFileName) {
+		try {
+			OUISnapshotHeader	Header{};
+			std::memcpy(Header.Magic, OUISnapshotMagic, sizeof(Header.Magic));
+			Header.Entries = (uint32_t) Table.Entries;
+			Header.Vendors = (uint32_t) Table.Vendors;
+			Header.StringBytes = Table.Offsets[Table.Vendors];
+			if(!SourceVersion(SourceFileName, Header.SourceSize, Header.SourceModified))
+				return false;
+
+			auto TmpFileName = FileName + ".tmp";
+			std::ofstream OS(TmpFileName, std::ios::binary | std::ios::trunc);
+			OS.write((const char *)&Header, sizeof(Header));
+			OS.write((const char *)Table.Keys, Table.Entries * sizeof(uint64_t));
+			OS.write((const char *)Table.VendorIndex, Table.Entries * sizeof(uint32_t));
+			OS.write((const char *)Table.Offsets, (Table.Vendors + 1) * sizeof(uint32_t));
+			OS.write(Table.Names, Header.StringBytes);
+			OS.close();
+			if(!OS)
+				return false;
+			Poco::File(TmpFileName).renameTo(FileName);
+			return true;
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
+		}
+		return false;
+	}
+
+	//	The table is served from the mapping, nothing is copied: loading costs the checks below. A snapshot not
+	//	built from the current text file is refused.
+	std::shared_ptr<const OUITable> OUIServer::LoadSnapshot(const std::string &FileName, const std::string &SourceFileName) {
+		try {
+			Poco::File	F(FileName);
+			auto FileSize = F.getSize();
+			if(FileSize < sizeof(OUISnapshotHeader))
+				return nullptr;
+
+			auto Table = std::make_shared<OUITable>();
+			Table->Mapping = std::make_unique<Poco::SharedMemory>(F, Poco::SharedMemory::AM_READ);
+			const char *Data = Table->Mapping->begin();
+			OUISnapshotHeader	Header{};
+			std::memcpy(&Header, Data, sizeof(Header));
+			if(std::memcmp(Header.Magic, OUISnapshotMagic, sizeof(Header.Magic))!=0)
+				return nullptr;
+
+			uint64_t SourceSize;
+			int64_t SourceModified;
+			if(SourceVersion(SourceFileName, SourceSize, SourceModified) &&
+				(SourceSize!=Header.SourceSize || SourceModified!=Header.SourceModified)) {
+				Logger().information("OUI snapshot is stale.");
+				return nullptr;
+			}
+
+			uint64_t Expected = sizeof(Header) + (uint64_t) Header.Entries * (sizeof(uint64_t) + sizeof(uint32_t)) +
+								((uint64_t) Header.Vendors + 1) * sizeof(uint32_t) + Header.StringBytes;
+			if(Expected != FileSize)
+				return nullptr;
+
+			const char *Cur = Data + sizeof(Header);
+			Table->Entries = Header.Entries;
+			Table->Vendors = Header.Vendors;
+			Table->Keys = (const uint64_t *) Cur;
+			Cur += Header.Entries * sizeof(uint64_t);
+			Table->VendorIndex = (const uint32_t *) Cur;
+			Cur += Header.Entries * sizeof(uint32_t);
+			Table->Offsets = (const uint32_t *) Cur;
+			Cur += (Header.Vendors + 1) * sizeof(uint32_t);
+			Table->Names = Cur;
+
+			if(Table->Offsets[0]!=0 || Table->Offsets[Header.Vendors]!=Header.StringBytes)
+				return nullptr;
+			for(uint32_t i=0;i<Header.Vendors;++i) {
+				if(Table->Offsets[i]>Table->Offsets[i+1])
+					return nullptr;
+			}
+			for(std::size_t i=0;i<Table->Entries;++i) {
+				if(Table->VendorIndex[i]>=Header.Vendors || (i && Table->Keys[i-1]>=Table->Keys[i]))
+					return nullptr;
+			}
+			Logger().information(fmt::format("Loaded {} OUIs from snapshot.", Table->size()));
+			return Table;
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
+		}
+		return nullptr;
+	}
+
+	void OUIServer::Publish(std::shared_ptr<const OUITable> Table) {
+		std::atomic_store(&OUIs_, std::move(Table));
+	}
+
+	//	Load the current OUI text file, through its binary snapshot when it was built from that file.
+	bool OUIServer::LoadCurrentFile() {
+		if(Poco::File(SnapshotFileName_).exists()) {
+			auto Table = LoadSnapshot(SnapshotFileName_, CurrentOUIFileName_);
+			if(Table) {
+				Publish(Table);
+				return true;
+			}
+		}
+		OUIMap TmpOUIs;
+		if(!Poco::File(CurrentOUIFileName_).exists() || !ProcessFile(CurrentOUIFileName_, TmpOUIs))
+			return false;
+		auto Table = BuildTable(TmpOUIs);
+		if(!SaveSnapshot(*Table, SnapshotFileName_, CurrentOUIFileName_))
+			Logger().warning("Could not save OUI snapshot.");
+		Publish(Table);
+		return true;
+	}
+
 	void OUIServer::onTimer([[maybe_unused]] Poco::Timer & timer) {
 		if(Updating_)
 			return;
@@ -107,7 +277,7 @@ namespace OpenWifi {
 		if(Current.exists()) {
 			if((OpenWifi::Now()-Current.getLastModified().epochTime()) < (7*24*60*60)) {
 				if(!Initialized_) {
-					if(ProcessFile(CurrentOUIFileName_, OUIs_)) {
+					if(LoadCurrentFile()) {
 						Initialized_ = true;
 						Updating_=false;
 						Logger().information("Using cached file.");
@@ -122,20 +292,20 @@ namespace OpenWifi {
 
 		OUIMap TmpOUIs;
 		if(GetFile(LatestOUIFileName_) && ProcessFile(LatestOUIFileName_, TmpOUIs)) {
-			std::lock_guard G(Mutex_);
-			OUIs_ = std::move(TmpOUIs);
+			auto Table = BuildTable(TmpOUIs);
+			Publish(Table);
 			LastUpdate_ = OpenWifi::Now();
 			Poco::File F1(CurrentOUIFileName_);
 			if(F1.exists())
 				F1.remove();
 			Poco::File F2(LatestOUIFileName_);
 			F2.renameTo(CurrentOUIFileName_);
+			if(!SaveSnapshot(*Table, SnapshotFileName_, CurrentOUIFileName_))
+				Logger().warning("Could not save OUI snapshot.");
 			Logger().information(fmt::format("New OUI file {} downloaded.",LatestOUIFileName_));
-		} else if(OUIs_.empty()) {
-			if(ProcessFile(CurrentOUIFileName_, TmpOUIs)) {
+		} else if(!std::atomic_load(&OUIs_)) {
+			if(LoadCurrentFile()) {
 				LastUpdate_ = OpenWifi::Now();
-				std::lock_guard G(Mutex_);
-				OUIs_ = std::move(TmpOUIs);
 			}
 		}
 		Initialized_=true;
@@ -143,10 +313,12 @@ namespace OpenWifi {
 	}
 
 	std::string OUIServer::GetManufacturer(const std::string &MAC) {
-		std::lock_guard Guard(Mutex_);
-		auto Manufacturer = OUIs_.find(Utils::SerialNumberToOUI(MAC));
-		if(Manufacturer != OUIs_.end())
-			return Manufacturer->second;
+		auto Table = std::atomic_load(&OUIs_);
+		if(Table) {
+			auto Manufacturer = Table->Find(Utils::SerialNumberToOUI(MAC));
+			if(!Manufacturer.empty())
+				return std::string(Manufacturer);
+		}
 		return "";
 	}
 };
@@ -5,10 +5,46 @@
 #pragma once
 
 #include "framework/MicroService.h"
+#include "Poco/SharedMemory.h"
 #include "Poco/Timer.h"
 
 namespace OpenWifi {
 
+	//	Immutable OUI lookup table: sorted OUI keys, each pointing into a table of interned vendor names.
+	//	A table is never modified once published, so readers only need to hold a reference to it. The arrays either
+	//	live in the table, when it is built from the text file, or in the mapped snapshot it was loaded from.
+	struct OUITable {
+		std::size_t 		Entries = 0;
+		std::size_t 		Vendors = 0;
+		const uint64_t 		*Keys = nullptr;
+		const uint32_t 		*VendorIndex = nullptr;
+		const uint32_t 		*Offsets = nullptr;		//	Vendors+1 offsets into Names
+		const char 			*Names = nullptr;
+
+		std::vector<uint64_t> 		KeyStore;
+		std::vector<uint32_t> 		IndexStore, OffsetStore;
+		std::string 				NameStore;
+		std::unique_ptr<Poco::SharedMemory>	Mapping;
+
+		OUITable() = default;
+		OUITable(const OUITable &) = delete;
+		OUITable & operator=(const OUITable &) = delete;
+
+		[[nodiscard]] inline std::string_view Vendor(std::size_t Index) const {
+			return {Names + Offsets[Index], Offsets[Index+1] - Offsets[Index]};
+		}
+
+		//	an empty view when the OUI is unknown
+		[[nodiscard]] inline std::string_view Find(uint64_t OUI) const {
+			auto Hint = std::lower_bound(Keys,Keys+Entries,OUI);
+			if(Hint==Keys+Entries || *Hint!=OUI)
+				return {};
+			return Vendor(VendorIndex[Hint-Keys]);
+		}
+
+		[[nodiscard]] inline std::size_t size() const { return Entries; }
+	};
+
 	class OUIServer : public SubSystemServer {
 	  public:
 
@@ -29,15 +65,22 @@ namespace OpenWifi {
 		[[nodiscard]] bool GetFile(const std::string &FileName);
 		[[nodiscard]] bool ProcessFile(const std::string &FileName, OUIMap &Map);
 
+		static std::shared_ptr<const OUITable> BuildTable(const OUIMap &Map);
+		[[nodiscard]] bool SaveSnapshot(const OUITable &Table, const std::string &FileName, const std::string &SourceFileName);
+		[[nodiscard]] std::shared_ptr<const OUITable> LoadSnapshot(const std::string &FileName, const std::string &SourceFileName);
+
 	  private:
 		uint64_t 			LastUpdate_ = 0 ;
 		bool 				Initialized_ = false;
-		OUIMap 				OUIs_;
+		std::shared_ptr<const OUITable>	OUIs_;
 		std::atomic_bool 	Updating_=false;
 		std::atomic_bool 	Running_=false;
 		Poco::Timer         Timer_;
 		std::unique_ptr<Poco::TimerCallback<OUIServer>>   UpdaterCallBack_;
-		std::string 		LatestOUIFileName_,CurrentOUIFileName_;
+		std::string 		LatestOUIFileName_,CurrentOUIFileName_,SnapshotFileName_;
+
+		void Publish(std::shared_ptr<const OUITable> Table);
+		bool LoadCurrentFile();
 
 		OUIServer() noexcept:
 			SubSystemServer("OUIServer", "OUI-SVR", "ouiserver")
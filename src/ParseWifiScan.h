@@ -342,16 +342,7 @@ namespace OpenWifi {
 
 
 	inline std::vector<unsigned char> Base64Decode2Vec(const std::string &F) {
-		std::istringstream ifs(F);
-		Poco::Base64Decoder b64in(ifs);
-		std::ostringstream ofs;
-		Poco::StreamCopier::copyStream(b64in, ofs);
-		std::vector<unsigned char> r;
-		auto s = ofs.str();
-		for (const auto &c : s) {
-			r.push_back((unsigned char)c);
-		}
-		return r;
+		return Utils::base64decode(F);
 	}
 
 	using value_string = std::vector<std::pair<uint,const char *>>;
@@ -677,7 +668,7 @@ namespace OpenWifi {
 		{ 0, NULL }
 	};
 
-	const char * VALS(const value_string &vals, uint v) {
+	inline const char * VALS(const value_string &vals, uint v) {
 		for(const auto &e:vals) {
 			if(e.first==v && e.second!=NULL)
 				return e.second;
@@ -685,7 +676,7 @@ namespace OpenWifi {
 		return "unknown";
 	}
 
-	bool bitSet(unsigned char c, uint bit) {
+	inline bool bitSet(unsigned char c, uint bit) {
 		switch (bit) {
 		case 0: return (c & 0x01);
 		case 1: return (c & 0x02);
@@ -699,7 +690,7 @@ namespace OpenWifi {
 		}
 	}
 
-	bool bitSet(uint16_t c, uint bit) {
+	inline bool bitSet(uint16_t c, uint bit) {
 		switch (bit) {
 		case 0: return  (c & 0x0001);
 		case 1: return  (c & 0x0002);
@@ -721,7 +712,7 @@ namespace OpenWifi {
 		}
 	}
 
-	std::string BufferToHex(const std::vector<unsigned char> &b) {
+	inline std::string BufferToHex(const std::vector<unsigned char> &b) {
 		static const char hex[] = "0123456789abcdef";
 		std::string result;
 		for(const auto &c:b) {
@@ -733,7 +724,7 @@ namespace OpenWifi {
 		return result;
 	}
 
-	std::string BufferToHex(const unsigned char *b,uint size, char separator=' ') {
+	inline std::string BufferToHex(const unsigned char *b,uint size, char separator=' ') {
 		static const char hex[] = "0123456789abcdef";
 		std::string result;
 		while(size) {
@@ -747,7 +738,7 @@ namespace OpenWifi {
 		return result;
 	}
 
-	std::string bitString(unsigned char c) {
+	inline std::string bitString(unsigned char c) {
 		std::string R;
 		for(std::size_t i=0;i<8;i++) {
 			if(c & 0x80)
@@ -759,36 +750,68 @@ namespace OpenWifi {
 		return R;
 	}
 
-	uint16_t GetUInt16(const unsigned char *d,uint & offset) {
+	inline uint16_t GetUInt16(const unsigned char *d,uint & offset) {
 		uint16_t value = d[offset] + d[offset+1]*256;
 		offset +=2;
 		return value;
 	}
 
-	uint32_t GetUInt32(const unsigned char *d,uint & offset) {
-		uint32_t value = d[offset+0]+d[offset+1]*256 + d[offset+2]*256*256 + d[offset+3]*256*256*256;
+	inline uint32_t GetUInt32(const unsigned char *d,uint & offset) {
+		uint32_t value = d[offset+0] + d[offset+1]*256 + d[offset+2]*256*256 + (uint32_t) d[offset+3]*256*256*256;
 		offset +=4;
 		return value;
 	}
 
-	uint32_t GetUInt32Big(const unsigned char *d,uint & offset) {
-		uint32_t value = d[offset+3]+d[offset+2]*256 + d[offset+1]*256*256 + d[offset+0]*256*256*256;
+	inline uint32_t GetUInt32Big(const unsigned char *d,uint & offset) {
+		uint32_t value = d[offset+3] + d[offset+2]*256 + d[offset+1]*256*256 + (uint32_t) d[offset+0]*256*256*256;
 		offset +=4;
 		return value;
 	}
 
-	uint32_t GetUInt24Big(const unsigned char *d,uint & offset) {
+	inline uint32_t GetUInt24Big(const unsigned char *d,uint & offset) {
 		uint32_t value = d[offset+2] + d[offset+1]*256 + d[offset+0]*256*256;
 		offset +=3;
 		return value;
 	}
 
-	uint32_t GetUInt24(const unsigned char *d,uint & offset) {
+	inline uint32_t GetUInt24(const unsigned char *d,uint & offset) {
 		uint32_t value = d[offset+0] + d[offset+1]*256 + d[offset+2]*256*256;
 		offset +=3;
 		return value;
 	}
 
+	//	Bounds-checked readers over a decoded IE. A short IE throws std::out_of_range, the decoder is abandoned
+	//	and the IE is returned undecoded.
+	inline void IERequire(const std::vector<unsigned char> &d, uint offset, uint size) {
+		if(offset + size > d.size())
+			throw std::out_of_range("IE too short");
+	}
+
+	inline uint16_t GetUInt16(const std::vector<unsigned char> &d,uint & offset) {
+		IERequire(d, offset, 2);
+		return GetUInt16(d.data(), offset);
+	}
+
+	inline uint32_t GetUInt32(const std::vector<unsigned char> &d,uint & offset) {
+		IERequire(d, offset, 4);
+		return GetUInt32(d.data(), offset);
+	}
+
+	inline uint32_t GetUInt32Big(const std::vector<unsigned char> &d,uint & offset) {
+		IERequire(d, offset, 4);
+		return GetUInt32Big(d.data(), offset);
+	}
+
+	inline uint32_t GetUInt24Big(const std::vector<unsigned char> &d,uint & offset) {
+		IERequire(d, offset, 3);
+		return GetUInt24Big(d.data(), offset);
+	}
+
+	inline uint32_t GetUInt24(const std::vector<unsigned char> &d,uint & offset) {
+		IERequire(d, offset, 3);
+		return GetUInt24(d.data(), offset);
+	}
+
 	// 0x01
 	inline nlohmann::json WFS_WLAN_EID_SUPP_RATES(const std::vector<unsigned char> &data) {
 		nlohmann::json 	Rates = nlohmann::json::array();
@@ -807,10 +830,10 @@ namespace OpenWifi {
 	inline nlohmann::json WFS_WLAN_EID_FH_PARAMS(const std::vector<unsigned char> &data) {
 		nlohmann::json 	new_ie;
 		nlohmann::json 	content;
-		content["Dwell Time"] = (uint64_t) (data[0] * 256 + data[1]);
-		content["Hop Set"] = (uint)data[2];
-		content["Hop Pattern"] = (uint)data[3];
-		content["Hop Index"] = (uint)data[4];
+		content["Dwell Time"] = (uint64_t) (data.at(0) * 256 + data.at(1));
+		content["Hop Set"] = (uint)data.at(2);
+		content["Hop Pattern"] = (uint)data.at(3);
+		content["Hop Index"] = (uint)data.at(4);
 		new_ie["name"]="FH Params";
 		new_ie["content"]=content;
 		new_ie["type"]=WLAN_EID_FH_PARAMS;
@@ -821,7 +844,7 @@ namespace OpenWifi {
 	inline nlohmann::json WFS_WLAN_EID_DS_PARAMS(const std::vector<unsigned char> &data) {
 		nlohmann::json 	new_ie;
 		nlohmann::json 	content;
-		content["current_channel"] = (uint64_t) data[0];
+		content["current_channel"] = (uint64_t) data.at(0);
 		new_ie["name"]="DS Params";
 		new_ie["content"]=content;
 		new_ie["type"]=WLAN_EID_DS_PARAMS;
@@ -834,13 +857,13 @@ namespace OpenWifi {
 		nlohmann::json 	content;
 		if(data.size()>=4) {
 			uint offset=0;
-			content["DTIM count"] = (uint64_t)data[offset++];
-			content["DTIM period"] = (uint64_t)data[offset++];
-			content["Bitmap control"]["Multicast"] = (uint)data[offset] & 0x01;
-			content["Bitmap control"]["Bitmap Offset"] = (uint)(data[offset] & 0xFe) >> 1;
+			content["DTIM count"] = (uint64_t)data.at(offset++);
+			content["DTIM period"] = (uint64_t)data.at(offset++);
+			content["Bitmap control"]["Multicast"] = (uint)data.at(offset) & 0x01;
+			content["Bitmap control"]["Bitmap Offset"] = (uint)(data.at(offset) & 0xFe) >> 1;
 			offset++;
 			if(offset<data.size()) {
-				content["Bitmap control"]["Partial Virtual Bitmap"] = BufferToHex( &data[offset], data.size()-offset);
+				content["Bitmap control"]["Partial Virtual Bitmap"] = BufferToHex( data.data()+offset, data.size()-offset);
 			}
 		}
 		new_ie["name"]="Traffic Indication Map (TIM)";
@@ -852,25 +875,28 @@ namespace OpenWifi {
 	// 0x07
 	inline nlohmann::json WFS_WLAN_EID_COUNTRY(const std::vector<unsigned char> &data) {
 		nlohmann::json new_ie;
+		//	the code goes out as JSON text, anything but printable ASCII would make the whole result unprintable
 		std::string CountryName;
-		CountryName += (char)data[0];
-		CountryName += (char)data[1];
+		for(std::size_t i=0;i<2;i++) {
+			auto c = data.at(i);
+			CountryName += (c>=0x20 && c<0x7f) ? (char)c : '?';
+		}
 		nlohmann::json content;
 
 		content["Code"] = CountryName;
-		content["Environment"] = VALS(environment_vals,data[2]);
+		content["Environment"] = VALS(environment_vals,data.at(2));
 		nlohmann::json ie_data;
 		nlohmann::json constraints = nlohmann::json::array();
 		for (std::size_t i = 3; (i+3)<= data.size(); i += 3) {
 			nlohmann::json constraint;
-			if(data[i]<=200) {
-				constraint["Country Info"]["First Channel Number"] = (uint64_t)data[i+0];
-				constraint["Country Info"]["Number of Channels"] = (uint64_t)data[i+1];
-				constraint["Country Info"]["Maximum Transmit Power Level (in dBm)"] = (uint64_t)data[i+2];
+			if(data.at(i)<=200) {
+				constraint["Country Info"]["First Channel Number"] = (uint64_t)data.at(i+0);
+				constraint["Country Info"]["Number of Channels"] = (uint64_t)data.at(i+1);
+				constraint["Country Info"]["Maximum Transmit Power Level (in dBm)"] = (uint64_t)data.at(i+2);
 			} else {
-				constraint["Country Info"]["Regulatory Extension Identifier"] = (uint64_t)data[i+0];
-				constraint["Country Info"]["Regulatory Class"] = (uint64_t)data[i+1];
-				constraint["Country Info"]["Coverage Class"] = (uint64_t)data[i+2];
+				constraint["Country Info"]["Regulatory Extension Identifier"] = (uint64_t)data.at(i+0);
+				constraint["Country Info"]["Regulatory Class"] = (uint64_t)data.at(i+1);
+				constraint["Country Info"]["Coverage Class"] = (uint64_t)data.at(i+2);
 			}
 			constraints.push_back(constraint);
 		}
@@ -887,14 +913,14 @@ namespace OpenWifi {
 		nlohmann::json 	content;
 		if(data.size()==4) {
 			content["Cisco QBSS Version 1 - non CCA"]["QBSS Version"] = 1;
-			content["Cisco QBSS Version 1 - non CCA"]["Station Count"] = (uint)( data[2] + data[1]*256);
-			content["Cisco QBSS Version 1 - non CCA"]["Channel Utilization"] = (uint) data[3];
-			content["Cisco QBSS Version 1 - non CCA"]["Available Admission Capabilities"] = (uint) data[4];
+			content["Cisco QBSS Version 1 - non CCA"]["Station Count"] = (uint)( data.at(0) + data.at(1)*256);
+			content["Cisco QBSS Version 1 - non CCA"]["Channel Utilization"] = (uint) data.at(2);
+			content["Cisco QBSS Version 1 - non CCA"]["Available Admission Capabilities"] = (uint) data.at(3);
 		} else if(data.size()==5) {
 			content["802.11e CCA Version"]["QBSS Version"] = 2;
-			content["802.11e CCA Version"]["Station Count"] = (uint)( data[2] + data[1]*256);
-			content["802.11e CCA Version"]["Channel Utilization"] = (uint) data[3];
-			content["802.11e CCA Version"]["Available Admission Capabilities"] = (uint) data[4] + data[5]*256;
+			content["802.11e CCA Version"]["Station Count"] = (uint)( data.at(0) + data.at(1)*256);
+			content["802.11e CCA Version"]["Channel Utilization"] = (uint) data.at(2);
+			content["802.11e CCA Version"]["Available Admission Capabilities"] = (uint) data.at(3) + data.at(4)*256;
 		}
 		new_ie["name"]="QBSS Load";
 		new_ie["content"]=content;
@@ -905,7 +931,7 @@ namespace OpenWifi {
 	inline nlohmann::json WFS_WLAN_EID_PWR_CONSTRAINT(const std::vector<unsigned char> &data) {
 		nlohmann::json 	new_ie;
 		nlohmann::json 	content;
-		content["Local Power Constraint"] = (uint) data[0];
+		content["Local Power Constraint"] = (uint) data.at(0);
 		new_ie["name"]="Local Power Constraint";
 		new_ie["content"]=content;
 		new_ie["type"]=WLAN_EID_PWR_CONSTRAINT;
@@ -915,9 +941,9 @@ namespace OpenWifi {
 	inline nlohmann::json WFS_WLAN_EID_ERP_INFO(const std::vector<unsigned char> &data) {
 		nlohmann::json 	new_ie;
 		nlohmann::json 	content;
-		content["Non ERP Present"] = bitSet(data[0],0);
-		content["Use Protection"] = bitSet(data[0],1);
-		content["Barker Preamble Mode"] = bitSet(data[0],2);
+		content["Non ERP Present"] = bitSet(data.at(0),0);
+		content["Use Protection"] = bitSet(data.at(0),1);
+		content["Barker Preamble Mode"] = bitSet(data.at(0),2);
 		new_ie["name"]="ERP Information";
 		new_ie["content"]=content;
 		new_ie["type"]=WLAN_EID_ERP_INFO;
@@ -928,8 +954,8 @@ namespace OpenWifi {
 		nlohmann::json 	new_ie;
 		nlohmann::json 	content;
 		if(data.size()==2) {
-			content["Transmit Power"] = (uint) data[0];
-			content["Link Margin"] = (uint) data[1];
+			content["Transmit Power"] = (uint) data.at(0);
+			content["Link Margin"] = (uint) data.at(1);
 		}
 		new_ie["name"]="TPC Report";
 		new_ie["content"]=content;
@@ -941,12 +967,12 @@ namespace OpenWifi {
 		nlohmann::json 	new_ie;
 		nlohmann::json 	content;
 		if(data.size()>=2) {
-			content["Current Regulatory Class"]= (uint) data[0];
+			content["Current Regulatory Class"]= (uint) data.at(0);
 			std::string alternates;
 			for(uint i=1;i<data.size();++i) {
 				if(!alternates.empty())
 					alternates += ", ";
-				alternates += std::to_string((uint)data[i]);
+				alternates += std::to_string((uint)data.at(i));
 			}
 			content["Alternate Regulatory Classes"] = alternates;
 		}
@@ -963,7 +989,7 @@ namespace OpenWifi {
 		content["MCS Set"]["Rx Bitmask Bits 24-31"] = bitString(data[3]);
 	}
 
-	void dissect_ht_capability_ie(const unsigned char *data,uint size, nlohmann::json & content) {
+	inline void dissect_ht_capability_ie(const unsigned char *data,uint size, nlohmann::json & content) {
 		if(size==26) {
 			uint offset = 0 ;
 			uint16_t ht_caps = data[offset+1] * 256 + data[offset];
@@ -997,7 +1023,7 @@ namespace OpenWifi {
 			content["HT Extended Capabilities"]["Reverse Direction Responder"] = (data[offset] & 0x08) >> 3;
 			offset++;
 
-			uint32_t caps = data[offset] + data[offset+1]*256 + data[offset+2] * 256 * 256 + data[offset+3] * 256 * 256 * 256 ;
+			uint32_t caps = data[offset] + data[offset+1]*256 + data[offset+2] * 256 * 256 + (uint32_t) data[offset+3] * 256 * 256 * 256 ;
 
 			content["Transmit Beam Forming (TxBF) Capabilities"]["Transmit Beamforming"] = (caps & 0x00000001) >> 0;
 			content["Transmit Beam Forming (TxBF) Capabilities"]["Receive Staggered Sounding"] = (caps & 0x00000002) >> 1;
@@ -1032,7 +1058,7 @@ namespace OpenWifi {
 
 	}
 
-	void dissect_ht_info_ie_1_0(const unsigned char *data, uint size, nlohmann::json & content)
+	inline void dissect_ht_info_ie_1_0(const unsigned char *data, uint size, nlohmann::json & content)
 	{
 		if (size != 22) {
 			return;
@@ -1066,7 +1092,7 @@ namespace OpenWifi {
 		nlohmann::json 	content;
 
 		if(data.size()==26) {
-			dissect_ht_capability_ie(&data[0],data.size(),content);
+			dissect_ht_capability_ie(&data.at(0),data.size(),content);
 		}
 
 		new_ie["name"]="HT Capabilities";
@@ -1098,20 +1124,20 @@ namespace OpenWifi {
 		nlohmann::json 	content;
 
 		if(data.size()>=2 && data.size()<=5) {
-			auto len = data[0];
+			uint len = std::min((uint) (data.at(0) & 0x07), (uint) data.size()-2);
 			for(uint i=0;i<=len;i++) {
 				switch(i) {
 				case 0:
-					content["Tx Pwr Info"]["Local Max Tx Pwr Constraint 20MHz"] = (uint16_t) data[i+1];
+					content["Tx Pwr Info"]["Local Max Tx Pwr Constraint 20MHz"] = (uint16_t) data.at(i+1);
 					break;
 				case 1:
-					content["Tx Pwr Info"]["Local Max Tx Pwr Constraint 40MHz"] = (uint16_t) data[i+1];
+					content["Tx Pwr Info"]["Local Max Tx Pwr Constraint 40MHz"] = (uint16_t) data.at(i+1);
 					break;
 				case 2:
-					content["Tx Pwr Info"]["Local Max Tx Pwr Constraint 80MHz"] = (uint16_t) data[i+1];
+					content["Tx Pwr Info"]["Local Max Tx Pwr Constraint 80MHz"] = (uint16_t) data.at(i+1);
 					break;
 				case 3:
-					content["Tx Pwr Info"]["Local Max Tx Pwr Constraint 160MHz/80+80 MHz"] = (uint16_t) data[i+1];
+					content["Tx Pwr Info"]["Local Max Tx Pwr Constraint 160MHz/80+80 MHz"] = (uint16_t) data.at(i+1);
 					break;
 				default:
 					content["Tx Pwr Info"]["Local Max Tx Pwr Constraint 160MHz/80+80 MHz"] = (uint16_t) 0xff;
@@ -1130,7 +1156,7 @@ namespace OpenWifi {
 
 		if(data.size()==12) {
 			uint offset=0;
-			uint caps = data[offset] + data[offset+1]* 256 + data[offset+2]*256*256 + data[offset+3]*256*256*256;
+			uint caps = data.at(offset) + data.at(offset+1)* 256 + data.at(offset+2)*256*256 + (uint32_t) data.at(offset+3)*256*256*256;
 
 			content["VHT Capabilities Info"]["Maximum MPDU Length"] = VALS(vht_max_mpdu_length_flag, (caps & 0x00000003) >> 0 );
 			content["VHT Capabilities Info"]["Supported Channel Width Set"] = VALS(vht_supported_chan_width_set_flag, (caps & 0x0000000c) >> 2 );
@@ -1156,7 +1182,7 @@ namespace OpenWifi {
 			content["VHT Capabilities Info"]["Rx Antenna Pattern Consistency"] = (caps & 0x10000000) >> 28;
 			content["VHT Capabilities Info"]["Tx Antenna Pattern Consistency"] = (caps & 0x20000000) >> 29;
 			offset += 4;
-			ParseMCSset(&data[offset],content);
+			ParseMCSset(&data.at(offset),content);
 		}
 
 		new_ie["name"]="VHT Capabilities Info";
@@ -1171,7 +1197,7 @@ namespace OpenWifi {
 
 		if(data.size()==5) {
 			uint offset=0;
-			uint caps = data[offset++];
+			uint caps = data.at(offset++);
 			content["RM Capabilities"]["Link Measurement"] = (caps & 0x00000001) >> 0;
 			content["RM Capabilities"]["Neighbor Report"] = (caps & 0x00000002) >> 1;
 			content["RM Capabilities"]["Parallel Measurements"] = (caps & 0x00000004) >> 2;
@@ -1181,7 +1207,7 @@ namespace OpenWifi {
 			content["RM Capabilities"]["Beacon Table Measurement"] = (caps & 0x00000040) >> 6;
 			content["RM Capabilities"]["Beacon Measurement Reporting Conditions"] = (caps & 0x00000080) >> 7;
 
-			caps = data[offset++];
+			caps = data.at(offset++);
 			content["RM Capabilities"]["Frame Measurement"] = (caps & 0x00000001) >> 0;
 			content["RM Capabilities"]["Channel Load Measurement"] = (caps & 0x00000002) >> 1;
 			content["RM Capabilities"]["Noise Histogram Measurement"] = (caps & 0x00000004) >> 2;
@@ -1191,13 +1217,13 @@ namespace OpenWifi {
 			content["RM Capabilities"]["Transmit Stream/Category Measurement"] = (caps & 0x00000040) >> 6;
 			content["RM Capabilities"]["Triggered Transmit Stream/Category Measurement"] = (caps & 0x00000080) >> 7;
 
-			caps = data[offset++];
+			caps = data.at(offset++);
 			content["RM Capabilities"]["AP Channel Report capability"] = (caps & 0x00000007) >> 0;
 			content["RM Capabilities"]["RM MIB capability"] = (caps & 0x00000002) >> 1;
 			content["RM Capabilities"]["Operating Channel Max Measurement Duration"] = (caps & 0x0000001c) >> 2;
 			content["RM Capabilities"]["Nonoperating Channel Max Measurement Duration"] = (caps & 0x000000e0) >> 5;
 
-			caps = data[offset++];
+			caps = data.at(offset++);
 			content["RM Capabilities"]["Measurement Pilotcapability"] = (caps & 0x00000007) >> 0;
 			content["RM Capabilities"]["RM MIB capability"] = (caps & 0x00000008) >> 3;
 			content["RM Capabilities"]["Neighbor Report TSF Offset"] = (caps & 0x00000010) >> 4;
@@ -1205,7 +1231,7 @@ namespace OpenWifi {
 			content["RM Capabilities"]["RSNI Measurement capability"] = (caps & 0x00000040) >> 6;
 			content["RM Capabilities"]["BSS Average Access Delay capability"] = (caps & 0x00000080) >> 7;
 
-			caps = data[offset];
+			caps = data.at(offset);
 			content["RM Capabilities"]["BSS Available Admission Capacity capability"] = (caps & 0x00000001) >> 0;
 			content["RM Capabilities"]["Antenna capability"] = (caps & 0x00000002) >> 1;
 		}
@@ -1222,76 +1248,76 @@ namespace OpenWifi {
 
 		if(data.size()>=1) {
 			uint offset=0;
-			content["Extended Capabilities"]["20/40 BSS Coexistence Management Support"] = (data[offset] & 0x01) >> 0;
-			content["Extended Capabilities"]["On-demand beacon"] = (data[offset] & 0x02) >> 1;
-			content["Extended Capabilities"]["Extended Channel Switching"] = (data[offset] & 0x04) >> 2;
-			content["Extended Capabilities"]["WAVE indication"] = (data[offset] & 0x08) >> 3;
-			content["Extended Capabilities"]["PSMP Capability"] = (data[offset] & 0x10) >> 4;
-			content["Extended Capabilities"]["Reserved"] = (data[offset] & 0x20) >> 5;
-			content["Extended Capabilities"]["S-PSMP Support"] = (data[offset] & 0x40) >> 6;
-			content["Extended Capabilities"]["Event"] = (data[offset] & 0x80) >> 7;
+			content["Extended Capabilities"]["20/40 BSS Coexistence Management Support"] = (data.at(offset) & 0x01) >> 0;
+			content["Extended Capabilities"]["On-demand beacon"] = (data.at(offset) & 0x02) >> 1;
+			content["Extended Capabilities"]["Extended Channel Switching"] = (data.at(offset) & 0x04) >> 2;
+			content["Extended Capabilities"]["WAVE indication"] = (data.at(offset) & 0x08) >> 3;
+			content["Extended Capabilities"]["PSMP Capability"] = (data.at(offset) & 0x10) >> 4;
+			content["Extended Capabilities"]["Reserved"] = (data.at(offset) & 0x20) >> 5;
+			content["Extended Capabilities"]["S-PSMP Support"] = (data.at(offset) & 0x40) >> 6;
+			content["Extended Capabilities"]["Event"] = (data.at(offset) & 0x80) >> 7;
 
 			offset++;
 			if(offset<data.size()) {
-				content["Extended Capabilities"]["Diagnostics"] = (data[offset] & 0x01) >> 0;
-				content["Extended Capabilities"]["Multicast Diagnostics"] = (data[offset] & 0x02) >> 1;
-				content["Extended Capabilities"]["Location Tracking"] = (data[offset] & 0x04) >> 2;
-				content["Extended Capabilities"]["FMS"] = (data[offset] & 0x08) >> 3;
-				content["Extended Capabilities"]["Proxy ARP Service"] = (data[offset] & 0x10) >> 4;
-				content["Extended Capabilities"]["Collocated Interference Reporting"] = (data[offset] & 0x20) >> 5;
-				content["Extended Capabilities"]["Civic Location"] = (data[offset] & 0x40) >> 6;
-				content["Extended Capabilities"]["Geospatial Location"] = (data[offset] & 0x80) >> 7;
+				content["Extended Capabilities"]["Diagnostics"] = (data.at(offset) & 0x01) >> 0;
+				content["Extended Capabilities"]["Multicast Diagnostics"] = (data.at(offset) & 0x02) >> 1;
+				content["Extended Capabilities"]["Location Tracking"] = (data.at(offset) & 0x04) >> 2;
+				content["Extended Capabilities"]["FMS"] = (data.at(offset) & 0x08) >> 3;
+				content["Extended Capabilities"]["Proxy ARP Service"] = (data.at(offset) & 0x10) >> 4;
+				content["Extended Capabilities"]["Collocated Interference Reporting"] = (data.at(offset) & 0x20) >> 5;
+				content["Extended Capabilities"]["Civic Location"] = (data.at(offset) & 0x40) >> 6;
+				content["Extended Capabilities"]["Geospatial Location"] = (data.at(offset) & 0x80) >> 7;
 			}
 
 			offset++;
 			if(offset<data.size()) {
-				content["Extended Capabilities"]["TFS"] = (data[offset] & 0x01) >> 0;
-				content["Extended Capabilities"]["WNM-Sleep Mode"] = (data[offset] & 0x02) >> 1;
-				content["Extended Capabilities"]["TIM Broadcast"] = (data[offset] & 0x04) >> 2;
-				content["Extended Capabilities"]["BSS Transition"] = (data[offset] & 0x08) >> 3;
-				content["Extended Capabilities"]["QoS Traffic Capability"] = (data[offset] & 0x10) >> 4;
-				content["Extended Capabilities"]["AC Station Count"] = (data[offset] & 0x20) >> 5;
-				content["Extended Capabilities"]["Multiple BSSID"] = (data[offset] & 0x40) >> 6;
-				content["Extended Capabilities"]["Timing Measurement"] = (data[offset] & 0x80) >> 7;
+				content["Extended Capabilities"]["TFS"] = (data.at(offset) & 0x01) >> 0;
+				content["Extended Capabilities"]["WNM-Sleep Mode"] = (data.at(offset) & 0x02) >> 1;
+				content["Extended Capabilities"]["TIM Broadcast"] = (data.at(offset) & 0x04) >> 2;
+				content["Extended Capabilities"]["BSS Transition"] = (data.at(offset) & 0x08) >> 3;
+				content["Extended Capabilities"]["QoS Traffic Capability"] = (data.at(offset) & 0x10) >> 4;
+				content["Extended Capabilities"]["AC Station Count"] = (data.at(offset) & 0x20) >> 5;
+				content["Extended Capabilities"]["Multiple BSSID"] = (data.at(offset) & 0x40) >> 6;
+				content["Extended Capabilities"]["Timing Measurement"] = (data.at(offset) & 0x80) >> 7;
 			}
 
 			offset++;
 			if(offset<data.size()) {
-				content["Extended Capabilities"]["Channel Usage"] = (data[offset] & 0x01) >> 0;
-				content["Extended Capabilities"]["SSID List"] = (data[offset] & 0x02) >> 1;
-				content["Extended Capabilities"]["DMS"] = (data[offset] & 0x04) >> 2;
-				content["Extended Capabilities"]["UTC TSF Offset"] = (data[offset] & 0x08) >> 3;
-				content["Extended Capabilities"]["Peer U-APSD Buffer STA Support"] = (data[offset] & 0x10) >> 4;
-				content["Extended Capabilities"]["TDLS Peer PSM Support"] = (data[offset] & 0x20) >> 5;
-				content["Extended Capabilities"]["TDLS channel switching"] = (data[offset] & 0x40) >> 6;
-				content["Extended Capabilities"]["Interworking"] = (data[offset] & 0x80) >> 7;
+				content["Extended Capabilities"]["Channel Usage"] = (data.at(offset) & 0x01) >> 0;
+				content["Extended Capabilities"]["SSID List"] = (data.at(offset) & 0x02) >> 1;
+				content["Extended Capabilities"]["DMS"] = (data.at(offset) & 0x04) >> 2;
+				content["Extended Capabilities"]["UTC TSF Offset"] = (data.at(offset) & 0x08) >> 3;
+				content["Extended Capabilities"]["Peer U-APSD Buffer STA Support"] = (data.at(offset) & 0x10) >> 4;
+				content["Extended Capabilities"]["TDLS Peer PSM Support"] = (data.at(offset) & 0x20) >> 5;
+				content["Extended Capabilities"]["TDLS channel switching"] = (data.at(offset) & 0x40) >> 6;
+				content["Extended Capabilities"]["Interworking"] = (data.at(offset) & 0x80) >> 7;
 			}
 
 			offset++;
 			if(offset<data.size()) {
-				content["Extended Capabilities"]["QoS Map"] = (data[offset] & 0x01) >> 0;
-				content["Extended Capabilities"]["EBR"] = (data[offset] & 0x02) >> 1;
-				content["Extended Capabilities"]["SSPN Interface"] = (data[offset] & 0x04) >> 2;
-				content["Extended Capabilities"]["Reserved"] = (data[offset] & 0x08) >> 3;
-				content["Extended Capabilities"]["MSGCF Capability"] = (data[offset] & 0x10) >> 4;
-				content["Extended Capabilities"]["TDLS support"] = (data[offset] & 0x20) >> 5;
-				content["Extended Capabilities"]["TDLS Prohibited"] = (data[offset] & 0x40) >> 6;
-				content["Extended Capabilities"]["TDLS Channel Switching Prohibited"] = (data[offset] & 0x80) >> 7;
+				content["Extended Capabilities"]["QoS Map"] = (data.at(offset) & 0x01) >> 0;
+				content["Extended Capabilities"]["EBR"] = (data.at(offset) & 0x02) >> 1;
+				content["Extended Capabilities"]["SSPN Interface"] = (data.at(offset) & 0x04) >> 2;
+				content["Extended Capabilities"]["Reserved"] = (data.at(offset) & 0x08) >> 3;
+				content["Extended Capabilities"]["MSGCF Capability"] = (data.at(offset) & 0x10) >> 4;
+				content["Extended Capabilities"]["TDLS support"] = (data.at(offset) & 0x20) >> 5;
+				content["Extended Capabilities"]["TDLS Prohibited"] = (data.at(offset) & 0x40) >> 6;
+				content["Extended Capabilities"]["TDLS Channel Switching Prohibited"] = (data.at(offset) & 0x80) >> 7;
 			}
 
 			offset++;
 			if(offset<data.size()) {
-				content["Extended Capabilities"]["Reject Unadmitted Frame"] = (data[offset] & 0x01) >> 0;
-				content["Extended Capabilities"]["Service Interval Granularity"] = VALS(service_interval_granularity_vals,(data[offset] & 0x0e) >> 1);
-				content["Extended Capabilities"]["Identifier Location"] = (data[offset] & 0x10) >> 4;
-				content["Extended Capabilities"]["U-APSD Coexistence"] = (data[offset] & 0x20) >> 5;
-				content["Extended Capabilities"]["WNM-Notification"] = (data[offset] & 0x40) >> 6;
-				content["Extended Capabilities"]["Reserved"] = (data[offset] & 0x80) >> 7;
+				content["Extended Capabilities"]["Reject Unadmitted Frame"] = (data.at(offset) & 0x01) >> 0;
+				content["Extended Capabilities"]["Service Interval Granularity"] = VALS(service_interval_granularity_vals,(data.at(offset) & 0x0e) >> 1);
+				content["Extended Capabilities"]["Identifier Location"] = (data.at(offset) & 0x10) >> 4;
+				content["Extended Capabilities"]["U-APSD Coexistence"] = (data.at(offset) & 0x20) >> 5;
+				content["Extended Capabilities"]["WNM-Notification"] = (data.at(offset) & 0x40) >> 6;
+				content["Extended Capabilities"]["Reserved"] = (data.at(offset) & 0x80) >> 7;
 			}
 
 			offset++;
 			if(offset<data.size()) {
-				content["Extended Capabilities"]["UTF-8 SSID"] = (data[offset] & 0x01) >> 0;
+				content["Extended Capabilities"]["UTF-8 SSID"] = (data.at(offset) & 0x01) >> 0;
 			}
 		}
 
@@ -1308,28 +1334,28 @@ namespace OpenWifi {
 		// 01 00 00 0f ac 04 01 00 00 0f ac 04 02 00 00 0f ac 02 00 0f ac 06 8c 00
 
 		uint offset = 0 ;
-		content["RSN Version"] = GetUInt16(&data[0],offset);
-		auto RSNOUI = GetUInt24Big(&data[0],offset);
-		content["Group Cipher Suite OUI"] = BufferToHex(&data[offset-3],3,':');
+		content["RSN Version"] = GetUInt16(data,offset);
+		auto RSNOUI = GetUInt24Big(data,offset);
+		content["Group Cipher Suite OUI"] = BufferToHex(&data.at(offset-3),3,':');
 		if(RSNOUI==OUI_RSN) {
-			content["Group Cipher Suite type"] = VALS(ieee80211_rsn_cipher_vals,data[offset++]);
+			content["Group Cipher Suite type"] = VALS(ieee80211_rsn_cipher_vals,data.at(offset++));
 		} else {
-			content["Group Cipher Suite type"] = BufferToHex(&data[offset++],1);
+			content["Group Cipher Suite type"] = BufferToHex(&data.at(offset++),1);
 		}
 		if(offset<data.size()) {
-			auto pcsc = GetUInt16(&data[0], offset);
+			auto pcsc = GetUInt16(data,offset);
 			content["Pairwise Cipher Suite Count"] = pcsc;
 			if (offset + pcsc * 4 <= data.size()) {
 				nlohmann::json suites = nlohmann::json::array();
 				while (pcsc) {
 					nlohmann::json entry;
-					RSNOUI = GetUInt24Big(&data[0], offset);
-					entry["Group Cipher Suite OUI"] = BufferToHex(&data[offset - 3], 3, ':');
+					RSNOUI = GetUInt24Big(data,offset);
+					entry["Group Cipher Suite OUI"] = BufferToHex(&data.at(offset - 3), 3, ':');
 					if (RSNOUI == OUI_RSN) {
 						entry["Group Cipher Suite type"] =
-							VALS(ieee80211_rsn_cipher_vals, data[offset++]);
+							VALS(ieee80211_rsn_cipher_vals, data.at(offset++));
 					} else {
-						entry["Group Cipher Suite type"] = BufferToHex(&data[offset++], 1);
+						entry["Group Cipher Suite type"] = BufferToHex(&data.at(offset++), 1);
 					}
 					suites.push_back(entry);
 					pcsc--;
@@ -1339,18 +1365,18 @@ namespace OpenWifi {
 		}
 
 		if(offset<data.size()) {
-			auto akms_count = GetUInt16(&data[0],offset);
+			auto akms_count = GetUInt16(data,offset);
 			content["Auth Key Management (AKM) Suite Count"] = akms_count;
 			if(offset+akms_count*4<=data.size()) {
 				nlohmann::json suites=nlohmann::json::array();
 				while(akms_count) {
 					nlohmann::json entry;
-					RSNOUI = GetUInt24Big(&data[0],offset);
-					entry["Auth Key Management (AKM) OUI"] = BufferToHex(&data[offset-3],3,':');
+					RSNOUI = GetUInt24Big(data,offset);
+					entry["Auth Key Management (AKM) OUI"] = BufferToHex(&data.at(offset-3),3,':');
 					if(RSNOUI==OUI_RSN) {
-						entry["Auth Key Management (AKM) type"] = VALS(ieee80211_rsn_keymgmt_vals,data[offset++]);
+						entry["Auth Key Management (AKM) type"] = VALS(ieee80211_rsn_keymgmt_vals,data.at(offset++));
 					} else {
-						entry["Auth Key Management (AKM) type"] = BufferToHex(&data[offset++],1);
+						entry["Auth Key Management (AKM) type"] = BufferToHex(&data.at(offset++),1);
 					}
 					suites.push_back(entry);
 					akms_count--;
@@ -1360,7 +1386,7 @@ namespace OpenWifi {
 		}
 
 		if(offset+2<=data.size()) {
-			auto rsn_cap = GetUInt16(&data[0], offset);
+			auto rsn_cap = GetUInt16(data,offset);
 			content["RSN Capabilities"]["RSN Pre-Auth capabilities"] = (rsn_cap & 0x0001) >> 0;
 			content["RSN Capabilities"]["RSN No Pairwise capabilities"] = (rsn_cap & 0x0002) >> 1;
 
@@ -1376,13 +1402,13 @@ namespace OpenWifi {
 		}
 
 		if(offset+2<=data.size()) {
-			auto pmkid_count = GetUInt16(&data[0],offset);
+			auto pmkid_count = GetUInt16(data,offset);
 			content["PMKID Count"] = pmkid_count;
 			if(offset+pmkid_count*16<=data.size()) {
 				nlohmann::json list=nlohmann::json::array();
 				while(pmkid_count) {
 					nlohmann::json entry;
-					entry["PMKID"] = BufferToHex(&data[offset],16);
+					entry["PMKID"] = BufferToHex(&data.at(offset),16);
 					list.push_back(entry);
 					pmkid_count--;
 					offset+=16;
@@ -1392,12 +1418,12 @@ namespace OpenWifi {
 		}
 
 		if(offset+4<=data.size()) {
-			RSNOUI = GetUInt24Big(&data[0],offset);
-			content["Group Management Cipher Suite"]["Group Management Cipher Suite OUI"] = BufferToHex(&data[offset-3],3,':');
+			RSNOUI = GetUInt24Big(data,offset);
+			content["Group Management Cipher Suite"]["Group Management Cipher Suite OUI"] = BufferToHex(&data.at(offset-3),3,':');
 			if(RSNOUI==OUI_RSN) {
-				content["Group Management Cipher Suite"]["Group Management Cipher Suite type"] = VALS(ieee80211_rsn_cipher_vals,data[offset++]);
+				content["Group Management Cipher Suite"]["Group Management Cipher Suite type"] = VALS(ieee80211_rsn_cipher_vals,data.at(offset++));
 			} else {
-				content["Group Management Cipher Suite"]["Group Management Cipher Suite type"] = BufferToHex(&data[offset++],1);
+				content["Group Management Cipher Suite"]["Group Management Cipher Suite type"] = BufferToHex(&data.at(offset++),1);
 			}
 		}
 
@@ -1408,13 +1434,14 @@ namespace OpenWifi {
 	}
 
 	inline nlohmann::json
-	dissect_qos_info(const unsigned char *b,uint l)
+	dissect_qos_info(const std::vector<unsigned char> &d, uint offset)
 	{
 		nlohmann::json content;
 
-		if(l<1)
+		if(offset>=d.size())
 			return content;
 
+		auto b = d[offset];
 		auto ftype = MGT_PROBE_REQ;
 
 		switch (ftype) {
@@ -1423,11 +1450,11 @@ namespace OpenWifi {
 			case MGT_REASSOC_REQ:
 			{
 				/* To AP so decode as per WMM standard Figure 7 QoS Info field when sent from WMM STA*/
-				content["WME QoS Info"]["Max SP Length"] = VALS(ieee802111_wfa_ie_wme_qos_info_sta_max_sp_length_vals,(*b & 0x60) >> 5);
-				content["WME QoS Info"]["AC_BE"] = (*b & 0x08) >> 3;
-				content["WME QoS Info"]["AC_BK"] = (*b & 0x04) >> 2;
-				content["WME QoS Info"]["AC_VI"] = (*b & 0x02) >> 1;
-				content["WME QoS Info"]["AC_VO"] = (*b & 0x01) >> 0;
+				content["WME QoS Info"]["Max SP Length"] = VALS(ieee802111_wfa_ie_wme_qos_info_sta_max_sp_length_vals,(b & 0x60) >> 5);
+				content["WME QoS Info"]["AC_BE"] = (b & 0x08) >> 3;
+				content["WME QoS Info"]["AC_BK"] = (b & 0x04) >> 2;
+				content["WME QoS Info"]["AC_VI"] = (b & 0x02) >> 1;
+				content["WME QoS Info"]["AC_VO"] = (b & 0x01) >> 0;
 				break;
 			}
 			case MGT_BEACON:
@@ -1436,8 +1463,8 @@ namespace OpenWifi {
 			case MGT_REASSOC_RESP:
 			{
 				/* From AP so decode as per WMM standard Figure 6 QoS Info field when sent from WMM AP */
-				content["WME QoS Info"]["U-APSD"] = (*b & 0x80) >> 4;
-				content["WME QoS Info"]["Parameter Set Count"] = (*b & 0x0f) >> 0;
+				content["WME QoS Info"]["U-APSD"] = (b & 0x80) >> 4;
+				content["WME QoS Info"]["Parameter Set Count"] = (b & 0x0f) >> 0;
 				break;
 			}
 			default:
@@ -1447,113 +1474,117 @@ namespace OpenWifi {
 		return content;
 	}
 
-	inline nlohmann::json dissect_vendor_ie_wpawme(const unsigned char *b, uint l) {
+	//	The vendor dissectors get the IE body after the OUI: d[0] is the vendor type. Every read goes through the
+	//	checked readers, and counts sent by the device are checked against what the IE holds before looping.
+	inline nlohmann::json dissect_vendor_ie_wpawme(const std::vector<unsigned char> &d) {
 		nlohmann::json ie;
 		uint offset=0;
 
-		// ie["dump"] = BufferToHex(b,l);
-
 		ie["vendor"] = "Wi-Fi : WPA / WME";
-		auto type = b[0];
+		IERequire(d, offset, 1);
+		auto type = d[offset++];
 		ie["type"] = VALS(ieee802111_wfa_ie_type_vals,type);
-		offset++;
 
-		if(offset<l) {
+		if(offset<d.size()) {
 			switch (type) {
 			case 1: {
-				ie["WPA Version"] = GetUInt16(b, offset);
-				auto OUI = GetUInt24Big(b, offset);
+				ie["WPA Version"] = GetUInt16(d, offset);
+				auto OUI = GetUInt24Big(d, offset);
+				IERequire(d, offset, 1);
 				if (OUI == OUI_WPAWME)
 					ie["Multicast Cipher Suite type"] =
-						VALS(ieee80211_wfa_ie_wpa_cipher_vals, b[offset++]);
+						VALS(ieee80211_wfa_ie_wpa_cipher_vals, d[offset++]);
 				else
-					ie["Multicast Cipher Suite type"] = BufferToHex(&b[offset++], 1);
-				auto ucs_count = GetUInt16(b, offset);
+					ie["Multicast Cipher Suite type"] = BufferToHex(&d[offset++], 1);
+				auto ucs_count = GetUInt16(d, offset);
 				ie["Unicast Cipher Suite Count"] = ucs_count;
+				IERequire(d, offset, ucs_count * 4u);
 				nlohmann::json list = nlohmann::json::array();
 				while (ucs_count) {
-					OUI = GetUInt24Big(b, offset);
+					OUI = GetUInt24Big(d, offset);
 					nlohmann::json entry;
-					entry["Unicast Cipher Suite OUI"] = BufferToHex(&b[offset - 3], 3);
+					entry["Unicast Cipher Suite OUI"] = BufferToHex(&d[offset - 3], 3);
 					if (OUI == OUI_WPAWME)
 						entry["Unicast Cipher Suite type"] =
-							VALS(ieee80211_wfa_ie_wpa_cipher_vals, b[offset++]);
+							VALS(ieee80211_wfa_ie_wpa_cipher_vals, d[offset++]);
 					else
-						entry["Unicast Cipher Suite type"] = BufferToHex(&b[offset++], 1);
+						entry["Unicast Cipher Suite type"] = BufferToHex(&d[offset++], 1);
 					list.push_back(entry);
 					ucs_count--;
 				}
 				ie["Unicast Cipher Suite List"] = list;
 
-				auto akms_count = GetUInt16(b, offset);
+				auto akms_count = GetUInt16(d, offset);
 				ie["Auth Key Management (AKM) Suite Count"] = akms_count;
+				IERequire(d, offset, akms_count * 4u);
 				nlohmann::json list2 = nlohmann::json::array();
 				while (akms_count) {
-					OUI = GetUInt24Big(b, offset);
+					OUI = GetUInt24Big(d, offset);
 					nlohmann::json entry;
-					entry["Auth Key Management (AKM) OUI"] = BufferToHex(&b[offset - 3], 3);
+					entry["Auth Key Management (AKM) OUI"] = BufferToHex(&d[offset - 3], 3);
 					if (OUI == OUI_WPAWME)
 						entry["Auth Key Management (AKM) type"] =
-							VALS(ieee80211_wfa_ie_wpa_keymgmt_vals, b[offset++]);
+							VALS(ieee80211_wfa_ie_wpa_keymgmt_vals, d[offset++]);
 					else
-						entry["Auth Key Management (AKM) type"] = BufferToHex(&b[offset++], 1);
+						entry["Auth Key Management (AKM) type"] = BufferToHex(&d[offset++], 1);
 					list2.push_back(entry);
 					akms_count--;
 				}
-				ie["Unicast Cipher Suite List"] = list2;
+				ie["Auth Key Management (AKM) List"] = list2;
 			} break;
 			case 2: {
-				auto sub_type = b[offset++];
+				IERequire(d, offset, 2);
+				auto sub_type = d[offset++];
 				ie["WME Subtype"] = VALS(ieee802111_wfa_ie_wme_type,sub_type);
-				ie["WME Version"] = (uint) b[offset++];
+				ie["WME Version"] = (uint) d[offset++];
 
 				switch(sub_type) {
 					case 0: {
-							ie["WME QoS Info"] = dissect_qos_info(&b[offset],l-offset);
+							ie["WME QoS Info"] = dissect_qos_info(d,offset);
 						}
 						break;
 					case 1: {
-						ie["WME QoS Info"] = dissect_qos_info(&b[offset],l-offset);
+						ie["WME QoS Info"] = dissect_qos_info(d,offset);
 						offset++;
 						offset++;		// skip reserved...
+						IERequire(d, offset, 4 * 4);
 						nlohmann::json list=nlohmann::json::array();
 						for(uint i=0;i<4;i++) {
 							nlohmann::json entry;
-							entry["ACI"] = VALS(ieee80211_wfa_ie_wme_acs_vals, (b[offset] & 0x60)>>5);
-							entry["Admission Control Mandatory"] = (b[offset] & 0x10) >> 4;
-							entry["AIFSN"] = (b[offset] & 0x0f)>>5;
+							entry["ACI"] = VALS(ieee80211_wfa_ie_wme_acs_vals, (d[offset] & 0x60)>>5);
+							entry["Admission Control Mandatory"] = (d[offset] & 0x10) >> 4;
+							entry["AIFSN"] = (d[offset] & 0x0f)>>0;
 							offset++;
-							entry["ECW Max"] = (b[offset] & 0xf0)>>4;
-							entry["ECW Min"] = (b[offset] & 0x0f)>>0;
+							entry["ECW Max"] = (d[offset] & 0xf0)>>4;
+							entry["ECW Min"] = (d[offset] & 0x0f)>>0;
 							offset++;
-							entry["TXOP Limit"] = b[offset] + b[offset+1]*256;
-							offset+=2;
+							entry["TXOP Limit"] = GetUInt16(d,offset);
 							list.push_back(entry);
 						}
 						ie["Ac Parameters"]["ACI / AIFSN Field"] = list;
 						}
 						break;
 					case 2: {
-						auto tid = GetUInt24(b,offset);
+						auto tid = GetUInt24(d,offset);
 							ie["TS Info"]["TID"] =  (tid & 0x00001E) >> 1;
 							ie["TS Info"]["Direction"] = VALS(ieee80211_wfa_ie_wme_tspec_tsinfo_direction_vals,(tid & 0x000060) >> 5);
 							ie["TS Info"]["PSB"] =  VALS(ieee80211_wfa_ie_wme_tspec_tsinfo_psb_vals, (tid & 0x000400) >> 10);
 							ie["TS Info"]["UP"] =  VALS(ieee80211_wfa_ie_wme_tspec_tsinfo_up_vals,(tid & 0x003800) >> 11);
-							ie["TS Info"]["Normal MSDU Size"] = GetUInt16(b,offset);
-							ie["TS Info"]["Maximum MSDU Size"] = GetUInt16(b,offset);
-							ie["TS Info"]["Minimum Service Interval"] = GetUInt32(b,offset);
-							ie["TS Info"]["Maximum Service Interval"] = GetUInt32(b,offset);
-							ie["TS Info"]["Inactivity Interval"] = GetUInt32(b,offset);
-							ie["TS Info"]["Suspension Interval"] = GetUInt32(b,offset);
-							ie["TS Info"]["Service Start Time"] = GetUInt32(b,offset);
-							ie["TS Info"]["Minimum Data Rate"] = GetUInt32(b,offset);
-							ie["TS Info"]["Mean Data Rate"] = GetUInt32(b,offset);
-							ie["TS Info"]["Peak Data Rate"] = GetUInt32(b,offset);
-							ie["TS Info"]["Burst Size"] = GetUInt32(b,offset);
-							ie["TS Info"]["Delay Bound"] = GetUInt32(b,offset);
-							ie["TS Info"]["Minimum PHY Rate"] = GetUInt32(b,offset);
-							ie["TS Info"]["Surplus Bandwidth Allowance"] = GetUInt16(b,offset);
-							ie["TS Info"]["Medium Time"] = GetUInt16(b,offset);
+							ie["TS Info"]["Normal MSDU Size"] = GetUInt16(d,offset);
+							ie["TS Info"]["Maximum MSDU Size"] = GetUInt16(d,offset);
+							ie["TS Info"]["Minimum Service Interval"] = GetUInt32(d,offset);
+							ie["TS Info"]["Maximum Service Interval"] = GetUInt32(d,offset);
+							ie["TS Info"]["Inactivity Interval"] = GetUInt32(d,offset);
+							ie["TS Info"]["Suspension Interval"] = GetUInt32(d,offset);
+							ie["TS Info"]["Service Start Time"] = GetUInt32(d,offset);
+							ie["TS Info"]["Minimum Data Rate"] = GetUInt32(d,offset);
+							ie["TS Info"]["Mean Data Rate"] = GetUInt32(d,offset);
+							ie["TS Info"]["Peak Data Rate"] = GetUInt32(d,offset);
+							ie["TS Info"]["Burst Size"] = GetUInt32(d,offset);
+							ie["TS Info"]["Delay Bound"] = GetUInt32(d,offset);
+							ie["TS Info"]["Minimum PHY Rate"] = GetUInt32(d,offset);
+							ie["TS Info"]["Surplus Bandwidth Allowance"] = GetUInt16(d,offset);
+							ie["TS Info"]["Medium Time"] = GetUInt16(d,offset);
 						}
 						break;
 					default:
@@ -1562,7 +1593,7 @@ namespace OpenWifi {
 
 			} break;
 			case 4: {
-				ie["TLV Block"] = BufferToHex(&b[offset],l-offset);
+				ie["TLV Block"] = BufferToHex(&d[offset],d.size()-offset);
 			} break;
 			default:
 				break;
@@ -1572,83 +1603,79 @@ namespace OpenWifi {
 		return ie;
 	}
 
-	inline nlohmann::json dissect_vendor_ie_rsn(const unsigned char *b, uint l) {
+	inline nlohmann::json dissect_vendor_ie_rsn(const std::vector<unsigned char> &d) {
 		nlohmann::json ie;
 		ie["vendor"] = "Wi-Fi : RSN";
 
-		switch(b[0]) {
+		IERequire(d, 0, 1);
+		switch(d[0]) {
 		case 4: {
-			ie["RSN PMKID"] = BufferToHex(&b[1],16);
+			IERequire(d, 1, 16);
+			ie["RSN PMKID"] = BufferToHex(&d[1],16);
 		}
 			break;
 		default:
-			ie["RSN Unknown"] = BufferToHex(&b[1],l-1);
+			ie["RSN Unknown"] = BufferToHex(d.data()+1,d.size()-1);
 			break;
 		}
 		return ie;
 	}
 
-	inline nlohmann::json dissect_vendor_ie_ht(const unsigned char *b, uint l) {
+	inline nlohmann::json dissect_vendor_ie_ht(const std::vector<unsigned char> &d) {
 		nlohmann::json ie;
 		ie["vendor"] = "Wi-Fi : 802.11 Pre-N";
-		--l;
-		auto type = b[0];
+		IERequire(d, 0, 1);
+		auto type = d[0];
+		//	both dissectors only decode a body of exactly their size
 		switch(type) {
 		case 51: {
-			dissect_ht_capability_ie(&b[1],l-1,ie);
+			dissect_ht_capability_ie(d.data()+1,d.size()-1,ie);
 		}
 			break;
 		case 52: {
-			dissect_ht_info_ie_1_0(&b[1],l-1,ie);
+			dissect_ht_info_ie_1_0(d.data()+1,d.size()-1,ie);
 		}
 			break;
 		default:
-			ie["802.11n (Pre) Unknown Data"] = BufferToHex(&b[1],l-1);
+			ie["802.11n (Pre) Unknown Data"] = BufferToHex(d.data()+1,d.size()-1);
 			break;
 		}
 		return ie;
 	}
 
-	inline nlohmann::json dissect_vendor_ie_wfa(const unsigned char *b, uint l) {
+	inline nlohmann::json dissect_vendor_ie_wfa([[maybe_unused]] const std::vector<unsigned char> &d) {
 		nlohmann::json ie;
 		ie["vendor"] = "Wi-Fi Alliance";
-
-		b++;l++;
 		return ie;
 	}
 
-	inline nlohmann::json dissect_vendor_ie_aironet(const unsigned char *b, uint l) {
+	inline nlohmann::json dissect_vendor_ie_aironet([[maybe_unused]] const std::vector<unsigned char> &d) {
 		nlohmann::json ie;
 		ie["vendor"] = "Cisco Wireless (Aironet)";
-		b++;l++;
 		return ie;
 	}
 
-	inline nlohmann::json dissect_vendor_ie_marvell(const unsigned char *b, uint l) {
+	inline nlohmann::json dissect_vendor_ie_marvell([[maybe_unused]] const std::vector<unsigned char> &d) {
 		nlohmann::json ie;
 		ie["vendor"] = "Marvell Semiconductor";
-		b++;l++;
 		return ie;
 	}
 
-	inline nlohmann::json dissect_vendor_ie_atheros(const unsigned char *b, uint l) {
+	inline nlohmann::json dissect_vendor_ie_atheros([[maybe_unused]] const std::vector<unsigned char> &d) {
 		nlohmann::json ie;
 		ie["vendor"] = "Atheros Communications";
-		b++;l++;
 		return ie;
 	}
 
-	inline nlohmann::json dissect_vendor_ie_aruba(const unsigned char *b, uint l) {
+	inline nlohmann::json dissect_vendor_ie_aruba([[maybe_unused]] const std::vector<unsigned char> &d) {
 		nlohmann::json ie;
 		ie["vendor"] = "Aruba Networks";
-		b++;l++;
 		return ie;
 	}
 
-	inline nlohmann::json dissect_vendor_ie_nintendo(const unsigned char *b, uint l) {
+	inline nlohmann::json dissect_vendor_ie_nintendo([[maybe_unused]] const std::vector<unsigned char> &d) {
 		nlohmann::json ie;
 		ie["vendor"] = "Nintendo";
-		b++;l++;
 		return ie;
 	}
 
@@ -1656,40 +1683,42 @@ namespace OpenWifi {
 		nlohmann::json 	new_ie;
 		nlohmann::json 	content;
 
-		if(data.size()>=3) {
+		//	3 bytes of OUI and the vendor type
+		if(data.size()>=4) {
 			uint offset=0;
-			auto RSNOUI = GetUInt24Big(&data[0],offset);
+			auto RSNOUI = GetUInt24Big(data,offset);
+			std::vector<unsigned char>	body(data.begin()+offset,data.end());
 
 			switch(RSNOUI) {
 			case OUI_WPAWME:
-				content = dissect_vendor_ie_wpawme(&data[offset], data.size()-offset);
+				content = dissect_vendor_ie_wpawme(body);
 				break;
 			case OUI_RSN:
-				content = dissect_vendor_ie_rsn(&data[offset], data.size()-offset);
+				content = dissect_vendor_ie_rsn(body);
 				break;
 			case OUI_PRE11N:
-				content = dissect_vendor_ie_ht(&data[offset], data.size()-offset);
+				content = dissect_vendor_ie_ht(body);
 				break;
 			case OUI_WFA:
-				content = dissect_vendor_ie_wfa(&data[offset], data.size()-offset);
+				content = dissect_vendor_ie_wfa(body);
 				break;
 			case OUI_CISCOWL:
-				content = dissect_vendor_ie_aironet(&data[offset], data.size()-offset);
+				content = dissect_vendor_ie_aironet(body);
 				break;
 			case OUI_MARVELL:
-				content = dissect_vendor_ie_marvell(&data[offset], data.size()-offset);
+				content = dissect_vendor_ie_marvell(body);
 				break;
 			case OUI_ATHEROS:
-				content = dissect_vendor_ie_atheros(&data[offset], data.size()-offset);
+				content = dissect_vendor_ie_atheros(body);
 				break;
 			case OUI_ARUBA:
-				content = dissect_vendor_ie_aruba(&data[offset], data.size()-offset);
+				content = dissect_vendor_ie_aruba(body);
 				break;
 			case OUI_NINTENDO:
-				content = dissect_vendor_ie_nintendo(&data[offset], data.size()-offset);
+				content = dissect_vendor_ie_nintendo(body);
 				break;
 			default:
-				content["content"] = BufferToHex(&data[0],data.size());
+				content["content"] = BufferToHex(data.data(),data.size());
 				break;
 			}
 
@@ -1701,27 +1730,34 @@ namespace OpenWifi {
 		return new_ie;
 	}
 
-	inline nlohmann::json WFS_WLAN_EID_EXTENSION(const std::vector<unsigned char> &data) {
-		nlohmann::json 	new_ie;
-		nlohmann::json 	content;
+	using IEDecoder = nlohmann::json (*)(const std::vector<unsigned char> &data);
 
-		std::cout << BufferToHex(&data[0],data.size()) << std::endl;
-		uint offset=0;
-		auto sub_ie = data[offset++];
-		switch (sub_ie) {
-		case WLAN_EID_EXT_HE_CAPABILITY: {
+	//	One slot per element (or extension element) ID. MinLength is checked before the decoder runs, shorter
+	//	IEs are left undecoded.
+	struct IEDecoderEntry {
+		IEDecoder 	Decoder = nullptr;
+		uint32_t 	MinLength = 0;
+	};
+	using IEDecoderTable = std::array<IEDecoderEntry,256>;
 
-		} break;
-		case WLAN_EID_EXT_HE_OPERATION: {
+	inline const IEDecoderTable & ExtensionIEDecoders() {
+		//	no extension element has a dedicated decoder yet: all of them are reported as a hex block
+		static const IEDecoderTable Table{};
+		return Table;
+	}
 
-		} break;
-		case WLAN_EID_EXT_HE_MU_EDCA: {
+	inline nlohmann::json WFS_WLAN_EID_EXTENSION(const std::vector<unsigned char> &data) {
+		nlohmann::json 	new_ie;
+		nlohmann::json 	content;
 
-		} break;
-		default:
-			content["Extension EID"] = BufferToHex(&data[0],1);
-			content["Block"] = BufferToHex(&data[1],data.size()-1);
-			break;
+		auto sub_ie = data.at(0);
+		const auto &Entry = ExtensionIEDecoders()[sub_ie];
+		//	MinLength bounds the body after the extension ID, as it bounds the whole IE in IEDecoders
+		if(Entry.Decoder!=nullptr && data.size()-1>=Entry.MinLength) {
+			content = Entry.Decoder(std::vector<unsigned char>(data.begin()+1,data.end()));
+		} else {
+			content["Extension EID"] = BufferToHex(data.data(),1);
+			content["Block"] = BufferToHex(data.data()+1,data.size()-1);
 		}
 
 		new_ie["name"]="EI Extensions";
@@ -1730,96 +1766,107 @@ namespace OpenWifi {
 		return new_ie;
 	}
 
-	inline bool ParseWifiScan(Poco::JSON::Object::Ptr &Obj, std::stringstream &Result, Poco::Logger &Logger) {
-		std::ostringstream	ofs;
-		Obj->stringify(ofs);
-
-		nlohmann::json D = nlohmann::json::parse(ofs.str());
-		std::cout << "Start of parsing wifi" << std::endl;
-		if (D.contains("status")) {
-			auto Status = D["status"];
-
-			if (Status.contains("scan") && Status["scan"].is_array()) {
-				nlohmann::json ScanArray = Status["scan"];
-				nlohmann::json ParsedScan = nlohmann::json::array();
-				for (auto &scan_entry : ScanArray) {
-					if (scan_entry.contains("ies") && scan_entry["ies"].is_array()) {
-						auto ies = scan_entry["ies"];
-						nlohmann::json 	new_ies=nlohmann::json::array();
-						for (auto &ie : ies) {
-							try {
-								if (ie.contains("type") && ie.contains("data")) {
-									uint64_t ie_type = ie["type"];
-									std::string ie_data = ie["data"];
-									// std::cout << "TYPE:" << ie_type << "  DATA:" << ie_data << std::endl;
-									auto data = Base64Decode2Vec(ie_data);
-									if (ie_type == ieee80211_eid::WLAN_EID_COUNTRY) {
-										new_ies.push_back(WFS_WLAN_EID_COUNTRY(data));
-									} else if (ie_type == ieee80211_eid::WLAN_EID_SUPP_RATES) {
-										new_ies.push_back(WFS_WLAN_EID_SUPP_RATES(data));
-									} else if (ie_type == ieee80211_eid::WLAN_EID_FH_PARAMS) {
-										new_ies.push_back(WFS_WLAN_EID_FH_PARAMS(data));
-									} else if (ie_type == ieee80211_eid::WLAN_EID_DS_PARAMS) {
-										new_ies.push_back(WFS_WLAN_EID_DS_PARAMS(data));
-									} else if (ie_type == ieee80211_eid::WLAN_EID_TIM) {
-										new_ies.push_back(WFS_WLAN_EID_TIM(data));
-									} else if (ie_type == ieee80211_eid::WLAN_EID_QBSS_LOAD) {
-										new_ies.push_back(WFS_WLAN_EID_QBSS_LOAD(data));
-									} else if (ie_type == ieee80211_eid::WLAN_EID_PWR_CONSTRAINT) {
-										new_ies.push_back(WFS_WLAN_EID_PWR_CONSTRAINT(data));
-									} else if (ie_type == ieee80211_eid::WLAN_EID_ERP_INFO) {
-										new_ies.push_back(WFS_WLAN_EID_ERP_INFO(data));
-									} else if (ie_type == ieee80211_eid::WLAN_EID_SUPPORTED_REGULATORY_CLASSES) {
-										new_ies.push_back(WFS_WLAN_EID_SUPPORTED_REGULATORY_CLASSES(data));
-									} else if (ie_type == ieee80211_eid::WLAN_EID_HT_CAPABILITY) {
-										new_ies.push_back(WFS_WLAN_EID_HT_CAPABILITY(data));
-									} else if (ie_type == ieee80211_eid::WLAN_EID_EXT_SUPP_RATES) {
-										new_ies.push_back(WFS_WLAN_EID_EXT_SUPP_RATES(data));
-									} else if (ie_type == ieee80211_eid::WLAN_EID_TX_POWER_ENVELOPE) {
-										new_ies.push_back(WFS_WLAN_EID_TX_POWER_ENVELOPE(data));
-									} else if (ie_type == ieee80211_eid::WLAN_EID_VHT_CAPABILITY) {
-										new_ies.push_back(WFS_WLAN_EID_VHT_CAPABILITY(data));
-									} else if (ie_type == ieee80211_eid::WLAN_EID_RRM_ENABLED_CAPABILITIES) {
-										new_ies.push_back(WFS_WLAN_EID_RRM_ENABLED_CAPABILITIES(data));
-									} else if (ie_type == ieee80211_eid::WLAN_EID_EXT_CAPABILITY) {
-										new_ies.push_back(WFS_WLAN_EID_EXT_CAPABILITY(data));
-									} else if (ie_type == ieee80211_eid::WLAN_EID_TPC_REPORT) {
-										new_ies.push_back(WFS_WLAN_EID_TPC_REPORT(data));
-									} else if (ie_type == ieee80211_eid::WLAN_EID_RSN) {
-										new_ies.push_back(WFS_WLAN_EID_RSN(data));
-									} else if (ie_type == ieee80211_eid::WLAN_EID_VENDOR_SPECIFIC) {
-										new_ies.push_back(WFS_WLAN_EID_VENDOR_SPECIFIC(data));
-									} else if (ie_type == ieee80211_eid::WLAN_EID_EXTENSION) {
-										new_ies.push_back(WFS_WLAN_EID_EXTENSION(data));
-									} else {
-										std::cout
-											<< "Skipping IE: no parsing available: " << ie_type
-											<< std::endl;
-										new_ies.push_back(ie);
-									}
-								} else {
-									std::cout << "Skipping IE: no data and type" << std::endl;
-									new_ies.push_back(ie);
-								}
-							} catch (...) {
-								std::cout << "Skipping IE: exception" << std::endl;
-								Logger.information(fmt::format("Error parsing IEs"));
-								new_ies.push_back(ie);
-							}
+	inline const IEDecoderTable & IEDecoders() {
+		static const IEDecoderTable Table = []() {
+			IEDecoderTable T{};
+			T[WLAN_EID_SUPP_RATES] = { WFS_WLAN_EID_SUPP_RATES, 0 };
+			T[WLAN_EID_FH_PARAMS] = { WFS_WLAN_EID_FH_PARAMS, 5 };
+			T[WLAN_EID_DS_PARAMS] = { WFS_WLAN_EID_DS_PARAMS, 1 };
+			T[WLAN_EID_TIM] = { WFS_WLAN_EID_TIM, 0 };
+			T[WLAN_EID_COUNTRY] = { WFS_WLAN_EID_COUNTRY, 3 };
+			T[WLAN_EID_QBSS_LOAD] = { WFS_WLAN_EID_QBSS_LOAD, 0 };
+			T[WLAN_EID_PWR_CONSTRAINT] = { WFS_WLAN_EID_PWR_CONSTRAINT, 1 };
+			T[WLAN_EID_TPC_REPORT] = { WFS_WLAN_EID_TPC_REPORT, 0 };
+			T[WLAN_EID_ERP_INFO] = { WFS_WLAN_EID_ERP_INFO, 1 };
+			T[WLAN_EID_HT_CAPABILITY] = { WFS_WLAN_EID_HT_CAPABILITY, 0 };
+			T[WLAN_EID_RSN] = { WFS_WLAN_EID_RSN, 6 };
+			T[WLAN_EID_EXT_SUPP_RATES] = { WFS_WLAN_EID_EXT_SUPP_RATES, 0 };
+			T[WLAN_EID_SUPPORTED_REGULATORY_CLASSES] = { WFS_WLAN_EID_SUPPORTED_REGULATORY_CLASSES, 0 };
+			T[WLAN_EID_RRM_ENABLED_CAPABILITIES] = { WFS_WLAN_EID_RRM_ENABLED_CAPABILITIES, 0 };
+			T[WLAN_EID_EXT_CAPABILITY] = { WFS_WLAN_EID_EXT_CAPABILITY, 0 };
+			T[WLAN_EID_VHT_CAPABILITY] = { WFS_WLAN_EID_VHT_CAPABILITY, 0 };
+			T[WLAN_EID_TX_POWER_ENVELOPE] = { WFS_WLAN_EID_TX_POWER_ENVELOPE, 0 };
+			T[WLAN_EID_VENDOR_SPECIFIC] = { WFS_WLAN_EID_VENDOR_SPECIFIC, 4 };
+			T[WLAN_EID_EXTENSION] = { WFS_WLAN_EID_EXTENSION, 1 };
+			return T;
+		}();
+		return Table;
+	}
+
+	//	One IE of a scan: decoded when there is a decoder for it, as the device sent it otherwise.
+	inline void WriteScanIE(const Poco::Dynamic::Var &IE, std::ostream &Result, uint64_t &Failed) {
+		const auto &Decoders = IEDecoders();
+		try {
+			if (IE.type() == typeid(Poco::JSON::Object::Ptr)) {
+				const auto &O = IE.extract<Poco::JSON::Object::Ptr>();
+				if (O->has("type") && O->has("data")) {
+					auto ie_type = O->getValue<uint64_t>("type");
+					if (ie_type < Decoders.size() && Decoders[ie_type].Decoder != nullptr) {
+						auto data = Base64Decode2Vec(O->getValue<std::string>("data"));
+						if (data.size() >= Decoders[ie_type].MinLength) {
+							//	complete before anything is written, so a decoder giving up leaves no partial output
+							Result << Decoders[ie_type].Decoder(data).dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+							return;
 						}
-						scan_entry["ies"] = new_ies;
-						ParsedScan.push_back(scan_entry);
-					} else {
-						std::cout << "Skipping scan" << std::endl;
-						ParsedScan.push_back(scan_entry);
+						Failed++;
 					}
 				}
-				Status["scan"] = ParsedScan;
-				D["status"] = Status;
 			}
+		} catch (...) {
+			Failed++;
+		}
+		Poco::JSON::Stringifier::condense(IE, Result);
+	}
+
+	inline void WriteScanKey(const std::string &Key, bool &First, std::ostream &Result) {
+		if (!First)
+			Result << ',';
+		First = false;
+		Result << nlohmann::json(Key).dump() << ':';
+	}
+
+	//	Obj is written as it is, but for the "ies" arrays of the BSSs in status.scan.
+	inline void WriteScan(const Poco::Dynamic::Var &V, std::size_t Depth, std::ostream &Result, uint64_t &Failed) {
+		static const std::array<const char *, 2> Path{"status", "scan"};
+		if (Depth < Path.size() || Depth == Path.size() + 1) {
+			if (V.type() == typeid(Poco::JSON::Object::Ptr)) {
+				const auto &O = V.extract<Poco::JSON::Object::Ptr>();
+				bool First = true;
+				Result << '{';
+				for (const auto &[Key, Value] : *O) {
+					WriteScanKey(Key, First, Result);
+					if (Depth < Path.size() ? Key == Path[Depth] : Key == "ies")
+						WriteScan(Value, Depth + 1, Result, Failed);
+					else
+						Poco::JSON::Stringifier::condense(Value, Result);
+				}
+				Result << '}';
+				return;
+			}
+		} else if (V.type() == typeid(Poco::JSON::Array::Ptr)) {
+			//	the BSS list, or the IEs of one BSS
+			const auto &A = V.extract<Poco::JSON::Array::Ptr>();
+			Result << '[';
+			for (std::size_t i = 0; i < A->size(); i++) {
+				if (i)
+					Result << ',';
+				if (Depth == Path.size())
+					WriteScan(A->get(i), Depth + 1, Result, Failed);
+				else
+					WriteScanIE(A->get(i), Result, Failed);
+			}
+			Result << ']';
+			return;
 		}
-		Result << to_string(D);
-		std::cout << "End of parsing wifi" << std::endl;
+		Poco::JSON::Stringifier::condense(V, Result);
+	}
+
+	//	Decode the IEs of every BSS and write the result straight to Result, walking Obj without copying it.
+	inline bool ParseWifiScan(Poco::JSON::Object::Ptr &Obj, std::stringstream &Result, Poco::Logger &Logger) {
+		uint64_t Failed = 0;
+		WriteScan(Obj, 0, Result, Failed);
+		if(Failed)
+			Logger.debug(fmt::format("WIFISCAN: {} IEs could not be decoded.", Failed));
 		return false;
 	}
 
@@ -0,0 +1,255 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+//	RFC 7692 permessage-deflate: extension negotiation, and the raw DEFLATE streams carried by frames with RSV1 set.
+//	It only depends on the standard library and zlib, so the simulator uses it to play the device side.
+namespace OpenWifi::PerMessageDeflate {
+
+	static const char 			Name[] = "permessage-deflate";
+	static constexpr int 		MinWindowBits = 9;			//	zlib compresses with 9 when asked for 8, so never inflate with less
+	static constexpr int 		MaxWindowBits = 15;
+	static constexpr uint16_t	FlagCompressed = 0x40;		//	RSV1, on the first frame of a compressed message
+
+	//	what the server is willing to do
+	struct Settings {
+		bool 		Enabled = true;
+		int 		WindowBits = MaxWindowBits;		//	largest window the client may compress with
+		bool 		ContextTakeover = true;			//	false asks the client to compress every message on its own
+		uint64_t 	MaxMessageSize = 1024 * 1024;	//	largest inflated message
+	};
+
+	//	what both ends agreed on
+	struct Parameters {
+		bool 	ClientNoContextTakeover = false;
+		bool 	ServerNoContextTakeover = false;
+		int 	ClientMaxWindowBits = MaxWindowBits;
+		int 	ServerMaxWindowBits = MaxWindowBits;
+	};
+
+	inline std::string Trim(const std::string &S) {
+		auto First = S.find_first_not_of(" \t");
+		if(First==std::string::npos)
+			return "";
+		auto Last = S.find_last_not_of(" \t");
+		return S.substr(First, Last - First + 1);
+	}
+
+	inline std::vector<std::string> Split(const std::string &S, char Separator) {
+		std::vector<std::string>	Parts;
+		std::string::size_type 		Start = 0;
+		while(true) {
+			auto End = S.find(Separator, Start);
+			Parts.push_back(Trim(S.substr(Start, End==std::string::npos ? std::string::npos : End - Start)));
+			if(End==std::string::npos)
+				return Parts;
+			Start = End + 1;
+		}
+	}
+
+	inline bool WindowBits(const std::string &Value, int &Bits) {
+		auto V = Value;
+		if(V.size()>=2 && V.front()=='"' && V.back()=='"')
+			V = V.substr(1, V.size() - 2);
+		if(V.empty() || V.size()>2 || !std::all_of(V.begin(), V.end(), [](char c) { return c>='0' && c<='9'; }))
+			return false;
+		Bits = std::stoi(V);
+		return Bits>=8 && Bits<=MaxWindowBits;
+	}
+
+	//	Parses one extension offer or response. Unknown, repeated or malformed parameters reject it, as the RFC asks.
+	inline bool Parse(const std::string &Extension, Parameters &P, bool &ClientMaxWindowBitsPresent) {
+		auto Tokens = Split(Extension, ';');
+		if(Tokens.empty() || Tokens[0]!=Name)
+			return false;
+		P = Parameters{};
+		ClientMaxWindowBitsPresent = false;
+		bool Seen[4] = {false, false, false, false};
+		for(std::size_t i=1;i<Tokens.size();i++) {
+			auto Equal = Tokens[i].find('=');
+			auto Param = Trim(Tokens[i].substr(0, Equal));
+			auto Value = Equal==std::string::npos ? std::string() : Trim(Tokens[i].substr(Equal + 1));
+			int Index;
+			if(Param=="server_no_context_takeover" && Equal==std::string::npos) {
+				Index = 0;
+				P.ServerNoContextTakeover = true;
+			} else if(Param=="client_no_context_takeover" && Equal==std::string::npos) {
+				Index = 1;
+				P.ClientNoContextTakeover = true;
+			} else if(Param=="server_max_window_bits" && Equal!=std::string::npos) {
+				Index = 2;
+				if(!WindowBits(Value, P.ServerMaxWindowBits))
+					return false;
+			} else if(Param=="client_max_window_bits") {
+				Index = 3;
+				ClientMaxWindowBitsPresent = true;
+				if(Equal!=std::string::npos && !WindowBits(Value, P.ClientMaxWindowBits))
+					return false;
+			} else {
+				return false;
+			}
+			if(Seen[Index])
+				return false;
+			Seen[Index] = true;
+		}
+		return true;
+	}
+
+	//	Server side: picks the first acceptable offer of a Sec-WebSocket-Extensions header. Returns the value of the
+	//	response header, empty when permessage-deflate is not used. The server never compresses, so whatever the
+	//	client asks about the server's own stream is accepted.
+	inline std::string Negotiate(const std::string &Offers, const Settings &S, Parameters &Agreed) {
+		if(!S.Enabled)
+			return "";
+		for(const auto &Offer:Split(Offers, ',')) {
+			Parameters	P;
+			bool 		ClientMaxWindowBitsPresent;
+			if(!Parse(Offer, P, ClientMaxWindowBitsPresent))
+				continue;
+
+			std::string Response{Name};
+			if(P.ServerNoContextTakeover)
+				Response += "; server_no_context_takeover";
+			if(P.ServerMaxWindowBits<MaxWindowBits)
+				Response += "; server_max_window_bits=" + std::to_string(P.ServerMaxWindowBits);
+			P.ClientNoContextTakeover = P.ClientNoContextTakeover || !S.ContextTakeover;
+			if(P.ClientNoContextTakeover)
+				Response += "; client_no_context_takeover";
+			//	a client that did not offer client_max_window_bits may use a 32KB window whatever the server wants
+			if(ClientMaxWindowBitsPresent) {
+				P.ClientMaxWindowBits = std::min(P.ClientMaxWindowBits, S.WindowBits);
+				Response += "; client_max_window_bits=" + std::to_string(P.ClientMaxWindowBits);
+			} else {
+				P.ClientMaxWindowBits = MaxWindowBits;
+			}
+			Agreed = P;
+			return Response;
+		}
+		return "";
+	}
+
+	//	Client side: the offer to send, and the check of the server's answer.
+	inline std::string Offer(int WindowBits, bool NoContextTakeover) {
+		std::string Result{Name};
+		Result += "; client_max_window_bits";
+		if(WindowBits<MaxWindowBits)
+			Result += "=" + std::to_string(WindowBits);
+		if(NoContextTakeover)
+			Result += "; client_no_context_takeover";
+		return Result;
+	}
+
+	inline bool Accept(const std::string &Response, Parameters &Agreed) {
+		bool 	ClientMaxWindowBitsPresent;
+		return !Response.empty() && Response.find(',')==std::string::npos && Parse(Response, Agreed, ClientMaxWindowBitsPresent);
+	}
+
+	//	Inflates messages of one direction of a connection. With context takeover, it keeps the window of the previous
+	//	messages (2^WindowBits bytes plus about 7KB of zlib state) for the life of the connection.
+	class Inflater {
+	  public:
+		explicit Inflater(int WindowBits) {
+			Valid_ = inflateInit2(&Stream_, -std::clamp(WindowBits, MinWindowBits, MaxWindowBits))==Z_OK;
+		}
+		~Inflater() {
+			if(Valid_)
+				inflateEnd(&Stream_);
+		}
+		Inflater(const Inflater &) = delete;
+		Inflater & operator=(const Inflater &) = delete;
+
+		//	Inflates one whole message into Out. Fails on corrupt data or when the message would exceed MaxSize, and
+		//	the connection should then be closed: its window can no longer be trusted.
+		bool Inflate(const char *Data, std::size_t Size, std::string &Out, std::size_t MaxSize, bool Reset) {
+			static const unsigned char Tail[4] = {0x00, 0x00, 0xff, 0xff};
+			if(!Valid_)
+				return false;
+			Out.clear();
+			bool Ok = Run((const unsigned char *) Data, Size, Out, MaxSize) && Run(Tail, sizeof(Tail), Out, MaxSize);
+			if(Reset || !Ok)
+				inflateReset(&Stream_);
+			return Ok;
+		}
+
+	  private:
+		z_stream 	Stream_{};
+		bool 		Valid_ = false;
+
+		bool Run(const unsigned char *Data, std::size_t Size, std::string &Out, std::size_t MaxSize) {
+			unsigned char Buffer[16384];
+			Stream_.next_in = const_cast<unsigned char *>(Data);
+			Stream_.avail_in = (uInt) Size;
+			do {
+				Stream_.next_out = Buffer;
+				Stream_.avail_out = sizeof(Buffer);
+				auto R = inflate(&Stream_, Z_SYNC_FLUSH);
+				auto Produced = sizeof(Buffer) - Stream_.avail_out;
+				if(Out.size() + Produced > MaxSize)
+					return false;
+				Out.append((const char *) Buffer, Produced);
+				if(R==Z_STREAM_END) {
+					//	a final block ends the stream, whatever follows starts a new one
+					inflateReset(&Stream_);
+				} else if(R!=Z_OK && !(R==Z_BUF_ERROR && Produced==0)) {
+					return false;
+				}
+				if(R==Z_BUF_ERROR)
+					break;
+			} while(Stream_.avail_in>0 || Stream_.avail_out==0);
+			return true;
+		}
+	};
+
+	//	Compresses messages the way a device would, for the simulator.
+	class Deflater {
+	  public:
+		Deflater(int WindowBits, int Level = Z_DEFAULT_COMPRESSION) {
+			Valid_ = deflateInit2(&Stream_, Level, Z_DEFLATED, -std::clamp(WindowBits, MinWindowBits, MaxWindowBits), 8,
+								  Z_DEFAULT_STRATEGY)==Z_OK;
+		}
+		~Deflater() {
+			if(Valid_)
+				deflateEnd(&Stream_);
+		}
+		Deflater(const Deflater &) = delete;
+		Deflater & operator=(const Deflater &) = delete;
+
+		bool Deflate(const char *Data, std::size_t Size, std::string &Out, bool Reset) {
+			if(!Valid_)
+				return false;
+			Out.clear();
+			unsigned char Buffer[16384];
+			Stream_.next_in = (unsigned char *) const_cast<char *>(Data);
+			Stream_.avail_in = (uInt) Size;
+			do {
+				Stream_.next_out = Buffer;
+				Stream_.avail_out = sizeof(Buffer);
+				if(deflate(&Stream_, Z_SYNC_FLUSH)==Z_STREAM_ERROR)
+					return false;
+				Out.append((const char *) Buffer, sizeof(Buffer) - Stream_.avail_out);
+			} while(Stream_.avail_out==0);
+			//	the empty stored block ending every flush is implied on the wire
+			if(Out.size()>=4 && Out.compare(Out.size() - 4, 4, "\x00\x00\xff\xff", 4)==0)
+				Out.resize(Out.size() - 4);
+			if(Reset)
+				deflateReset(&Stream_);
+			return true;
+		}
+
+	  private:
+		z_stream 	Stream_{};
+		bool 		Valid_ = false;
+	};
+}
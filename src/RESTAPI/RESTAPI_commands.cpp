@@ -14,8 +14,15 @@ namespace OpenWifi {
 	void RESTAPI_commands::DoGet() {
 		auto SerialNumber = GetParameter(RESTAPI::Protocol::SERIALNUMBER, "");
 		std::vector<GWObjects::CommandDetails> Commands;
+		Storage::PageCursor After, Next;
 		if (QB_.Newest) {
 			StorageService()->GetNewestCommands(SerialNumber, QB_.Limit, Commands);
+		} else if (QB_.UseCursor) {
+			if(!Storage::DecodeCursor(QB_.Cursor, After)) {
+				return BadRequest(RESTAPI::Errors::InvalidCursor);
+			}
+			StorageService()->GetCommands(SerialNumber, QB_.StartDate, QB_.EndDate, After, QB_.Limit,
+								   Commands, Next);
 		} else {
 			StorageService()->GetCommands(SerialNumber, QB_.StartDate, QB_.EndDate, QB_.Offset, QB_.Limit,
 								   Commands);
@@ -28,6 +35,8 @@ namespace OpenWifi {
 		}
 		Poco::JSON::Object RetObj;
 		RetObj.set(RESTAPI::Protocol::COMMANDS, ArrayObj);
+		if (QB_.UseCursor && !QB_.Newest)
+			RetObj.set(RESTAPI::Protocol::NEXTCURSOR, Storage::EncodeCursor(Next));
 		ReturnObject(RetObj);
 	}
 
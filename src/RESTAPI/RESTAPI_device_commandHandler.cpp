@@ -157,8 +157,15 @@ namespace OpenWifi {
 			}
 		} else {
 			std::vector<GWObjects::Statistics> Stats;
+			Storage::PageCursor After, Next;
 			if (QB_.Newest) {
 				StorageService()->GetNewestStatisticsData(SerialNumber_, QB_.Limit, Stats);
+			} else if (QB_.UseCursor) {
+				if(!Storage::DecodeCursor(QB_.Cursor, After)) {
+					return BadRequest(RESTAPI::Errors::InvalidCursor);
+				}
+				StorageService()->GetStatisticsData(SerialNumber_, QB_.StartDate, QB_.EndDate,
+													 After, QB_.Limit, Stats, Next);
 			} else {
 				StorageService()->GetStatisticsData(SerialNumber_, QB_.StartDate, QB_.EndDate,
 													 QB_.Offset, QB_.Limit, Stats);
@@ -172,6 +179,8 @@ namespace OpenWifi {
 			Poco::JSON::Object RetObj;
 			RetObj.set(RESTAPI::Protocol::DATA, ArrayObj);
 			RetObj.set(RESTAPI::Protocol::SERIALNUMBER, SerialNumber_);
+			if (QB_.UseCursor && !QB_.Newest)
+				RetObj.set(RESTAPI::Protocol::NEXTCURSOR, Storage::EncodeCursor(Next));
 			return ReturnObject(RetObj);
 		}
 	}
@@ -390,8 +399,15 @@ namespace OpenWifi {
 
 	void RESTAPI_device_commandHandler::GetLogs() {
 		std::vector<GWObjects::DeviceLog> Logs;
+		Storage::PageCursor After, Next;
 		if (QB_.Newest) {
 			StorageService()->GetNewestLogData(SerialNumber_, QB_.Limit, Logs, QB_.LogType);
+		} else if (QB_.UseCursor) {
+			if(!Storage::DecodeCursor(QB_.Cursor, After)) {
+				return BadRequest(RESTAPI::Errors::InvalidCursor);
+			}
+			StorageService()->GetLogData(SerialNumber_, QB_.StartDate, QB_.EndDate, After,
+										  QB_.Limit, Logs, QB_.LogType, Next);
 		} else {
 			StorageService()->GetLogData(SerialNumber_, QB_.StartDate, QB_.EndDate, QB_.Offset,
 										  QB_.Limit, Logs, QB_.LogType);
@@ -406,6 +422,8 @@ namespace OpenWifi {
 		Poco::JSON::Object RetObj;
 		RetObj.set(RESTAPI::Protocol::VALUES, ArrayObj);
 		RetObj.set(RESTAPI::Protocol::SERIALNUMBER, SerialNumber_);
+		if (QB_.UseCursor && !QB_.Newest)
+			RetObj.set(RESTAPI::Protocol::NEXTCURSOR, Storage::EncodeCursor(Next));
 		ReturnObject(RetObj);
 	}
 
@@ -8,7 +8,6 @@
 
 #include "RESTAPI_device_handler.h"
 #include "CentralConfig.h"
-#include "ConfigurationCache.h"
 #include "Poco/JSON/Parser.h"
 #include "StorageService.h"
 #include "framework/ConfigurationValidator.h"
@@ -138,7 +137,6 @@ namespace OpenWifi {
 		Poco::toLowerInPlace(Device.SerialNumber);
 
 		if (StorageService()->CreateDevice(Device)) {
-			SetCurrentConfigurationID(SerialNumber, Device.UUID);
 			Poco::JSON::Object DevObj;
 			Device.to_json(DevObj);
 			return ReturnObject(DevObj);
@@ -189,8 +187,7 @@ namespace OpenWifi {
 		}
 
 		Existing.LastConfigurationChange = OpenWifi::Now();
-		if (StorageService()->UpdateDevice(Existing)) {
-			SetCurrentConfigurationID(SerialNumber, Existing.UUID);
+		if (StorageService()->UpdateDevice(Existing, !NewDevice.Configuration.empty())) {
 			Poco::JSON::Object DevObj;
 			NewDevice.to_json(DevObj);
 			return ReturnObject(DevObj);
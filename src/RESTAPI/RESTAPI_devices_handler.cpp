@@ -18,6 +18,7 @@
 
 namespace OpenWifi {
 
+	static const uint64_t DeviceListBatchSize = 100;
 
 	bool PrepareOrderBy(const std::string &OrderByList, std::string &OrderByString) {
 		auto items = Poco::StringTokenizer(OrderByList,",");
@@ -65,75 +66,110 @@ namespace OpenWifi {
 		}
 
 		std::string OrderBy{" ORDER BY serialNumber ASC "}, Arg;
-		if(HasParameter("orderBy",Arg)) {
-			if(!PrepareOrderBy(Arg,OrderBy)) {
+		bool CustomOrder = HasParameter("orderBy",Arg);
+		if(CustomOrder) {
+			//	cursors are keyed on the serial number, so a custom order cannot be combined with them
+			if(QB_.UseCursor || !PrepareOrderBy(Arg,OrderBy)) {
 				return BadRequest(RESTAPI::Errors::InvalidLOrderBy);
 			}
 		}
 
+		Storage::PageCursor After, Next;
+		if(QB_.UseCursor && !Storage::DecodeCursor(QB_.Cursor, After)) {
+			return BadRequest(RESTAPI::Errors::InvalidCursor);
+		}
+
 		auto serialOnly = GetBoolParameter(RESTAPI::Protocol::SERIALONLY, false);
 		auto deviceWithStatus = GetBoolParameter(RESTAPI::Protocol::DEVICEWITHSTATUS, false);
 		auto completeInfo = GetBoolParameter("completeInfo",false);
 
-		Poco::JSON::Object RetObj;
+		auto ArrayName = deviceWithStatus ? RESTAPI::Protocol::DEVICESWITHSTATUS : RESTAPI::Protocol::DEVICES;
+
 		if (!QB_.Select.empty()) {
-			Poco::JSON::Array Objects;
-			for (auto &i : SelectedRecords()) {
-				auto SerialNumber = i;
-				GWObjects::Device D;
-				if (StorageService()->GetDevice(SerialNumber, D)) {
-					if(completeInfo) {
-						Poco::JSON::Object	FullDeviceInfo;
-						CompleteDeviceInfo(D, FullDeviceInfo);
-						Objects.add(FullDeviceInfo);
-					} else {
-						Poco::JSON::Object Obj;
-						if (deviceWithStatus)
-							D.to_json_with_status(Obj);
-						else
-							D.to_json(Obj);
-						Objects.add(Obj);
-					}
-				} else {
-					Logger_.error(
-						fmt::format("DEVICE({}): device in select cannot be found.", i));
-				}
+			std::vector<GWObjects::Device> Devices;
+			std::vector<std::string> Missing;
+			if(!StorageService()->GetDevices(SelectedRecords(), Devices, Missing)) {
+				return InternalError(RESTAPI::Errors::InternalError);
 			}
-			if (deviceWithStatus)
-				RetObj.set(RESTAPI::Protocol::DEVICESWITHSTATUS, Objects);
-			else
-				RetObj.set(RESTAPI::Protocol::DEVICES, Objects);
-
+			for(const auto &i:Missing) {
+				Logger_.error(
+					fmt::format("DEVICE({}): device in select cannot be found.", i));
+			}
+			return ReturnStreamedArray(ArrayName, [&](JSONArrayStream &Stream, Poco::JSON::Object &Trailer) {
+				for (const auto &D : Devices) {
+					Poco::JSON::Object Obj;
+					if(completeInfo)
+						CompleteDeviceInfo(D, Obj);
+					else if (deviceWithStatus)
+						D.to_json_with_status(Obj);
+					else
+						D.to_json(Obj);
+					Stream.Add(Obj);
+				}
+				if(!Missing.empty()) {
+					Poco::JSON::Array MissingArray;
+					for(const auto &i:Missing)
+						MissingArray.add(i);
+					Trailer.set(RESTAPI::Protocol::MISSING, MissingArray);
+				}
+			});
 		} else if (QB_.CountOnly == true) {
 			uint64_t Count = 0;
 			if (StorageService()->GetDeviceCount(Count)) {
 				return ReturnCountOnly(Count);
 			}
 		} else if (serialOnly) {
+			Poco::JSON::Object RetObj;
 			std::vector<std::string> SerialNumbers;
-			StorageService()->GetDeviceSerialNumbers(QB_.Offset, QB_.Limit, SerialNumbers, OrderBy);
+			if(QB_.UseCursor)
+				StorageService()->GetDeviceSerialNumbers(After, QB_.Limit, SerialNumbers, Next);
+			else
+				StorageService()->GetDeviceSerialNumbers(QB_.Offset, QB_.Limit, SerialNumbers, OrderBy);
 			Poco::JSON::Array Objects;
 			for (const auto &i : SerialNumbers) {
 				Objects.add(i);
 			}
 			RetObj.set(RESTAPI::Protocol::SERIALNUMBERS, Objects);
+			if(QB_.UseCursor)
+				RetObj.set(RESTAPI::Protocol::NEXTCURSOR, Storage::EncodeCursor(Next));
+			return ReturnObject(RetObj);
 		} else {
-			std::vector<GWObjects::Device> Devices;
-			StorageService()->GetDevices(QB_.Offset, QB_.Limit, Devices, OrderBy);
-			Poco::JSON::Array Objects;
-			for (const auto &i : Devices) {
-				Poco::JSON::Object Obj;
-				if (deviceWithStatus)
-					i.to_json_with_status(Obj);
-				else
-					i.to_json(Obj);
-				Objects.add(Obj);
-			}
-			if (deviceWithStatus)
-				RetObj.set(RESTAPI::Protocol::DEVICESWITHSTATUS, Objects);
-			else
-				RetObj.set(RESTAPI::Protocol::DEVICES, Objects);
+			//	Devices are read and serialized DeviceListBatchSize at a time. When the listing is ordered on the
+			//	serial number, batches after the first seek past the last serial number instead of re-counting an OFFSET.
+			return ReturnStreamedArray(ArrayName, [&](JSONArrayStream &Stream, Poco::JSON::Object &Trailer) {
+				bool KeyOrdered = QB_.UseCursor || !CustomOrder;
+				bool Seek = QB_.UseCursor;
+				Storage::PageCursor Position = After;
+				uint64_t Offset = QB_.Offset, Remaining = QB_.Limit;
+				while(Remaining) {
+					std::vector<GWObjects::Device> Devices;
+					auto HowMany = std::min(Remaining, DeviceListBatchSize);
+					if(Seek)
+						StorageService()->GetDevices(Position, HowMany, Devices, Next);
+					else
+						StorageService()->GetDevices(Offset, HowMany, Devices, OrderBy);
+					for (const auto &i : Devices) {
+						Poco::JSON::Object Obj;
+						if (deviceWithStatus)
+							i.to_json_with_status(Obj);
+						else
+							i.to_json(Obj);
+						Stream.Add(Obj);
+					}
+					if(Devices.size()<HowMany)
+						break;
+					Remaining -= HowMany;
+					Offset += HowMany;
+					if(KeyOrdered) {
+						Position.Key = Devices.back().SerialNumber;
+						Position.Valid = Seek = true;
+					}
+				}
+				if(QB_.UseCursor)
+					Trailer.set(RESTAPI::Protocol::NEXTCURSOR, Storage::EncodeCursor(Next));
+			});
 		}
+		Poco::JSON::Object RetObj;
 		ReturnObject(RetObj);
 	}
 }
\ No newline at end of file
@@ -25,7 +25,16 @@ namespace OpenWifi {
 		if (!StorageService()->GetAttachedFileContent(UUID, SerialNumber, FileContent, FileType)) {
 			return NotFound();
 		}
-		SendFileContent(FileContent,"pcap",UUID+".pcap");
+		if (!FileContent.empty()) {
+			return SendFileContent(FileContent,"pcap",UUID+".pcap");
+		}
+
+		uint64_t Size = 0;
+		auto Content = FileUploader()->Store().Open(UUID, Size);
+		if (!Content) {
+			return NotFound();
+		}
+		SendFileStream(*Content, Size, UUID+".pcap");
 	}
 
 	void RESTAPI_file::DoDelete() {
@@ -0,0 +1,34 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#include "RESTAPI_ingressOffenders_handler.h"
+#include "IngressLimiter.h"
+
+namespace OpenWifi {
+
+	void RESTAPI_ingressOffenders_handler::DoGet() {
+		std::vector<GWObjects::IngressOffender>	Offenders;
+		IngressLimiter()->GetOffenders(Offenders, GetBoolParameter("repeatOnly", false));
+		if (QB_.CountOnly)
+			return ReturnCountOnly(Offenders.size());
+		return ReturnObject("offenders", Offenders);
+	}
+
+	void RESTAPI_ingressOffenders_handler::DoDelete() {
+		if(!Internal_ && (UserInfo_.userinfo.userRole!=SecurityObjects::ROOT && UserInfo_.userinfo.userRole!=SecurityObjects::ADMIN)) {
+			return UnAuthorized(RESTAPI::Errors::ACCESS_DENIED);
+		}
+		auto SerialNumber = GetParameter(RESTAPI::Protocol::SERIALNUMBER, "");
+		if (SerialNumber.empty()) {
+			IngressLimiter()->ClearOffenders();
+			return OK();
+		}
+		if (!IngressLimiter()->RemoveOffender(Poco::toLower(SerialNumber)))
+			return NotFound();
+		return OK();
+	}
+}
@@ -0,0 +1,29 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#pragma once
+
+#include "framework/MicroService.h"
+
+namespace OpenWifi {
+	class RESTAPI_ingressOffenders_handler : public RESTAPIHandler {
+	  public:
+		RESTAPI_ingressOffenders_handler(const RESTAPIHandler::BindingMap &bindings, Poco::Logger &L,
+										 RESTAPI_GenericServer &Server, uint64_t TransactionId,
+										 bool Internal)
+			: RESTAPIHandler(bindings, L,
+							 std::vector<std::string>{Poco::Net::HTTPRequest::HTTP_GET,
+													  Poco::Net::HTTPRequest::HTTP_DELETE,
+													  Poco::Net::HTTPRequest::HTTP_OPTIONS},
+							 Server, TransactionId, Internal) {}
+		static auto PathName() { return std::list<std::string>{"/api/v1/ingressOffenders"}; }
+		void DoGet() final;
+		void DoDelete() final;
+		void DoPost() final{};
+		void DoPut() final{};
+	};
+}
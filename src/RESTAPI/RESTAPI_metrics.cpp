@@ -0,0 +1,17 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#include "RESTAPI_metrics.h"
+
+namespace OpenWifi {
+	void RESTAPI_metrics::DoGet() {
+		PrepareResponse();
+		Response->setContentType("text/plain; version=0.0.4; charset=utf-8");
+		std::ostream &Answer = Response->send();
+		Metrics::Registry()->Write(Answer);
+	}
+}
@@ -15,11 +15,13 @@
 #include "RESTAPI/RESTAPI_device_handler.h"
 #include "RESTAPI/RESTAPI_devices_handler.h"
 #include "RESTAPI/RESTAPI_file.h"
+#include "RESTAPI/RESTAPI_metrics.h"
 #include "RESTAPI/RESTAPI_ouis.h"
 #include "RESTAPI/RESTAPI_capabilities_handler.h"
 #include "RESTAPI/RESTAPI_telemetryWebSocket.h"
 #include "RESTAPI/RESTAPI_iptocountry_handler.h"
 #include "RESTAPI/RESTAPI_radiusProxyConfig_handler.h"
+#include "RESTAPI/RESTAPI_ingressOffenders_handler.h"
 
 namespace OpenWifi {
 
@@ -44,6 +46,7 @@ namespace OpenWifi {
 				RESTAPI_blacklist_list,
 				RESTAPI_iptocountry_handler,
 				RESTAPI_radiusProxyConfig_handler,
+				RESTAPI_ingressOffenders_handler,
 				RESTAPI_capabilities_handler, RESTAPI_telemetryWebSocket>(Path,Bindings,L, S, TransactionId);
     }
 
@@ -64,6 +67,8 @@ namespace OpenWifi {
 				RESTAPI_blacklist,
 				RESTAPI_iptocountry_handler,
 				RESTAPI_radiusProxyConfig_handler,
-				RESTAPI_blacklist_list>(Path,Bindings,L, S, TransactionId);
+				RESTAPI_blacklist_list,
+				RESTAPI_ingressOffenders_handler,
+				RESTAPI_metrics>(Path,Bindings,L, S, TransactionId);
 	}
 }
\ No newline at end of file
@@ -168,6 +168,18 @@ namespace OpenWifi::GWObjects {
 		return false;
 	}
 
+	void IngressOffender::to_json(Poco::JSON::Object &Obj) const {
+		field_to_json(Obj,"serialNumber", serialNumber);
+		field_to_json(Obj,"deviceType", deviceType);
+		field_to_json(Obj,"lastClass", lastClass);
+		field_to_json(Obj,"episodes", episodes);
+		field_to_json(Obj,"dropped", dropped);
+		field_to_json(Obj,"sampled", sampled);
+		field_to_json(Obj,"firstSeen", firstSeen);
+		field_to_json(Obj,"lastSeen", lastSeen);
+		field_to_json(Obj,"repeatOffender", repeatOffender);
+	}
+
 	void BlackListedDevice::to_json(Poco::JSON::Object &Obj) const {
 		field_to_json(Obj,"serialNumber", serialNumber);
 		field_to_json(Obj,"author", author);
@@ -203,6 +215,10 @@ namespace OpenWifi::GWObjects {
 		field_to_json(Obj,"kafkaClients", kafkaClients);
 		field_to_json(Obj,"kafkaPackets", kafkaPackets);
 		field_to_json(Obj,"locale", locale);
+		field_to_json(Obj,"droppedMessages", droppedMessages);
+		field_to_json(Obj,"sampledMessages", sampledMessages);
+		field_to_json(Obj,"runningUUID", runningUUID);
+		field_to_json(Obj,"configPatch", configPatch);
 
 		switch(VerifiedCertificate) {
 			case NO_CERTIFICATE:
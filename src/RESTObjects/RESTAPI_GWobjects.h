@@ -38,6 +38,10 @@ namespace OpenWifi::GWObjects {
 		uint64_t 	kafkaPackets=0;
 		uint64_t 	websocketPackets=0;
 		std::string locale;
+		uint64_t 	droppedMessages=0;
+		uint64_t 	sampledMessages=0;
+		uint64_t 	runningUUID=0;			//	the configuration the device last reported
+		bool 		configPatch=false;		//	the firmware accepts configure as a patch of its running configuration
 		void to_json(Poco::JSON::Object &Obj) const;
 	};
 
@@ -159,6 +163,19 @@ namespace OpenWifi::GWObjects {
 		bool from_json(const Poco::JSON::Object::Ptr &Obj);
 	};
 
+	struct IngressOffender {
+		std::string serialNumber;
+		std::string deviceType;
+		std::string lastClass;
+		uint64_t 	episodes = 0;
+		uint64_t 	dropped = 0;
+		uint64_t 	sampled = 0;
+		uint64_t 	firstSeen = 0;
+		uint64_t 	lastSeen = 0;
+		bool 		repeatOffender = false;
+		void to_json(Poco::JSON::Object &Obj) const;
+	};
+
 	struct RttySessionDetails {
 		std::string SerialNumber;
 		std::string Server;
@@ -9,8 +9,8 @@
 
 namespace OpenWifi {
 
+	//	filled by CacheSnapshot, from its snapshot or from the database
 	int SerialNumberCache::Start() {
-		StorageService()->UpdateSerialNumberCache();
 		return 0;
 	}
 
@@ -33,6 +33,34 @@ namespace OpenWifi {
 		}
 	}
 
+	void SerialNumberCache::SetSerialNumbers(const std::vector<std::string> &SerialNumbers) {
+		std::vector<uint64_t>	SNs, Reverse_SNs;
+		SNs.reserve(SerialNumbers.size());
+		Reverse_SNs.reserve(SerialNumbers.size());
+		for(const auto &S:SerialNumbers) {
+			SNs.push_back(std::stoull(S, nullptr, 16));
+			Reverse_SNs.push_back(std::stoull(ReverseSerialNumber(S), nullptr, 16));
+		}
+		SetNumbers(std::move(SNs), std::move(Reverse_SNs));
+	}
+
+	void SerialNumberCache::SetNumbers(std::vector<uint64_t> SNs, std::vector<uint64_t> Reverse_SNs) {
+		std::sort(SNs.begin(), SNs.end());
+		SNs.erase(std::unique(SNs.begin(), SNs.end()), SNs.end());
+		std::sort(Reverse_SNs.begin(), Reverse_SNs.end());
+		Reverse_SNs.erase(std::unique(Reverse_SNs.begin(), Reverse_SNs.end()), Reverse_SNs.end());
+
+		std::lock_guard		G(Mutex_);
+		SNs_ = std::move(SNs);
+		Reverse_SNs_ = std::move(Reverse_SNs);
+	}
+
+	void SerialNumberCache::GetNumbers(std::vector<uint64_t> &SNs, std::vector<uint64_t> &Reverse_SNs) {
+		std::lock_guard		G(Mutex_);
+		SNs = SNs_;
+		Reverse_SNs = Reverse_SNs_;
+	}
+
 	void SerialNumberCache::DeleteSerialNumber(const std::string &S) {
 		std::lock_guard		G(Mutex_);
 
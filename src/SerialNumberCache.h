@@ -19,6 +19,14 @@ namespace OpenWifi {
 		void Stop() override;
 		void AddSerialNumber(const std::string &SerialNumber);
 		void DeleteSerialNumber(const std::string &SerialNumber);
+		//	replaces the whole cache, much faster than adding the numbers one by one
+		void SetSerialNumbers(const std::vector<std::string> &SerialNumbers);
+		void SetNumbers(std::vector<uint64_t> SNs, std::vector<uint64_t> Reverse_SNs);
+		void GetNumbers(std::vector<uint64_t> &SNs, std::vector<uint64_t> &Reverse_SNs);
+		[[nodiscard]] inline std::size_t Size() {
+			std::lock_guard		G(Mutex_);
+			return SNs_.size();
+		}
 		void FindNumbers(const std::string &SerialNumber, uint HowMany, std::vector<uint64_t> &A);
 		inline bool NumberExists(uint64_t SerialNumber) {
 			std::lock_guard		G(Mutex_);
@@ -15,7 +15,6 @@ namespace OpenWifi {
 		StorageClass::Start();
 
 		Create_Tables();
-        InitializeBlackListCache();
 
 		return 0;
     }
@@ -8,6 +8,11 @@
 
 #pragma once
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+
 #include "framework/MicroService.h"
 #include "framework/StorageClass.h"
 #include "RESTObjects//RESTAPI_GWobjects.h"
@@ -38,24 +43,119 @@ namespace OpenWifi {
 			return " LIMIT " + std::to_string(HowMany) + " OFFSET " + std::to_string(From) + " ";
 		}
 
-		inline std::string ConvertParams(const std::string & S) const {
-			std::string R;
-			R.reserve(S.size()*2+1);
-			if(dbType_==pgsql) {
-				auto Idx=1;
-				for(auto const & i:S)
-				{
-					if(i=='?') {
-						R += '$';
-						R.append(std::to_string(Idx++));
-					} else {
-						R += i;
-					}
+		//	latency of one kind of database write, keep the reference: the lookup takes a lock
+		static inline Metrics::Histogram & WriteLatency(const std::string &Operation) {
+			return Metrics::GetHistogram("owgw_storage_write_duration_seconds",
+										 "Time spent writing device data to the database, by operation.", {{"operation", Operation}});
+		}
+
+		//	Changes whenever a device is added or removed, its configuration UUID changes, or the black list changes:
+		//	the caches built from those tables are only reused while it stays the same. Generation is bumped by the
+		//	writers of the cached data, a connect leaves it alone.
+		struct CacheMarker {
+			uint64_t 	Generation = 0;
+			uint64_t 	Devices = 0;
+			uint64_t 	BlackListed = 0;
+
+			[[nodiscard]] inline bool operator==(const CacheMarker &M) const {
+				return Generation==M.Generation && Devices==M.Devices && BlackListed==M.BlackListed;
+			}
+		};
+
+		//	Position of a keyset (cursor) based listing. Timestamp/Key are the ORDER BY key of the last row returned,
+		//	Skip is the number of rows already returned that share that exact key (time series have no unique key:
+		//	they are ordered on Recorded, SerialNumber, UUID and Key holds the last two as "serial:uuid").
+		struct PageCursor {
+			uint64_t 	Timestamp = 0;
+			uint64_t 	Skip = 0;
+			std::string Key;
+			bool 		Valid = false;
+		};
+
+		[[nodiscard]] static inline std::string EncodeCursor(const PageCursor & C) {
+			if(!C.Valid)
+				return "";
+			auto Raw = std::to_string(C.Timestamp) + "|" + std::to_string(C.Skip) + "|" + C.Key;
+			return Utils::ToHex(std::vector<unsigned char>(Raw.begin(),Raw.end()));
+		}
+
+		[[nodiscard]] static inline bool DecodeCursor(const std::string & S, PageCursor & C) {
+			C = PageCursor{};
+			if(S.empty())
+				return true;
+			if(S.size() % 2)
+				return false;
+			std::string Raw;
+			Raw.reserve(S.size()/2);
+			auto Nibble = [](char c) -> int {
+				if(c>='0' && c<='9') return c-'0';
+				if(c>='a' && c<='f') return c-'a'+10;
+				if(c>='A' && c<='F') return c-'A'+10;
+				return -1;
+			};
+			for(std::size_t i=0;i<S.size();i+=2) {
+				auto H = Nibble(S[i]), L = Nibble(S[i+1]);
+				if(H<0 || L<0)
+					return false;
+				Raw += (char) ((H<<4) | L);
+			}
+			auto P1 = Raw.find('|');
+			auto P2 = P1==std::string::npos ? std::string::npos : Raw.find('|',P1+1);
+			if(P2==std::string::npos)
+				return false;
+			try {
+				C.Timestamp = std::stoull(Raw.substr(0,P1));
+				C.Skip = std::stoull(Raw.substr(P1+1,P2-P1-1));
+			} catch (...) {
+				return false;
+			}
+			C.Key = Raw.substr(P2+1);
+			for(const auto &c:C.Key)
+				if(c=='\'' || c=='\\')
+					return false;
+			C.Valid = true;
+			return true;
+		}
+
+		//	Compute the cursor following a page of time series rows ordered on (Recorded, SerialNumber, UUID). Rows
+		//	sharing the whole key of the last one are counted so the next page skips them, and only them.
+		template <typename T> static inline void NextTimeSeriesCursor(const PageCursor & After, uint64_t HowMany,
+												const std::vector<T> & Rows, PageCursor & Next) {
+			Next = PageCursor{};
+			if(Rows.empty() || Rows.size()<HowMany)
+				return;
+			const auto &Last = Rows.back();
+			Next.Timestamp = Last.Recorded;
+			Next.Key = Last.SerialNumber + ":" + std::to_string(Last.UUID);
+			for(auto i=Rows.rbegin();i!=Rows.rend() && i->Recorded==Last.Recorded && i->SerialNumber==Last.SerialNumber &&
+											 i->UUID==Last.UUID;++i)
+				Next.Skip++;
+			if(Next.Skip==Rows.size() && After.Valid && After.Timestamp==Next.Timestamp && After.Key==Next.Key)
+				Next.Skip += After.Skip;
+			Next.Valid = true;
+		}
+
+		//	The rows at or after a time series cursor, newest first when Descending. The plain Recorded bound is implied
+		//	by the row value comparison, it is there so the (SerialNumber, Recorded, UUID) index bounds the scan.
+		[[nodiscard]] static inline std::string TimeSeriesCondition(const PageCursor & C, bool Descending) {
+			auto Colon = C.Key.rfind(':');
+			uint64_t UUID = 0;
+			if(Colon!=std::string::npos) {
+				try {
+					UUID = std::stoull(C.Key.substr(Colon+1));
+				} catch (...) {
+					Colon = std::string::npos;
 				}
-			} else {
-				R = S;
 			}
-			return R;
+			if(Colon==std::string::npos)	//	a cursor from before the tiebreaker: timestamp only
+				return fmt::format("Recorded{}{}", Descending ? "<=" : ">=", C.Timestamp);
+			auto Op = Descending ? "<=" : ">=";
+			return fmt::format("Recorded{}{} AND (Recorded, SerialNumber, UUID){}({}, '{}', {})", Op, C.Timestamp, Op,
+							   C.Timestamp, C.Key.substr(0,Colon), UUID);
+		}
+
+		inline std::string ConvertParams(const std::string & S) const {
+			return ConvertSQLParams(dbType_, S);
 		}
 
         static auto instance() {
@@ -69,6 +169,8 @@ namespace OpenWifi {
 		bool AddStatisticsData(const GWObjects::Statistics & Stats);
 		bool GetStatisticsData(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate, uint64_t Offset, uint64_t HowMany,
 							   std::vector<GWObjects::Statistics> &Stats);
+		bool GetStatisticsData(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate, const PageCursor & After, uint64_t HowMany,
+							   std::vector<GWObjects::Statistics> &Stats, PageCursor & Next);
 		bool DeleteStatisticsData(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate );
 		bool GetNewestStatisticsData(std::string &SerialNumber, uint64_t HowMany, std::vector<GWObjects::Statistics> &Stats);
 
@@ -85,17 +187,25 @@ namespace OpenWifi {
 		bool CreateDefaultDevice(std::string & SerialNumber, std::string & Capabilities, std::string & Firmware, std::string &Compatible,const Poco::Net::IPAddress & IPAddress);
 
 		bool GetDevice(std::string &SerialNumber, GWObjects::Device &);
+		bool GetDevices(const std::vector<std::string> &SerialNumbers, std::vector<GWObjects::Device> &Devices, std::vector<std::string> &Missing);
 		bool GetDevices(uint64_t From, uint64_t HowMany, std::vector<GWObjects::Device> &Devices, const std::string & orderBy="");
+		bool GetDevices(const PageCursor & After, uint64_t HowMany, std::vector<GWObjects::Device> &Devices, PageCursor & Next);
 //		bool GetDevices(uint64_t From, uint64_t HowMany, const std::string & Select, std::vector<GWObjects::Device> &Devices, const std::string & orderBy="");
 		bool DeleteDevice(std::string &SerialNumber);
-		bool UpdateDevice(GWObjects::Device &);
+		bool UpdateDevice(GWObjects::Device &, bool NewConfiguration=false);
 		bool DeviceExists(std::string & SerialNumber);
 		bool SetConnectInfo(std::string &SerialNumber, std::string &Firmware);
 		bool GetDeviceCount(uint64_t & Count);
 		bool GetDeviceSerialNumbers(uint64_t From, uint64_t HowMany, std::vector<std::string> & SerialNumbers, const std::string & orderBy="");
+		bool GetDeviceSerialNumbers(const PageCursor & After, uint64_t HowMany, std::vector<std::string> & SerialNumbers, PageCursor & Next);
 		bool GetDeviceFWUpdatePolicy(std::string & SerialNumber, std::string & Policy);
 		bool SetDevicePassword(std::string & SerialNumber, std::string & Password);
 		bool UpdateSerialNumberCache();
+		bool GetCacheMarker(CacheMarker &Marker);
+		void BumpCacheGeneration();
+		//	held shared by writers from their database change until their cache update, and exclusively to read the
+		//	marker and the caches as one consistent snapshot
+		inline std::shared_mutex & CacheMutex() { return CacheMutex_; }
 		void GetDeviceDbFieldList( Types::StringVec & Fields);
 
 		bool ExistingConfiguration(std::string &SerialNumber, uint64_t CurrentConfig, std::string &NewConfig, uint64_t &);
@@ -108,6 +218,8 @@ namespace OpenWifi {
 
 		bool GetLogData(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate, uint64_t Offset, uint64_t HowMany,
 						std::vector<GWObjects::DeviceLog> &Stats, uint64_t Type);
+		bool GetLogData(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate, const PageCursor & After, uint64_t HowMany,
+						std::vector<GWObjects::DeviceLog> &Stats, uint64_t Type, PageCursor & Next);
 		bool DeleteLogData(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate, uint64_t Type);
 		bool GetNewestLogData(std::string &SerialNumber, uint64_t HowMany, std::vector<GWObjects::DeviceLog> &Stats, uint64_t Type);
 
@@ -122,6 +234,7 @@ namespace OpenWifi {
 
 		bool AddCommand(std::string & SerialNumber, GWObjects::CommandDetails & Command,CommandExecutionType Type);
 		bool GetCommands(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate, uint64_t Offset, uint64_t HowMany, std::vector<GWObjects::CommandDetails> & Commands);
+		bool GetCommands(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate, const PageCursor & After, uint64_t HowMany, std::vector<GWObjects::CommandDetails> & Commands, PageCursor & Next);
 		bool DeleteCommands(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate);
 		bool GetNonExecutedCommands( uint64_t Offset, uint64_t HowMany, std::vector<GWObjects::CommandDetails> & Commands );
 		bool UpdateCommand( std::string &UUID, GWObjects::CommandDetails & Command );
@@ -131,7 +244,7 @@ namespace OpenWifi {
 		bool CommandExecuted(std::string & UUID);
 		bool CommandCompleted(std::string & UUID, const Poco::JSON::Object & ReturnVars, const std::chrono::duration<double, std::milli> & execution_time, bool FullCommand);
 //		bool AttachFileToCommand(std::string & UUID);
-		bool AttachFileDataToCommand(std::string & UUID, const std::stringstream &s);
+		bool AttachFileDataToCommand(std::string & UUID, uint64_t Size);
 		bool CancelWaitFile( std::string & UUID, std::string & ErrorText );
 //		bool GetAttachedFile(std::string & UUID, const std::string & SerialNumber, const std::string & FileName, std::string &Type);
 		bool GetAttachedFileContent(std::string & UUID, const std::string & SerialNumber, std::string & FileContent, std::string &Type);
@@ -142,12 +255,23 @@ namespace OpenWifi {
 
 		bool RemoveOldCommands(std::string & SerilNumber, std::string & Command);
 
+		//	Configurations sent to devices, stored once per distinct content. See storage_configurations.cpp.
+		bool AddConfigurationBlob(const std::string & Configuration, std::string & Hash);
+		bool GetConfigurationBlob(const std::string & Hash, std::string & Configuration);
+		bool AddDeviceConfiguration(const std::string & SerialNumber, uint64_t UUID, const std::string & Hash);
+		bool GetDeviceConfiguration(const std::string & SerialNumber, uint64_t UUID, std::string & Configuration);
+		bool CompactCommandDetails(const std::string & SerialNumber, const std::string & Details, std::string & Compacted);
+		void ExpandCommandDetails(GWObjects::CommandDetails & Command);
+		bool RemoveConfigurationsOlderThan(uint64_t Date);
+
 		bool AddBlackListDevices(std::vector<GWObjects::BlackListedDevice> &  Devices);
 		bool AddBlackListDevice(GWObjects::BlackListedDevice &  Device);
 		bool GetBlackListDevice(std::string & SerialNumber, GWObjects::BlackListedDevice & Device);
 		bool DeleteBlackListDevice(std::string & SerialNumber);
 		bool IsBlackListed(std::string & SerialNumber);
 		bool InitializeBlackListCache();
+		void GetBlackListCache(std::vector<uint64_t> &Serials, std::vector<std::string> &Others);
+		void SetBlackListCache(std::vector<uint64_t> Serials, std::vector<std::string> Others);
 		bool GetBlackListDevices(uint64_t Offset, uint64_t HowMany, std::vector<GWObjects::BlackListedDevice> & Devices );
 		bool UpdateBlackListDevice(std::string & SerialNumber, GWObjects::BlackListedDevice & Device);
 		uint64_t GetBlackListDeviceCount();
@@ -167,6 +291,8 @@ namespace OpenWifi {
 		int Create_CommandList();
 		int Create_BlackList();
 		int Create_FileUploads();
+		int Create_Configurations();
+		int Create_CacheGeneration();
 
 		bool AnalyzeCommands(Types::CountedMap &R);
 		bool AnalyzeDevices(GWObjects::Dashboard &D);
@@ -175,7 +301,15 @@ namespace OpenWifi {
 		void 	Stop() override;
 
 	  private:
+		static constexpr std::size_t 	MaxCachedBlobs = 256;
+
+		std::shared_mutex	CacheMutex_;
+		std::atomic_bool 	CacheGenerationLost_ = false;	//	a bump failed: no marker can be trusted until restart
+		std::mutex 			BlobMutex_;
+		std::map<std::string, std::shared_ptr<const std::string>>	Blobs_;		//	recently used configurations, by hash
 
+		std::shared_ptr<const std::string> CachedBlob(const std::string & Hash);
+		void CacheBlob(const std::string & Hash, const std::string & Configuration);
    };
 
    inline auto StorageService() { return Storage::instance(); }
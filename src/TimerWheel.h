@@ -0,0 +1,129 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace OpenWifi {
+
+	//	Hierarchical timer wheel: 4 levels of 64 slots, so a wheel with 1s ticks holds timers up to 194 days away.
+	//	Scheduling and cancelling are O(1), and a timer is touched at most once per level before it expires, whatever
+	//	the number of timers. Entries live in their owner, the wheel only links them.
+	template <typename T> class TimerWheel {
+	  public:
+		static constexpr uint64_t SlotBits = 6;
+		static constexpr uint64_t Slots = 1 << SlotBits;
+		static constexpr uint64_t Levels = 4;
+		static constexpr uint64_t MaxTicks = ((uint64_t)1 << (SlotBits * Levels)) - 1;
+
+		struct Entry {
+			explicit Entry(T *O) : Owner(O) {}
+			T			*Owner;
+			Entry 		*Prev = nullptr, *Next = nullptr;
+			Entry 		**Head = nullptr;			//	the slot holding the entry, null when it is not scheduled
+			uint64_t 	Tick = 0;
+		};
+
+		TimerWheel(uint64_t TickMs, uint64_t NowMs) : TickMs_(std::max((uint64_t)1, TickMs)), Current_(NowMs / TickMs_) {}
+
+		//	(re)arms E to expire at AtMs, at least one tick from now
+		inline void Schedule(Entry &E, uint64_t AtMs) {
+			std::lock_guard	G(Mutex_);
+			Unlink(E);
+			Place(E, std::max((AtMs + TickMs_ - 1) / TickMs_, Current_ + 1));
+		}
+
+		inline void Cancel(Entry &E) {
+			std::lock_guard	G(Mutex_);
+			Unlink(E);
+		}
+
+		[[nodiscard]] inline uint64_t Size() const { return Size_; }
+
+		//	Moves the wheel to NowMs and calls Expired(Owner) for every timer that went off, with the wheel unlocked so
+		//	Expired may schedule or cancel timers. Owners must not be destroyed by another thread meanwhile.
+		template <typename F> void Advance(uint64_t NowMs, F &&Expired) {
+			{
+				std::lock_guard	G(Mutex_);
+				for(auto Target = NowMs / TickMs_; Current_ < Target; ) {
+					Current_++;
+					for(uint64_t Level = 1; Level < Levels && Index(Current_, Level - 1) == 0; Level++)
+						Cascade(Wheel_[Level][Index(Current_, Level)]);
+					auto &Slot = Wheel_[0][Index(Current_, 0)];
+					while(Slot) {
+						auto E = Slot;
+						Unlink(*E);
+						Fired_.push_back(E->Owner);
+					}
+				}
+			}
+			for(auto Owner:Fired_)
+				Expired(Owner);
+			Fired_.clear();
+		}
+
+	  private:
+		std::mutex 			Mutex_;
+		uint64_t 			TickMs_;
+		uint64_t 			Current_;
+		std::atomic_uint64_t	Size_ = 0;
+		std::array<std::array<Entry *, Slots>, Levels>	Wheel_{};
+		std::vector<T *>	Fired_;
+
+		static inline uint64_t Index(uint64_t Tick, uint64_t Level) { return (Tick >> (SlotBits * Level)) & (Slots - 1); }
+
+		inline void Place(Entry &E, uint64_t Tick) {
+			Tick = std::min(Tick, Current_ + MaxTicks);
+			auto Delta = Tick - Current_;
+			uint64_t Level = 0;
+			while(Level < Levels - 1 && Delta >= ((uint64_t)1 << (SlotBits * (Level + 1))))
+				Level++;
+			auto &Head = Wheel_[Level][Index(Tick, Level)];
+			E.Tick = Tick;
+			E.Prev = nullptr;
+			E.Next = Head;
+			if(Head)
+				Head->Prev = &E;
+			Head = &E;
+			E.Head = &Head;
+			Size_++;
+		}
+
+		inline void Unlink(Entry &E) {
+			if(!E.Head)
+				return;
+			if(E.Prev)
+				E.Prev->Next = E.Next;
+			else
+				*E.Head = E.Next;
+			if(E.Next)
+				E.Next->Prev = E.Prev;
+			E.Prev = E.Next = nullptr;
+			E.Head = nullptr;
+			Size_--;
+		}
+
+		//	moves the timers of a higher level slot down now that their time is near
+		inline void Cascade(Entry *&Slot) {
+			auto E = Slot;
+			Slot = nullptr;
+			while(E) {
+				auto Next = E->Next;
+				E->Head = nullptr;
+				Size_--;
+				Place(*E, std::max(E->Tick, Current_));
+				E = Next;
+			}
+		}
+	};
+}
@@ -25,11 +25,80 @@
 #include "CentralConfig.h"
 #include "FindCountry.h"
 #include "framework/WebSocketClientNotifications.h"
+#include "DeviceStatisticsNotifier.h"
+#include "FrameRecorder.h"
+#include "IngressLimiter.h"
+#include "framework/Metrics.h"
 
 #include "RADIUS_proxy_server.h"
 
 namespace OpenWifi {
 
+	struct FrameMetrics {
+		Metrics::Counter	&Frames;
+		Metrics::Counter	&Bytes;
+		Metrics::Counter	&Compressed;
+		Metrics::Counter	&Inflated;
+	};
+
+	//	one set per reactor thread, so reactors never write to the same counters
+	static FrameMetrics & ReactorMetrics() {
+		thread_local FrameMetrics	M = [] {
+			auto Thread = Poco::Thread::current();
+			Metrics::Labels	L{{"reactor", Thread ? Thread->name() : "main"}};
+			return FrameMetrics{
+				.Frames = Metrics::GetCounter("owgw_websocket_frames_total", "Frames received from devices, by reactor thread.", L),
+				.Bytes = Metrics::GetCounter("owgw_websocket_received_bytes_total", "Bytes received from devices, by reactor thread.", L),
+				.Compressed = Metrics::GetCounter("owgw_websocket_compressed_bytes_total", "Bytes received in permessage-deflate frames, by reactor thread.", L),
+				.Inflated = Metrics::GetCounter("owgw_websocket_inflated_bytes_total", "Bytes those frames inflated to, by reactor thread.", L)};
+		}();
+		return M;
+	}
+
+	static Metrics::Histogram * EventLatency(uCentralProtocol::Events::EVENT_MSG Event) {
+		using namespace uCentralProtocol::Events;
+		static const auto Histograms = [] {
+			//	in EVENT_MSG order
+			const char *Names[] = {"unknown", CONNECT, STATE, HEALTHCHECK, LOG, CRASHLOG, PING, CFGPENDING, RECOVERY,
+								   DEVICEUPDATE, TELEMETRY};
+			std::array<Metrics::Histogram *, ET_TELEMETRY + 1>	H{};
+			for(std::size_t i=0;i<H.size();i++)
+				H[i] = &Metrics::GetHistogram("owgw_event_duration_seconds", "Time spent processing device events, by method.",
+											  {{"method", Names[i]}});
+			return H;
+		}();
+		return Event < Histograms.size() ? Histograms[Event] : nullptr;
+	}
+
+	//	devices that compress each message on its own share their reactor's inflater, which keeps nothing
+	//	between messages
+	static PerMessageDeflate::Inflater & ReactorInflater() {
+		thread_local PerMessageDeflate::Inflater	I(PerMessageDeflate::MaxWindowBits);
+		return I;
+	}
+
+	//	memory held by the inflaters of connections with context takeover
+	static std::atomic_int64_t & InflaterMemory() {
+		static std::atomic_int64_t	Bytes = 0;
+		[[maybe_unused]] static bool Registered = [] {
+			Metrics::Registry()->AddGauge("owgw_websocket_inflater_bytes", "Approximate memory held by the permessage-deflate windows of device connections.",
+										  {}, [] { return (double) Bytes.load(std::memory_order_relaxed); });
+			return true;
+		}();
+		return Bytes;
+	}
+
+	static inline int64_t InflaterSize(int WindowBits) { return ((int64_t)1 << WindowBits) + 7 * 1024; }
+
+	//	a miss costs a device read from the database
+	static Metrics::Counter & ConfigCacheLookups(bool Hit) {
+		static auto &Hits = Metrics::GetCounter("owgw_config_cache_lookups_total",
+												"Configuration checks of device messages, by configuration cache result.", {{"result", "hit"}});
+		static auto &Misses = Metrics::GetCounter("owgw_config_cache_lookups_total",
+												  "Configuration checks of device messages, by configuration cache result.", {{"result", "miss"}});
+		return Hit ? Hits : Misses;
+	}
+
 	void WSConnection::LogException(const Poco::Exception &E) {
 		Logger().information(fmt::format("EXCEPTION({}): {}", CId_, E.displayText()));
 	}
@@ -96,8 +165,23 @@ namespace OpenWifi {
 			Response.setVersion(Request.getVersion());
 			Response.setKeepAlive(Params->getKeepAlive() && Request.getKeepAlive() &&
 								  Session.canKeepAlive());
+			PerMessageDeflate::Parameters	Deflate;
+			auto Extension = PerMessageDeflate::Negotiate(Request.get("Sec-WebSocket-Extensions", ""),
+														  WebSocketServer()->DeflateSettings(), Deflate);
+			if (!Extension.empty()) {
+				//	sent along with the 101 by the WebSocket constructor
+				Response.set("Sec-WebSocket-Extensions", Extension);
+				Deflate_ = true;
+				if (!Deflate.ClientNoContextTakeover) {
+					InflaterBits_ = std::max(Deflate.ClientMaxWindowBits, PerMessageDeflate::MinWindowBits);
+					Inflater_ = std::make_unique<PerMessageDeflate::Inflater>(InflaterBits_);
+					InflaterMemory() += InflaterSize(InflaterBits_);
+				}
+			}
 			WS_ = std::make_unique<Poco::Net::WebSocket>(Request, Response);
 			WS_->setMaxPayloadSize(BufSize);
+			//	the device type is only known once the device has sent its connect event
+			Ingress_.SetProfile(IngressLimiter()->ProfileFor(""), Reactor_.Now());
 			auto TS = Poco::Timespan(360, 0);
 
 			WS_->setReceiveTimeout(TS);
@@ -113,6 +197,9 @@ namespace OpenWifi {
 			Reactor_.addEventHandler(*WS_, Poco::NObserver<WSConnection, Poco::Net::ErrorNotification>(
 											   *this, &WSConnection::OnSocketError));
 			Registered_ = true;
+			LastReceived_ = Reactor_.Now();
+			if (Reactor_.LivenessSettings().Enabled)
+				Reactor_.Wheel().Schedule(LivenessTimer_, LastReceived_ + Reactor_.LivenessSettings().IdleMs);
 			Logger().information(fmt::format("CONNECTION({}): completed.", CId_));
 			return;
 		} catch (const Poco::Net::CertificateValidationException &E) {
@@ -177,6 +264,14 @@ namespace OpenWifi {
 
 	WSConnection::~WSConnection() {
 
+		Reactor_.Wheel().Cancel(LivenessTimer_);
+
+		if (Inflater_)
+			InflaterMemory() -= InflaterSize(InflaterBits_);
+
+		if (!SerialNumber_.empty() && Ingress_.Pending())
+			IngressLimiter()->Report(SerialNumber_, Compatible_, Ingress_.Take(Reactor_.Now()));
+
 		if (ConnectionId_)
 			DeviceRegistry()->UnRegister(SerialNumberInt_, ConnectionId_);
 
@@ -203,20 +298,26 @@ namespace OpenWifi {
 			t.detach();
 		}
 
-		WebSocketClientNotificationDeviceDisconnected(SerialNumber_);
+		DeviceStatisticsNotifier()->Remove(SerialNumberInt_, ConnectionId_);
+		WebSocketClientNotificationDeviceDisconnected(SerialNumber_, Venue_);
 	}
 
 	bool WSConnection::LookForUpgrade(const uint64_t UUID, uint64_t & UpgradedUUID) {
 
+		//	configuration patches are made against what the device runs, not what it was last sent
+		Conn_->Conn_.runningUUID = UUID;
+
 		//	A UUID of zero means ignore updates for that connection.
 		if (UUID == 0)
 			return false;
 
-		uint64_t GoodConfig = ConfigurationCache().CurrentConfig(SerialNumberInt_);
+		uint64_t GoodConfig = GetCurrentConfigurationID(SerialNumberInt_);
 		if (GoodConfig && (GoodConfig == UUID || GoodConfig == Conn_->Conn_.PendingUUID)) {
+			ConfigCacheLookups(true).Add();
 			UpgradedUUID = UUID;
 			return false;
 		}
+		ConfigCacheLookups(false).Add();
 
 		GWObjects::Device D;
 		if (StorageService()->GetDevice(SerialNumber_, D)) {
@@ -224,7 +325,7 @@ namespace OpenWifi {
 			//	This is the case where the cache is empty after a restart. So GoodConfig will 0. If the device already 	has the right UUID, we just return.
 			if (D.UUID == UUID) {
 				UpgradedUUID = UUID;
-				ConfigurationCache().Add(SerialNumberInt_, UUID);
+				SetCurrentConfigurationID(SerialNumberInt_, UUID);
 				return false;
 			}
 
@@ -236,7 +337,7 @@ namespace OpenWifi {
 				UpgradedUUID = D.UUID;
 				Cfg.SetUUID(D.UUID);
 				D.Configuration = Cfg.get();
-				StorageService()->UpdateDevice(D);
+				StorageService()->UpdateDevice(D, true);
 			}
 
 			UpgradedUUID = D.UUID;
@@ -265,7 +366,7 @@ namespace OpenWifi {
 			StorageService()->AddCommand(SerialNumber_, Cmd, Storage::COMMAND_EXECUTED);
 			CommandManager()->PostCommand(SerialNumber_, Cmd.Command, Params, Cmd.UUID, Sent);
 
-			WebSocketClientNotificationDeviceConfigurationChange(D.SerialNumber, UUID, UpgradedUUID);
+			WebSocketClientNotificationDeviceConfigurationChange(D.SerialNumber, UUID, UpgradedUUID, D.Venue);
 
 			return true;
 		}
@@ -276,50 +377,93 @@ namespace OpenWifi {
 		CommandManager()->PostCommandResult(SerialNumber_, *Doc);
 	}
 
+	WSConnection::FrameType WSConnection::ParseFrame(const std::string &Frame, Poco::JSON::Object::Ptr &Doc) {
+		Poco::JSON::Parser parser;
+		Doc = parser.parse(Frame).extract<Poco::JSON::Object::Ptr>();
+		if (Doc->has(uCentralProtocol::JSONRPC)) {
+			if (Doc->has(uCentralProtocol::METHOD) && Doc->has(uCentralProtocol::PARAMS))
+				return FrameType::EVENT;
+			if (Doc->has(uCentralProtocol::RESULT) && Doc->has(uCentralProtocol::ID))
+				return FrameType::RESULT;
+			return FrameType::INVALID_RPC;
+		}
+		if (Doc->has(uCentralProtocol::RADIUS))
+			return FrameType::RADIUS;
+		return FrameType::NOT_RPC;
+	}
+
+	//	Params, expanded from compress_64 when the device sent it compressed. Uncompressed keeps the expanded text.
+	//	A compressed payload that is not valid JSON throws.
+	WSConnection::ParamsStatus WSConnection::ExpandParams(const Poco::JSON::Object::Ptr &Doc, Poco::JSON::Object::Ptr &Params,
+														  std::string &Uncompressed) {
+		if (!Doc->isObject(uCentralProtocol::PARAMS))
+			return ParamsStatus::NOT_AN_OBJECT;
+		Params = Doc->get(uCentralProtocol::PARAMS).extract<Poco::JSON::Object::Ptr>();
+		if (!Params->has(uCentralProtocol::COMPRESS_64))
+			return ParamsStatus::OK;
+
+		uint64_t compress_sz = 0 ;
+		if(Params->has("compress_sz")) {
+			compress_sz = Params->get("compress_sz");
+		}
+		if (!Utils::ExtractBase64CompressedData(Params->get(uCentralProtocol::COMPRESS_64).toString(), Uncompressed, compress_sz))
+			return ParamsStatus::CORRUPT_COMPRESSED_DATA;
+		Poco::JSON::Parser Parser;
+		Params = Parser.parse(Uncompressed).extract<Poco::JSON::Object::Ptr>();
+		return ParamsStatus::OK;
+	}
+
 	void WSConnection::ProcessJSONRPCEvent(Poco::JSON::Object::Ptr &Doc) {
 
 		auto Method = Doc->get(uCentralProtocol::METHOD).toString();
 		auto EventType = uCentralProtocol::Events::EventFromString(Method);
+		Metrics::ScopedTimer	Timer(EventLatency(EventType));
 		if (EventType == uCentralProtocol::Events::ET_UNKNOWN) {
 			poco_warning(Logger(),fmt::format("ILLEGAL-PROTOCOL({}): Unknown message type '{}'", CId_, Method));
 			Errors_++;
 			return;
 		}
 
-		if (!Doc->isObject(uCentralProtocol::PARAMS)) {
-			poco_warning(Logger(),fmt::format("MISSING-PARAMS({}): params must be an object.", CId_));
-			Errors_++;
-			return;
+		//	before the payload is expanded or stored, which is where a flooding device would cost the most
+		auto Class = IngressLimiter::ClassOf(EventType);
+		auto Admitted = Ingress_.Admit(Class, Reactor_.Now());
+		if (Admitted != IngressLimiter::ACCEPT) {
+			IngressLimiter()->Count(Class, Admitted);
+			if (Conn_ != nullptr)
+				(Admitted == IngressLimiter::DROP ? Conn_->Conn_.droppedMessages : Conn_->Conn_.sampledMessages)++;
+			if (!SerialNumber_.empty() && Ingress_.ReportDue(Reactor_.Now()))
+				IngressLimiter()->Report(SerialNumber_, Compatible_, Ingress_.Take(Reactor_.Now()));
+			if (Admitted == IngressLimiter::DROP) {
+				poco_trace(Logger(), fmt::format("INGRESS-LIMIT({}): {} message dropped.", CId_, Method));
+				return;
+			}
 		}
 
 		//  expand params if necessary
-		auto ParamsObj = Doc->get(uCentralProtocol::PARAMS).extract<Poco::JSON::Object::Ptr>();
-		if (ParamsObj->has(uCentralProtocol::COMPRESS_64)) {
-			std::string UncompressedData;
-			try {
-				auto CompressedData = ParamsObj->get(uCentralProtocol::COMPRESS_64).toString();
-				uint64_t compress_sz = 0 ;
-				if(ParamsObj->has("compress_sz")) {
-					compress_sz = ParamsObj->get("compress_sz");
-				}
-
-				if (Utils::ExtractBase64CompressedData(CompressedData, UncompressedData, compress_sz)) {
+		Poco::JSON::Object::Ptr ParamsObj;
+		std::string UncompressedData;
+		try {
+			switch (ExpandParams(Doc, ParamsObj, UncompressedData)) {
+			case ParamsStatus::NOT_AN_OBJECT:
+				poco_warning(Logger(),fmt::format("MISSING-PARAMS({}): params must be an object.", CId_));
+				Errors_++;
+				return;
+			case ParamsStatus::CORRUPT_COMPRESSED_DATA:
+				poco_warning(Logger(),fmt::format("INVALID-COMPRESSED-DATA({}): Compressed cannot be uncompressed - content must be corrupt..: size={}",
+													CId_, ParamsObj->get(uCentralProtocol::COMPRESS_64).toString().size()));
+				Errors_++;
+				return;
+			case ParamsStatus::OK:
+				if (!UncompressedData.empty())
 					poco_trace(Logger(),fmt::format("EVENT({}): Found compressed payload expanded to '{}'.",
 													  CId_, UncompressedData));
-					Poco::JSON::Parser Parser;
-					ParamsObj = Parser.parse(UncompressedData).extract<Poco::JSON::Object::Ptr>();
-				} else {
-					poco_warning(Logger(),fmt::format("INVALID-COMPRESSED-DATA({}): Compressed cannot be uncompressed - content must be corrupt..: size={}",
-														CId_, CompressedData.size()));
-					Errors_++;
-					return;
-				}
-			} catch (const Poco::Exception &E) {
-				poco_warning(Logger(),fmt::format("INVALID-COMPRESSED-JSON-DATA({}): Compressed cannot be parsed - JSON must be corrupt..",
-													CId_));
-				Logger().log(E);
-				return;
+				break;
 			}
+		} catch (const Poco::Exception &E) {
+			poco_warning(Logger(),fmt::format("INVALID-COMPRESSED-JSON-DATA({}): Compressed cannot be parsed - JSON must be corrupt..",
+												CId_));
+			Logger().log(E);
+			return;
 		}
 
 		if (!ParamsObj->has(uCentralProtocol::SERIAL)) {
@@ -363,6 +507,8 @@ namespace OpenWifi {
 				Conn_->Conn_.UUID = UUID;
 				Conn_->Conn_.Firmware = Firmware;
 				Conn_->Conn_.PendingUUID = 0;
+				Conn_->Conn_.runningUUID = UUID;
+				Conn_->Conn_.configPatch = ParamsObj->optValue(uCentralProtocol::CONFIG_PATCH, false);
 				Conn_->Conn_.LastContact = OpenWifi::Now();
 				Conn_->Conn_.Address = Utils::FormatIPv6(WS_->peerAddress().toString());
 				CId_ = SerialNumber_ + "@" + CId_;
@@ -387,6 +533,7 @@ namespace OpenWifi {
 				Conn_->Conn_.locale = FindCountryFromIP()->Get(IP);
 				GWObjects::Device	DeviceInfo;
 				auto DeviceExists = StorageService()->GetDevice(SerialNumber_,DeviceInfo);
+				Venue_ = DeviceInfo.Venue;
 				// std::cout << "Connecting: " << SerialNumber_ << std::endl;
 				if (Daemon()->AutoProvisioning() && !DeviceExists) {
 					StorageService()->CreateDefaultDevice(SerialNumber_, Capabilities, Firmware,
@@ -398,7 +545,7 @@ namespace OpenWifi {
 					if(!Firmware.empty() && Firmware!=DeviceInfo.Firmware) {
 						DeviceInfo.Firmware = Firmware;
 						Updated = true;
-						WebSocketClientNotificationDeviceFirmwareUpdated(SerialNumber_, Firmware);
+						WebSocketClientNotificationDeviceFirmwareUpdated(SerialNumber_, Firmware, Venue_);
 					}
 
 					if(DeviceInfo.locale != Conn_->Conn_.locale) {
@@ -419,8 +566,9 @@ namespace OpenWifi {
 					Conn_->Conn_.UUID = UpgradedUUID;
 				}
 				Conn_->Conn_.Compatible = Compatible_;
+				Ingress_.SetProfile(IngressLimiter()->ProfileFor(Compatible_), Reactor_.Now());
 
-				WebSocketClientNotificationDeviceConnected(SerialNumber_);
+				WebSocketClientNotificationDeviceConnected(SerialNumber_, Venue_);
 
 				if (KafkaManager()->Enabled()) {
 					Poco::JSON::Stringifier Stringify;
@@ -485,10 +633,7 @@ namespace OpenWifi {
 					KafkaManager()->PostMessage(KafkaTopics::STATE, SerialNumber_, OS.str());
 				}
 
-				WebSocketNotification<WebNotificationSingleDevice>	N;
-				N.content.serialNumber = SerialNumber_;
-				N.type = "device_statistics";
-				WebSocketClientServer()->SendNotification(N);
+				DeviceStatisticsNotifier()->Update(SerialNumberInt_, ConnectionId_, SerialNumber_, Venue_, Conn_->Conn_);
 
 			} else {
 				poco_warning(Logger(), fmt::format("STATE({}): Invalid request. Missing serial, uuid, or state", CId_));
@@ -893,6 +1038,35 @@ namespace OpenWifi {
 		}
 	}
 
+	//	Called by the reactor when the liveness timer goes off. Any frame from the device proves it is alive, so only a
+	//	connection silent since the last PING counts it as missed.
+	void WSConnection::CheckLiveness() {
+		std::lock_guard Guard(Mutex_);
+		const auto &Settings = Reactor_.LivenessSettings();
+		auto Now = Reactor_.Now();
+		if (Now - LastReceived_ < Settings.IdleMs) {
+			Reactor_.Wheel().Schedule(LivenessTimer_, LastReceived_ + Settings.IdleMs);
+			return;
+		}
+		if (MissedPongs_ >= Settings.MaxMissed) {
+			poco_information(Logger(), fmt::format("IDLE({}): silent for {}s and {} PINGs unanswered. Closing.", CId_,
+												   (Now - LastReceived_) / 1000, MissedPongs_));
+			Reactor_.CountReaped();
+			return delete this;
+		}
+		try {
+			WS_->sendFrame("", 0,
+						   (int)Poco::Net::WebSocket::FRAME_OP_PING | (int)Poco::Net::WebSocket::FRAME_FLAG_FIN);
+		} catch (const Poco::Exception &E) {
+			poco_information(Logger(), fmt::format("IDLE({}): PING could not be sent: {}. Closing.", CId_, E.displayText()));
+			return delete this;
+		}
+		poco_trace(Logger(), fmt::format("WS-PING({}): silent for {}s, PING sent.", CId_, (Now - LastReceived_) / 1000));
+		MissedPongs_++;
+		Reactor_.CountPing();
+		Reactor_.Wheel().Schedule(LivenessTimer_, Now + Settings.TimeoutMs);
+	}
+
 	std::string asString(Poco::Buffer<char> &buf) {
 		if (buf.sizeBytes() > 0) {
 			buf.append(0);
@@ -901,6 +1075,30 @@ namespace OpenWifi {
 		return "";
 	}
 
+	//	Replaces a compressed message by its inflated text. Compressed messages have to fit in one frame, like all
+	//	device messages.
+	bool WSConnection::InflateFrame(Poco::Buffer<char> &Frame, int Flags) {
+		auto Op = Flags & Poco::Net::WebSocket::FRAME_OP_BITMASK;
+		if (!Deflate_ || (Flags & Poco::Net::WebSocket::FRAME_FLAG_FIN) == 0 ||
+			(Op != Poco::Net::WebSocket::FRAME_OP_TEXT && Op != Poco::Net::WebSocket::FRAME_OP_BINARY))
+			return false;
+
+		static auto &Latency = Metrics::GetHistogram("owgw_websocket_inflate_duration_seconds",
+													 "Time spent inflating permessage-deflate messages.");
+		Metrics::ScopedTimer	Timer(Latency);
+		thread_local std::string	Message;
+		auto &Inflater = Inflater_ ? *Inflater_ : ReactorInflater();
+		if (!Inflater.Inflate(Frame.begin(), Frame.sizeBytes(), Message, WebSocketServer()->DeflateSettings().MaxMessageSize,
+							  !Inflater_))
+			return false;
+
+		auto &Counters = ReactorMetrics();
+		Counters.Compressed.Add(Frame.sizeBytes());
+		Counters.Inflated.Add(Message.size());
+		Frame.assign(Message.data(), Message.size());
+		return true;
+	}
+
 	void WSConnection::ProcessIncomingFrame() {
 
 		// bool MustDisconnect=false;
@@ -918,8 +1116,27 @@ namespace OpenWifi {
 				return delete this;
 			} else {
 
+				if (flags & PerMessageDeflate::FlagCompressed) {
+					if (!InflateFrame(IncomingFrame, flags)) {
+						poco_warning(Logger(), fmt::format("INVALID-COMPRESSED-FRAME({}): cannot inflate (length={}, flags={}). Disconnecting.",
+															CId_, IncomingSize, flags));
+						return delete this;
+					}
+					flags &= ~PerMessageDeflate::FlagCompressed;
+				}
+
 				std::string IncomingMessageStr = asString(IncomingFrame);
 
+				LastReceived_ = Reactor_.Now();
+				MissedPongs_ = 0;
+
+				auto &Counters = ReactorMetrics();
+				Counters.Frames.Add();
+				Counters.Bytes.Add(IncomingSize);
+
+				if (FrameRecorder()->Enabled())
+					FrameRecorder()->Record(SerialNumber_, flags, IncomingMessageStr);
+
 				// auto flag_fin = (flags & Poco::Net::WebSocket::FRAME_FLAG_FIN) == Poco::Net::WebSocket::FRAME_FLAG_FIN;
 				// auto flag_cont = (Op == Poco::Net::WebSocket::FRAME_OP_CONT) ;
 				//std::cout << "SerialNumber: " << SerialNumber_ << "  Size: " << std::dec
@@ -959,7 +1176,7 @@ namespace OpenWifi {
 				} break;
 
 				case Poco::Net::WebSocket::FRAME_OP_PONG: {
-					poco_trace(Logger(), fmt::format("PONG({}): received and ignored.", CId_));
+					poco_trace(Logger(), fmt::format("PONG({}): received.", CId_));
 					return;
 				} break;
 
@@ -967,32 +1184,32 @@ namespace OpenWifi {
 					poco_trace(Logger(), fmt::format("FRAME({}): Frame received (length={}, flags={}). Msg={}", CId_,
 									 IncomingSize, flags, IncomingMessageStr));
 
-					Poco::JSON::Parser parser;
-					auto ParsedMessage = parser.parse(IncomingMessageStr);
-					auto IncomingJSON = ParsedMessage.extract<Poco::JSON::Object::Ptr>();
-
-					if (IncomingJSON->has(uCentralProtocol::JSONRPC)) {
-						if (IncomingJSON->has(uCentralProtocol::METHOD) &&
-							IncomingJSON->has(uCentralProtocol::PARAMS)) {
-							ProcessJSONRPCEvent(IncomingJSON);
-						} else if (IncomingJSON->has(uCentralProtocol::RESULT) &&
-								   IncomingJSON->has(uCentralProtocol::ID)) {
-							poco_trace(Logger(), fmt::format("RPC-RESULT({}): payload: {}", CId_, IncomingMessageStr));
-							ProcessJSONRPCResult(IncomingJSON);
-						} else {
-							poco_warning(Logger(),
-								fmt::format("INVALID-PAYLOAD({}): Payload is not JSON-RPC 2.0: {}",
-											 CId_, IncomingMessageStr));
-						}
-					} else if (IncomingJSON->has(uCentralProtocol::RADIUS)) {
+					Poco::JSON::Object::Ptr IncomingJSON;
+					switch (ParseFrame(IncomingMessageStr, IncomingJSON)) {
+					case FrameType::EVENT:
+						ProcessJSONRPCEvent(IncomingJSON);
+						break;
+					case FrameType::RESULT:
+						poco_trace(Logger(), fmt::format("RPC-RESULT({}): payload: {}", CId_, IncomingMessageStr));
+						ProcessJSONRPCResult(IncomingJSON);
+						break;
+					case FrameType::INVALID_RPC:
+						poco_warning(Logger(),
+							fmt::format("INVALID-PAYLOAD({}): Payload is not JSON-RPC 2.0: {}",
+										 CId_, IncomingMessageStr));
+						break;
+					case FrameType::RADIUS:
 						ProcessIncomingRadiusData(IncomingJSON);
-					} else {
+						break;
+					case FrameType::NOT_RPC: {
 							std::ostringstream iS;
 							IncomingJSON->stringify(iS);
 							std::cout << iS.str() << std::endl;
 							poco_warning(Logger(), fmt::format(
 													   "FRAME({}): illegal transaction header, missing 'jsonrpc'", CId_));
 							Errors_++;
+						}
+						break;
 					}
 					return;
 				} break;
@@ -1076,6 +1293,14 @@ namespace OpenWifi {
 		return BytesSent == Payload.size();
 	}
 
+	//	Starts the closing handshake. The device answers with its own CLOSE frame, which ends the connection on the
+	//	reactor thread as when the device closes first.
+	void WSConnection::Close() {
+		std::lock_guard Guard(Mutex_);
+		if (WS_)
+			WS_->shutdown(Poco::Net::WebSocket::WS_ENDPOINT_GOING_AWAY, "gateway shutting down");
+	}
+
 	std::string Base64Encode(const unsigned char *buffer, std::size_t size) {
 		std::istringstream s(std::string{(const char *)buffer,size});
 		std::ostringstream o;
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <string>
+#include "Poco/Buffer.h"
 #include "Poco/Net/SocketReactor.h"
 #include "Poco/Net/StreamSocket.h"
 #include "Poco/JSON/Object.h"
@@ -13,6 +14,9 @@
 #include "Poco/Net/WebSocket.h"
 
 #include "DeviceRegistry.h"
+#include "IngressLimiter.h"
+#include "PerMessageDeflate.h"
+#include "WS_ReactorPool.h"
 #include "RESTObjects/RESTAPI_GWobjects.h"
 
 namespace OpenWifi {
@@ -23,18 +27,27 @@ namespace OpenWifi {
 		WSConnection(Poco::Net::StreamSocket& Socket, Poco::Net::SocketReactor& Reactor);
 		~WSConnection();
 
+		//	The decoding of a text frame, without side effects: shared with owgw_bench so it measures this code.
+		enum class FrameType { EVENT, RESULT, RADIUS, INVALID_RPC, NOT_RPC };
+		enum class ParamsStatus { OK, NOT_AN_OBJECT, CORRUPT_COMPRESSED_DATA };
+		static FrameType ParseFrame(const std::string &Frame, Poco::JSON::Object::Ptr &Doc);
+		static ParamsStatus ExpandParams(const Poco::JSON::Object::Ptr &Doc, Poco::JSON::Object::Ptr &Params,
+										 std::string &Uncompressed);
+
 		void ProcessJSONRPCEvent(Poco::JSON::Object::Ptr & Doc);
 		void ProcessJSONRPCResult(Poco::JSON::Object::Ptr Doc);
 		void ProcessIncomingFrame();
 		void ProcessIncomingRadiusData(const Poco::JSON::Object::Ptr &Doc);
 
 		bool Send(const std::string &Payload);
+		void Close();
 		bool SendRadiusAuthenticationData(const unsigned char * buffer, std::size_t size);
 		bool SendRadiusAccountingData(const unsigned char * buffer, std::size_t size);
 
 		void OnSocketReadable(const Poco::AutoPtr<Poco::Net::ReadableNotification>& pNf);
 		void OnSocketShutdown(const Poco::AutoPtr<Poco::Net::ShutdownNotification>& pNf);
 		void OnSocketError(const Poco::AutoPtr<Poco::Net::ErrorNotification>& pNf);
+		void CheckLiveness();
 		bool LookForUpgrade(const uint64_t UUID, uint64_t & UpgradedUUID);
 		static bool ExtractBase64CompressedData(const std::string & CompressedData, std::string & UnCompressedData, uint64_t compress_sz);
 		void LogException(const Poco::Exception &E);
@@ -63,11 +76,12 @@ namespace OpenWifi {
 		std::recursive_mutex                Mutex_;
 		Poco::Logger                    	&Logger_;
 		Poco::Net::StreamSocket       		Socket_;
-		Poco::Net::SocketReactor			& Reactor_;
+		WSReactor							& Reactor_;
 		std::unique_ptr<Poco::Net::WebSocket> WS_;
 		std::string                         SerialNumber_;
 		uint64_t 							SerialNumberInt_=0;
 		std::string 						Compatible_;
+		std::string 						Venue_;
 		std::shared_ptr<DeviceRegistry::ConnectionEntry> 	Conn_;
 		bool                                Registered_ = false ;
 		std::string 						CId_;
@@ -85,8 +99,16 @@ namespace OpenWifi {
 		mutable uint64_t 					TelemetryInterval_ = 0;
 		mutable uint64_t 					TelemetryWebSocketPackets_=0;
 		mutable uint64_t 					TelemetryKafkaPackets_=0;
+		TimerWheel<WSConnection>::Entry		LivenessTimer_{this};
+		uint64_t 							LastReceived_=0;
+		uint64_t 							MissedPongs_=0;
+		bool 								Deflate_=false;		//	the device negotiated permessage-deflate
+		std::unique_ptr<PerMessageDeflate::Inflater>	Inflater_;	//	only with context takeover, or the reactor's is used
+		int 								InflaterBits_=0;
+		IngressLimiter::Buckets				Ingress_;
 
 		void CompleteStartup();
+		bool InflateFrame(Poco::Buffer<char> &Frame, int Flags);
 		bool StartTelemetry();
 		bool StopTelemetry();
 		void UpdateCounts();
@@ -0,0 +1,42 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#include "WS_ReactorPool.h"
+#include "WS_Connection.h"
+
+namespace OpenWifi {
+
+	WSReactor::WSReactor(const std::string &Name, const Liveness &L) :
+		Liveness_(L),
+		Now_(Clock()),
+		Wheel_(TickMs, Now_),
+		Pings_(Metrics::GetCounter("owgw_websocket_liveness_pings_total", "PINGs sent to silent devices, by reactor thread.", {{"reactor", Name}})),
+		Reaped_(Metrics::GetCounter("owgw_websocket_reaped_total", "Connections closed after unanswered PINGs, by reactor thread.", {{"reactor", Name}})) {
+		Metrics::Registry()->AddGauge("owgw_websocket_liveness_tracked", "Connections watched for liveness, by reactor thread.",
+									  {{"reactor", Name}}, [this] { return (double) Wheel_.Size(); });
+	}
+
+	void WSReactor::onBusy() {
+		Tick();
+		SocketReactor::onBusy();
+	}
+
+	void WSReactor::onTimeout() {
+		Tick();
+		SocketReactor::onTimeout();
+	}
+
+	//	called after every poll: one clock read, and the wheel is only moved once per tick
+	void WSReactor::Tick() {
+		auto Now = Clock();
+		Now_.store(Now, std::memory_order_relaxed);
+		if(Now < NextTick_)
+			return;
+		NextTick_ = Now - (Now % TickMs) + TickMs;
+		Wheel_.Advance(Now, [](WSConnection *Connection) { Connection->CheckLiveness(); });
+	}
+}
@@ -8,10 +8,63 @@
 #include "Poco/Net/SocketAcceptor.h"
 #include "Poco/Environment.h"
 
+#include "framework/MicroService.h"
+#include "TimerWheel.h"
+
 namespace OpenWifi {
+	class WSConnection;
+
+	//	A reactor that also watches the liveness of its device connections: a connection that stays silent for
+	//	IdleMs is sent a PING, and it is closed once MaxMissed PINGs went unanswered for TimeoutMs each. The timers
+	//	are kept in a wheel advanced by the reactor thread itself, between two polls, so a connection is only ever
+	//	closed by the thread serving it.
+	class WSReactor : public Poco::Net::SocketReactor {
+	  public:
+		struct Liveness {
+			bool 		Enabled = true;
+			uint64_t 	IdleMs = 120000;
+			uint64_t 	TimeoutMs = 30000;
+			uint64_t 	MaxMissed = 3;
+		};
+
+		WSReactor(const std::string &Name, const Liveness &L);
+
+		//	milliseconds on the steady clock, read once per poll so frames can be time stamped for free
+		[[nodiscard]] inline uint64_t Now() const { return Now_.load(std::memory_order_relaxed); }
+		[[nodiscard]] inline const Liveness & LivenessSettings() const { return Liveness_; }
+		[[nodiscard]] inline TimerWheel<WSConnection> & Wheel() { return Wheel_; }
+		inline void CountPing() { Pings_.Add(); }
+		inline void CountReaped() { Reaped_.Add(); }
+
+		static inline uint64_t Clock() {
+			return (uint64_t) std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+	  protected:
+		void onBusy() override;
+		void onTimeout() override;
+
+	  private:
+		static constexpr uint64_t TickMs = 1000;
+
+		Liveness 					Liveness_;
+		std::atomic_uint64_t 		Now_;
+		uint64_t 					NextTick_ = 0;
+		TimerWheel<WSConnection>	Wheel_;
+		Metrics::Counter 			&Pings_;
+		Metrics::Counter 			&Reaped_;
+
+		void Tick();
+	};
+
 	class ReactorThreadPool {
 	  public:
 		explicit ReactorThreadPool() {
+			Liveness_.Enabled = MicroService::instance().ConfigGetBool("openwifi.websocket.liveness.enable", Liveness_.Enabled);
+			Liveness_.IdleMs = 1000 * MicroService::instance().ConfigGetInt("openwifi.websocket.liveness.idle", Liveness_.IdleMs / 1000);
+			Liveness_.TimeoutMs = 1000 * MicroService::instance().ConfigGetInt("openwifi.websocket.liveness.timeout", Liveness_.TimeoutMs / 1000);
+			Liveness_.MaxMissed = std::max((uint64_t)1, (uint64_t)MicroService::instance().ConfigGetInt("openwifi.websocket.liveness.maxmissed", Liveness_.MaxMissed));
 			if(Poco::Environment::processorCount()>8)
 				NumberOfThreads_ = Poco::Environment::processorCount()/2;
 			else
@@ -25,11 +78,12 @@ namespace OpenWifi {
 
 		void Start(const std::string & ThreadNamePrefix) {
 			for (uint64_t i = 0; i < NumberOfThreads_; ++i) {
-				auto NewReactor = std::make_unique<Poco::Net::SocketReactor>();
+				auto Name = ThreadNamePrefix + "#" + std::to_string(i);
+				auto NewReactor = std::make_unique<WSReactor>(Name, Liveness_);
 				auto NewThread = std::make_unique<Poco::Thread>();
 				NewThread->setStackSize(2000000);
 				NewThread->start(*NewReactor);
-				NewThread->setName(ThreadNamePrefix + "#" + std::to_string(i));
+				NewThread->setName(Name);
 				Reactors_.emplace_back(std::move(NewReactor));
 				Threads_.emplace_back(std::move(NewThread));
 			}
@@ -48,7 +102,7 @@ namespace OpenWifi {
 			}
 		}
 
-		Poco::Net::SocketReactor &NextReactor() {
+		WSReactor &NextReactor() {
 			std::lock_guard		G(Mutex_);
 			NextReactor_++;
 			NextReactor_ %= NumberOfThreads_;
@@ -59,7 +113,8 @@ namespace OpenWifi {
 		std::mutex			Mutex_;
 		uint64_t 			NumberOfThreads_;
 		uint64_t 			NextReactor_ = 0;
-		std::vector<std::unique_ptr<Poco::Net::SocketReactor>> Reactors_;
+		WSReactor::Liveness	Liveness_;
+		std::vector<std::unique_ptr<WSReactor>> Reactors_;
 		std::vector<std::unique_ptr<Poco::Thread>> Threads_;
 	};
 	inline auto ReactorThreadPool() { return ReactorThreadPool::instance(); }
@@ -6,9 +6,13 @@
 //	Arilia Wireless Inc.
 //
 
+#include <algorithm>
+#include <random>
+
 #include "Poco/Net/HTTPHeaderStream.h"
 #include "Poco/JSON/Array.h"
 
+#include "CommandManager.h"
 #include "ConfigurationCache.h"
 #include "TelemetryStream.h"
 #include "WS_Server.h"
@@ -65,6 +69,15 @@ namespace OpenWifi {
         SimulatorId_ = MicroService::instance().ConfigGetString("simulatorid","");
         SimulatorEnabled_ = !SimulatorId_.empty();
 
+		Deflate_.Enabled = MicroService::instance().ConfigGetBool("openwifi.websocket.deflate.enable", false);
+		Deflate_.WindowBits = std::clamp((int) MicroService::instance().ConfigGetInt("openwifi.websocket.deflate.windowbits", PerMessageDeflate::MaxWindowBits),
+										 PerMessageDeflate::MinWindowBits, PerMessageDeflate::MaxWindowBits);
+		Deflate_.ContextTakeover = MicroService::instance().ConfigGetBool("openwifi.websocket.deflate.contexttakeover", true);
+		Deflate_.MaxMessageSize = MicroService::instance().ConfigGetInt("openwifi.websocket.deflate.maxmessage", 1024 * 1024);
+		if(Deflate_.Enabled)
+			Logger().information(fmt::format("permessage-deflate: window bits {}, context takeover {}, largest message {} bytes.",
+											 Deflate_.WindowBits, Deflate_.ContextTakeover, Deflate_.MaxMessageSize));
+
 		ReactorThread_.setName("WS-DEVICE-REACTOR");
 		ReactorThread_.setStackSize(3000000);
 		ReactorThread_.start(Reactor_);
@@ -72,11 +85,60 @@ namespace OpenWifi {
         return 0;
     }
 
+	//	Lets devices leave a little at a time instead of all at once when the reactors stop: no new connections, the
+	//	commands in flight get a chance to complete, and the connections are closed in random order over a period.
+	//	Devices retry at the same interval after being closed, so their reconnections stay spread out as well.
+	//	The whole drain ends by openwifi.drain.timeout, which must stay below the grace period of the orchestrator
+	//	(30s by default for Kubernetes and Docker) less the Kafka flush that follows, or the gateway gets killed mid-way.
+	void WebSocketServer::Drain() {
+		if(!MicroService::instance().ConfigGetBool("openwifi.drain.enable", true))
+			return;
+
+		using namespace std::chrono_literals;
+		auto Deadline = std::chrono::steady_clock::now() +
+						std::chrono::seconds(MicroService::instance().ConfigGetInt("openwifi.drain.timeout", 18));
+
+		Logger().notice("Draining: no longer accepting device connections.");
+		Reactor_.stop();
+		ReactorThread_.join();
+		Acceptors_.clear();
+		Drained_ = true;
+
+		auto RPCDeadline = std::min(Deadline, std::chrono::steady_clock::now() +
+						   std::chrono::seconds(MicroService::instance().ConfigGetInt("openwifi.drain.rpctimeout", 5)));
+		while(CommandManager()->Outstanding() && std::chrono::steady_clock::now() < RPCDeadline)
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		if(CommandManager()->Outstanding())
+			Logger().warning(fmt::format("Draining: {} commands still unanswered.", CommandManager()->Outstanding()));
+
+		auto Devices = DeviceRegistry()->ConnectedDevices();
+		std::shuffle(Devices.begin(), Devices.end(), std::mt19937_64{std::random_device{}()});
+		//	keep a few seconds of the deadline for the closing handshakes
+		auto Left = std::chrono::duration_cast<std::chrono::milliseconds>(Deadline - 3s - std::chrono::steady_clock::now());
+		auto Period = std::clamp(std::chrono::milliseconds(1000 * MicroService::instance().ConfigGetInt("openwifi.drain.period", 10)),
+								 std::chrono::milliseconds(0), std::max(Left, std::chrono::milliseconds(0)));
+		Logger().notice(fmt::format("Draining: closing {} device connections over {}s.", Devices.size(),
+									std::chrono::duration_cast<std::chrono::seconds>(Period).count()));
+		auto Start = std::chrono::steady_clock::now();
+		for(std::size_t i=0;i<Devices.size();i++) {
+			std::this_thread::sleep_until(Start + Period * i / Devices.size());
+			DeviceRegistry()->Disconnect(Devices[i]);
+		}
+
+		//	the closing handshakes complete on the reactors
+		while(!DeviceRegistry()->ConnectedDevices().empty() && std::chrono::steady_clock::now() < Deadline)
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		Logger().notice(fmt::format("Draining: done, {} devices did not close their connection.",
+									DeviceRegistry()->ConnectedDevices().size()));
+	}
+
     void WebSocketServer::Stop() {
         Logger().notice("Stopping reactors...");
 		// ReactorPool_.Stop();
-		Reactor_.stop();
-		ReactorThread_.join();
+		if(!Drained_) {
+			Reactor_.stop();
+			ReactorThread_.join();
+		}
     }
 
 }      //namespace
@@ -34,6 +34,7 @@ namespace OpenWifi {
 
 		int Start() override;
 		void Stop() override;
+		void Drain() override;
 		bool IsCertOk() { return IssuerCert_!= nullptr; }
 		bool ValidateCertificate(const std::string & ConnectionId, const Poco::Crypto::X509Certificate & Certificate);
 		// Poco::Net::SocketReactor & GetNextReactor() { return ReactorPool_.NextReactor(); }
@@ -52,6 +53,7 @@ namespace OpenWifi {
 
 		inline bool UseProvisioning() const { return LookAtProvisioning_; }
 		inline bool UseDefaults() const { return UseDefaultConfig_; }
+		inline const PerMessageDeflate::Settings & DeflateSettings() const { return Deflate_; }
 
 	  private:
 		std::unique_ptr<Poco::Crypto::X509Certificate>	IssuerCert_;
@@ -65,6 +67,8 @@ namespace OpenWifi {
 		bool 							LookAtProvisioning_ = false;
 		bool 							UseDefaultConfig_ = true;
 		bool 							SimulatorEnabled_=false;
+		bool 							Drained_=false;
+		PerMessageDeflate::Settings		Deflate_;
 
 		WebSocketServer() noexcept:
 		    SubSystemServer("WebSocketServer", "WS-SVR", "ucentral.websocket") {
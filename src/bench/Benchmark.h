@@ -0,0 +1,206 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Poco/DateTime.h"
+#include "Poco/DateTimeFormatter.h"
+#include "Poco/Environment.h"
+#include "Poco/JSON/Array.h"
+#include "Poco/JSON/Object.h"
+#include "Poco/Runnable.h"
+#include "Poco/Thread.h"
+
+#include "fmt/format.h"
+
+namespace OpenWifi::Bench {
+
+	//	Keeps the compiler from dropping a computation whose result is never used.
+	template <typename T> inline void DoNotOptimize(const T &Value) {
+		asm volatile("" : : "r,m"(Value) : "memory");
+	}
+
+	//	Runs Iterations times the operation under test. Thread is the index of the calling thread, from 0 to the
+	//	number of threads of the run, so contention benchmarks can give each thread its own keys.
+	typedef std::function<void(uint64_t Thread, uint64_t Iterations)>	Function;
+
+	struct Result {
+		std::string 	Name;
+		uint64_t 		Threads = 1;
+		uint64_t 		Iterations = 0;		//	per thread
+		double 			RealNs = 0.0;		//	wall time per iteration of one thread
+		double 			CpuNs = 0.0;		//	process CPU time per iteration, all threads included
+		double 			ItemsPerSecond = 0.0;
+		double 			BytesPerSecond = 0.0;
+	};
+
+	//	A minimal harness in the spirit of Google Benchmark: each benchmark is calibrated until one run lasts at least
+	//	MinTime, then reported. The JSON output follows the Google Benchmark layout so its tools can compare runs.
+	class Suite {
+	  public:
+		Suite(double MinTime, const std::string &Filter) :
+			MinTime_(MinTime),
+			Filter_(Filter.empty() ? ".*" : Filter) {
+		}
+
+		inline void Add(const std::string &Name, Function F, const std::vector<uint64_t> &Threads = {1}, uint64_t BytesPerIteration = 0) {
+			for(const auto &T:Threads) {
+				auto FullName = T==1 ? Name : fmt::format("{}/threads:{}", Name, T);
+				if(std::regex_search(FullName, Filter_))
+					Entries_.push_back(Entry{.Name = FullName, .F = F, .Threads = T, .Bytes = BytesPerIteration});
+			}
+		}
+
+		inline void Run() {
+			std::cout << fmt::format("{:<56} {:>14} {:>14} {:>12} {:>14}", "Benchmark", "Time(ns)", "CPU(ns)", "Iterations", "Items/s") << std::endl;
+			for(const auto &E:Entries_) {
+				auto R = Measure(E);
+				std::cout << fmt::format("{:<56} {:>14.1f} {:>14.1f} {:>12} {:>14.0f}", R.Name, R.RealNs, R.CpuNs, R.Iterations, R.ItemsPerSecond) << std::endl;
+				Results_.push_back(R);
+			}
+		}
+
+		[[nodiscard]] inline const Result * Find(const std::string &Name) const {
+			for(const auto &R:Results_)
+				if(R.Name==Name)
+					return &R;
+			return nullptr;
+		}
+
+		inline void WriteJSON(std::ostream &OS, const std::string &Version) const {
+			Poco::JSON::Object	Report, Context;
+			Context.set("date", Poco::DateTimeFormatter::format(Poco::DateTime(), "%Y-%m-%dT%H:%M:%SZ"));
+			Context.set("host_name", Poco::Environment::nodeName());
+			Context.set("executable", "owgw_bench");
+			Context.set("num_cpus", std::thread::hardware_concurrency());
+			Context.set("owgw_version", Version);
+#ifdef NDEBUG
+			Context.set("library_build_type", "release");
+#else
+			Context.set("library_build_type", "debug");
+#endif
+			Report.set("context", Context);
+
+			Poco::JSON::Array	Benchmarks;
+			for(const auto &R:Results_) {
+				Poco::JSON::Object	B;
+				B.set("name", R.Name);
+				B.set("run_name", R.Name);
+				B.set("run_type", "iteration");
+				B.set("threads", R.Threads);
+				B.set("iterations", R.Iterations);
+				B.set("real_time", R.RealNs);
+				B.set("cpu_time", R.CpuNs);
+				B.set("time_unit", "ns");
+				B.set("items_per_second", R.ItemsPerSecond);
+				if(R.BytesPerSecond>0.0)
+					B.set("bytes_per_second", R.BytesPerSecond);
+				Benchmarks.add(B);
+			}
+			Report.set("benchmarks", Benchmarks);
+			Report.stringify(OS, 2);
+			OS << std::endl;
+		}
+
+	  private:
+		struct Entry {
+			std::string 	Name;
+			Function		F;
+			uint64_t 		Threads = 1;
+			uint64_t 		Bytes = 0;
+		};
+
+		double				MinTime_;
+		std::regex			Filter_;
+		std::vector<Entry>	Entries_;
+		std::vector<Result>	Results_;
+
+		static inline double CpuSeconds() {
+			timespec	T{};
+			clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &T);
+			return (double) T.tv_sec + (double) T.tv_nsec / 1e9;
+		}
+
+		//	Poco threads, since the gateway code names and looks up its threads through Poco::Thread::current()
+		class Runner : public Poco::Runnable {
+		  public:
+			Runner(const Entry &E, uint64_t Thread, uint64_t Iterations, std::atomic_uint64_t &Ready, std::atomic_bool &Go) :
+				E_(E), Thread_(Thread), Iterations_(Iterations), Ready_(Ready), Go_(Go) {
+			}
+
+			void run() final {
+				Ready_++;
+				while(!Go_)
+					std::this_thread::yield();
+				E_.F(Thread_, Iterations_);
+			}
+
+		  private:
+			const Entry 			&E_;
+			uint64_t 				Thread_, Iterations_;
+			std::atomic_uint64_t 	&Ready_;
+			std::atomic_bool 		&Go_;
+		};
+
+		//	runs F on every thread at once and returns the wall and CPU seconds until the last one is done
+		static inline void Once(const Entry &E, uint64_t Iterations, double &Real, double &Cpu) {
+			std::atomic_uint64_t	Ready = 0;
+			std::atomic_bool 		Go = false;
+			std::vector<std::unique_ptr<Runner>>		Runners;
+			std::vector<std::unique_ptr<Poco::Thread>>	Threads;
+			for(uint64_t T=0;T<E.Threads;T++) {
+				Runners.push_back(std::make_unique<Runner>(E, T, Iterations, Ready, Go));
+				Threads.push_back(std::make_unique<Poco::Thread>(fmt::format("bench-{}", T)));
+				Threads.back()->start(*Runners.back());
+			}
+			while(Ready!=E.Threads)
+				std::this_thread::yield();
+
+			auto Cpu0 = CpuSeconds();
+			auto Start = std::chrono::steady_clock::now();
+			Go = true;
+			for(auto &T:Threads)
+				T->join();
+			Real = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+			Cpu = CpuSeconds() - Cpu0;
+		}
+
+		inline Result Measure(const Entry &E) const {
+			uint64_t 	Iterations = 1;
+			double 		Real = 0.0, Cpu = 0.0;
+			while(true) {
+				Once(E, Iterations, Real, Cpu);
+				if(Real>=MinTime_ || Iterations>=1000000000)
+					break;
+				//	aim a little past MinTime so the next run is very likely the last one
+				auto Scale = Real<=0.0 ? 100.0 : std::min(100.0, std::max(1.5, MinTime_ * 1.4 / Real));
+				Iterations = std::min((uint64_t) 1000000000, (uint64_t) ((double) Iterations * Scale) + 1);
+			}
+
+			Result	R;
+			R.Name = E.Name;
+			R.Threads = E.Threads;
+			R.Iterations = Iterations;
+			R.RealNs = Real * 1e9 / (double) Iterations;
+			R.CpuNs = Cpu * 1e9 / (double) (Iterations * E.Threads);
+			R.ItemsPerSecond = (double) (Iterations * E.Threads) / Real;
+			R.BytesPerSecond = (double) (Iterations * E.Threads * E.Bytes) / Real;
+			return R;
+		}
+	};
+}
@@ -0,0 +1,145 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#include <algorithm>
+#include <sstream>
+
+#include "Poco/Base64Encoder.h"
+#include "Poco/DirectoryIterator.h"
+#include "Poco/File.h"
+#include "Poco/FileStream.h"
+#include "Poco/Path.h"
+#include "Poco/StreamCopier.h"
+
+#include "fmt/format.h"
+#include "zlib.h"
+
+#include "Payloads.h"
+
+namespace OpenWifi::Bench {
+
+	static inline std::string MAC(uint64_t Value) {
+		return fmt::format("{:02x}:{:02x}:{:02x}:{:02x}:{:02x}:{:02x}",
+						   (Value >> 40) & 0xff, (Value >> 32) & 0xff, (Value >> 24) & 0xff,
+						   (Value >> 16) & 0xff, (Value >> 8) & 0xff, Value & 0xff);
+	}
+
+	static inline std::string Base64(const std::string &S) {
+		std::ostringstream OS;
+		Poco::Base64Encoder E(OS);
+		E.rdbuf()->setLineLength(0);
+		E << S;
+		E.close();
+		return OS.str();
+	}
+
+	std::string Compress64(const std::string &Data) {
+		std::string Compressed(compressBound(Data.size()), '\0');
+		auto Size = (uLongf) Compressed.size();
+		compress((Bytef *) Compressed.data(), &Size, (const Bytef *) Data.data(), Data.size());
+		Compressed.resize(Size);
+		return Base64(Compressed);
+	}
+
+	std::string ConnectEvent(uint64_t Serial) {
+		return fmt::format(
+			R"({{"jsonrpc":"2.0","method":"connect","params":{{"serial":"{:012x}","uuid":1,"firmware":"OpenWrt 21.02-SNAPSHOT r16399+120-c67509efd7 / TIP-v2.5.0","wanip":["10.0.0.2:54322"],)"
+			R"("capabilities":{{"compatible":"edgecore_eap101","model":"EdgeCore EAP101","platform":"ap",)"
+			R"("label_macaddr":"{}","macaddr":{{"lan":"{}","wan":"{}"}},)"
+			R"("network":{{"lan":["eth1","eth2"],"wan":["eth0"]}},)"
+			R"("wifi":{{"platform/soc/c000000.wifi":{{"band":["2G"],"channels":[1,2,3,4,5,6,7,8,9,10,11],"ht_capa":6639,"tx_ant":3,"rx_ant":3}},)"
+			R"("platform/soc/c000000.wifi+1":{{"band":["5G"],"channels":[36,40,44,48,52,56,60,64,100,104,108,112,116,132,136,140,144,149,153,157,161,165],"ht_capa":6639,"vht_capa":865696178,"tx_ant":3,"rx_ant":3}}}}}}}}}})",
+			Serial, MAC(Serial), MAC(Serial + 1), MAC(Serial + 2));
+	}
+
+	std::string StateDocument(uint64_t Serial, uint64_t Clients) {
+		std::string Associations2G, Associations5G;
+		for(uint64_t i=0;i<Clients;i++) {
+			auto &A = (i % 3) ? Associations5G : Associations2G;
+			if(!A.empty())
+				A += ',';
+			A += fmt::format(
+				R"({{"bssid":"{}","station":"{}","rssi":{},"connected":{},"inactive":{},)"
+				R"("rx_bytes":{},"tx_bytes":{},"rx_packets":{},"tx_packets":{},)"
+				R"("rx_rate":{{"bitrate":866700,"mcs":9,"nss":2,"chwidth":80,"vht":true,"sgi":true}},)"
+				R"("tx_rate":{{"bitrate":780000,"mcs":8,"nss":2,"chwidth":80,"vht":true,"sgi":true}}}})",
+				MAC(Serial + 16), MAC(0x020000000000 + (Serial << 8) + i), -40 - (int)(i % 45), 100 + i, i % 10,
+				1000000 + i * 7919, 2000000 + i * 104729, 1000 + i * 13, 2000 + i * 17);
+		}
+		return fmt::format(
+			R"({{"unit":{{"load":[0.12,0.08,0.05],"memory":{{"total":973139968,"free":640557056,"cached":86351872,"buffered":9641984}},"uptime":86400,"localtime":1640000000}},)"
+			R"("radios":[{{"channel":6,"channel_width":"20","tx_power":20,"noise":-95,"active_ms":86400000,"busy_ms":8640000,"receive_ms":4320000,"transmit_ms":2160000,"phy":"platform/soc/c000000.wifi"}},)"
+			R"({{"channel":36,"channel_width":"80","tx_power":23,"noise":-98,"active_ms":86400000,"busy_ms":17280000,"receive_ms":8640000,"transmit_ms":4320000,"phy":"platform/soc/c000000.wifi+1"}}],)"
+			R"("interfaces":[{{"name":"up0v0","uptime":86400,"ipv4":{{"addresses":["10.0.0.2/24"],"leasetime":43200}},)"
+			R"("counters":{{"collisions":0,"multicast":1234,"rx_bytes":123456789,"rx_dropped":0,"rx_errors":0,"rx_packets":234567,"tx_bytes":987654321,"tx_dropped":0,"tx_errors":0,"tx_packets":345678}},)"
+			R"("ssids":[{{"bssid":"{}","iface":"wlan0","mode":"ap","ssid":"OpenWifi","phy":"platform/soc/c000000.wifi","radio":{{"$ref":"#/radios/0"}},"associations":[{}]}},)"
+			R"({{"bssid":"{}","iface":"wlan1","mode":"ap","ssid":"OpenWifi","phy":"platform/soc/c000000.wifi+1","radio":{{"$ref":"#/radios/1"}},"associations":[{}]}}]}}]}})",
+			MAC(Serial + 16), Associations2G, MAC(Serial + 17), Associations5G);
+	}
+
+	std::string StateEvent(uint64_t Serial, uint64_t Clients) {
+		return fmt::format(R"({{"jsonrpc":"2.0","method":"state","params":{{"serial":"{:012x}","uuid":1,"request_uuid":"","state":{}}}}})",
+						   Serial, StateDocument(Serial, Clients));
+	}
+
+	std::string CompressedStateEvent(uint64_t Serial, uint64_t Clients) {
+		auto Params = fmt::format(R"({{"serial":"{:012x}","uuid":1,"request_uuid":"","state":{}}})", Serial, StateDocument(Serial, Clients));
+		return fmt::format(R"({{"jsonrpc":"2.0","method":"state","params":{{"compress_64":"{}","compress_sz":{}}}}})",
+						   Compress64(Params), Params.size());
+	}
+
+	std::string HealthCheckEvent(uint64_t Serial) {
+		return fmt::format(
+			R"({{"jsonrpc":"2.0","method":"healthcheck","params":{{"serial":"{:012x}","uuid":1,"request_uuid":"","sanity":100,)"
+			R"("data":{{"interfaces":{{"up0v0":{{"ipv4_dhcp":true}},"down1v0":{{"ipv4_dhcp":true}}}},"dns":{{"up0v0":true}}}}}}}})",
+			Serial);
+	}
+
+	std::string WifiScanResult(uint64_t Neighbours) {
+		static const std::string Rates("\x82\x84\x8b\x96\x0c\x12\x18\x24", 8);
+		static const std::string Country("CA \x01\x0b\x1e\x24\x04\x17", 9);
+		static const std::string RSN("\x01\x00\x00\x0f\xac\x04\x01\x00\x00\x0f\xac\x04\x01\x00\x00\x0f\xac\x02\x00\x00", 20);
+		static const std::string HT("\xef\x19\x1b\xff\xff\xff\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00", 26);
+		static const std::string VHT("\xb2\x01\x80\x33\xfa\xff\x00\x00\xfa\xff\x00\x00", 12);
+		static const std::string WMM("\x00\x50\xf2\x02\x01\x01\x80\x00\x03\xa4\x00\x00\x27\xa4\x00\x00\x42\x43\x5e\x00\x62\x32\x2f\x00", 24);
+
+		std::string Scan;
+		for(uint64_t i=0;i<Neighbours;i++) {
+			auto Channel = i % 2 ? 1 + (i % 3) * 5 : 36 + (i % 4) * 4;
+			auto Frequency = Channel < 15 ? 2407 + Channel * 5 : 5000 + Channel * 5;
+			auto SSID = fmt::format("Neighbour-{}", i);
+			if(i)
+				Scan += ',';
+			Scan += fmt::format(
+				R"({{"bssid":"{}","ssid":"{}","frequency":{},"channel":{},"signal":{},"tsf":{},"last_seen":{},"capability":1073,"ies":[)"
+				R"({{"type":0,"data":"{}"}},{{"type":1,"data":"{}"}},{{"type":3,"data":"{}"}},{{"type":7,"data":"{}"}},)"
+				R"({{"type":48,"data":"{}"}},{{"type":45,"data":"{}"}},{{"type":191,"data":"{}"}},{{"type":221,"data":"{}"}}]}})",
+				MAC(0x0a0000000000 + i), SSID, Frequency, Channel, -35 - (int)(i % 55), 1000000 + i, 100 + i,
+				Base64(SSID), Base64(Rates), Base64(std::string(1, (char)Channel)), Base64(Country),
+				Base64(RSN), Base64(HT), Base64(VHT), Base64(WMM));
+		}
+		return fmt::format(R"({{"serial":"53494d000001","status":{{"error":0,"text":"","when":0,"scan":[{}]}}}})", Scan);
+	}
+
+	std::vector<std::string> LoadFiles(const std::string &Directory, const std::string &Extension) {
+		std::vector<std::string>	Names, Files;
+		if(Directory.empty() || !Poco::File(Directory).exists())
+			return Files;
+		for(Poco::DirectoryIterator It(Directory), End; It!=End; ++It) {
+			if(It->isFile() && (Extension.empty() || Poco::Path(It->path()).getExtension()==Extension))
+				Names.push_back(It->path());
+		}
+		std::sort(Names.begin(), Names.end());
+		for(const auto &Name:Names) {
+			Poco::FileInputStream	In(Name);
+			std::string Content;
+			Poco::StreamCopier::copyToString(In, Content);
+			Files.push_back(std::move(Content));
+		}
+		return Files;
+	}
+}
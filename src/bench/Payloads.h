@@ -0,0 +1,32 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace OpenWifi::Bench {
+
+	//	Device frames shaped like the ones in PROTOCOL.md, for when no captured payloads are given.
+	std::string ConnectEvent(uint64_t Serial);
+	std::string StateEvent(uint64_t Serial, uint64_t Clients);
+	std::string HealthCheckEvent(uint64_t Serial);
+	std::string CompressedStateEvent(uint64_t Serial, uint64_t Clients);
+
+	//	Just the state document carried by StateEvent.
+	std::string StateDocument(uint64_t Serial, uint64_t Clients);
+
+	//	The "result" object of a wifiscan answer, with Neighbours BSSs and their IEs.
+	std::string WifiScanResult(uint64_t Neighbours);
+
+	//	zlib and base64, the way devices send compress_64 payloads
+	std::string Compress64(const std::string &Data);
+
+	//	The content of every regular file in Directory, sorted by name. A missing directory yields nothing.
+	std::vector<std::string> LoadFiles(const std::string &Directory, const std::string &Extension = "");
+}
@@ -0,0 +1,886 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <thread>
+#include <unordered_map>
+
+#include "Poco/File.h"
+#include "Poco/JSON/Parser.h"
+#include "Poco/Net/IPAddress.h"
+
+#include "CacheSnapshot.h"
+#include "CentralConfig.h"
+#include "CommandManager.h"
+#include "ConfigurationCache.h"
+#include "DeviceRegistry.h"
+#include "DeviceStatisticsNotifier.h"
+#include "IngressLimiter.h"
+#include "OUIServer.h"
+#include "Daemon.h"
+#include "ParseWifiScan.h"
+#include "PerMessageDeflate.h"
+#include "SerialNumberCache.h"
+#include "StateUtils.h"
+#include "StorageService.h"
+#include "TimerWheel.h"
+#include "WS_Connection.h"
+#include "framework/ConfigurationValidator.h"
+#include "framework/MicroService.h"
+#include "framework/Metrics.h"
+#include "framework/ow_constants.h"
+#include "ow_version.h"
+
+#include "Benchmark.h"
+#include "Payloads.h"
+
+namespace OpenWifi::Bench {
+
+	static const uint64_t 	FirstSerial = 0x53494d000000;
+	static const uint64_t 	RegisteredDevices = 10000;
+	static const uint64_t 	CachedSerialNumbers = 20000;
+	static const uint64_t 	BlackListedDevices = 1000;
+	static const char 		*DBName = "owgw_bench.db";
+	static const char 		*SnapshotName = "owgw_bench_cache.bin";
+	static const char 		*OUISnapshotName = "owgw_bench_oui.bin";
+	static const std::vector<uint64_t>	Contention{1, 4, 16};
+
+	//	The text frame path of WSConnection::ProcessIncomingFrame and ProcessJSONRPCEvent, through the same decoding
+	//	functions, up to the point where the event is handed to storage, Kafka and the registry, which have their own
+	//	benchmarks.
+	static uint64_t DecodeFrame(const std::string &Frame, std::string &Document) {
+		Poco::JSON::Object::Ptr IncomingJSON;
+		if(WSConnection::ParseFrame(Frame, IncomingJSON)!=WSConnection::FrameType::EVENT)
+			return uCentralProtocol::Events::ET_UNKNOWN;
+
+		auto EventType = uCentralProtocol::Events::EventFromString(IncomingJSON->get(uCentralProtocol::METHOD).toString());
+		if(EventType==uCentralProtocol::Events::ET_UNKNOWN)
+			return uCentralProtocol::Events::ET_UNKNOWN;
+
+		Poco::JSON::Object::Ptr ParamsObj;
+		std::string Uncompressed;
+		if(WSConnection::ExpandParams(IncomingJSON, ParamsObj, Uncompressed)!=WSConnection::ParamsStatus::OK)
+			return uCentralProtocol::Events::ET_UNKNOWN;
+
+		if(EventType==uCentralProtocol::Events::ET_STATE && ParamsObj->has(uCentralProtocol::STATE)) {
+			Document = ParamsObj->get(uCentralProtocol::STATE).toString();
+			uint64_t Radios_2G, Radios_5G;
+			StateUtils::ComputeAssociations(ParamsObj->getObject(uCentralProtocol::STATE), Radios_2G, Radios_5G);
+		} else if(EventType==uCentralProtocol::Events::ET_CONNECT && ParamsObj->has(uCentralProtocol::CAPABILITIES)) {
+			Document = ParamsObj->get(uCentralProtocol::CAPABILITIES).toString();
+		} else if(ParamsObj->has(uCentralProtocol::DATA)) {
+			Document = ParamsObj->get(uCentralProtocol::DATA).toString();
+		}
+		return EventType;
+	}
+
+	static uint64_t AverageSize(const std::vector<std::string> &V) {
+		uint64_t Total = 0;
+		for(const auto &i:V)
+			Total += i.size();
+		return V.empty() ? 0 : Total / V.size();
+	}
+
+	static void AddFrames(Suite &S, const std::string &Name, std::vector<std::string> Frames) {
+		if(Frames.empty())
+			return;
+		auto Bytes = AverageSize(Frames);
+		S.Add("WSConnection/Frame/" + Name, [Frames](uint64_t, uint64_t Iterations) {
+			std::string Document;
+			for(uint64_t i=0;i<Iterations;i++)
+				DoNotOptimize(DecodeFrame(Frames[i % Frames.size()], Document));
+		}, {1}, Bytes);
+	}
+
+	static void AddFrameBenchmarks(Suite &S, const std::string &FramesDirectory) {
+		AddFrames(S, "connect", {ConnectEvent(FirstSerial)});
+		AddFrames(S, "healthcheck", {HealthCheckEvent(FirstSerial)});
+		AddFrames(S, "state-10", {StateEvent(FirstSerial, 10)});
+		AddFrames(S, "state-100", {StateEvent(FirstSerial, 100)});
+		AddFrames(S, "state-100-compressed", {CompressedStateEvent(FirstSerial, 100)});
+		AddFrames(S, "captured", LoadFiles(FramesDirectory));
+	}
+
+	static void AddRegistryBenchmarks(Suite &S) {
+		for(uint64_t i=0;i<RegisteredDevices;i++) {
+			uint64_t ConnectionId;
+			DeviceRegistry()->Register(FirstSerial + i, nullptr, ConnectionId);
+		}
+		auto Stats = StateDocument(FirstSerial, 10);
+		//	every thread works on its own devices, as every connection does in the gateway
+		S.Add("DeviceRegistry/SetStatistics", [Stats](uint64_t Thread, uint64_t Iterations) {
+			for(uint64_t i=0;i<Iterations;i++)
+				DeviceRegistry()->SetStatistics(FirstSerial + (Thread * 997 + i) % RegisteredDevices, Stats);
+		}, Contention, Stats.size());
+		S.Add("DeviceRegistry/GetState", [](uint64_t Thread, uint64_t Iterations) {
+			GWObjects::ConnectionState	State;
+			for(uint64_t i=0;i<Iterations;i++)
+				DoNotOptimize(DeviceRegistry()->GetState(FirstSerial + (Thread * 997 + i) % RegisteredDevices, State));
+		}, Contention);
+		S.Add("DeviceRegistry/GetStatistics", [](uint64_t Thread, uint64_t Iterations) {
+			std::string Stats;
+			for(uint64_t i=0;i<Iterations;i++)
+				DoNotOptimize(DeviceRegistry()->GetStatistics(FirstSerial + (Thread * 997 + i) % RegisteredDevices, Stats));
+		}, Contention);
+	}
+
+	//	A fleet of 10000 devices sending their state: what the notifier costs for each state, and one flush of the
+	//	interval with every device changed. UI clients are not connected, the sending itself is not included.
+	static void AddDeviceStatisticsNotifierBenchmarks(Suite &S) {
+		S.Add("DeviceStatisticsNotifier/Update", [](uint64_t Thread, uint64_t Iterations) {
+			GWObjects::ConnectionState	State;
+			for(uint64_t i=0;i<Iterations;i++) {
+				auto Serial = FirstSerial + (Thread * 997 + i) % RegisteredDevices;
+				State.RX += 1500;
+				State.TX += 500;
+				DeviceStatisticsNotifier()->Update(Serial, 1 + Serial, fmt::format("{:012x}", Serial), "", State);
+			}
+		}, Contention);
+		S.Add("DeviceStatisticsNotifier/Flush", [](uint64_t, uint64_t Iterations) {
+			GWObjects::ConnectionState	State;
+			Poco::Timer	Unused;
+			for(uint64_t i=0;i<Iterations;i++) {
+				State.RX += 1500;
+				for(uint64_t d=0;d<RegisteredDevices;d++)
+					DeviceStatisticsNotifier()->Update(FirstSerial + d, 1 + FirstSerial + d, fmt::format("{:012x}", FirstSerial + d), "", State);
+				DeviceStatisticsNotifier()->onTimer(Unused);
+			}
+		});
+	}
+
+	static void AddSerialNumberCacheBenchmarks(Suite &S) {
+		for(uint64_t i=0;i<CachedSerialNumbers;i++)
+			SerialNumberCache()->AddSerialNumber(fmt::format("{:012x}", FirstSerial + i * 7));
+		S.Add("SerialNumberCache/FindNumbers/prefix", [](uint64_t, uint64_t Iterations) {
+			std::vector<uint64_t>	Found;
+			for(uint64_t i=0;i<Iterations;i++) {
+				Found.clear();
+				SerialNumberCache()->FindNumbers(fmt::format("53494d{:02x}", i % 256), 20, Found);
+				DoNotOptimize(Found.size());
+			}
+		});
+		S.Add("SerialNumberCache/FindNumbers/exact", [](uint64_t, uint64_t Iterations) {
+			std::vector<uint64_t>	Found;
+			for(uint64_t i=0;i<Iterations;i++) {
+				Found.clear();
+				SerialNumberCache()->FindNumbers(fmt::format("{:012x}", FirstSerial + (i % CachedSerialNumbers) * 7), 1, Found);
+				DoNotOptimize(Found.size());
+			}
+		});
+		S.Add("SerialNumberCache/FindNumbers/reversed", [](uint64_t, uint64_t Iterations) {
+			std::vector<uint64_t>	Found;
+			for(uint64_t i=0;i<Iterations;i++) {
+				Found.clear();
+				SerialNumberCache()->FindNumbers(fmt::format("*{:03x}", i % 4096), 20, Found);
+				DoNotOptimize(Found.size());
+			}
+		});
+	}
+
+	static void AddValidatorBenchmarks(Suite &S, const std::string &ConfigurationDirectory) {
+		std::vector<std::string>	Configurations;
+		for(auto &C:LoadFiles(ConfigurationDirectory, "json")) {
+			if(C.find("\"interfaces\"")!=std::string::npos && C.find("\"radios\"")!=std::string::npos)
+				Configurations.push_back(std::move(C));
+		}
+		if(Configurations.empty()) {
+			std::cout << "No configuration found in '" << ConfigurationDirectory << "': ConfigurationValidator skipped." << std::endl;
+			return;
+		}
+		S.Add("ConfigurationValidator/Validate", [Configurations](uint64_t, uint64_t Iterations) {
+			std::string Error;
+			for(uint64_t i=0;i<Iterations;i++)
+				DoNotOptimize(ValidateUCentralConfiguration(Configurations[i % Configurations.size()], Error));
+		}, {1}, AverageSize(Configurations));
+
+		//	a fleet wide change: a new uuid and the first SSID renamed
+		std::vector<std::pair<std::string,std::string>>	Changes;
+		uint64_t FullBytes = 0, PatchBytes = 0;
+		for(const auto &C:Configurations) {
+			Poco::JSON::Parser	P;
+			auto Config = P.parse(C).extract<Poco::JSON::Object::Ptr>();
+			std::ostringstream Base, Target;
+			Poco::JSON::Stringifier::condense(Config, Base);
+			Config->set(uCentralProtocol::UUID, Config->optValue<uint64_t>(uCentralProtocol::UUID, 1) + 1);
+			auto Interfaces = Config->getArray("interfaces");
+			if(Interfaces && Interfaces->size() && Interfaces->isObject(0)) {
+				auto SSIDs = Interfaces->getObject(0)->getArray("ssids");
+				if(SSIDs && SSIDs->size() && SSIDs->isObject(0))
+					SSIDs->getObject(0)->set("name", "Renamed-SSID");
+			}
+			Poco::JSON::Stringifier::condense(Config, Target);
+			std::string Patch;
+			if(!CommandManager::ConfigurationDiff(Base.str(), Target.str(), Patch))
+				continue;
+			FullBytes += Target.str().size();
+			PatchBytes += Patch.size();
+			Changes.emplace_back(Base.str(), Target.str());
+		}
+		if(Changes.empty())
+			return;
+		std::cout << fmt::format("ConfigurationPatch: {} configurations of {} bytes sent as {} bytes of patches.", Changes.size(),
+								 FullBytes, PatchBytes) << std::endl;
+		S.Add("ConfigurationPatch/Diff", [Changes](uint64_t, uint64_t Iterations) {
+			std::string Patch;
+			for(uint64_t i=0;i<Iterations;i++) {
+				const auto &[Base,Target] = Changes[i % Changes.size()];
+				DoNotOptimize(CommandManager::ConfigurationDiff(Base, Target, Patch));
+			}
+		}, {1}, FullBytes / Changes.size());
+	}
+
+	static void AddPayloadBenchmarks(Suite &S) {
+		auto Params = fmt::format(R"({{"serial":"{:012x}","uuid":1,"state":{}}})", FirstSerial, StateDocument(FirstSerial, 100));
+		auto Compressed = Compress64(Params);
+		S.Add("Utils/ExtractBase64CompressedData/sized", [Compressed, Size=Params.size()](uint64_t, uint64_t Iterations) {
+			std::string Uncompressed;
+			for(uint64_t i=0;i<Iterations;i++)
+				DoNotOptimize(Utils::ExtractBase64CompressedData(Compressed, Uncompressed, Size));
+		}, {1}, Params.size());
+		//	older firmware does not send compress_sz, the output size is then guessed
+		S.Add("Utils/ExtractBase64CompressedData/unsized", [Compressed](uint64_t, uint64_t Iterations) {
+			std::string Uncompressed;
+			for(uint64_t i=0;i<Iterations;i++)
+				DoNotOptimize(Utils::ExtractBase64CompressedData(Compressed, Uncompressed, 0));
+		}, {1}, Params.size());
+
+		//	the same state sent as a permessage-deflate frame instead of compress_64
+		PerMessageDeflate::Deflater	Deflater(PerMessageDeflate::MaxWindowBits);
+		std::string Frame;
+		Deflater.Deflate(Params.data(), Params.size(), Frame, true);
+		S.Add("PerMessageDeflate/Inflate/nocontext", [Frame](uint64_t, uint64_t Iterations) {
+			PerMessageDeflate::Inflater	Inflater(PerMessageDeflate::MaxWindowBits);
+			std::string Message;
+			for(uint64_t i=0;i<Iterations;i++)
+				DoNotOptimize(Inflater.Inflate(Frame.data(), Frame.size(), Message, 1024 * 1024, true));
+		}, {1}, Params.size());
+		//	with context takeover, every frame depends on the ones before it: a device's run of states is replayed
+		std::vector<std::string> Frames(64);
+		for(auto &F:Frames)
+			Deflater.Deflate(Params.data(), Params.size(), F, false);
+		S.Add("PerMessageDeflate/Inflate/context", [Frames](uint64_t, uint64_t Iterations) {
+			std::unique_ptr<PerMessageDeflate::Inflater>	Inflater;
+			std::string Message;
+			for(uint64_t i=0;i<Iterations;i++) {
+				if(i % Frames.size() == 0)
+					Inflater = std::make_unique<PerMessageDeflate::Inflater>(PerMessageDeflate::MaxWindowBits);
+				DoNotOptimize(Inflater->Inflate(Frames[i % Frames.size()].data(), Frames[i % Frames.size()].size(), Message, 1024 * 1024, false));
+			}
+		}, {1}, Params.size());
+
+		for(const uint64_t Neighbours:{20, 100}) {
+			auto Scan = WifiScanResult(Neighbours);
+			S.Add(fmt::format("ParseWifiScan/{}", Neighbours), [Scan](uint64_t, uint64_t Iterations) {
+				Poco::JSON::Parser	P;
+				auto Obj = P.parse(Scan).extract<Poco::JSON::Object::Ptr>();
+				auto &Logger = Poco::Logger::get("bench");
+				for(uint64_t i=0;i<Iterations;i++) {
+					std::stringstream	Result;
+					ParseWifiScan(Obj, Result, Logger);
+					DoNotOptimize(Result.tellp());
+				}
+			}, {1}, Scan.size());
+		}
+
+		for(const uint64_t Clients:{10, 100}) {
+			auto State = StateDocument(FirstSerial, Clients);
+			S.Add(fmt::format("StateUtils/ComputeAssociations/{}", Clients), [State](uint64_t, uint64_t Iterations) {
+				Poco::JSON::Parser	P;
+				auto Obj = P.parse(State).extract<Poco::JSON::Object::Ptr>();
+				uint64_t Radios_2G, Radios_5G;
+				for(uint64_t i=0;i<Iterations;i++)
+					DoNotOptimize(StateUtils::ComputeAssociations(Obj, Radios_2G, Radios_5G));
+			});
+		}
+	}
+
+	static void AddStorageBenchmarks(Suite &S) {
+		auto Stats = StateDocument(FirstSerial, 10);
+		S.Add("Storage/AddStatisticsData", [Stats](uint64_t Thread, uint64_t Iterations) {
+			GWObjects::Statistics	Record{.SerialNumber = fmt::format("{:012x}", FirstSerial + Thread), .UUID = 1, .Data = Stats};
+			for(uint64_t i=0;i<Iterations;i++) {
+				Record.Recorded = OpenWifi::Now();
+				DoNotOptimize(StorageService()->AddStatisticsData(Record));
+			}
+		}, {1, 4}, Stats.size());
+
+		//	The same insert with and without a cached prepared statement, on a pool of their own over the scratch
+		//	database: Uncached converts, prepares and plans the query on a pooled session on every call, as storage did
+		//	before CachedStatement.
+		typedef Poco::Tuple<std::string, uint64_t, std::string, uint64_t>	StatsRecord;
+		static const std::string InsertSQL{"INSERT INTO Statistics ( SerialNumber, UUID, Data, Recorded ) VALUES ( ?,?,?,? )"};
+		static auto StatementPool = new Poco::Data::SessionPool(Poco::Data::SQLite::Connector::KEY,
+																 MicroService::instance().DataDir() + "/" + DBName, 1, 4);
+		S.Add("Storage/Insert/Uncached", [Stats](uint64_t, uint64_t Iterations) {
+			StatsRecord	R(fmt::format("{:012x}", FirstSerial + 0x200000), 1, Stats, 0);
+			for(uint64_t i=0;i<Iterations;i++) {
+				R.set<3>(OpenWifi::Now());
+				Poco::Data::Session 	Session = StatementPool->get();
+				Poco::Data::Statement 	Insert(Session);
+				Insert << ConvertSQLParams(sqlite, InsertSQL), Poco::Data::Keywords::use(R);
+				Insert.execute();
+			}
+		}, {1}, Stats.size());
+		S.Add("Storage/Insert/Cached", [Stats](uint64_t, uint64_t Iterations) {
+			static CachedStatement<StatsRecord>	Insert{InsertSQL};
+			StatsRecord	R(fmt::format("{:012x}", FirstSerial + 0x200000), 1, Stats, 0);
+			for(uint64_t i=0;i<Iterations;i++) {
+				R.set<3>(OpenWifi::Now());
+				Insert.Execute(*StatementPool, sqlite, R);
+			}
+		}, {1}, Stats.size());
+
+		//	Walking the statistics of one device a page at a time: OFFSET reads and drops every row before the page,
+		//	the cursor seeks to it. Rows come 4 to a second, so pages end inside a run of equal timestamps.
+		static const uint64_t PagedStatistics = 10000, PageSize = 100;
+		auto PagedSerial = fmt::format("{:012x}", FirstSerial + 0x100000);
+		GWObjects::Statistics	Paged{.SerialNumber = PagedSerial, .UUID = 1, .Data = "{}"};
+		for(uint64_t i=0;i<PagedStatistics;i++) {
+			Paged.Recorded = 1600000000 + i / 4;
+			StorageService()->AddStatisticsData(Paged);
+		}
+		S.Add("Storage/StatisticsPage/Offset", [PagedSerial](uint64_t, uint64_t Iterations) {
+			auto Serial = PagedSerial;
+			std::vector<GWObjects::Statistics>	Rows;
+			for(uint64_t i=0;i<Iterations;i++) {
+				Rows.clear();
+				StorageService()->GetStatisticsData(Serial, 0, 0, (i % (PagedStatistics / PageSize)) * PageSize, PageSize, Rows);
+				DoNotOptimize(Rows.size());
+			}
+		});
+		S.Add("Storage/StatisticsPage/Cursor", [PagedSerial](uint64_t, uint64_t Iterations) {
+			auto Serial = PagedSerial;
+			std::vector<GWObjects::Statistics>	Rows;
+			Storage::PageCursor	After, Next;
+			for(uint64_t i=0;i<Iterations;i++) {
+				Rows.clear();
+				StorageService()->GetStatisticsData(Serial, 0, 0, After, PageSize, Rows, Next);
+				After = Next;	//	back to the first page after the last one
+				DoNotOptimize(Rows.size());
+			}
+		});
+
+		for(uint64_t i=0;i<BlackListedDevices;i++) {
+			GWObjects::BlackListedDevice	D{.serialNumber = fmt::format("{:012x}", FirstSerial + i * 13), .reason = "bench", .author = "owgw_bench", .created = OpenWifi::Now()};
+			StorageService()->AddBlackListDevice(D);
+		}
+		//	most devices knocking on the door are not black listed, one in 16 is
+		S.Add("Storage/IsBlackListed", [](uint64_t Thread, uint64_t Iterations) {
+			for(uint64_t i=0;i<Iterations;i++) {
+				auto Serial = fmt::format("{:012x}", FirstSerial + (i % 16 ? 1 + (Thread + i) * 13 : ((Thread + i) % BlackListedDevices) * 13));
+				DoNotOptimize(StorageService()->IsBlackListed(Serial));
+			}
+		}, Contention);
+	}
+
+	//	what a warm start costs instead of scanning the device and black list tables: the caches filled by the
+	//	serial number cache and storage benchmarks, plus one configuration per cached serial number
+	static void AddCacheSnapshotBenchmarks(Suite &S) {
+		for(uint64_t i=0;i<CachedSerialNumbers;i++)
+			SetCurrentConfigurationID(FirstSerial + i * 7, 1 + i);
+		static const auto FileName = MicroService::instance().DataDir() + "/" + SnapshotName;
+		S.Add("CacheSnapshot/Save", [](uint64_t, uint64_t Iterations) {
+			for(uint64_t i=0;i<Iterations;i++)
+				DoNotOptimize(CacheSnapshot()->Save(FileName));
+		});
+		S.Add("CacheSnapshot/Load", [](uint64_t, uint64_t Iterations) {
+			for(uint64_t i=0;i<Iterations;i++)
+				DoNotOptimize(CacheSnapshot()->Load(FileName));
+		});
+	}
+
+	//	Discards what a REST response would send, noting when its first byte was written.
+	class FirstByteBuf : public std::streambuf {
+	  public:
+		explicit FirstByteBuf(std::chrono::steady_clock::time_point Start) : Start_(Start) {}
+		[[nodiscard]] uint64_t FirstByteNs() const { return FirstByteNs_; }
+		[[nodiscard]] uint64_t Bytes() const { return Bytes_; }
+
+	  protected:
+		int overflow(int C) override {
+			Written(1);
+			return C==traits_type::eof() ? traits_type::not_eof(C) : C;
+		}
+		std::streamsize xsputn(const char *, std::streamsize N) override {
+			Written(N);
+			return N;
+		}
+
+	  private:
+		void Written(std::streamsize N) {
+			if(Bytes_==0 && N>0)
+				FirstByteNs_ = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start_).count();
+			Bytes_ += N;
+		}
+
+		std::chrono::steady_clock::time_point	Start_;
+		uint64_t 	FirstByteNs_ = 0, Bytes_ = 0;
+	};
+
+	//	a field of /proc/self/status, in kB: 0 where it does not exist
+	static uint64_t ProcessStatus(const std::string &Field) {
+		std::ifstream	IS("/proc/self/status");
+		std::string 	Line;
+		while(std::getline(IS, Line))
+			if(Line.compare(0, Field.size() + 1, Field + ":")==0)
+				return std::strtoull(Line.c_str() + Field.size() + 1, nullptr, 10);
+		return 0;
+	}
+
+	//	Time to first byte and extra peak resident memory of one device listing, the worst seen by each benchmark.
+	//	Writing 5 to clear_refs resets the peak (VmHWM) on Linux, so each listing gets its own.
+	struct ListingReport {
+		uint64_t 	Calls = 0, FirstByteNs = 0, PeakKB = 0, Bytes = 0;
+	};
+	static std::map<std::string, ListingReport>	Listings;
+
+	static void MeasureListing(const std::string &Name, const std::function<void(std::ostream &)> &List) {
+		std::ofstream("/proc/self/clear_refs") << "5";
+		auto Resident = ProcessStatus("VmRSS");
+		FirstByteBuf	Buf(std::chrono::steady_clock::now());
+		std::ostream	OS(&Buf);
+		List(OS);
+		auto Peak = ProcessStatus("VmHWM");
+		auto &R = Listings[Name];
+		R.Calls++;
+		R.FirstByteNs = std::max(R.FirstByteNs, Buf.FirstByteNs());
+		R.PeakKB = std::max(R.PeakKB, Peak > Resident ? Peak - Resident : 0);
+		R.Bytes = Buf.Bytes();
+	}
+
+	//	GET /devices over the whole inventory: as one JSON document, as the handler used to answer, and streamed
+	//	DeviceListBatchSize devices at a time, as it does now.
+	static const uint64_t 	ListedDevices = 10000, FirstListedSerial = FirstSerial + 0x300000;
+
+	static std::atomic_uint64_t	FailedSelects = 0;
+
+	static void AddDeviceListBenchmarks(Suite &S) {
+		auto Configuration = Config::Config().get();
+		for(uint64_t i=0;i<ListedDevices;i++) {
+			GWObjects::Device	D;
+			D.SerialNumber = fmt::format("{:012x}", FirstListedSerial + i);
+			D.Configuration = Configuration;
+			D.Compatible = "bench_ap";
+			D.Manufacturer = "bench";
+			D.DeviceType = "ap";
+			StorageService()->CreateDevice(D);
+		}
+
+		S.Add("DeviceList/Document", [](uint64_t, uint64_t Iterations) {
+			for(uint64_t i=0;i<Iterations;i++) {
+				MeasureListing("DeviceList/Document", [](std::ostream &OS) {
+					std::vector<GWObjects::Device>	Devices;
+					StorageService()->GetDevices(0, ListedDevices, Devices, " ORDER BY serialNumber ASC ");
+					Poco::JSON::Array 	Objects;
+					for(const auto &D:Devices) {
+						Poco::JSON::Object	Obj;
+						D.to_json(Obj);
+						Objects.add(Obj);
+					}
+					Poco::JSON::Object	RetObj;
+					RetObj.set(RESTAPI::Protocol::DEVICES, Objects);
+					Poco::JSON::Stringifier::stringify(RetObj, OS);
+				});
+			}
+		});
+		S.Add("DeviceList/Streamed", [](uint64_t, uint64_t Iterations) {
+			for(uint64_t i=0;i<Iterations;i++) {
+				MeasureListing("DeviceList/Streamed", [](std::ostream &OS) {
+					static const uint64_t BatchSize = 100;
+					JSONArrayStream	Stream(OS, RESTAPI::Protocol::DEVICES);
+					Storage::PageCursor Position, Next;
+					for(uint64_t Remaining = ListedDevices; Remaining;) {
+						std::vector<GWObjects::Device>	Devices;
+						auto HowMany = std::min(Remaining, BatchSize);
+						if(Position.Valid)
+							StorageService()->GetDevices(Position, HowMany, Devices, Next);
+						else
+							StorageService()->GetDevices(0, HowMany, Devices, " ORDER BY serialNumber ASC ");
+						for(const auto &D:Devices) {
+							Poco::JSON::Object	Obj;
+							D.to_json(Obj);
+							Stream.Add(Obj);
+						}
+						if(Devices.size()<HowMany)
+							break;
+						Remaining -= HowMany;
+						Position.Key = Devices.back().SerialNumber;
+						Position.Valid = true;
+					}
+					Stream.Finish(Poco::JSON::Object());
+				});
+			}
+		});
+
+		//	GET /devices?select= with 100 serial numbers, by 1, 100 and 1000 concurrent requests: one lookup per
+		//	device, as the handler used to, then the batched multi-get. Time(ns) is the latency of one request. A
+		//	request failing because the session pool ran out is counted and reported after the run.
+		static const uint64_t Selected = 100;
+		static const std::vector<uint64_t> Requests{1, 100, 1000};
+		auto Selection = [](uint64_t Thread, uint64_t Iteration) {
+			std::vector<std::string>	SerialNumbers;
+			for(uint64_t d=0;d<Selected;d++)
+				SerialNumbers.push_back(fmt::format("{:012x}", FirstListedSerial + (Thread * 997 + Iteration * Selected + d) % ListedDevices));
+			return SerialNumbers;
+		};
+		S.Add("DeviceSelect/PerDevice", [Selection](uint64_t Thread, uint64_t Iterations) {
+			for(uint64_t i=0;i<Iterations;i++) {
+				for(auto &SerialNumber:Selection(Thread, i)) {
+					GWObjects::Device	D;
+					if(!StorageService()->GetDevice(SerialNumber, D))
+						FailedSelects++;
+				}
+			}
+		}, Requests);
+		S.Add("DeviceSelect/MultiGet", [Selection](uint64_t Thread, uint64_t Iterations) {
+			for(uint64_t i=0;i<Iterations;i++) {
+				std::vector<GWObjects::Device>	Devices;
+				std::vector<std::string>		Missing;
+				if(!StorageService()->GetDevices(Selection(Thread, i), Devices, Missing))
+					FailedSelects++;
+			}
+		}, Requests);
+	}
+
+	//	A table the size of the IEEE registry: lookups, and what loading its snapshot costs at startup instead of
+	//	parsing the text file
+	static void AddOUIBenchmarks(Suite &S) {
+		static const uint64_t OUIs = 36000, Vendors = 28000;
+		OUIServer::OUIMap	Map;
+		for(uint64_t i=0;i<OUIs;i++)
+			Map[(i * 2654435761ULL) & 0xffffff] = fmt::format("Vendor number {} Inc.", i % Vendors);
+		auto Built = OUIServer::BuildTable(Map);
+		static const auto FileName = MicroService::instance().DataDir() + "/" + OUISnapshotName;
+		static const auto SourceName = FileName + ".txt";
+		std::ofstream(SourceName) << "bench";
+		if(!OUIServer()->SaveSnapshot(*Built, FileName, SourceName)) {
+			std::cout << "Could not save an OUI snapshot: OUIServer skipped." << std::endl;
+			return;
+		}
+		S.Add("OUIServer/LoadSnapshot", [](uint64_t, uint64_t Iterations) {
+			for(uint64_t i=0;i<Iterations;i++)
+				DoNotOptimize(OUIServer()->LoadSnapshot(FileName, SourceName));
+		});
+		S.Add("OUIServer/BuildTable", [Map](uint64_t, uint64_t Iterations) {
+			for(uint64_t i=0;i<Iterations;i++)
+				DoNotOptimize(OUIServer::BuildTable(Map));
+		});
+		auto Loaded = OUIServer()->LoadSnapshot(FileName, SourceName);
+		if(!Loaded)
+			return;
+		//	one MAC in 4 has a registered OUI
+		S.Add("OUIServer/Lookup", [Loaded](uint64_t Thread, uint64_t Iterations) {
+			std::vector<std::string>	MACs;
+			for(uint64_t i=0;i<1024;i++)
+				MACs.push_back(fmt::format("{:06x}{:06x}", ((Thread * 1024 + i) * (i % 4 ? 7919 : 2654435761ULL)) & 0xffffff, i));
+			for(uint64_t i=0;i<Iterations;i++)
+				DoNotOptimize(Loaded->Find(Utils::SerialNumberToOUI(MACs[i % MACs.size()])).size());
+		}, Contention);
+	}
+
+	//	Kafka messages delivered to their topic callback by the dispatcher's workers. Each producing thread sends
+	//	numbered messages on its own 64 keys, and the callback checks that every key sees its numbers in order.
+	static KafkaDispatcher		Dispatcher;
+	static std::atomic_uint64_t	Calls = 0, Dispatched = 0, Delivered = 0, OutOfOrder = 0;
+
+	static void AddKafkaDispatcherBenchmarks(Suite &S) {
+		Dispatcher.Start(4, 1024);
+		Types::TopicNotifyFunction F = [](const std::string &Key, const std::string &Payload) {
+			//	a key is always delivered by the same worker, so each worker only needs its own keys
+			thread_local std::unordered_map<std::string,uint64_t>	Next;
+			auto Sequence = std::stoull(Payload);
+			auto &Expected = Next[Key];
+			if(Sequence!=Expected)
+				OutOfOrder++;
+			Expected = Sequence + 1;
+			Delivered++;
+		};
+		Dispatcher.RegisterTopicWatcher("bench", F);
+		S.Add("KafkaDispatcher/Dispatch", [](uint64_t, uint64_t Iterations) {
+			auto Call = Calls++;
+			std::vector<std::string>	Keys;
+			for(uint64_t k=0;k<64;k++)
+				Keys.push_back(fmt::format("{}-{}", Call, k));
+			for(uint64_t i=0;i<Iterations;i++)
+				Dispatcher.Dispatch("bench", Keys[i % Keys.size()], std::to_string(i / Keys.size()));
+			auto Target = Dispatched += Iterations;
+			while(Delivered < Target)
+				std::this_thread::yield();
+		}, Contention);
+	}
+
+	//	The consumer's offset bookkeeping under both commit policies, with the broker left out: each call plays one
+	//	partition through the dispatcher. PerMessage commits every offset as soon as it is consumed, as the consumer
+	//	used to, and counts the commits that got ahead of the workers: after a crash those messages are lost. Batched
+	//	commits every 500 messages what the workers have acknowledged, as KafkaConsumer does now.
+	static KafkaOffsetTracker	Offsets;
+	static std::atomic_uint64_t	Partitions = 0, OffsetsDelivered = 0, PerMessageCommits = 0, BatchedCommits = 0,
+								CommitsAheadOfWorkers = 0;
+
+	static void PlayPartition(uint64_t Iterations, bool PerMessage) {
+		auto TP = std::make_pair(std::string("bench-offsets"), (int) Partitions++);
+		std::map<KafkaOffsetTracker::TopicPartition,int64_t>	Ready;
+		auto Target = OffsetsDelivered + Iterations;
+		for(uint64_t i=0;i<Iterations;i++) {
+			Offsets.Dispatched(TP, (int64_t) i);
+			Dispatcher.Dispatch(TP.first, std::to_string(i % 64), "{}", &Offsets, TP.second, (int64_t) i);
+			if(PerMessage) {
+				Offsets.Committable(Ready);
+				if(Ready[TP] < (int64_t) i + 1)
+					CommitsAheadOfWorkers++;
+				PerMessageCommits++;
+			} else if(i % 500 == 499) {
+				Offsets.Committable(Ready);
+				Offsets.Committed(Ready);
+				BatchedCommits += !Ready.empty();
+			}
+		}
+		//	the messages still queued here are the ones a batched commit leaves to be read again
+		while(OffsetsDelivered < Target)
+			std::this_thread::yield();
+		Offsets.Committable(Ready);
+		Offsets.Committed(Ready);
+		if(!PerMessage)
+			BatchedCommits += !Ready.empty();
+		Offsets.Forget(TP);
+	}
+
+	static void AddKafkaOffsetBenchmarks(Suite &S) {
+		Types::TopicNotifyFunction F = [](const std::string &, const std::string &) { OffsetsDelivered++; };
+		Dispatcher.RegisterTopicWatcher("bench-offsets", F);
+		S.Add("KafkaConsumer/CommitPerMessage", [](uint64_t, uint64_t Iterations) { PlayPartition(Iterations, true); });
+		S.Add("KafkaConsumer/CommitBatched", [](uint64_t, uint64_t Iterations) { PlayPartition(Iterations, false); });
+	}
+
+	static void AddRESTAPIBenchmarks(Suite &S) {
+		S.Add("RESTAPI/Route", [](uint64_t, uint64_t Iterations) {
+			static const std::vector<std::string> Paths{
+				"/api/v1/devices", "/api/v1/device/53494d000001", "/api/v1/device/53494d000001/statistics",
+				"/api/v1/commands", "/api/v1/command/2b3a8e5c-2e2e-4d4b-9d1b-0f2f4f1e6a3c", "/api/v1/blacklist",
+				"/api/v1/deviceDashboard", "/api/v1/not/a/route"};
+			RESTAPI_GenericServer		Server;
+			RESTAPIHandler::BindingMap	Bindings;
+			auto &Logger = Poco::Logger::get("bench");
+			for(uint64_t i=0;i<Iterations;i++)
+				delete RESTAPI_ExtRouter(Paths[i % Paths.size()], Bindings, Logger, Server, i);
+		});
+
+		//	limits high enough that no call is refused: this measures the bookkeeping, not the rejections
+		S.Add("RateLimiter/DistinctClients", [](uint64_t Thread, uint64_t Iterations) {
+			std::vector<Poco::Net::IPAddress>	Clients;
+			for(uint64_t c=0;c<256;c++)
+				Clients.emplace_back(fmt::format("10.{}.{}.1", Thread, c));
+			uint64_t RetryAfterMs;
+			for(uint64_t i=0;i<Iterations;i++)
+				DoNotOptimize(RESTAPI_RateLimiter()->IsRateLimited(Clients[i % Clients.size()], 1, 1, 65536, RetryAfterMs));
+		}, Contention);
+		S.Add("RateLimiter/SameClient", [](uint64_t, uint64_t Iterations) {
+			Poco::Net::IPAddress	Client("10.0.0.1");
+			uint64_t RetryAfterMs;
+			for(uint64_t i=0;i<Iterations;i++)
+				DoNotOptimize(RESTAPI_RateLimiter()->IsRateLimited(Client, 2, 1, 65536, RetryAfterMs));
+		}, Contention);
+	}
+
+	//	What the ingress limits add to every device event: within the limits, and for a device flooding its state
+	static void AddIngressLimiterBenchmarks(Suite &S) {
+		S.Add("IngressLimiter/Admit/within", [](uint64_t, uint64_t Iterations) {
+			IngressLimiter::Buckets	B;
+			B.SetProfile(IngressLimiter()->ProfileFor(""), 1);
+			//	one event of each class every 10 seconds
+			for(uint64_t i=0;i<Iterations;i++)
+				DoNotOptimize(B.Admit((IngressLimiter::MessageClass) (i % IngressLimiter::CLASSES), 1 + i * 2500));
+		}, Contention);
+		S.Add("IngressLimiter/Admit/flooding", [](uint64_t, uint64_t Iterations) {
+			IngressLimiter::Buckets	B;
+			B.SetProfile(IngressLimiter()->ProfileFor(""), 1);
+			for(uint64_t i=0;i<Iterations;i++) {
+				DoNotOptimize(B.Admit(IngressLimiter::STATE, 1 + i / 1000));
+				if(B.ReportDue(1 + i / 1000))
+					DoNotOptimize(B.Take(1 + i / 1000).Dropped);
+			}
+		}, Contention);
+	}
+
+	//	What instrumentation adds to every frame: the reactor's frame and byte counters, and the event timer. The
+	//	instrumented frame is compared to WSConnection/Frame/healthcheck, the smallest frame and so the worst ratio.
+	static void AddMetricsBenchmarks(Suite &S) {
+		S.Add("Metrics/FrameInstrumentation", [](uint64_t, uint64_t Iterations) {
+			auto &Frames = Metrics::GetCounter("owgw_bench_frames_total", "Benchmark frames.");
+			auto &Bytes = Metrics::GetCounter("owgw_bench_bytes_total", "Benchmark bytes.");
+			auto &Latency = Metrics::GetHistogram("owgw_bench_event_duration_seconds", "Benchmark events.");
+			for(uint64_t i=0;i<Iterations;i++) {
+				Frames.Add();
+				Bytes.Add(1000);
+				Metrics::ScopedTimer	Timer(Latency);
+			}
+		}, Contention);
+
+		auto Frame = HealthCheckEvent(FirstSerial);
+		S.Add("Metrics/Frame/healthcheck", [Frame](uint64_t, uint64_t Iterations) {
+			auto &Frames = Metrics::GetCounter("owgw_bench_frames_total", "Benchmark frames.");
+			auto &Bytes = Metrics::GetCounter("owgw_bench_bytes_total", "Benchmark bytes.");
+			auto &Latency = Metrics::GetHistogram("owgw_bench_event_duration_seconds", "Benchmark events.");
+			std::string Document;
+			for(uint64_t i=0;i<Iterations;i++) {
+				Frames.Add();
+				Bytes.Add(Frame.size());
+				Metrics::ScopedTimer	Timer(Latency);
+				DoNotOptimize(DecodeFrame(Frame, Document));
+			}
+		}, {1}, Frame.size());
+
+		//	what CommandManager paid per answer before it kept one reference per method
+		S.Add("Metrics/LabelledLookup", [](uint64_t, uint64_t Iterations) {
+			static const std::vector<std::string> Methods{"configure", "reboot", "upgrade", "factory", "leds", "trace"};
+			for(uint64_t i=0;i<Iterations;i++)
+				Metrics::GetHistogram("owgw_bench_command_duration_seconds", "Benchmark commands.",
+									  {{"method", Methods[i % Methods.size()]}}).Add(i);
+		}, Contention);
+
+		S.Add("Metrics/Scrape", [](uint64_t, uint64_t Iterations) {
+			Poco::NullOutputStream	Null;
+			for(uint64_t i=0;i<Iterations;i++)
+				Metrics::Registry()->Write(Null);
+		});
+	}
+
+	//	The reactor's liveness timers: one iteration is one second of a reactor holding 2000 connections that all
+	//	stay busy, so every timer that goes off is re-armed 120s later, as CheckLiveness does.
+	static void AddTimerWheelBenchmarks(Suite &S) {
+		struct Connection {
+			TimerWheel<Connection>::Entry	Timer{this};
+		};
+		S.Add("TimerWheel/Tick", [](uint64_t, uint64_t Iterations) {
+			static const uint64_t Connections = 2000, IdleMs = 120000;
+			uint64_t Now = 0;
+			TimerWheel<Connection>	Wheel(1000, Now);
+			std::vector<Connection>	C(Connections);
+			for(uint64_t i=0;i<Connections;i++)
+				Wheel.Schedule(C[i].Timer, (i * IdleMs) / Connections);
+			for(uint64_t i=0;i<Iterations;i++) {
+				Now += 1000;
+				Wheel.Advance(Now, [&](Connection *Expired) { Wheel.Schedule(Expired->Timer, Now + IdleMs); });
+			}
+		});
+		S.Add("TimerWheel/Rearm", [](uint64_t, uint64_t Iterations) {
+			TimerWheel<Connection>	Wheel(1000, 0);
+			Connection	C;
+			for(uint64_t i=0;i<Iterations;i++)
+				Wheel.Schedule(C.Timer, 120000 + (i % 1000) * 1000);
+		});
+	}
+
+	static void Usage(const char *Name) {
+		std::cout << "Usage: " << Name << " [--filter=<regex>] [--json=<file>] [--min-time=<seconds>]" << std::endl
+				  << "       [--frames=<directory>] [--configurations=<directory>] [gateway options]" << std::endl
+				  << "  --filter          only run the benchmarks whose name matches" << std::endl
+				  << "  --json            write the results to file, in the Google Benchmark JSON layout" << std::endl
+				  << "  --min-time        minimum duration of a measured run (0.5)" << std::endl
+				  << "  --frames          captured device frames, one per file, to run through frame processing" << std::endl
+				  << "  --configurations  device configurations (*.json) to validate" << std::endl
+				  << "The gateway configuration is found as for owgw (OWGW_CONFIG, --file=...). Storage is redirected to a" << std::endl
+				  << "scratch SQLite database in the data directory, which is removed afterwards." << std::endl;
+	}
+}
+
+int main(int argc, char **argv) {
+	using namespace OpenWifi;
+	using namespace OpenWifi::Bench;
+
+	std::string Filter, JSONFile, FramesDirectory, ConfigurationDirectory{OWGW_SOURCE_DIR "/test_scripts/curl"};
+	double 		MinTime = 0.5;
+	std::vector<char *>	DaemonArgs{argv[0]};
+	for(int i=1;i<argc;i++) {
+		std::string Arg(argv[i]);
+		auto Option = [&Arg](const std::string &Name, std::string &Value) {
+			if(Arg.rfind(Name + "=", 0)!=0)
+				return false;
+			Value = Arg.substr(Name.size() + 1);
+			return true;
+		};
+		std::string Value;
+		if(Arg=="--help") {
+			Usage(argv[0]);
+			return 0;
+		} else if(Option("--filter", Filter) || Option("--json", JSONFile) || Option("--frames", FramesDirectory) ||
+				   Option("--configurations", ConfigurationDirectory)) {
+			continue;
+		} else if(Option("--min-time", Value)) {
+			MinTime = std::stod(Value);
+		} else {
+			DaemonArgs.push_back(argv[i]);
+		}
+	}
+
+	try {
+		Daemon()->init((int) DaemonArgs.size(), DaemonArgs.data());
+
+		//	never write into the gateway's own database
+		auto ScratchDB = MicroService::instance().DataDir() + "/" + DBName;
+		if(Poco::File(ScratchDB).exists())
+			Poco::File(ScratchDB).remove();
+		MicroService::instance().config().setString("storage.type", "sqlite");
+		MicroService::instance().config().setString("storage.type.sqlite.db", DBName);
+		StorageService()->Start();
+		ConfigurationValidator()->Start();
+		RESTAPI_RateLimiter()->Start();
+
+		Suite	S(MinTime, Filter);
+		AddFrameBenchmarks(S, FramesDirectory);
+		AddRegistryBenchmarks(S);
+		AddDeviceStatisticsNotifierBenchmarks(S);
+		AddSerialNumberCacheBenchmarks(S);
+		AddValidatorBenchmarks(S, ConfigurationDirectory);
+		AddPayloadBenchmarks(S);
+		AddStorageBenchmarks(S);
+		AddCacheSnapshotBenchmarks(S);
+		AddDeviceListBenchmarks(S);
+		AddOUIBenchmarks(S);
+		AddKafkaDispatcherBenchmarks(S);
+		AddKafkaOffsetBenchmarks(S);
+		AddRESTAPIBenchmarks(S);
+		AddIngressLimiterBenchmarks(S);
+		AddMetricsBenchmarks(S);
+		AddTimerWheelBenchmarks(S);
+		S.Run();
+		Dispatcher.Stop();
+		if(OutOfOrder)
+			std::cout << fmt::format("KafkaDispatcher: {} messages delivered out of order for their key.", OutOfOrder.load()) << std::endl;
+		auto Plain = S.Find("WSConnection/Frame/healthcheck"), Instrumented = S.Find("Metrics/Frame/healthcheck");
+		if(Plain && Instrumented && Plain->RealNs>0.0)
+			std::cout << fmt::format("Metrics: {:.1f}% added to WSConnection/Frame/healthcheck.",
+									 100.0 * (Instrumented->RealNs - Plain->RealNs) / Plain->RealNs) << std::endl;
+		for(const auto &[Name,R]:Listings)
+			std::cout << fmt::format("{}: {} devices, {} bytes, first byte after {:.1f}ms, {}kB of extra peak resident memory (worst of {}).",
+									 Name, ListedDevices, R.Bytes, (double) R.FirstByteNs / 1e6, R.PeakKB, R.Calls) << std::endl;
+		if(FailedSelects)
+			std::cout << fmt::format("DeviceSelect: {} lookups failed, most likely for want of a pooled session.", FailedSelects.load()) << std::endl;
+		if(PerMessageCommits || BatchedCommits)
+			std::cout << fmt::format("KafkaConsumer: {} commits per message, {} ahead of the workers; {} batched commits.",
+									 PerMessageCommits.load(), CommitsAheadOfWorkers.load(), BatchedCommits.load()) << std::endl;
+
+		if(!JSONFile.empty()) {
+			std::ofstream	OF(JSONFile, std::ios::trunc);
+			S.WriteJSON(OF, OW_VERSION::VERSION + "(" + OW_VERSION::BUILD + ")-" + OW_VERSION::HASH);
+		}
+
+		StorageService()->Stop();
+		Poco::File(ScratchDB).remove();
+		for(const auto &Name:{std::string(SnapshotName), std::string(OUISnapshotName), std::string(OUISnapshotName) + ".txt"}) {
+			Poco::File	Scratch(MicroService::instance().DataDir() + "/" + Name);
+			if(Scratch.exists())
+				Scratch.remove();
+		}
+	} catch (const Poco::Exception &E) {
+		std::cerr << E.displayText() << std::endl;
+		return Poco::Util::Application::EXIT_SOFTWARE;
+	}
+	return 0;
+}
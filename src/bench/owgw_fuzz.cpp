@@ -0,0 +1,98 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+//	Fuzzing of the wifiscan IE decoders. An input is one IE: its element ID followed by its body, the way
+//	ParseWifiScan finds them once base64 decoded. Built with clang this is a libFuzzer target, otherwise the driver
+//	below replays the files given on the command line, or feeds it random IEs.
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+
+#include "ParseWifiScan.h"
+
+namespace OpenWifi::Fuzz {
+
+	//	The same steps as ParseWifiScan for one IE: a short IE is skipped, a decoder giving up on a truncated IE
+	//	throws std::out_of_range. Anything else, or a result that cannot be printed, is a finding.
+	inline void DecodeIE(const uint8_t *Data, std::size_t Size) {
+		if (Size == 0)
+			return;
+		const auto &Entry = IEDecoders()[Data[0]];
+		std::vector<unsigned char> IE(Data + 1, Data + Size);
+		if (Entry.Decoder == nullptr || IE.size() < Entry.MinLength)
+			return;
+		try {
+			auto Decoded = Entry.Decoder(IE);
+			auto Text = Decoded.dump();
+		} catch (const std::out_of_range &) {
+		}
+	}
+
+#ifndef OWGW_LIBFUZZER
+	static const std::vector<uint32_t> VendorOUIs{OUI_WPAWME, OUI_RSN,	   OUI_PRE11N, OUI_WFA,	   OUI_CISCOWL,
+												  OUI_MARVELL, OUI_ATHEROS, OUI_ARUBA,	OUI_NINTENDO};
+
+	//	Random IEs, half of them vendor specific with a known OUI so the vendor dissectors get past their switch.
+	static void RandomIEs(uint64_t Iterations, uint64_t Seed) {
+		std::mt19937_64 R(Seed);
+		std::vector<uint8_t> Input;
+		for (uint64_t i = 0; i < Iterations; i++) {
+			Input.resize(1 + R() % 80);
+			for (auto &c : Input)
+				c = R();
+			if (i % 2) {
+				Input[0] = WLAN_EID_VENDOR_SPECIFIC;
+				if (Input.size() >= 5) {
+					auto OUI = VendorOUIs[R() % VendorOUIs.size()];
+					Input[1] = OUI >> 16;
+					Input[2] = OUI >> 8;
+					Input[3] = OUI;
+					Input[4] = R() % 5;
+					if (Input.size() >= 6)
+						Input[5] = R() % 3;
+				}
+			}
+			DecodeIE(Input.data(), Input.size());
+		}
+	}
+#endif
+
+} // namespace OpenWifi::Fuzz
+
+#ifdef OWGW_LIBFUZZER
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *Data, std::size_t Size) {
+	OpenWifi::Fuzz::DecodeIE(Data, Size);
+	return 0;
+}
+#else
+int main(int argc, char **argv) {
+	if (argc > 1) {
+		for (int i = 1; i < argc; i++) {
+			std::ifstream IS(argv[i], std::ios::binary);
+			if (!IS) {
+				std::cerr << "owgw_fuzz: cannot read " << argv[i] << std::endl;
+				return 1;
+			}
+			std::vector<uint8_t> Input{std::istreambuf_iterator<char>(IS), std::istreambuf_iterator<char>()};
+			OpenWifi::Fuzz::DecodeIE(Input.data(), Input.size());
+		}
+		return 0;
+	}
+	uint64_t Iterations = 2000000;
+	if (auto Env = std::getenv("OWGW_FUZZ_ITERATIONS"))
+		Iterations = std::strtoull(Env, nullptr, 10);
+	uint64_t Seed = std::random_device{}();
+	if (auto Env = std::getenv("OWGW_FUZZ_SEED"))
+		Seed = std::strtoull(Env, nullptr, 10);
+	std::cout << "owgw_fuzz: seed " << Seed << std::endl;
+	OpenWifi::Fuzz::RandomIEs(Iterations, Seed);
+	std::cout << "owgw_fuzz: " << Iterations << " random IEs decoded." << std::endl;
+	return 0;
+}
+#endif
@@ -0,0 +1,287 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+//	Counters, gauges and latency histograms exported in the Prometheus text format. Recording is lock free: every
+//	metric is split in stripes, a thread always writes to the same stripe with relaxed atomics, and the stripes are
+//	only added up when the metrics are scraped. Hot paths keep a reference to their metric, the registry lookup
+//	takes a lock and is meant to be done once.
+namespace OpenWifi::Metrics {
+
+	typedef std::vector<std::pair<std::string,std::string>>	Labels;
+
+	static constexpr std::size_t Stripes = 16;
+
+	inline std::size_t Stripe() {
+		static std::atomic_size_t	Next = 0;
+		thread_local std::size_t	Mine = Next++ % Stripes;
+		return Mine;
+	}
+
+	class Counter {
+	  public:
+		inline void Add(uint64_t Value = 1) {
+			Cells_[Stripe()].Value.fetch_add(Value, std::memory_order_relaxed);
+		}
+
+		[[nodiscard]] inline uint64_t Value() const {
+			uint64_t Total = 0;
+			for(const auto &C:Cells_)
+				Total += C.Value.load(std::memory_order_relaxed);
+			return Total;
+		}
+
+	  private:
+		struct alignas(64) Cell {
+			std::atomic_uint64_t	Value = 0;
+		};
+		std::array<Cell,Stripes>	Cells_;
+	};
+
+	//	HDR-style histogram of microseconds: 8 sub buckets per power of two, so any value is known within 12.5%.
+	//	It is exported with one bucket per power of two, from 16us to about 33s.
+	class Histogram {
+	  public:
+		static constexpr std::size_t SubBuckets = 8;
+		static constexpr std::size_t Powers = 36;				//	up to 2^36us, about 19 hours
+		static constexpr std::size_t BucketCount = Powers * SubBuckets;
+		static constexpr std::size_t FirstExportedPower = 4, LastExportedPower = 25;
+
+		inline void Add(uint64_t Us) {
+			auto &S = Shards_[Stripe()];
+			S.Buckets[Bucket(Us)].fetch_add(1, std::memory_order_relaxed);
+			S.Sum.fetch_add(Us, std::memory_order_relaxed);
+		}
+
+		struct Snapshot {
+			std::array<uint64_t,BucketCount>	Buckets{};
+			uint64_t 						Count = 0, Sum = 0;
+			[[nodiscard]] uint64_t Percentile(double P) const;
+		};
+		[[nodiscard]] Snapshot Collect() const;
+
+		static inline std::size_t Bucket(uint64_t Us) {
+			if(Us < SubBuckets)
+				return Us;
+			auto Msb = 63 - __builtin_clzll(Us);
+			auto Shift = Msb - 3;
+			return std::min((std::size_t)((Shift + 1) * SubBuckets + ((Us >> Shift) & (SubBuckets - 1))), BucketCount - 1);
+		}
+
+		//	the smallest value of a bucket
+		static inline uint64_t BucketValue(std::size_t Bucket) {
+			if(Bucket < SubBuckets)
+				return Bucket;
+			auto Shift = Bucket / SubBuckets - 1;
+			return (SubBuckets + Bucket % SubBuckets) << Shift;
+		}
+
+	  private:
+		struct alignas(64) Shard {
+			std::array<std::atomic_uint64_t,BucketCount>	Buckets{};
+			std::atomic_uint64_t 						Sum = 0;
+		};
+		std::array<Shard,Stripes>	Shards_;
+	};
+
+	//	records the time from its construction to its destruction, nothing when given no histogram
+	class ScopedTimer {
+	  public:
+		explicit ScopedTimer(Histogram *H = nullptr) : Histogram_(H), Start_(std::chrono::steady_clock::now()) {}
+		explicit ScopedTimer(Histogram &H) : ScopedTimer(&H) {}
+		inline void Set(Histogram *H) { Histogram_ = H; }
+		~ScopedTimer() {
+			if(Histogram_)
+				Histogram_->Add((uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+									std::chrono::steady_clock::now() - Start_).count());
+		}
+	  private:
+		Histogram 								*Histogram_;
+		std::chrono::steady_clock::time_point	Start_;
+	};
+
+	class Registry {
+	  public:
+		typedef std::function<double()>	GaugeFunction;
+
+		static auto instance() {
+			static auto instance_ = new Registry;
+			return instance_;
+		}
+
+		//	the same name and labels always return the same metric
+		Counter & GetCounter(const std::string &Name, const std::string &Help, const Labels &L = {});
+		Histogram & GetHistogram(const std::string &Name, const std::string &Help, const Labels &L = {});
+		//	gauges are read when scraped, F must stay valid as long as the process runs
+		void AddGauge(const std::string &Name, const std::string &Help, const Labels &L, GaugeFunction F);
+
+		void Write(std::ostream &OS) const;
+
+	  private:
+		enum class Type { COUNTER, GAUGE, HISTOGRAM };
+		struct Family {
+			Type 											MetricType = Type::COUNTER;
+			std::string 									Help;
+			std::map<std::string,std::unique_ptr<Counter>>	Counters;
+			std::map<std::string,std::unique_ptr<Histogram>>	Histograms;
+			std::map<std::string,GaugeFunction>				Gauges;
+		};
+
+		mutable std::mutex 				Mutex_;
+		std::map<std::string,Family>	Families_;
+
+		Family & GetFamily(const std::string &Name, const std::string &Help, Type T);
+		static std::string LabelText(const Labels &L);
+		static std::string Escape(const std::string &S);
+	};
+
+	inline Histogram::Snapshot Histogram::Collect() const {
+		Snapshot	S;
+		for(const auto &Shard:Shards_) {
+			for(std::size_t i=0;i<BucketCount;i++) {
+				auto V = Shard.Buckets[i].load(std::memory_order_relaxed);
+				S.Buckets[i] += V;
+				S.Count += V;
+			}
+			S.Sum += Shard.Sum.load(std::memory_order_relaxed);
+		}
+		return S;
+	}
+
+	inline uint64_t Histogram::Snapshot::Percentile(double P) const {
+		if(Count==0)
+			return 0;
+		auto Target = std::max((uint64_t)1, (uint64_t)(P / 100.0 * (double)Count + 0.5));
+		uint64_t Seen = 0;
+		for(std::size_t i=0;i<Buckets.size();i++) {
+			Seen += Buckets[i];
+			if(Seen>=Target)
+				return BucketValue(i);
+		}
+		return BucketValue(Buckets.size()-1);
+	}
+
+	inline Registry::Family & Registry::GetFamily(const std::string &Name, const std::string &Help, Type T) {
+		auto &F = Families_[Name];
+		if(F.Help.empty()) {
+			F.Help = Help;
+			F.MetricType = T;
+		}
+		return F;
+	}
+
+	inline Counter & Registry::GetCounter(const std::string &Name, const std::string &Help, const Labels &L) {
+		std::lock_guard	G(Mutex_);
+		auto &Slot = GetFamily(Name, Help, Type::COUNTER).Counters[LabelText(L)];
+		if(!Slot)
+			Slot = std::make_unique<Counter>();
+		return *Slot;
+	}
+
+	inline Histogram & Registry::GetHistogram(const std::string &Name, const std::string &Help, const Labels &L) {
+		std::lock_guard	G(Mutex_);
+		auto &Slot = GetFamily(Name, Help, Type::HISTOGRAM).Histograms[LabelText(L)];
+		if(!Slot)
+			Slot = std::make_unique<Histogram>();
+		return *Slot;
+	}
+
+	inline void Registry::AddGauge(const std::string &Name, const std::string &Help, const Labels &L, GaugeFunction F) {
+		std::lock_guard	G(Mutex_);
+		GetFamily(Name, Help, Type::GAUGE).Gauges[LabelText(L)] = std::move(F);
+	}
+
+	inline std::string Registry::Escape(const std::string &S) {
+		std::string R;
+		for(const auto &c:S) {
+			if(c=='\\' || c=='"')
+				R += '\\';
+			if(c=='\n') {
+				R += "\\n";
+				continue;
+			}
+			R += c;
+		}
+		return R;
+	}
+
+	inline std::string Registry::LabelText(const Labels &L) {
+		std::string R;
+		for(const auto &[Name,Value]:L) {
+			if(!R.empty())
+				R += ',';
+			R += Name + "=\"" + Escape(Value) + "\"";
+		}
+		return R;
+	}
+
+	inline void Registry::Write(std::ostream &OS) const {
+		auto Braces = [](const std::string &L) { return L.empty() ? std::string() : "{" + L + "}"; };
+		auto With = [](const std::string &L, const std::string &Extra) { return "{" + (L.empty() ? Extra : L + "," + Extra) + "}"; };
+
+		std::lock_guard	G(Mutex_);
+		for(const auto &[Name,F]:Families_) {
+			OS << "# HELP " << Name << " " << F.Help << "\n";
+			switch(F.MetricType) {
+			case Type::COUNTER: {
+				OS << "# TYPE " << Name << " counter\n";
+				for(const auto &[L,C]:F.Counters)
+					OS << Name << Braces(L) << " " << C->Value() << "\n";
+			} break;
+			case Type::GAUGE: {
+				OS << "# TYPE " << Name << " gauge\n";
+				for(const auto &[L,Gauge]:F.Gauges)
+					OS << Name << Braces(L) << " " << Gauge() << "\n";
+			} break;
+			case Type::HISTOGRAM: {
+				//	recorded in microseconds, exported in seconds as Prometheus expects
+				OS << "# TYPE " << Name << " histogram\n";
+				for(const auto &[L,H]:F.Histograms) {
+					auto S = H->Collect();
+					uint64_t Cumulative = 0;
+					std::size_t i = 0;
+					for(auto Power=Histogram::FirstExportedPower;Power<=Histogram::LastExportedPower;Power++) {
+						//	buckets below the one starting at 2^Power hold the values under 2^Power
+						for(;i<Histogram::Bucket((uint64_t)1 << Power);i++)
+							Cumulative += S.Buckets[i];
+						OS << Name << "_bucket" << With(L, "le=\"" + std::to_string((double)((uint64_t)1 << Power) / 1000000.0) + "\"")
+						   << " " << Cumulative << "\n";
+					}
+					OS << Name << "_bucket" << With(L, "le=\"+Inf\"") << " " << S.Count << "\n";
+					OS << Name << "_sum" << Braces(L) << " " << (double)S.Sum / 1000000.0 << "\n";
+					OS << Name << "_count" << Braces(L) << " " << S.Count << "\n";
+				}
+			} break;
+			}
+		}
+	}
+
+	inline auto Registry() { return Registry::instance(); }
+
+	inline Counter & GetCounter(const std::string &Name, const std::string &Help, const Labels &L = {}) {
+		return Registry()->GetCounter(Name, Help, L);
+	}
+
+	inline Histogram & GetHistogram(const std::string &Name, const std::string &Help, const Labels &L = {}) {
+		return Registry()->GetHistogram(Name, Help, L);
+	}
+}
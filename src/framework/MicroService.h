@@ -22,6 +22,16 @@
 #include <iomanip>
 #include <queue>
 #include <variant>
+#include <future>
+#include <functional>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <typeinfo>
+#include <unordered_map>
+#include <string_view>
 
 namespace OpenWifi {
     inline uint64_t Now() { return std::time(nullptr); };
@@ -64,6 +74,7 @@ using namespace std::chrono_literals;
 #include "Poco/Net/HTTPSClientSession.h"
 #include "Poco/Net/NetworkInterface.h"
 #include "Poco/ExpireLRUCache.h"
+#include "Poco/LRUCache.h"
 #include "Poco/JSON/Object.h"
 #include "Poco/JSON/Parser.h"
 #include "Poco/StringTokenizer.h"
@@ -88,6 +99,7 @@ using namespace std::chrono_literals;
 
 #include "framework/OpenWifiTypes.h"
 #include "framework/KafkaTopics.h"
+#include "framework/Metrics.h"
 #include "framework/ow_constants.h"
 #include "RESTObjects/RESTAPI_SecurityObjects.h"
 #include "nlohmann/json.hpp"
@@ -1623,6 +1635,8 @@ namespace OpenWifi {
 
 	    virtual int Start() = 0;
 	    virtual void Stop() = 0;
+	    //	called on termination, in reverse start order, while every subsystem is still running
+	    virtual void Drain() {}
 
         struct LoggerWrapper {
             Poco::Logger &L;
@@ -1742,12 +1756,14 @@ namespace OpenWifi {
 	            std::string _fileName;
     };
 
+	//	Token buckets keyed by (client address, route). A bucket holds up to MaxCalls tokens and refills continuously at
+	//	MaxCalls per Interval, so bursts across a window edge can no longer reach twice the allowed rate. Buckets live in
+	//	sharded maps and are updated with a compare and swap, so callers never wait on a global lock.
 	class RESTAPI_RateLimiter : public SubSystemServer {
 	public:
-
-	    struct ClientCacheEntry {
-	        int64_t  Start=0;
-	        int      Count=0;
+	    struct Profile {
+	        int64_t     Interval=1000;
+	        int64_t     MaxCalls=100;
 	    };
 
 	    static auto instance() {
@@ -1758,37 +1774,115 @@ namespace OpenWifi {
 	    inline int Start() final { return 0;};
 	    inline void Stop() final { };
 
-	    inline bool IsRateLimited(const Poco::Net::HTTPServerRequest &R, int64_t Period, int64_t MaxCalls) {
-	        Poco::URI   uri(R.getURI());
-	        auto H = str_hash(uri.getPath() + R.clientAddress().host().toString());
-	        auto E = Cache_.get(H);
-	        auto Now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
-	        if(E.isNull()) {
-	            Cache_.add(H,ClientCacheEntry{.Start=Now, .Count=1});
-	            return false;
-	        }
-	        if((Now-E->Start)<Period) {
-	            E->Count++;
-	            Cache_.update(H,E);
-	            if(E->Count > MaxCalls) {
-	                Logger().warning(fmt::format("RATE-LIMIT-EXCEEDED: from '{}'", R.clientAddress().toString()));
-	                return true;
-	            }
+	    //	Returns true when the call must be refused, RetryAfterMs is then the wait until a token is available.
+	    inline bool IsRateLimited(const Poco::Net::HTTPServerRequest &R, uint64_t RouteId, int64_t Period, int64_t MaxCalls, uint64_t &RetryAfterMs) {
+	        return IsRateLimited(R.clientAddress().host(), RouteId, Period, MaxCalls, RetryAfterMs);
+	    }
+
+	    inline bool IsRateLimited(const Poco::Net::IPAddress &Host, uint64_t RouteId, int64_t Period, int64_t MaxCalls, uint64_t &RetryAfterMs) {
+	        auto Key = HashBytes(Host.addr(), Host.length(), RouteId);
+	        auto Capacity = (uint64_t) std::clamp(MaxCalls, (int64_t)1, (int64_t)MaxTokens) * TokenScale;
+	        auto Interval = (uint64_t) std::max(Period, (int64_t)1);
+	        auto Now = NowMs();
+
+	        if(Take(Key, Interval, Capacity, Now, RetryAfterMs))
 	            return false;
-	        }
-	        E->Start = Now;
-	        E->Count = 1;
-	        Cache_.update(H,E);
-	        return false;
+	        Logger().warning(fmt::format("RATE-LIMIT-EXCEEDED: from '{}'", Host.toString()));
+	        return true;
 	    }
 
+	    //	Per route overrides, from openwifi.restapi.ratelimit.<n>.path / .maxcalls / .interval
+	    [[nodiscard]] inline std::optional<Profile> RouteProfile(const std::string &Pattern);
+
 	    inline void Clear() {
-	        Cache_.clear();
+	        for(auto &S:Shards_) {
+	            std::unique_lock G(S.Mutex);
+	            S.Buckets.clear();
+	        }
 	    }
 
 	private:
-	    Poco::ExpireLRUCache<uint64_t,ClientCacheEntry>      Cache_{2048};
-	    std::hash<std::string>          str_hash;
+	    static constexpr uint64_t   TokenBits = 22;             //  low bits: tokens in 1/TokenScale units, high bits: last refill in ms
+	    static constexpr uint64_t   TokenMask = (1ULL << TokenBits) - 1;
+	    static constexpr uint64_t   TokenScale = 64;
+	    static constexpr uint64_t   MaxTokens = TokenMask / TokenScale;
+	    static constexpr std::size_t NumShards = 64;
+	    static constexpr std::size_t MaxBucketsPerShard = 1024;
+
+	    struct Bucket {
+	        std::atomic_uint64_t    State=0;
+	        uint64_t                Interval=0;
+	    };
+
+	    struct Shard {
+	        std::shared_mutex                       Mutex;
+	        std::unordered_map<uint64_t,Bucket>     Buckets;
+	    };
+
+	    std::array<Shard,NumShards>     Shards_;
+	    std::chrono::steady_clock::time_point   Epoch_ = std::chrono::steady_clock::now();
+	    std::once_flag                  ProfilesLoaded_;
+	    std::map<std::string,Profile>   Profiles_;
+
+	    inline uint64_t NowMs() const {
+	        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - Epoch_).count() + 1;
+	    }
+
+	    static inline uint64_t HashBytes(const void *Data, std::size_t Length, uint64_t Seed) {
+	        uint64_t H = 14695981039346656037ULL ^ Seed;
+	        auto P = (const unsigned char *)Data;
+	        for(std::size_t i=0;i<Length;i++) {
+	            H ^= P[i];
+	            H *= 1099511628211ULL;
+	        }
+	        return H;
+	    }
+
+	    static inline bool TakeToken(Bucket &B, uint64_t Interval, uint64_t Capacity, uint64_t Now, uint64_t &RetryAfterMs) {
+	        auto Current = B.State.load(std::memory_order_relaxed);
+	        while(true) {
+	            uint64_t Last = Current >> TokenBits;
+	            uint64_t Tokens = Current & TokenMask;
+	            uint64_t Elapsed = std::min(Now > Last ? Now - Last : 0, Interval);
+	            Tokens = std::min(Capacity, Tokens + Elapsed * Capacity / Interval);
+	            if(Tokens < TokenScale) {
+	                RetryAfterMs = ((TokenScale - Tokens) * Interval + Capacity - 1) / Capacity;
+	                return false;
+	            }
+	            auto Next = (std::max(Now,Last) << TokenBits) | (Tokens - TokenScale);
+	            if(B.State.compare_exchange_weak(Current, Next, std::memory_order_relaxed))
+	                return true;
+	        }
+	    }
+
+	    //	The bucket is only touched while its shard lock is held (shared for existing buckets), so it cannot be
+	    //	evicted under our feet. Buckets are created full. A shard that grows too large drops the buckets that have
+	    //	been idle for a full interval: they would be full again anyway, so forgetting them changes no decision.
+	    inline bool Take(uint64_t Key, uint64_t Interval, uint64_t Capacity, uint64_t Now, uint64_t &RetryAfterMs) {
+	        auto & S = Shards_[Key % NumShards];
+	        {
+	            std::shared_lock G(S.Mutex);
+	            auto Hint = S.Buckets.find(Key);
+	            if(Hint!=S.Buckets.end())
+	                return TakeToken(Hint->second, Interval, Capacity, Now, RetryAfterMs);
+	        }
+	        std::unique_lock G(S.Mutex);
+	        if(S.Buckets.size()>=MaxBucketsPerShard) {
+	            for(auto i=S.Buckets.begin();i!=S.Buckets.end();) {
+	                auto Last = i->second.State.load() >> TokenBits;
+	                if(Now > Last && Now - Last >= i->second.Interval)
+	                    i = S.Buckets.erase(i);
+	                else
+	                    ++i;
+	            }
+	        }
+	        auto [Hint,Inserted] = S.Buckets.try_emplace(Key);
+	        if(Inserted) {
+	            Hint->second.State = (Now << TokenBits) | Capacity;
+	            Hint->second.Interval = Interval;
+	        }
+	        return TakeToken(Hint->second, Interval, Capacity, Now, RetryAfterMs);
+	    }
 
 	    RESTAPI_RateLimiter() noexcept:
 	    SubSystemServer("RateLimiter", "RATE-LIMITER", "rate.limiter")
@@ -1799,13 +1893,54 @@ namespace OpenWifi {
 
     inline auto RESTAPI_RateLimiter() { return RESTAPI_RateLimiter::instance(); }
 
+	//	Writes {"<Name>":[ e1, e2, ... ], "<trailer>":... } one element at a time, so a large listing never
+	//	needs to exist as a complete JSON DOM before the first byte is sent.
+	class JSONArrayStream {
+	  public:
+		JSONArrayStream(std::ostream &OS, const std::string &Name) : OS_(OS) {
+			OS_ << "{";
+			Poco::JSON::Stringifier::formatString(Name, OS_);
+			OS_ << ":[";
+		}
+
+		inline void Add(const Poco::JSON::Object &O) {
+			if(Count_++)
+				OS_ << ',';
+			Poco::JSON::Stringifier::stringify(O, OS_);
+		}
+
+		inline void Add(const std::string &S) {
+			if(Count_++)
+				OS_ << ',';
+			Poco::JSON::Stringifier::formatString(S, OS_);
+		}
+
+		inline void Finish(const Poco::JSON::Object &Trailer) {
+			OS_ << ']';
+			for(const auto &[Key,Value]:Trailer) {
+				OS_ << ',';
+				Poco::JSON::Stringifier::formatString(Key, OS_);
+				OS_ << ':';
+				Poco::JSON::Stringifier::stringify(Value, OS_);
+			}
+			OS_ << '}';
+			OS_.flush();
+		}
+
+		[[nodiscard]] inline uint64_t Count() const { return Count_; }
+
+	  private:
+		std::ostream 	&OS_;
+		uint64_t 		Count_=0;
+	};
+
 	class RESTAPIHandler : public Poco::Net::HTTPRequestHandler {
 	public:
 	    struct QueryBlock {
 	        uint64_t StartDate = 0 , EndDate = 0 , Offset = 0 , Limit = 0, LogType = 0 ;
-	        std::string SerialNumber, Filter;
+	        std::string SerialNumber, Filter, Cursor;
             std::vector<std::string>    Select;
-	        bool Lifetime=false, LastOnly=false, Newest=false, CountOnly=false, AdditionalInfo=false;
+	        bool Lifetime=false, LastOnly=false, Newest=false, CountOnly=false, AdditionalInfo=false, UseCursor=false;
 	    };
 	    typedef std::map<std::string, std::string> BindingMap;
 
@@ -1846,6 +1981,7 @@ namespace OpenWifi {
 	        try {
 	            Request = &RequestIn;
 	            Response = &ResponseIn;
+	            Metrics::ScopedTimer	Timer(Latency_);
 
 				Poco::Thread::current()->setName("WebServerThread_" + std::to_string(TransactionId_));
 
@@ -1855,8 +1991,10 @@ namespace OpenWifi {
                     }
                 }
 
-	            if(RateLimited_ && RESTAPI_RateLimiter()->IsRateLimited(RequestIn,MyRates_.Interval, MyRates_.MaxCalls)) {
-	                return UnAuthorized(RESTAPI::Errors::RATE_LIMIT_EXCEEDED);
+	            uint64_t RetryAfterMs=0;
+	            if(RateLimited_ && RESTAPI_RateLimiter()->IsRateLimited(RequestIn, RouteId_ ? RouteId_ : typeid(*this).hash_code(),
+	                                                                  MyRates_.Interval, MyRates_.MaxCalls, RetryAfterMs)) {
+	                return TooManyRequests(RESTAPI::Errors::RATE_LIMIT_EXCEEDED, RetryAfterMs);
 	            }
 
 	            if (!ContinueProcessing())
@@ -1893,6 +2031,16 @@ namespace OpenWifi {
 	        }
 	    }
 
+	    //	set by the router: identifies the matched endpoint, applies its configured rate limit, if any, and times it
+	    inline void SetRoute(uint64_t RouteId, const std::optional<RESTAPI_RateLimiter::Profile> &Limit, Metrics::Histogram *Latency) {
+	        RouteId_ = RouteId;
+	        Latency_ = Latency;
+	        if(Limit) {
+	            RateLimited_ = true;
+	            MyRates_ = RateLimit{.Interval=Limit->Interval, .MaxCalls=Limit->MaxCalls};
+	        }
+	    }
+
 	    [[nodiscard]] inline bool NeedAdditionalInfo() const { return QB_.AdditionalInfo; }
 	    [[nodiscard]] inline const std::vector<std::string> & SelectedRecords() const { return QB_.Select; }
 
@@ -2145,6 +2293,17 @@ namespace OpenWifi {
 	        Poco::JSON::Stringifier::stringify(ErrorObject, Answer);
 	    }
 
+	    inline void TooManyRequests(const OpenWifi::RESTAPI::Errors::msg &E, uint64_t RetryAfterMs) {
+	        PrepareResponse(Poco::Net::HTTPResponse::HTTP_TOO_MANY_REQUESTS);
+	        Response->set("Retry-After", std::to_string(std::max((uint64_t)1, (RetryAfterMs + 999) / 1000)));
+	        Poco::JSON::Object	ErrorObject;
+	        ErrorObject.set("ErrorCode",E.err_num);
+	        ErrorObject.set("ErrorDetails",Request->getMethod());
+	        ErrorObject.set("ErrorDescription",fmt::format("{}: {}",E.err_num,E.err_txt)) ;
+	        std::ostream &Answer = Response->send();
+	        Poco::JSON::Stringifier::stringify(ErrorObject, Answer);
+	    }
+
 	    inline void NotFound() {
 	        PrepareResponse(Poco::Net::HTTPResponse::HTTP_NOT_FOUND);
 	        Poco::JSON::Object	ErrorObject;
@@ -2253,6 +2412,72 @@ namespace OpenWifi {
             OutputStream << Content ;
         }
 
+        //  Send Size bytes from Content, honouring a single "Range: bytes=..." request, without loading the file.
+        inline void SendFileStream(std::istream &Content, uint64_t Size, const std::string & Name) {
+            uint64_t First = 0, Last = Size ? Size - 1 : 0;
+            bool Partial = false;
+            if(Request->has("Range")) {
+                //  digits only, so "bytes=abc-" or "bytes=-x" is refused rather than read as 0
+                auto Number = [](const std::string &Text, uint64_t &Value) {
+                    if(Text.empty() || Text.size()>19 || Text.find_first_not_of("0123456789")!=std::string::npos)
+                        return false;
+                    Value = std::strtoull(Text.c_str(), nullptr, 10);
+                    return true;
+                };
+                const auto & Range = Request->get("Range");
+                auto Dash = Range.find('-');
+                bool Satisfiable = Range.compare(0,6,"bytes=")==0 && Dash!=std::string::npos && Size>0;
+                if(Satisfiable) {
+                    auto From = Range.substr(6,Dash-6), To = Range.substr(Dash+1);
+                    uint64_t Suffix = 0, End = 0;
+                    if(From.empty()) {
+                        Satisfiable = Number(To, Suffix);
+                        First = Size - std::min(Size, Suffix);
+                    } else {
+                        Satisfiable = Number(From, First) && (To.empty() || Number(To, End));
+                        if(!To.empty())
+                            Last = std::min(Last, End);
+                    }
+                    Satisfiable = Satisfiable && First<=Last && First<Size;
+                }
+                if(!Satisfiable) {
+                    Response->set("Content-Range", fmt::format("bytes */{}", Size));
+                    PrepareResponse(Poco::Net::HTTPResponse::HTTP_REQUESTED_RANGE_NOT_SATISFIABLE);
+                    Response->setContentLength(0);
+                    Response->send();
+                    return;
+                }
+                Partial = true;
+            }
+
+            PrepareResponse(Partial ? Poco::Net::HTTPResponse::HTTP_PARTIAL_CONTENT : Poco::Net::HTTPResponse::HTTP_OK);
+            auto MT = Utils::FindMediaType(Name);
+            if(MT.Encoding==Utils::BINARY) {
+                Response->set("Content-Transfer-Encoding","binary");
+            }
+            Response->set("Content-Disposition", "attachment; filename=" + Name );
+            Response->set("Accept-Ranges", "bytes");
+            Response->set("Cache-Control", "no-store");
+            Response->set("Expires", "Mon, 26 Jul 2027 05:00:00 GMT");
+            if(Partial)
+                Response->set("Content-Range", fmt::format("bytes {}-{}/{}", First, Last, Size));
+            auto Length = Size ? Last - First + 1 : 0;
+            Response->setContentLength64(Length);
+            Response->setContentType(MT.ContentType);
+            auto & OutputStream = Response->send();
+
+            Content.seekg((std::streamoff) First);
+            std::array<char, 64 * 1024>  Buffer{};
+            while(Length && Content) {
+                Content.read(Buffer.data(), (std::streamsize) std::min<uint64_t>(Length, Buffer.size()));
+                auto Count = Content.gcount();
+                if(Count<=0)
+                    break;
+                OutputStream.write(Buffer.data(), Count);
+                Length -= Count;
+            }
+        }
+
         inline void SendHTMLFileBack(Poco::File & File,
                                      const Types::StringPairVec & FormVars) {
 			Response->setStatus(Poco::Net::HTTPResponse::HTTPStatus::HTTP_OK);
@@ -2313,6 +2538,34 @@ namespace OpenWifi {
             Poco::JSON::Stringifier::stringify(Object, Answer);
         }
 
+        //  Stream a large array back to the caller. Producer adds elements as they become available and may
+        //  fill Trailer with extra top level fields (i.e. a continuation cursor) written after the array.
+        inline void ReturnStreamedArray(const std::string &Name,
+                                        const std::function<void(JSONArrayStream &Stream, Poco::JSON::Object &Trailer)> &Producer) {
+            PrepareResponse();
+            Poco::JSON::Object  Trailer;
+            if(Request!= nullptr) {
+                auto AcceptedEncoding = Request->find("Accept-Encoding");
+                if(AcceptedEncoding!=Request->end()) {
+                    if( AcceptedEncoding->second.find("gzip")!=std::string::npos ||
+                        AcceptedEncoding->second.find("compress")!=std::string::npos) {
+                        Response->set("Content-Encoding", "gzip");
+                        std::ostream &Answer = Response->send();
+                        Poco::DeflatingOutputStream deflater(Answer, Poco::DeflatingStreamBuf::STREAM_GZIP);
+                        JSONArrayStream Stream(deflater, Name);
+                        Producer(Stream, Trailer);
+                        Stream.Finish(Trailer);
+                        deflater.close();
+                        return;
+                    }
+                }
+            }
+            std::ostream &Answer = Response->send();
+            JSONArrayStream Stream(Answer, Name);
+            Producer(Stream, Trailer);
+            Stream.Finish(Trailer);
+        }
+
 	        inline void ReturnCountOnly(uint64_t Count) {
 	            Poco::JSON::Object  Answer;
 	            Answer.set("count", Count);
@@ -2335,6 +2588,8 @@ namespace OpenWifi {
 	            QB_.Newest = GetBoolParameter(RESTAPI::Protocol::NEWEST,false);
 	            QB_.CountOnly = GetBoolParameter(RESTAPI::Protocol::COUNTONLY,false);
 	            QB_.AdditionalInfo = GetBoolParameter(RESTAPI::Protocol::WITHEXTENDEDINFO,false);
+	            //  an empty cursor asks for the first page of a cursor based listing
+	            QB_.UseCursor = HasParameter(RESTAPI::Protocol::CURSOR,QB_.Cursor);
 
                 auto RawSelect = GetParameter(RESTAPI::Protocol::SELECT, "");
 
@@ -2402,6 +2657,8 @@ namespace OpenWifi {
 	        RateLimit                   MyRates_;
             uint64_t                    TransactionId_;
             Poco::JSON::Object::Ptr     ParsedBody_;
+	        uint64_t                    RouteId_=0;
+	        Metrics::Histogram          *Latency_=nullptr;
 	    };
 
 	    class RESTAPI_UnknownRequestHandler : public RESTAPIHandler {
@@ -2425,34 +2682,153 @@ namespace OpenWifi {
 	                return std::false_type{};
 	            }
 
-	            template<typename T, typename... Args>
-	            RESTAPIHandler * RESTAPI_Router(const std::string & RequestedPath, RESTAPIHandler::BindingMap &Bindings,
-											   Poco::Logger & Logger, RESTAPI_GenericServer & Server, uint64_t TransactionId) {
-	                static_assert(test_has_PathName_method((T*)nullptr), "Class must have a static PathName() method.");
-	                if(RESTAPIHandler::ParseBindings(RequestedPath,T::PathName(),Bindings)) {
-	                    return new T(Bindings, Logger, Server, TransactionId, false);
+	    //	Endpoint patterns compiled once into a segment trie. Dispatch is a single pass over the request path: literal
+	    //	segments are looked up by name, parameter segments accept anything. When several patterns match, the handler
+	    //	listed first in the router wins, as with the old linear scan.
+	    class RESTAPI_RouteTrie {
+	    public:
+	        typedef RESTAPIHandler * (*HandlerFactory)(RESTAPIHandler::BindingMap &Bindings, Poco::Logger & Logger,
+	                                                   RESTAPI_GenericServer & Server, uint64_t TransactionId, bool Internal);
+
+	        template <typename... Handlers> static RESTAPI_RouteTrie Build() {
+	            RESTAPI_RouteTrie Trie;
+	            std::size_t Priority=0;
+	            (Trie.AddHandler<Handlers>(Priority++), ...);
+	            return Trie;
+	        }
+
+	        inline RESTAPIHandler * Route(const std::string & RequestedPath, RESTAPIHandler::BindingMap &Bindings,
+	                                      Poco::Logger & Logger, RESTAPI_GenericServer & Server, uint64_t TransactionId, bool Internal) const {
+	            Segments    Path;
+	            std::size_t Count=0;
+	            if(Split(RequestedPath,Path,Count)) {
+	                const Leaf *Best = nullptr;
+	                Walk(0, Path, Count, 0, Best);
+	                if(Best!= nullptr) {
+	                    Bindings.clear();
+	                    for(const auto &[Index,Name]:Best->Slots)
+	                        Bindings[Name] = std::string(Path[Index]);
+	                    auto Handler = Best->Factory(Bindings, Logger, Server, TransactionId, Internal);
+	                    Handler->SetRoute(Best->RouteId, Best->Limit, Best->Latency);
+	                    return Handler;
+	                }
+	            }
+	            return new RESTAPI_UnknownRequestHandler(Bindings, Logger, Server, TransactionId, Internal);
+	        }
+
+	    private:
+	        static constexpr std::size_t MaxSegments = 32;
+	        typedef std::array<std::string_view,MaxSegments> Segments;
+
+	        struct Leaf {
+	            HandlerFactory                                      Factory = nullptr;
+	            std::size_t                                         Priority = 0;
+	            std::vector<std::pair<std::size_t,std::string>>     Slots;      //  segment index -> lower case parameter name
+	            uint64_t                                            RouteId = 0;
+	            std::optional<RESTAPI_RateLimiter::Profile>         Limit;
+	            Metrics::Histogram                                  *Latency = nullptr;
+	        };
+
+	        struct Node {
+	            std::map<std::string,std::size_t,std::less<>>       Literals;
+	            std::size_t                                         Parameter = 0;
+	            Leaf                                                Handler;
+	        };
+
+	        std::vector<Node>   Nodes_ = std::vector<Node>(1);
+
+	        template <typename T> static RESTAPIHandler * Create(RESTAPIHandler::BindingMap &Bindings, Poco::Logger & Logger,
+	                                                             RESTAPI_GenericServer & Server, uint64_t TransactionId, bool Internal) {
+	            return new T(Bindings, Logger, Server, TransactionId, Internal);
+	        }
+
+	        template <typename T> inline void AddHandler(std::size_t Priority) {
+	            static_assert(test_has_PathName_method((T*)nullptr), "Class must have a static PathName() method.");
+	            for(const auto &Pattern:T::PathName())
+	                Add(Pattern, &Create<T>, Priority);
+	        }
+
+	        //	same segmentation as Utils::Split: a leading '/' gives an empty first segment, a trailing one is dropped
+	        static inline bool Split(std::string_view Path, Segments &Result, std::size_t &Count) {
+	            std::size_t P=0;
+	            Count=0;
+	            while(P<Path.size()) {
+	                if(Count==MaxSegments)
+	                    return false;
+	                auto P2 = Path.find('/',P);
+	                if(P2==std::string_view::npos) {
+	                    Result[Count++] = Path.substr(P);
+	                    break;
 	                }
+	                Result[Count++] = Path.substr(P,P2-P);
+	                P=P2+1;
+	            }
+	            return true;
+	        }
 
-	                if constexpr (sizeof...(Args) == 0) {
-	                    return new RESTAPI_UnknownRequestHandler(Bindings,Logger, Server, TransactionId, false);
+	        inline void Add(const std::string &Pattern, HandlerFactory Factory, std::size_t Priority) {
+	            Segments    Items;
+	            std::size_t Count=0;
+	            if(!Split(Pattern,Items,Count))
+	                return;
+	            Leaf    L{.Factory=Factory, .Priority=Priority, .RouteId=std::hash<std::string>{}(Pattern),
+	                      .Limit=RESTAPI_RateLimiter()->RouteProfile(Pattern),
+	                      .Latency=&Metrics::GetHistogram("owgw_rest_request_duration_seconds",
+	                                                      "Time spent handling REST API requests, by endpoint.", {{"endpoint",Pattern}})};
+	            std::size_t Current=0;
+	            for(std::size_t i=0;i<Count;i++) {
+	                std::size_t Next;
+	                if(!Items[i].empty() && Items[i][0]=='{') {
+	                    L.Slots.emplace_back(i,Poco::toLower(std::string(Items[i].substr(1,Items[i].size()-2))));
+	                    if(Nodes_[Current].Parameter==0) {
+	                        Nodes_[Current].Parameter = Nodes_.size();
+	                        Nodes_.emplace_back();
+	                    }
+	                    Next = Nodes_[Current].Parameter;
 	                } else {
-	                    return RESTAPI_Router<Args...>(RequestedPath, Bindings, Logger, Server, TransactionId);
+	                    auto Hint = Nodes_[Current].Literals.find(Items[i]);
+	                    if(Hint==Nodes_[Current].Literals.end()) {
+	                        Next = Nodes_.size();
+	                        Nodes_[Current].Literals.emplace(std::string(Items[i]),Next);
+	                        Nodes_.emplace_back();
+	                    } else {
+	                        Next = Hint->second;
+	                    }
 	                }
+	                Current = Next;
+	            }
+	            auto &Handler = Nodes_[Current].Handler;
+	            if(Handler.Factory==nullptr || Priority<Handler.Priority)
+	                Handler = std::move(L);
+	        }
+
+	        inline void Walk(std::size_t Current, const Segments &Path, std::size_t Count, std::size_t Depth, const Leaf *&Best) const {
+	            const auto &N = Nodes_[Current];
+	            if(Depth==Count) {
+	                if(N.Handler.Factory!= nullptr && (Best== nullptr || N.Handler.Priority<Best->Priority))
+	                    Best = &N.Handler;
+	                return;
+	            }
+	            auto Hint = N.Literals.find(Path[Depth]);
+	            if(Hint!=N.Literals.end())
+	                Walk(Hint->second, Path, Count, Depth+1, Best);
+	            if(N.Parameter!=0)
+	                Walk(N.Parameter, Path, Count, Depth+1, Best);
+	        }
+	    };
+
+	            template<typename T, typename... Args>
+	            RESTAPIHandler * RESTAPI_Router(const std::string & RequestedPath, RESTAPIHandler::BindingMap &Bindings,
+											   Poco::Logger & Logger, RESTAPI_GenericServer & Server, uint64_t TransactionId) {
+	                static const auto Routes = RESTAPI_RouteTrie::Build<T,Args...>();
+	                return Routes.Route(RequestedPath, Bindings, Logger, Server, TransactionId, false);
 	            }
 
 	            template<typename T, typename... Args>
 	            RESTAPIHandler * RESTAPI_Router_I(const std::string & RequestedPath, RESTAPIHandler::BindingMap &Bindings,
 												 Poco::Logger & Logger, RESTAPI_GenericServer & Server, uint64_t TransactionId) {
-	                static_assert(test_has_PathName_method((T*)nullptr), "Class must have a static PathName() method.");
-	                if(RESTAPIHandler::ParseBindings(RequestedPath,T::PathName(),Bindings)) {
-	                    return new T(Bindings, Logger, Server, TransactionId, true );
-	                }
-
-	                if constexpr (sizeof...(Args) == 0) {
-	                    return new RESTAPI_UnknownRequestHandler(Bindings,Logger, Server, TransactionId, true);
-	                } else {
-	                    return RESTAPI_Router_I<Args...>(RequestedPath, Bindings, Logger, Server, TransactionId);
-	                }
+	                static const auto Routes = RESTAPI_RouteTrie::Build<T,Args...>();
+	                return Routes.Route(RequestedPath, Bindings, Logger, Server, TransactionId, true);
 	            }
 
 	class OpenAPIRequestGet {
@@ -2580,6 +2956,8 @@ namespace OpenWifi {
 			Queue_.enqueueNotification( new KafkaMessage(Topic,Key,Payload));
 		}
 
+		[[nodiscard]] inline uint64_t Queued() { return Queue_.size(); }
+
     private:
         std::recursive_mutex  	Mutex_;
         Poco::Thread        	Worker_;
@@ -2587,6 +2965,83 @@ namespace OpenWifi {
 		Poco::NotificationQueue	Queue_;
     };
 
+	//	Offsets the consumer has handed to the dispatcher, per (topic, partition). Workers finish messages out of order
+	//	across keys, so only the offsets below the oldest message still in flight may be committed.
+	class KafkaOffsetTracker {
+	  public:
+		typedef std::pair<std::string,int>	TopicPartition;
+
+		inline void Dispatched(const TopicPartition &TP, int64_t Offset) {
+			std::lock_guard	G(Mutex_);
+			//	a new partition starts where the last commit left it: nothing before its first offset is ours to commit
+			auto [It,New] = Partitions_.try_emplace(TP);
+			auto &P = It->second;
+			if(New)
+				P.Committed = Offset - 1;
+			P.InFlight.insert(Offset);
+			P.Highest = std::max(P.Highest, Offset);
+			InFlight_++;
+		}
+
+		//	called by the worker once the topic callbacks have run, or right away when nobody watches the topic
+		inline void Processed(const TopicPartition &TP, int64_t Offset) {
+			std::lock_guard	G(Mutex_);
+			auto It = Partitions_.find(TP);
+			//	the partition was revoked while the message was queued: its offsets belong to another consumer now
+			if(It==Partitions_.end() || It->second.InFlight.erase(Offset)==0)
+				return;
+			if(--InFlight_==0)
+				Idle_.notify_all();
+		}
+
+		//	next offset to read for every partition that made progress since its last commit
+		inline void Committable(std::map<TopicPartition,int64_t> &Offsets) {
+			std::lock_guard	G(Mutex_);
+			Offsets.clear();
+			for(const auto &[TP,P]:Partitions_) {
+				auto Done = P.InFlight.empty() ? P.Highest : *P.InFlight.begin() - 1;
+				if(Done > P.Committed)
+					Offsets[TP] = Done + 1;
+			}
+		}
+
+		inline void Committed(const std::map<TopicPartition,int64_t> &Offsets) {
+			std::lock_guard	G(Mutex_);
+			for(const auto &[TP,Next]:Offsets) {
+				auto It = Partitions_.find(TP);
+				if(It!=Partitions_.end())
+					It->second.Committed = std::max(It->second.Committed, Next - 1);
+			}
+		}
+
+		inline bool WaitIdle(std::chrono::milliseconds Timeout) {
+			std::unique_lock	G(Mutex_);
+			return Idle_.wait_for(G, Timeout, [this]{ return InFlight_==0; });
+		}
+
+		inline void Forget(const TopicPartition &TP) {
+			std::lock_guard	G(Mutex_);
+			auto It = Partitions_.find(TP);
+			if(It==Partitions_.end())
+				return;
+			InFlight_ -= It->second.InFlight.size();
+			Partitions_.erase(It);
+			if(InFlight_==0)
+				Idle_.notify_all();
+		}
+
+	  private:
+		struct Partition {
+			std::set<int64_t>	InFlight;
+			int64_t 			Highest = -1;
+			int64_t 			Committed = -1;
+		};
+		std::mutex 								Mutex_;
+		std::condition_variable 				Idle_;
+		std::map<TopicPartition,Partition>		Partitions_;
+		uint64_t 								InFlight_ = 0;
+	};
+
     class KafkaConsumer : public Poco::Runnable {
     public:
         inline void run() override;
@@ -2606,27 +3061,149 @@ namespace OpenWifi {
             }
         }
 
+		inline void GetStats(Poco::JSON::Object &Obj) {
+			Obj.set("messages", Messages_.load());
+			Obj.set("commits", Commits_.load());
+			Obj.set("commitErrors", CommitErrors_.load());
+			Poco::JSON::Array	Partitions;
+			std::lock_guard	G(Mutex_);
+			for(const auto &[TP,Lag]:Lag_) {
+				Poco::JSON::Object	O;
+				O.set("topic", TP.first);
+				O.set("partition", TP.second);
+				O.set("lag", Lag);
+				Partitions.add(O);
+			}
+			Obj.set("partitions", Partitions);
+		}
+
 	  private:
 		std::recursive_mutex  	Mutex_;
         Poco::Thread        	Worker_;
         std::atomic_bool    	Running_=false;
+		std::atomic_uint64_t 	Messages_=0;
+		std::atomic_uint64_t 	Commits_=0;
+		std::atomic_uint64_t 	CommitErrors_=0;
+		std::map<std::pair<std::string,int>,int64_t>	Lag_;
+		KafkaOffsetTracker 		Offsets_;			//	outlives run(): workers still acknowledge after it returns
     };
 
-	class KafkaDispatcher : public Poco::Runnable {
+	//	Runs topic callbacks on a pool of workers. Messages are hashed on (topic, key) so messages sharing a key
+	//	are always delivered in order by the same worker, while unrelated traffic is processed in parallel.
+	class KafkaDispatcher {
 	  public:
 
-		inline void Start() {
+		struct DispatchEntry {
+			std::string 	Topic;
+			std::string 	Key;
+			std::string 	Payload;
+			uint64_t 		Queued = 0;
+			KafkaOffsetTracker	*Offsets = nullptr;		//	told once the callbacks have run
+			int 			Partition = -1;
+			int64_t 		Offset = -1;
+		};
+
+		class Worker : public Poco::Runnable {
+		  public:
+			explicit Worker(KafkaDispatcher &Dispatcher, uint64_t MaxQueueSize) :
+				Dispatcher_(Dispatcher), MaxQueueSize_(MaxQueueSize) {}
+
+			inline void Start() {
+				Running_ = true;
+				Thr_.start(*this);
+			}
+
+			inline void Stop() {
+				{
+					std::lock_guard G(Mutex_);
+					Running_ = false;
+				}
+				NotEmpty_.notify_all();
+				NotFull_.notify_all();
+				Thr_.join();
+			}
+
+			//	blocks the consumer when the worker falls too far behind, rather than dropping messages
+			inline void Enqueue(DispatchEntry && E) {
+				std::unique_lock G(Mutex_);
+				NotFull_.wait(G, [this]{ return Queue_.size() < MaxQueueSize_ || !Running_; });
+				if(!Running_)
+					return;
+				Queue_.push_back(std::move(E));
+				MaxDepth_ = std::max(MaxDepth_, (uint64_t) Queue_.size());
+				G.unlock();
+				NotEmpty_.notify_one();
+			}
+
+			inline void run() override {
+				Thr_.setName("kafka-dispatch");
+				while(true) {
+					DispatchEntry	E;
+					{
+						std::unique_lock G(Mutex_);
+						NotEmpty_.wait(G, [this]{ return !Queue_.empty() || !Running_; });
+						//	on Stop, deliver what is already queued: its offsets may be committed
+						if(Queue_.empty())
+							break;
+						E = std::move(Queue_.front());
+						Queue_.pop_front();
+					}
+					NotFull_.notify_one();
+					auto Lag = OpenWifi::Now() - E.Queued;
+					MaxLag_ = std::max(MaxLag_.load(), Lag);
+					Dispatcher_.Deliver(E);
+					if(E.Offsets)
+						E.Offsets->Processed(std::make_pair(E.Topic, E.Partition), E.Offset);
+					Processed_++;
+				}
+			}
+
+			[[nodiscard]] inline uint64_t Queued() {
+				std::lock_guard G(Mutex_);
+				return Queue_.size();
+			}
+
+			inline void GetStats(Poco::JSON::Object &Obj) {
+				std::lock_guard G(Mutex_);
+				Obj.set("queued", (uint64_t) Queue_.size());
+				Obj.set("maxQueued", MaxDepth_);
+				Obj.set("processed", Processed_.load());
+				Obj.set("lag", Queue_.empty() ? (uint64_t) 0 : OpenWifi::Now() - Queue_.front().Queued);
+				Obj.set("maxLag", MaxLag_.load());
+			}
+
+		  private:
+			KafkaDispatcher 			&Dispatcher_;
+			uint64_t 					MaxQueueSize_;
+			std::mutex 					Mutex_;
+			std::condition_variable 	NotEmpty_, NotFull_;
+			std::deque<DispatchEntry>	Queue_;
+			Poco::Thread 				Thr_;
+			bool 						Running_ = false;
+			uint64_t 					MaxDepth_ = 0;
+			std::atomic_uint64_t 		Processed_ = 0;
+			std::atomic_uint64_t 		MaxLag_ = 0;
+		};
+
+		inline void Start(uint64_t NumWorkers, uint64_t MaxQueueSize) {
+			std::unique_lock G(WorkersMutex_);
 			if(!Running_) {
 				Running_=true;
-				Worker_.start(*this);
+				NumWorkers = std::max((uint64_t)1, NumWorkers);
+				for(uint64_t i=0;i<NumWorkers;++i) {
+					Workers_.push_back(std::make_unique<Worker>(*this, std::max((uint64_t)1, MaxQueueSize)));
+					Workers_.back()->Start();
+				}
 			}
 		}
 
 		inline void Stop() {
+			std::unique_lock G(WorkersMutex_);
 			if(Running_) {
 				Running_=false;
-				Queue_.wakeUpAll();
-				Worker_.join();
+				for(auto &W:Workers_)
+					W->Stop();
+				Workers_.clear();
 			}
 		}
 
@@ -2656,44 +3233,74 @@ namespace OpenWifi {
 			}
 		}
 
-		void Dispatch(const std::string &Topic, const std::string &Key, const std::string &Payload) {
-			std::lock_guard	G(Mutex_);
-			auto It = Notifiers_.find(Topic);
-			if(It!=Notifiers_.end()) {
-				Queue_.enqueueNotification(new KafkaMessage(Topic, Key, Payload));
+		//	When Offsets is given, the message's offset is acknowledged to it once handled. A message refused because
+		//	the dispatcher is stopping is never acknowledged, so it is not committed and will be read again.
+		void Dispatch(const std::string &Topic, const std::string &Key, const std::string &Payload,
+					  KafkaOffsetTracker *Offsets = nullptr, int Partition = -1, int64_t Offset = -1) {
+			{
+				std::lock_guard	G(Mutex_);
+				if(Notifiers_.find(Topic)==Notifiers_.end()) {
+					if(Offsets)
+						Offsets->Processed(std::make_pair(Topic, Partition), Offset);
+					return;
+				}
 			}
+			//	Enqueue may wait for room: Stop waits for it, the worker never needs this lock to make room
+			std::shared_lock	G(WorkersMutex_);
+			if(Workers_.empty())
+				return;
+			auto Hash = std::hash<std::string>{}(Topic) * 31 + std::hash<std::string>{}(Key);
+			Workers_[Hash % Workers_.size()]->Enqueue(DispatchEntry{ .Topic=Topic, .Key=Key, .Payload=Payload, .Queued=OpenWifi::Now(),
+																	 .Offsets=Offsets, .Partition=Partition, .Offset=Offset });
 		}
 
-		inline void run() override {
-			Poco::AutoPtr<Poco::Notification>	Note(Queue_.waitDequeueNotification());
-			while(Note && Running_) {
-				auto Msg = dynamic_cast<KafkaMessage*>(Note.get());
-				if(Msg!= nullptr) {
-					auto It = Notifiers_.find(Msg->Topic());
-					if (It != Notifiers_.end()) {
-						const auto & FL = It->second;
-						for(const auto &[CallbackFunc,_]:FL) {
-							CallbackFunc(Msg->Key(), Msg->Payload());
-						}
-					}
-				}
-				Note = Queue_.waitDequeueNotification();
+		inline void Deliver(const DispatchEntry &E) {
+			Types::TopicNotifyFunctionList	FL;
+			{
+				std::lock_guard G(Mutex_);
+				auto It = Notifiers_.find(E.Topic);
+				if (It == Notifiers_.end())
+					return;
+				FL = It->second;
+			}
+			for(const auto &[CallbackFunc,_]:FL) {
+				CallbackFunc(E.Key, E.Payload);
 			}
 		}
 
 		inline void Topics(std::vector<std::string> &T) {
+			std::lock_guard G(Mutex_);
 			T.clear();
  			for(const auto &[TopicName,_]:Notifiers_)
 				T.push_back(TopicName);
 		}
 
+		[[nodiscard]] inline uint64_t Queued() {
+			std::shared_lock	G(WorkersMutex_);
+			uint64_t Total = 0;
+			for(auto &W:Workers_)
+				Total += W->Queued();
+			return Total;
+		}
+
+		inline void GetStats(Poco::JSON::Object &Obj) {
+			std::shared_lock	G(WorkersMutex_);
+			Poco::JSON::Array	Arr;
+			for(auto &W:Workers_) {
+				Poco::JSON::Object	O;
+				W->GetStats(O);
+				Arr.add(O);
+			}
+			Obj.set("workers", Arr);
+		}
+
 	  private:
 		std::recursive_mutex  	Mutex_;
 		Types::NotifyTable      Notifiers_;
-		Poco::Thread        	Worker_;
 		std::atomic_bool    	Running_=false;
 		uint64_t          		FunctionId_=1;
-		Poco::NotificationQueue	Queue_;
+		std::shared_mutex 		WorkersMutex_;		//	Workers_ changes in Start and Stop only
+		std::vector<std::unique_ptr<Worker>>	Workers_;
 	};
 
 	class KafkaManager : public SubSystemServer {
@@ -2714,15 +3321,20 @@ namespace OpenWifi {
 	            return 0;
 	        ConsumerThr_.Start();
 	        ProducerThr_.Start();
-			Dispatcher_.Start();
+			Dispatcher_.Start(DispatcherWorkers_, DispatcherQueueSize_);
+			Metrics::Registry()->AddGauge("owgw_kafka_queued_messages", "Messages waiting in the Kafka queues.",
+										  {{"queue","producer"}}, [this]() { return (double) ProducerThr_.Queued(); });
+			Metrics::Registry()->AddGauge("owgw_kafka_queued_messages", "Messages waiting in the Kafka queues.",
+										  {{"queue","dispatcher"}}, [this]() { return (double) Dispatcher_.Queued(); });
 	        return 0;
 	    }
 
 	    inline void Stop() override {
 	        if(KafkaEnabled_) {
+	            //  stop the consumer first so nothing is dispatched to workers that are going away
+	            ConsumerThr_.Stop();
 				Dispatcher_.Stop();
 	            ProducerThr_.Stop();
-	            ConsumerThr_.Stop();
 	            return;
 	        }
 	    }
@@ -2733,8 +3345,9 @@ namespace OpenWifi {
 	        }
 	    }
 
-		inline void Dispatch(const std::string &Topic, const std::string & Key, const std::string &Payload) {
-			Dispatcher_.Dispatch(Topic, Key, Payload);
+		inline void Dispatch(const std::string &Topic, const std::string & Key, const std::string &Payload,
+							 KafkaOffsetTracker *Offsets = nullptr, int Partition = -1, int64_t Offset = -1) {
+			Dispatcher_.Dispatch(Topic, Key, Payload, Offsets, Partition, Offset);
 		}
 
 	    [[nodiscard]] inline std::string WrapSystemId(const std::string & PayLoad) {
@@ -2761,8 +3374,21 @@ namespace OpenWifi {
 			Dispatcher_.Topics(T);
 		}
 
+		inline void GetStats(Poco::JSON::Object &Obj) {
+			if(KafkaEnabled_) {
+				Poco::JSON::Object	Dispatcher;
+				Dispatcher_.GetStats(Dispatcher);
+				Obj.set("dispatcher", Dispatcher);
+				Poco::JSON::Object	Consumer;
+				ConsumerThr_.GetStats(Consumer);
+				Obj.set("consumer", Consumer);
+			}
+		}
+
 	private:
 	    bool 							KafkaEnabled_ = false;
+	    uint64_t 						DispatcherWorkers_ = 4;
+	    uint64_t 						DispatcherQueueSize_ = 1024;
 	    std::string 					SystemInfoWrapper_;
 	    KafkaProducer                   ProducerThr_;
 	    KafkaConsumer                   ConsumerThr_;
@@ -2788,6 +3414,7 @@ namespace OpenWifi {
 	    explicit AuthClient() noexcept:
 	    SubSystemServer("Authentication", "AUTH-CLNT", "authentication")
 	    {
+	        CreateShards();
 	    }
 
 	    static auto instance() {
@@ -2795,18 +3422,36 @@ namespace OpenWifi {
 	        return instance_;
 	    }
 
-	    inline int Start() override {
-	        return 0;
-	    }
+	    struct TokenCacheEntry {
+	        std::string                                 Token;
+	        bool                                        Sub = false;
+	        bool                                        Valid = false;
+	        bool                                        Expired = false;
+	        uint64_t                                    Expires = 0;
+	        SecurityObjects::UserInfoAndPolicy          UInfo;
+	    };
+
+	    struct TokenValidation {
+	        bool                                        Authorized = false;
+	        bool                                        Expired = false;
+	        bool                                        Contacted = false;
+	        SecurityObjects::UserInfoAndPolicy          UInfo;
+	    };
+
+	    typedef Poco::LRUCache<uint64_t,TokenCacheEntry>    TokenCacheShard;
+
+	    inline int Start() override;
 
 	    inline void Stop() override {
-            std::lock_guard	G(Mutex_);
-	        Cache_.clear();
+	        for(auto &Shard:Shards_)
+	            Shard->clear();
 	    }
 
 	    inline void RemovedCachedToken(const std::string &Token) {
-	        std::lock_guard	G(Mutex_);
-	        Cache_.remove(Token);
+	        for(const auto Sub:{false,true}) {
+	            auto Hash = TokenHash(Token,Sub);
+	            ShardFor(Hash).remove(Hash);
+	        }
 	    }
 
 	    inline static bool IsTokenExpired(const SecurityObjects::WebToken &T) {
@@ -2825,28 +3470,37 @@ namespace OpenWifi {
                                              10000);
 	            Poco::JSON::Object::Ptr Response;
 
+                RemoteCalls_++;
                 auto StatusCode = Req.Do(Response);
-                if(StatusCode==Poco::Net::HTTPServerResponse::HTTP_GATEWAY_TIMEOUT) {
+                //  the security service failed or could not be reached: nothing is learnt about the token
+                if(StatusCode>=Poco::Net::HTTPServerResponse::HTTP_INTERNAL_SERVER_ERROR) {
                     Contacted = false;
                     return false;
                 }
 
                 Contacted = true;
+	            Expired = false;
 	            if(StatusCode==Poco::Net::HTTPServerResponse::HTTP_OK) {
 	                if(Response->has("tokenInfo") && Response->has("userInfo")) {
 	                    UInfo.from_json(Response);
 	                    if(IsTokenExpired(UInfo.webtoken)) {
 	                        Expired = true;
+	                        CacheNegative(SessionToken, Sub, true);
 	                        return false;
 	                    }
-	                    Expired = false;
-                        std::lock_guard	G(Mutex_);
-	                    Cache_.update(SessionToken, UInfo);
+	                    CachePositive(SessionToken, Sub, UInfo);
 	                    return true;
-	                } else {
-                        return false;
-                    }
+	                }
+	                if(!Response->has("tokenInfo"))
+	                    CacheNegative(SessionToken, Sub, false);
+	                return false;
 	            }
+	            //  only an explicit rejection is remembered, other answers are asked again next time
+	            if( StatusCode==Poco::Net::HTTPServerResponse::HTTP_UNAUTHORIZED ||
+	                StatusCode==Poco::Net::HTTPServerResponse::HTTP_FORBIDDEN ||
+	                StatusCode==Poco::Net::HTTPServerResponse::HTTP_NOT_FOUND)
+	                CacheNegative(SessionToken, Sub, false);
+	            return false;
 	        } catch (...) {
 	        }
 	        Expired = false;
@@ -2855,22 +3509,103 @@ namespace OpenWifi {
 
         inline bool IsAuthorized(const std::string &SessionToken, SecurityObjects::UserInfoAndPolicy & UInfo,
 								 bool & Expired, bool & Contacted, bool Sub = false) {
-            std::lock_guard	G(Mutex_);
-	        auto User = Cache_.get(SessionToken);
-	        if(!User.isNull()) {
-	            if(IsTokenExpired(User->webtoken)) {
+	        auto Hash = TokenHash(SessionToken,Sub);
+	        auto Entry = ShardFor(Hash).get(Hash);
+	        if(!Entry.isNull() && Entry->Token==SessionToken && Entry->Sub==Sub && Entry->Expires>=OpenWifi::Now()) {
+	            if(!Entry->Valid) {
+	                NegativeHits_++;
+	                Expired = Entry->Expired;
+	                Contacted = true;
+	                return false;
+	            }
+	            if(IsTokenExpired(Entry->UInfo.webtoken)) {
+	                ShardFor(Hash).remove(Hash);
 	                Expired = true;
 	                return false;
 	            }
+	            Hits_++;
 	            Expired = false;
-                UInfo = *User;
+                UInfo = Entry->UInfo;
                 return true;
 	        }
-	        return RetrieveTokenInformation(SessionToken, UInfo, Expired, Contacted, Sub);
+
+	        //  Only one request per token goes to the security service, concurrent callers wait for its answer.
+	        Misses_++;
+	        std::promise<TokenValidation>       Promise;
+	        std::shared_future<TokenValidation> Result;
+	        bool Owner = false;
+	        {
+	            std::lock_guard G(InFlightMutex_);
+	            auto Hint = InFlight_.find(std::make_pair(SessionToken,Sub));
+	            if(Hint==InFlight_.end()) {
+	                Result = Promise.get_future().share();
+	                InFlight_[std::make_pair(SessionToken,Sub)] = Result;
+	                Owner = true;
+	            } else {
+	                Result = Hint->second;
+	                Coalesced_++;
+	            }
+	        }
+
+	        if(Owner) {
+	            TokenValidation V;
+	            V.Authorized = RetrieveTokenInformation(SessionToken, V.UInfo, V.Expired, V.Contacted, Sub);
+	            Promise.set_value(V);
+	            std::lock_guard G(InFlightMutex_);
+	            InFlight_.erase(std::make_pair(SessionToken,Sub));
+	        }
+
+	        const auto &V = Result.get();
+	        Expired = V.Expired;
+	        Contacted = V.Contacted;
+	        if(V.Authorized)
+	            UInfo = V.UInfo;
+	        return V.Authorized;
+	    }
+
+	    inline void GetCacheStats(Poco::JSON::Object &Obj) const {
+	        Obj.set("shards", (uint64_t) Shards_.size());
+	        Obj.set("hits", Hits_.load());
+	        Obj.set("negativeHits", NegativeHits_.load());
+	        Obj.set("misses", Misses_.load());
+	        Obj.set("coalesced", Coalesced_.load());
+	        Obj.set("remoteCalls", RemoteCalls_.load());
 	    }
 
 	private:
-	    Poco::ExpireLRUCache<std::string,OpenWifi::SecurityObjects::UserInfoAndPolicy>      Cache_{512,1200000 };
+	    std::vector<std::unique_ptr<TokenCacheShard>>   Shards_;
+	    uint64_t                                        CacheSize_ = 4096;
+	    uint64_t                                        NumShards_ = 16;
+	    uint64_t                                        PositiveTTL_ = 1200;
+	    uint64_t                                        NegativeTTL_ = 30;
+	    std::mutex                                      InFlightMutex_;
+	    std::map<std::pair<std::string,bool>,std::shared_future<TokenValidation>>    InFlight_;
+	    std::atomic_uint64_t                            Hits_ = 0, NegativeHits_ = 0, Misses_ = 0, Coalesced_ = 0, RemoteCalls_ = 0;
+
+	    inline void CreateShards() {
+	        Shards_.clear();
+	        for(uint64_t i=0;i<NumShards_;i++)
+	            Shards_.push_back(std::make_unique<TokenCacheShard>(std::max((uint64_t)16, CacheSize_/NumShards_)));
+	    }
+
+	    inline static uint64_t TokenHash(const std::string &Token, bool Sub) {
+	        return std::hash<std::string>{}(Token) ^ (Sub ? 0x9e3779b97f4a7c15ULL : 0);
+	    }
+
+	    inline TokenCacheShard & ShardFor(uint64_t Hash) {
+	        return *Shards_[Hash % Shards_.size()];
+	    }
+
+	    inline void CachePositive(const std::string &Token, bool Sub, const SecurityObjects::UserInfoAndPolicy &UInfo) {
+	        auto Hash = TokenHash(Token,Sub);
+	        auto Expires = std::min(OpenWifi::Now() + PositiveTTL_, (uint64_t)(UInfo.webtoken.created_ + UInfo.webtoken.expires_in_));
+	        ShardFor(Hash).update(Hash, TokenCacheEntry{ .Token = Token, .Sub = Sub, .Valid = true, .Expired = false, .Expires = Expires, .UInfo = UInfo });
+	    }
+
+	    inline void CacheNegative(const std::string &Token, bool Sub, bool Expired) {
+	        auto Hash = TokenHash(Token,Sub);
+	        ShardFor(Hash).update(Hash, TokenCacheEntry{ .Token = Token, .Sub = Sub, .Valid = false, .Expired = Expired, .Expires = OpenWifi::Now() + NegativeTTL_ });
+	    }
 	};
 
 	inline auto AuthClient() { return AuthClient::instance(); }
@@ -2884,26 +3619,7 @@ namespace OpenWifi {
 	            {
 	            }
 
-	            void handleRequest(Poco::Net::HTTPServerRequest& Request, Poco::Net::HTTPServerResponse& Response) override
-	            {
-					try {
-						if((id_ % 100) == 0) {
-							Logger_.debug(fmt::format("ALB-REQUEST({}): ALB Request {}.",
-															Request.clientAddress().toString(), id_));
-						}
-						Response.setChunkedTransferEncoding(true);
-						Response.setContentType("text/html");
-						Response.setDate(Poco::Timestamp());
-						Response.setStatus(Poco::Net::HTTPResponse::HTTP_OK);
-						Response.setKeepAlive(true);
-						Response.set("Connection", "keep-alive");
-						Response.setVersion(Poco::Net::HTTPMessage::HTTP_1_1);
-						std::ostream &Answer = Response.send();
-						Answer << "process Alive and kicking!";
-					} catch (...) {
-
-					}
-	            }
+	            inline void handleRequest(Poco::Net::HTTPServerRequest& Request, Poco::Net::HTTPServerResponse& Response) override;
 
 	        private:
 	            Poco::Logger 	& Logger_;
@@ -3236,6 +3952,8 @@ namespace OpenWifi {
 		inline void InitializeSubSystemServers();
 		inline void StartSubSystemServers();
 		inline void StopSubSystemServers();
+		inline void DrainSubSystemServers();
+		[[nodiscard]] inline bool Draining() const { return Draining_; }
 		[[nodiscard]] static inline std::string CreateUUID();
 		inline bool SetSubsystemLogLevel(const std::string &SubSystem, const std::string &Level);
 		inline void Reload(const std::string &Sub);
@@ -3314,6 +4032,7 @@ namespace OpenWifi {
         SubSystemVec			    SubSystems_;
         bool                        NoAPISecurity_=false;
         bool                        NoBuiltInCrypto_=false;
+        std::atomic_bool            Draining_=false;
         Poco::JWT::Signer	        Signer_;
 		Poco::Logger				&Logger_;
     };
@@ -3533,6 +4252,9 @@ namespace OpenWifi {
         InitializeLoggingSystem();
 
 	    SubSystems_.push_back(KafkaManager());
+#ifndef TIP_SECURITY_SERVICE
+	    SubSystems_.push_back(AuthClient());
+#endif
 	    SubSystems_.push_back(ALBHealthCheckServer());
 	    SubSystems_.push_back(RESTAPI_ExtServer());
 	    SubSystems_.push_back(RESTAPI_IntServer());
@@ -3659,6 +4381,14 @@ namespace OpenWifi {
 	    BusEventManager_.Start();
 	}
 
+	inline void MicroService::DrainSubSystemServers() {
+        AddActivity("Draining");
+        Draining_ = true;
+	    for(auto i=SubSystems_.rbegin(); i!=SubSystems_.rend(); ++i) {
+			(*i)->Drain();
+		}
+	}
+
 	inline void MicroService::StopSubSystemServers() {
         AddActivity("Stopping");
 	    BusEventManager_.Stop();
@@ -3944,6 +4674,7 @@ namespace OpenWifi {
 	        logger.information(fmt::format("System ID set to {}",ID_));
 	        StartSubSystemServers();
 	        waitForTerminationRequest();
+	        DrainSubSystemServers();
 	        StopSubSystemServers();
 	        logger.notice(fmt::format("Stopped {}...",DAEMON_APP_NAME));
 	    }
@@ -4023,6 +4754,28 @@ namespace OpenWifi {
 	    }
 	}
 
+	inline void ALBRequestHandler::handleRequest(Poco::Net::HTTPServerRequest& Request, Poco::Net::HTTPServerResponse& Response) {
+		try {
+			if((id_ % 100) == 0) {
+				Logger_.debug(fmt::format("ALB-REQUEST({}): ALB Request {}.",
+												Request.clientAddress().toString(), id_));
+			}
+			//	a draining service is alive but wants no new work
+			auto Draining = MicroService::instance().Draining();
+			Response.setChunkedTransferEncoding(true);
+			Response.setContentType("text/html");
+			Response.setDate(Poco::Timestamp());
+			Response.setStatus(Draining ? Poco::Net::HTTPResponse::HTTP_SERVICE_UNAVAILABLE : Poco::Net::HTTPResponse::HTTP_OK);
+			Response.setKeepAlive(true);
+			Response.set("Connection", "keep-alive");
+			Response.setVersion(Poco::Net::HTTPMessage::HTTP_1_1);
+			std::ostream &Answer = Response.send();
+			Answer << (Draining ? "process draining" : "process Alive and kicking!");
+		} catch (...) {
+
+		}
+	}
+
 	inline int ALBHealthCheckServer::Start() {
 	    if(MicroService::instance().ConfigGetBool("alb.enable",false)) {
 	        Running_=true;
@@ -4065,9 +4818,28 @@ namespace OpenWifi {
         }
     }
 
+    inline std::optional<RESTAPI_RateLimiter::Profile> RESTAPI_RateLimiter::RouteProfile(const std::string &Pattern) {
+	    std::call_once(ProfilesLoaded_,[this]() {
+	        for(auto i=0;;i++) {
+	            auto Root = fmt::format("openwifi.restapi.ratelimit.{}.",i);
+	            auto Path = MicroService::instance().ConfigGetString(Root + "path","");
+	            if(Path.empty())
+	                break;
+	            Profiles_[Path] = Profile{ .Interval = (int64_t)MicroService::instance().ConfigGetInt(Root + "interval",1000),
+	                                       .MaxCalls = (int64_t)MicroService::instance().ConfigGetInt(Root + "maxcalls",100)};
+	        }
+	    });
+	    auto Hint = Profiles_.find(Pattern);
+	    if(Hint==Profiles_.end())
+	        return std::nullopt;
+	    return Hint->second;
+	}
+
     inline void KafkaManager::initialize(Poco::Util::Application & self) {
 	    SubSystemServer::initialize(self);
 	    KafkaEnabled_ = MicroService::instance().ConfigGetBool("openwifi.kafka.enable",false);
+	    DispatcherWorkers_ = MicroService::instance().ConfigGetInt("openwifi.kafka.dispatcher.workers",4);
+	    DispatcherQueueSize_ = MicroService::instance().ConfigGetInt("openwifi.kafka.dispatcher.queue.size",1024);
 	}
 
 	inline void KafkaLoggerFun([[maybe_unused]] cppkafka::KafkaHandleBase & handle, int level, const std::string & facility, const std::string &message) {
@@ -4141,8 +4913,7 @@ namespace OpenWifi {
 		cppkafka::Producer	Producer(Config);
 	    Running_ = true;
 
-		Poco::AutoPtr<Poco::Notification>	Note(Queue_.waitDequeueNotification());
-		while(Note && Running_) {
+		auto Produce = [&Producer](const Poco::AutoPtr<Poco::Notification> &Note) {
             try {
                 auto Msg = dynamic_cast<KafkaMessage *>(Note.get());
                 if (Msg != nullptr) {
@@ -4156,8 +4927,26 @@ namespace OpenWifi {
             } catch (...) {
                 KafkaManager()->Logger().error("std::exception");
             }
+		};
+
+		Poco::AutoPtr<Poco::Notification>	Note(Queue_.waitDequeueNotification());
+		while(Note && Running_) {
+			Produce(Note);
 			Note = Queue_.waitDequeueNotification();
 		}
+
+		//	what was queued before the stop still goes out, and the producer's own buffer is flushed
+		if(!Note)
+			Note = Queue_.dequeueNotification();
+		while(Note) {
+			Produce(Note);
+			Note = Queue_.dequeueNotification();
+		}
+		try {
+			Producer.flush(std::chrono::milliseconds(MicroService::instance().ConfigGetInt("openwifi.kafka.flush.timeout", 10000)));
+		} catch (const cppkafka::Exception &E) {
+			KafkaManager()->Logger().warning(fmt::format("Kafka messages lost on shutdown: {}", E.what()));
+		}
 	}
 
 	inline void KafkaConsumer::run() {
@@ -4183,22 +4972,71 @@ namespace OpenWifi {
 	    Config.set_default_topic_configuration(topic_config);
 
 	    cppkafka::Consumer Consumer(Config);
+	    bool AutoCommit = MicroService::instance().ConfigGetBool("openwifi.kafka.auto.commit",false);
+	    auto BatchSize = MicroService::instance().ConfigGetInt("openwifi.kafka.consumer.batchsize",100);
+	    auto PollTimeout = MicroService::instance().ConfigGetInt("openwifi.kafka.consumer.poll.timeout",100);
+	    auto CommitEvery = MicroService::instance().ConfigGetInt("openwifi.kafka.consumer.commit.messages",500);
+	    auto CommitInterval = std::chrono::milliseconds(MicroService::instance().ConfigGetInt("openwifi.kafka.consumer.commit.interval",1000));
+
+	    //  how long a rebalance or shutdown waits for the workers before committing what they have finished
+	    auto DrainTimeout = std::chrono::milliseconds(MicroService::instance().ConfigGetInt("openwifi.kafka.consumer.drain.timeout",5000));
+
+	    uint64_t PendingMessages = 0;
+	    auto LastCommit = std::chrono::steady_clock::now();
+
+	    //  only offsets the workers have processed are committed: a crash replays queued messages instead of losing them
+	    auto CommitPending = [&](bool Synchronous) {
+	        LastCommit = std::chrono::steady_clock::now();
+	        PendingMessages = 0;
+	        if(AutoCommit)
+	            return;
+	        std::map<KafkaOffsetTracker::TopicPartition,int64_t>	Ready;
+	        Offsets_.Committable(Ready);
+	        if(Ready.empty())
+	            return;
+	        cppkafka::TopicPartitionList   Offsets;
+	        for(const auto &[TP,Next]:Ready)
+	            Offsets.emplace_back(TP.first, TP.second, Next);
+	        try {
+	            if(Synchronous)
+	                Consumer.commit(Offsets);
+	            else
+	                Consumer.async_commit(Offsets);
+	            Offsets_.Committed(Ready);
+	            Commits_++;
+	        } catch (const cppkafka::HandleException &E) {
+	            CommitErrors_++;
+	            KafkaManager()->Logger().warning(fmt::format("Offset commit failed: {}", E.what()));
+	        }
+	        std::lock_guard G(Mutex_);
+	        for(const auto &[TP,Next]:Ready) {
+	            try {
+	                auto [Low,High] = Consumer.get_offsets(cppkafka::TopicPartition(TP.first, TP.second));
+	                Lag_[TP] = std::max((int64_t)0, High - Next);
+	            } catch (...) {
+	            }
+	        }
+	    };
+
 	    Consumer.set_assignment_callback([](cppkafka::TopicPartitionList& partitions) {
 	        if(!partitions.empty()) {
 	            KafkaManager()->Logger().information(fmt::format("Partition assigned: {}...",
                                                  partitions.front().get_partition()));
 	        }
 	    });
-	    Consumer.set_revocation_callback([](const cppkafka::TopicPartitionList& partitions) {
+	    Consumer.set_revocation_callback([&](const cppkafka::TopicPartitionList& partitions) {
+	        //  commit what we have processed before the partitions move to another consumer
+	        if(!Offsets_.WaitIdle(DrainTimeout))
+	            KafkaManager()->Logger().warning("Partition revocation: some messages were not processed in time and will be read again.");
+	        CommitPending(true);
+	        for(const auto &P:partitions)
+	            Offsets_.Forget(std::make_pair(P.get_topic(), P.get_partition()));
 	        if(!partitions.empty()) {
 	            KafkaManager()->Logger().information(fmt::format("Partition revocation: {}...",
                                                  partitions.front().get_partition()));
 	        }
 	    });
 
-	    bool AutoCommit = MicroService::instance().ConfigGetBool("openwifi.kafka.auto.commit",false);
-	    auto BatchSize = MicroService::instance().ConfigGetInt("openwifi.kafka.consumer.batchsize",20);
-
 	    Types::StringVec    Topics;
 		KafkaManager()->Topics(Topics);
 	    Consumer.subscribe(Topics);
@@ -4206,22 +5044,24 @@ namespace OpenWifi {
 	    Running_ = true;
 	    while(Running_) {
 	        try {
-	            std::vector<cppkafka::Message> MsgVec = Consumer.poll_batch(BatchSize, std::chrono::milliseconds(100));
+	            std::vector<cppkafka::Message> MsgVec = Consumer.poll_batch(BatchSize, std::chrono::milliseconds(PollTimeout));
 	            for(auto const &Msg:MsgVec) {
 	                if (!Msg)
 	                    continue;
+	                //  errors and EOF markers carry no message to hand to a worker: they are not tracked or committed
 	                if (Msg.get_error()) {
 	                    if (!Msg.is_eof()) {
 	                        KafkaManager()->Logger().error(fmt::format("Error: {}", Msg.get_error().to_string()));
 	                    }
-                        if(!AutoCommit)
-	                        Consumer.async_commit(Msg);
 	                    continue;
 	                }
-					KafkaManager()->Dispatch(Msg.get_topic(), Msg.get_key(),Msg.get_payload() );
-	                if (!AutoCommit)
-	                    Consumer.async_commit(Msg);
+	                Offsets_.Dispatched(std::make_pair(Msg.get_topic(), Msg.get_partition()), Msg.get_offset());
+					KafkaManager()->Dispatch(Msg.get_topic(), Msg.get_key(),Msg.get_payload(), &Offsets_, Msg.get_partition(), Msg.get_offset());
+	                PendingMessages++;
+	                Messages_++;
 	            }
+	            if(PendingMessages >= CommitEvery || (std::chrono::steady_clock::now() - LastCommit) >= CommitInterval)
+	                CommitPending(false);
 	        } catch (const cppkafka::HandleException &E) {
 	            KafkaManager()->Logger().warning(fmt::format("Caught a Kafka exception (consumer): {}", E.what()));
 	        } catch (const Poco::Exception &E) {
@@ -4230,7 +5070,22 @@ namespace OpenWifi {
                 KafkaManager()->Logger().error("std::exception");
             }
 	    }
+	    //  the dispatcher is stopped after the consumer, so its workers are still finishing what was handed to them
+	    if(!Offsets_.WaitIdle(DrainTimeout))
+	        KafkaManager()->Logger().warning("Kafka consumer stopping: some messages were not processed in time and will be read again.");
+	    CommitPending(true);
 	    Consumer.unsubscribe();
+	    //  the callback refers to locals that are destroyed before the consumer
+	    Consumer.set_revocation_callback(nullptr);
+	}
+
+	inline int AuthClient::Start() {
+	    CacheSize_ = MicroService::instance().ConfigGetInt("authentication.cache.size",4096);
+	    NumShards_ = std::max((uint64_t)1,MicroService::instance().ConfigGetInt("authentication.cache.shards",16));
+	    PositiveTTL_ = MicroService::instance().ConfigGetInt("authentication.cache.ttl",1200);
+	    NegativeTTL_ = MicroService::instance().ConfigGetInt("authentication.cache.negative.ttl",30);
+	    CreateShards();
+	    return 0;
 	}
 
 	inline void RESTAPI_ExtServer::reinitialize([[maybe_unused]] Poco::Util::Application &self) {
@@ -4297,6 +5152,14 @@ namespace OpenWifi {
 	                }
 	            }
 	            Answer.set("certificates", Certificates);
+#ifndef TIP_SECURITY_SERVICE
+	            Poco::JSON::Object  TokenCache;
+	            AuthClient()->GetCacheStats(TokenCache);
+	            Answer.set("tokenCache", TokenCache);
+#endif
+	            Poco::JSON::Object  Kafka;
+	            KafkaManager()->GetStats(Kafka);
+	            Answer.set("kafka", Kafka);
 	            return ReturnObject(Answer);
 	        }
 	        BadRequest(RESTAPI::Errors::InvalidCommand);
@@ -4352,6 +5215,18 @@ namespace OpenWifi {
 	                    LevelNamesArray.add(i);
 	                Result.set(RESTAPI::Protocol::LIST, LevelNamesArray);
 	                return ReturnObject(Result);
+	            } else if (Command == RESTAPI::Protocol::DRAIN) {
+	                //	same as a SIGTERM: drain, then stop. Later, so this answer still goes out.
+	                if(!Internal_ && (UserInfo_.userinfo.userRole!=SecurityObjects::ROOT && UserInfo_.userinfo.userRole!=SecurityObjects::ADMIN)) {
+	                    return UnAuthorized(RESTAPI::Errors::ACCESS_DENIED);
+	                }
+	                Logger_.notice(fmt::format("Drain and shutdown requested by {}.", Internal_ ? "another service" : UserInfo_.userinfo.email));
+	                std::thread	DrainThread([](){
+	                    std::this_thread::sleep_for(1000ms);
+	                    Poco::Util::ServerApplication::terminate();
+	                });
+	                DrainThread.detach();
+	                return OK();
 	            } else if (Command == RESTAPI::Protocol::STATS) {
 
 	            } else if (Command == RESTAPI::Protocol::RELOAD) {
@@ -4752,6 +5627,25 @@ namespace OpenWifi {
         return false;
     }
 
+	//	Several items of the same notification type sent as one message.
+	template <typename T> struct WebSocketNotificationBatch {
+		std::vector<T>		items;
+
+		inline void to_json(Poco::JSON::Object &Obj) const {
+			RESTAPI_utils::field_to_json(Obj,"items",items);
+		}
+
+		inline bool from_json(const Poco::JSON::Object::Ptr &Obj) {
+			try {
+				RESTAPI_utils::field_from_json(Obj,"items",items);
+				return true;
+			} catch (...) {
+
+			}
+			return false;
+		}
+	};
+
     class WebSocketClientProcessor {
     public:
         virtual void Processor(const Poco::JSON::Object::Ptr &O, std::string &Answer, bool &Done ) = 0;
@@ -4772,6 +5666,25 @@ namespace OpenWifi {
 
     class WebSocketClient;
 
+	//	What a UI client wants to hear about. An empty set means "everything" for that dimension.
+	struct WebSocketClientSubscription {
+		bool					Subscribed=false;
+		std::set<std::string>	Types;
+		std::set<std::string>	SerialNumbers;
+		std::set<std::string>	Venues;
+
+		[[nodiscard]] inline bool Matches(const std::string &Type, const std::string &SerialNumber, const std::string &Venue) const {
+			if(!Subscribed)
+				return true;
+			if(!Types.empty() && Types.find(Type)==Types.end())
+				return false;
+			if(SerialNumbers.empty() && Venues.empty())
+				return true;
+			return	(!SerialNumber.empty() && SerialNumbers.find(SerialNumber)!=SerialNumbers.end()) ||
+					(!Venue.empty() && Venues.find(Venue)!=Venues.end());
+		}
+	};
+
     class WebSocketClientServer : public SubSystemServer, Poco::Runnable {
     public:
         static auto instance() {
@@ -4789,8 +5702,11 @@ namespace OpenWifi {
         void SetProcessor(WebSocketClientProcessor *F);
         void UnRegister(const std::string &Id);
         void SetUser(const std::string &Id, const std::string &UserId);
+		void SetSubscription(const std::string &Id, const WebSocketClientSubscription &S);
+		void ClearSubscription(const std::string &Id);
         [[nodiscard]] inline bool GeoCodeEnabled() const { return GeoCodeEnabled_; }
         [[nodiscard]] inline std::string GoogleApiKey() const { return GoogleApiKey_; }
+		[[nodiscard]] inline uint64_t SendTimeout() const { return SendTimeout_; }
         [[nodiscard]] bool Send(const std::string &Id, const std::string &Payload);
 
 		template <typename T> bool
@@ -4806,19 +5722,80 @@ namespace OpenWifi {
 			return SendToUser(userName,OO.str());
 		}
 
-		template <typename T> void SendNotification(const WebSocketNotification<T> &Notification) {
-			Poco::JSON::Object  Payload;
-			Notification.to_json(Payload);
-			Poco::JSON::Object  Msg;
-			Msg.set("notification",Payload);
-			std::ostringstream OO;
-			Msg.stringify(OO);
-			SendToAll(OO.str());
+		//	The payload is only built if at least one client wants it, and then only once for all of them.
+		template <typename T> void SendNotification(const WebSocketNotification<T> &Notification,
+													const std::string &SerialNumber="", const std::string &Venue="") {
+			if(NumClients_==0)
+				return;
+
+			std::lock_guard	G(Mutex_);
+			std::vector<ClientEntry *>	Targets;
+			for(auto &[Id,Entry]:Clients_) {
+				if(Entry.Filter.Matches(Notification.type, SerialNumber, Venue))
+					Targets.push_back(&Entry);
+			}
+			if(Targets.empty())
+				return;
+
+			Enqueue(Targets, MakePayload(Notification));
+		}
+
+		//	Keys[i] holds the serial number and venue of Items[i]. Clients without a serial or venue filter
+		//	share one payload, filtered clients get only their own items.
+		template <typename T> void SendNotificationBatch(const std::string &Type, const std::vector<T> &Items,
+														 const std::vector<std::pair<std::string,std::string>> &Keys) {
+			if(NumClients_==0 || Items.empty())
+				return;
+
+			std::lock_guard	G(Mutex_);
+			std::vector<ClientEntry *>	FullTargets;
+			for(auto &[Id,Entry]:Clients_) {
+				const auto &F = Entry.Filter;
+				if(F.Subscribed && !F.Types.empty() && F.Types.find(Type)==F.Types.end())
+					continue;
+				if(!F.Subscribed || (F.SerialNumbers.empty() && F.Venues.empty())) {
+					FullTargets.push_back(&Entry);
+					continue;
+				}
+				WebSocketNotification<WebSocketNotificationBatch<T>>	N;
+				N.type = Type;
+				for(std::size_t i=0;i<Items.size() && i<Keys.size();i++) {
+					if(F.Matches(Type,Keys[i].first,Keys[i].second))
+						N.content.items.push_back(Items[i]);
+				}
+				if(!N.content.items.empty())
+					Enqueue({&Entry}, MakePayload(N));
+			}
+
+			if(!FullTargets.empty()) {
+				WebSocketNotification<WebSocketNotificationBatch<T>>	N;
+				N.type = Type;
+				N.content.items = Items;
+				Enqueue(FullTargets, MakePayload(N));
+			}
 		}
 
 		[[nodiscard]] bool SendToUser(const std::string &userName, const std::string &Payload);
 		void SendToAll(const std::string &Payload);
     private:
+		//	Writes to a client's socket happen outside Mutex_, under the client's own lock. UnRegister takes that lock
+		//	once the client is out of Clients_, so a client is never written to while it is being destroyed.
+		struct ClientSender {
+			std::mutex 										Mutex;
+			bool 											Gone = false;
+		};
+
+		struct ClientEntry {
+			WebSocketClient 								*Client = nullptr;
+			std::shared_ptr<ClientSender>					Sender = std::make_shared<ClientSender>();
+			std::string 									UserName;
+			WebSocketClientSubscription						Filter;
+			std::deque<std::shared_ptr<const std::string>>	Queue;
+			uint64_t 										Dropped = 0;
+			uint64_t 										MessagesSent = 0;
+			uint64_t 										BytesSent = 0;
+		};
+
         std::atomic_bool Running_ = false;
         Poco::Thread Thr_;
         // std::unique_ptr<MyParallelSocketReactor> ReactorPool_;
@@ -4826,9 +5803,26 @@ namespace OpenWifi {
 		Poco::Thread								ReactorThread_;
         bool GeoCodeEnabled_ = false;
         std::string GoogleApiKey_;
-        std::map<std::string, std::pair<WebSocketClient *, std::string>> Clients_;
+        std::map<std::string, ClientEntry> Clients_;
+		std::atomic_uint64_t 						NumClients_ = 0;
+		uint64_t 									MaxQueueSize_ = 256;
+		uint64_t 									SendTimeout_ = 2;
+		uint64_t 									LastReport_ = 0;
         WebSocketClientProcessor *Processor_ = nullptr;
         WebSocketClientServer() noexcept;
+
+		template <typename T> static std::shared_ptr<const std::string> MakePayload(const WebSocketNotification<T> &Notification) {
+			Poco::JSON::Object  Payload;
+			Notification.to_json(Payload);
+			Poco::JSON::Object  Msg;
+			Msg.set("notification",Payload);
+			std::ostringstream OO;
+			Msg.stringify(OO);
+			return std::make_shared<const std::string>(OO.str());
+		}
+
+		void Enqueue(const std::vector<ClientEntry *> &Targets, const std::shared_ptr<const std::string> &Payload);
+		void FlushQueues();
     };
 
     inline auto WebSocketClientServer() { return WebSocketClientServer::instance(); }
@@ -4841,6 +5835,7 @@ namespace OpenWifi {
         [[nodiscard]] inline const std::string &Id();
         [[nodiscard]] Poco::Logger &Logger();
         inline bool Send(const std::string &Payload);
+        [[nodiscard]] inline bool CanSend();
     private:
         std::unique_ptr<Poco::Net::WebSocket> WS_;
         Poco::Net::SocketReactor &Reactor_;
@@ -4849,6 +5844,7 @@ namespace OpenWifi {
         bool Authenticated_ = false;
         SecurityObjects::UserInfoAndPolicy UserInfo_;
         WebSocketClientProcessor *Processor_ = nullptr;
+        bool ProcessSubscription(const Poco::JSON::Object::Ptr &O, std::string &Answer);
         void OnSocketReadable(const Poco::AutoPtr<Poco::Net::ReadableNotification> &pNf);
         void OnSocketShutdown(const Poco::AutoPtr<Poco::Net::ShutdownNotification> &pNf);
         void OnSocketError(const Poco::AutoPtr<Poco::Net::ErrorNotification> &pNf);
@@ -4881,12 +5877,14 @@ namespace OpenWifi {
     inline void WebSocketClientServer::NewClient(Poco::Net::WebSocket & WS, const std::string &Id) {
         std::lock_guard G(Mutex_);
         auto Client = new WebSocketClient(WS,Id,Logger(), Processor_);
-        Clients_[Id] = std::make_pair(Client,"");
+        Clients_[Id] = ClientEntry{ .Client = Client };
+        NumClients_ = Clients_.size();
     }
 
     inline bool WebSocketClientServer::Register( WebSocketClient * Client, const std::string &Id) {
         std::lock_guard G(Mutex_);
-        Clients_[Id] = std::make_pair(Client,"");
+        Clients_[Id] = ClientEntry{ .Client = Client };
+        NumClients_ = Clients_.size();
         return true;
     }
 
@@ -4895,8 +5893,19 @@ namespace OpenWifi {
     }
 
     inline void WebSocketClientServer::UnRegister(const std::string &Id) {
-        std::lock_guard G(Mutex_);
-        Clients_.erase(Id);
+        std::shared_ptr<ClientSender>   Sender;
+        {
+            std::lock_guard G(Mutex_);
+            auto It = Clients_.find(Id);
+            if(It==Clients_.end())
+                return;
+            Sender = It->second.Sender;
+            Clients_.erase(It);
+            NumClients_ = Clients_.size();
+        }
+        //  waits for a write in progress
+        std::lock_guard G(Sender->Mutex);
+        Sender->Gone = true;
     }
 
     inline void WebSocketClientServer::SetUser(const std::string &Id, const std::string &UserId) {
@@ -4904,10 +5913,29 @@ namespace OpenWifi {
 
         auto it=Clients_.find(Id);
         if(it!=Clients_.end()) {
-            Clients_[Id] = std::make_pair(it->second.first,UserId);
+            it->second.UserName = UserId;
         }
     }
 
+	inline void WebSocketClientServer::SetSubscription(const std::string &Id, const WebSocketClientSubscription &S) {
+		std::lock_guard G(Mutex_);
+
+		auto it=Clients_.find(Id);
+		if(it!=Clients_.end()) {
+			it->second.Filter = S;
+			it->second.Filter.Subscribed = true;
+		}
+	}
+
+	inline void WebSocketClientServer::ClearSubscription(const std::string &Id) {
+		std::lock_guard G(Mutex_);
+
+		auto it=Clients_.find(Id);
+		if(it!=Clients_.end()) {
+			it->second.Filter = WebSocketClientSubscription{};
+		}
+	}
+
     [[nodiscard]] inline bool SendToUser(const std::string &userName, const std::string &Payload);
     inline WebSocketClientServer::WebSocketClientServer() noexcept:
             SubSystemServer("WebSocketClientServer", "WSCLNT-SVR", "websocketclients")
@@ -4921,12 +5949,16 @@ namespace OpenWifi {
 
             if(!Running_)
                 break;
+
+            FlushQueues();
         }
     };
 
     inline int WebSocketClientServer::Start() {
         GoogleApiKey_ = MicroService::instance().ConfigGetString("google.apikey","");
         GeoCodeEnabled_ = !GoogleApiKey_.empty();
+        MaxQueueSize_ = MicroService::instance().ConfigGetInt("websocketclients.queue.size",256);
+        SendTimeout_ = MicroService::instance().ConfigGetInt("websocketclients.send.timeout",2);
         // ReactorPool_ = std::make_unique<MyParallelSocketReactor>();
 		ReactorThread_.start(Reactor_);
         Thr_.start(*this);
@@ -4943,43 +5975,136 @@ namespace OpenWifi {
         }
     };
 
+	//	Called with Mutex_ held. When a client falls behind, the oldest notifications are dropped.
+	inline void WebSocketClientServer::Enqueue(const std::vector<ClientEntry *> &Targets, const std::shared_ptr<const std::string> &Payload) {
+		for(auto Entry:Targets) {
+			if(Entry->Queue.size()>=MaxQueueSize_) {
+				Entry->Queue.pop_front();
+				Entry->Dropped++;
+			}
+			Entry->Queue.push_back(Payload);
+		}
+		Thr_.wakeUp();
+	}
+
+	//	Only write to clients whose socket can take more data, so a slow browser only delays itself. The queues are
+	//	taken out under Mutex_ and written without it: notifications keep being queued while a client is written to,
+	//	and what a client could not take goes back in front of its queue.
+	inline void WebSocketClientServer::FlushQueues() {
+		struct Pending {
+			std::string 									Id;
+			WebSocketClient 								*Client = nullptr;
+			std::shared_ptr<ClientSender>					Sender;
+			std::deque<std::shared_ptr<const std::string>>	Queue;
+			uint64_t 										MessagesSent = 0;
+			uint64_t 										BytesSent = 0;
+			bool 											Failed = false;
+		};
+		std::vector<Pending>	Work;
+		{
+			std::lock_guard G(Mutex_);
+			for(auto &[Id,Entry]:Clients_) {
+				if(Entry.Dropped) {
+					Logger().debug(fmt::format("CLIENT({}): {} notifications dropped, client is too slow.", Id, Entry.Dropped));
+					Entry.Dropped = 0;
+				}
+				if(!Entry.Queue.empty())
+					Work.push_back(Pending{ .Id = Id, .Client = Entry.Client, .Sender = Entry.Sender, .Queue = std::move(Entry.Queue) });
+				Entry.Queue.clear();
+			}
+		}
+
+		for(auto &P:Work) {
+			std::lock_guard G(P.Sender->Mutex);
+			if(P.Sender->Gone)
+				continue;
+			while(!P.Queue.empty() && P.Client->CanSend()) {
+				if(!P.Client->Send(*P.Queue.front())) {
+					P.Failed = true;
+					break;
+				}
+				P.MessagesSent++;
+				P.BytesSent += P.Queue.front()->size();
+				P.Queue.pop_front();
+			}
+		}
+
+		std::lock_guard G(Mutex_);
+		for(auto &P:Work) {
+			auto It = Clients_.find(P.Id);
+			if(It==Clients_.end() || It->second.Client!=P.Client)
+				continue;
+			auto &Entry = It->second;
+			Entry.MessagesSent += P.MessagesSent;
+			Entry.BytesSent += P.BytesSent;
+			if(P.Failed) {
+				Entry.Queue.clear();
+				continue;
+			}
+			Entry.Queue.insert(Entry.Queue.begin(), P.Queue.begin(), P.Queue.end());
+			while(Entry.Queue.size()>MaxQueueSize_) {
+				Entry.Queue.pop_front();
+				Entry.Dropped++;
+			}
+		}
+
+		auto now = OpenWifi::Now();
+		if((now - LastReport_) >= 60) {
+			for(auto &[Id,Entry]:Clients_) {
+				Logger().debug(fmt::format("CLIENT({}): {} notifications, {} bytes sent in the last {} seconds.",
+										   Id, Entry.MessagesSent, Entry.BytesSent, now - LastReport_));
+				Entry.MessagesSent = Entry.BytesSent = 0;
+			}
+			LastReport_ = now;
+		}
+	}
 
     inline void WebSocketClient::OnSocketError([[maybe_unused]] const Poco::AutoPtr<Poco::Net::ErrorNotification> &pNf) {
         delete this;
     }
 
     inline bool WebSocketClientServer::Send(const std::string &Id, const std::string &Payload) {
-        std::lock_guard G(Mutex_);
-
-        auto It = Clients_.find(Id);
-        if(It!=Clients_.end())
-            return It->second.first->Send(Payload);
-        return false;
+        WebSocketClient                 *Client = nullptr;
+        std::shared_ptr<ClientSender>   Sender;
+        {
+            std::lock_guard G(Mutex_);
+            auto It = Clients_.find(Id);
+            if(It==Clients_.end())
+                return false;
+            Client = It->second.Client;
+            Sender = It->second.Sender;
+        }
+        std::lock_guard G(Sender->Mutex);
+        return !Sender->Gone && Client->Send(Payload);
     }
 
     inline bool WebSocketClientServer::SendToUser(const std::string &UserName, const std::string &Payload) {
-        std::lock_guard G(Mutex_);
-        uint64_t Sent=0;
-
-        for(const auto &client:Clients_) {
-            if(client.second.second == UserName) {
-                if(client.second.first->Send(Payload))
-                    Sent++;
+        std::vector<std::pair<WebSocketClient *,std::shared_ptr<ClientSender>>>    Targets;
+        {
+            std::lock_guard G(Mutex_);
+            for(const auto &client:Clients_) {
+                if(client.second.UserName == UserName)
+                    Targets.emplace_back(client.second.Client, client.second.Sender);
             }
         }
+
+        uint64_t Sent=0;
+        for(const auto &[Client,Sender]:Targets) {
+            std::lock_guard G(Sender->Mutex);
+            if(!Sender->Gone && Client->Send(Payload))
+                Sent++;
+        }
         return Sent>0;
     }
 
 	inline void WebSocketClientServer::SendToAll(const std::string &Payload) {
 		std::lock_guard G(Mutex_);
 
-		for(const auto &client:Clients_) {
-			try {
-				client.second.first->Send(Payload);
-			} catch (...) {
-
-			}
-		}
+		std::vector<ClientEntry *>	Targets;
+		for(auto &[Id,Entry]:Clients_)
+			Targets.push_back(&Entry);
+		if(!Targets.empty())
+			Enqueue(Targets, std::make_shared<const std::string>(Payload));
 	}
 
 	inline void WebSocketClient::OnSocketReadable([[maybe_unused]] const Poco::AutoPtr<Poco::Net::ReadableNotification> &pNf) {
@@ -5032,7 +6157,8 @@ namespace OpenWifi {
                         auto Obj = P.parse(IncomingFrame.begin())
                                 .extract<Poco::JSON::Object::Ptr>();
                         std::string Answer;
-                        if(Processor_!= nullptr)
+                        if(ProcessSubscription(Obj, Answer)) {
+                        } else if(Processor_!= nullptr)
                             Processor_->Processor(Obj, Answer, Done);
                         if (!Answer.empty())
                             WS_->sendFrame(Answer.c_str(), (int) Answer.size());
@@ -5056,6 +6182,32 @@ namespace OpenWifi {
         }
     }
 
+	//	{ "command" : "subscribe", "types" : [...], "serialNumbers" : [...], "venues" : [...] } or { "command" : "unsubscribe" }
+	inline bool WebSocketClient::ProcessSubscription(const Poco::JSON::Object::Ptr &O, std::string &Answer) {
+		if(!O->has("command"))
+			return false;
+		auto Command = O->get("command").toString();
+		if(Command=="subscribe") {
+			WebSocketClientSubscription	S;
+			std::vector<std::string>	Types, SerialNumbers, Venues;
+			RESTAPI_utils::field_from_json(O,"types",Types);
+			RESTAPI_utils::field_from_json(O,"serialNumbers",SerialNumbers);
+			RESTAPI_utils::field_from_json(O,"venues",Venues);
+			S.Types.insert(Types.begin(),Types.end());
+			for(const auto &SerialNumber:SerialNumbers)
+				S.SerialNumbers.insert(Poco::toLower(SerialNumber));
+			S.Venues.insert(Venues.begin(),Venues.end());
+			WebSocketClientServer()->SetSubscription(Id_,S);
+			Answer = R"lit({ "subscribed" : true })lit";
+			return true;
+		} else if(Command=="unsubscribe") {
+			WebSocketClientServer()->ClearSubscription(Id_);
+			Answer = R"lit({ "subscribed" : false })lit";
+			return true;
+		}
+		return false;
+	}
+
     inline void WebSocketClient::OnSocketShutdown([[maybe_unused]] const Poco::AutoPtr<Poco::Net::ShutdownNotification> &pNf) {
         delete this;
     }
@@ -5068,6 +6220,7 @@ namespace OpenWifi {
             Processor_(Processor) {
         try {
             WS_ = std::make_unique<Poco::Net::WebSocket>(WS);
+            WS_->setSendTimeout(Poco::Timespan((long)WebSocketClientServer()->SendTimeout(),0));
             Reactor_.addEventHandler(*WS_,
                                      Poco::NObserver<WebSocketClient, Poco::Net::ReadableNotification>(
                                              *this, &WebSocketClient::OnSocketReadable));
@@ -5121,6 +6274,15 @@ namespace OpenWifi {
         return false;
     }
 
+    [[nodiscard]] inline bool WebSocketClient::CanSend() {
+        try {
+            return WS_->poll(Poco::Timespan(0), Poco::Net::Socket::SELECT_WRITE);
+        } catch (...) {
+
+        }
+        return false;
+    }
+
     class RESTAPI_webSocketServer : public RESTAPIHandler {
     public:
         inline RESTAPI_webSocketServer(const RESTAPIHandler::BindingMap &bindings, Poco::Logger &L, RESTAPI_GenericServer &Server, uint64_t TransactionId, bool Internal)
@@ -4,6 +4,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <type_traits>
+
 #include "Poco/Data/Session.h"
 #include "Poco/Data/SessionPool.h"
 #include "Poco/Data/SQLite/Connector.h"
@@ -23,6 +28,173 @@ namespace OpenWifi {
         mysql
     };
 
+    //  rewrite '?' placeholders into the $n form PostgreSQL expects
+    inline std::string ConvertSQLParams(DBType Type, const std::string & S) {
+        std::string R;
+        R.reserve(S.size()*2+1);
+        if(Type==pgsql) {
+            auto Idx=1;
+            for(auto const & i:S)
+            {
+                if(i=='?') {
+                    R += '$';
+                    R.append(std::to_string(Idx++));
+                } else {
+                    R += i;
+                }
+            }
+        } else {
+            R = S;
+        }
+        return R;
+    }
+
+    class CachedStatementBase {
+    public:
+        virtual ~CachedStatementBase() = default;
+        virtual void Reset() = 0;
+
+        //  every cached statement holds pooled sessions, they must be released before the pool goes away
+        static inline void ResetAll() {
+            std::lock_guard G(RegistryMutex());
+            for(auto *S:Registry())
+                S->Reset();
+        }
+
+        //  How many pooled sessions the lanes of all cached statements may hold together: half of maxsessions. The
+        //  rest of the pool stays available to other queries, a call finding no free lane and no budget runs uncached.
+        static inline void SetSessionBudget(int64_t Sessions) {
+            SessionBudget() = Sessions;
+        }
+
+    protected:
+        CachedStatementBase() {
+            std::lock_guard G(RegistryMutex());
+            Registry().insert(this);
+        }
+
+        static inline bool ReserveSession() {
+            auto Available = SessionBudget().load();
+            while(Available>0) {
+                if(SessionBudget().compare_exchange_weak(Available, Available-1))
+                    return true;
+            }
+            return false;
+        }
+
+        static inline void ReleaseSession() {
+            SessionBudget()++;
+        }
+
+    private:
+        static inline std::set<CachedStatementBase *> & Registry() { static std::set<CachedStatementBase *> R; return R; }
+        static inline std::mutex & RegistryMutex() { static std::mutex M; return M; }
+        static inline std::atomic_int64_t & SessionBudget() { static std::atomic_int64_t B{0}; return B; }
+    };
+
+    //  A hot query prepared once per lane on a dedicated pooled session and re-executed with new values, so the
+    //  SQL is converted once and the database parses and plans it once instead of on every call. A lane is only
+    //  opened when all the existing ones are busy, and only while the session budget allows it.
+    template <typename Bind, typename Result = std::nullptr_t> class CachedStatement : public CachedStatementBase {
+    public:
+        explicit CachedStatement(const std::string &SQL, std::size_t Lanes = 4) :
+            SQL_(SQL), Lanes_(std::max((std::size_t)1,Lanes)) {
+        }
+
+        //  returns the number of rows extracted (selects) or affected (updates). Poco exceptions are passed on
+        //  to the caller after the lane is dropped, so a broken connection is not reused.
+        inline std::size_t Execute(Poco::Data::SessionPool &Pool, DBType Type, const Bind &Values, Result *Row = nullptr) {
+            auto &L = AcquireLane();
+            std::unique_lock G(L.Mutex, std::adopt_lock);
+            if(!L.Statement) {
+                if(!ReserveSession()) {
+                    G.unlock();
+                    return ExecuteOnce(Pool, Type, Values, Row);
+                }
+                L.Reserved = true;
+            }
+            try {
+                if(!L.Statement) {
+                    L.Session = std::make_unique<Poco::Data::Session>(Pool.get());
+                    L.Statement = std::make_unique<Poco::Data::Statement>(*L.Session);
+                    *L.Statement << ConvertSQLParams(Type, SQL_), Poco::Data::Keywords::use(L.Values);
+                    if constexpr (!std::is_same_v<Result,std::nullptr_t>) {
+                        *L.Statement, Poco::Data::Keywords::into(L.Row);
+                    }
+                }
+                L.Values = Values;
+                auto Count = L.Statement->execute();
+                if constexpr (!std::is_same_v<Result,std::nullptr_t>) {
+                    if(Row!= nullptr && Count)
+                        *Row = L.Row;
+                }
+                return Count;
+            } catch (...) {
+                Close(L);
+                throw;
+            }
+        }
+
+        inline void Reset() override {
+            for(auto &L:Lanes_) {
+                std::lock_guard G(L.Mutex);
+                Close(L);
+            }
+        }
+
+    private:
+        struct Lane {
+            std::mutex                                  Mutex;
+            std::unique_ptr<Poco::Data::Session>        Session;
+            std::unique_ptr<Poco::Data::Statement>      Statement;
+            bool                                        Reserved = false;
+            Bind                                        Values;
+            std::conditional_t<std::is_same_v<Result,std::nullptr_t>,int,Result>   Row{};
+        };
+
+        //  called with the lane locked
+        static inline void Close(Lane &L) {
+            L.Statement.reset();
+            L.Session.reset();
+            if(L.Reserved) {
+                L.Reserved = false;
+                ReleaseSession();
+            }
+        }
+
+        //  the query as it ran before it was cached, on a session returned to the pool right after
+        inline std::size_t ExecuteOnce(Poco::Data::SessionPool &Pool, DBType Type, const Bind &Values, Result *Row) {
+            Poco::Data::Session     Session = Pool.get();
+            Poco::Data::Statement   Statement(Session);
+            Bind                    V = Values;
+            std::conditional_t<std::is_same_v<Result,std::nullptr_t>,int,Result>   R{};
+            Statement << ConvertSQLParams(Type, SQL_), Poco::Data::Keywords::use(V);
+            if constexpr (!std::is_same_v<Result,std::nullptr_t>) {
+                Statement, Poco::Data::Keywords::into(R);
+            }
+            auto Count = Statement.execute();
+            if constexpr (!std::is_same_v<Result,std::nullptr_t>) {
+                if(Row!= nullptr && Count)
+                    *Row = R;
+            }
+            return Count;
+        }
+
+        //  returns a locked lane: the first free one, otherwise wait on one picked round robin
+        inline Lane & AcquireLane() {
+            for(auto &L:Lanes_)
+                if(L.Mutex.try_lock())
+                    return L;
+            auto &L = Lanes_[Next_++ % Lanes_.size()];
+            L.Mutex.lock();
+            return L;
+        }
+
+        std::string             SQL_;
+        std::vector<Lane>       Lanes_;
+        std::atomic_uint64_t    Next_=0;
+    };
+
     class StorageClass : public SubSystemServer {
     public:
         StorageClass() noexcept:
@@ -48,6 +220,7 @@ namespace OpenWifi {
         }
 
         void Stop() override {
+            CachedStatementBase::ResetAll();
             Pool_->shutdown();
         }
 
@@ -75,6 +248,7 @@ namespace OpenWifi {
         dbType_ = sqlite;
         auto DBName = MicroService::instance().DataDir() + "/" + MicroService::instance().ConfigGetString("storage.type.sqlite.db");
         int NumSessions = (int) MicroService::instance().ConfigGetInt("storage.type.sqlite.maxsessions", 64);
+        CachedStatementBase::SetSessionBudget(NumSessions/2);
         int IdleTime = (int) MicroService::instance().ConfigGetInt("storage.type.sqlite.idletime", 60);
 
         Poco::Data::SQLite::Connector::registerConnector();
@@ -89,6 +263,7 @@ namespace OpenWifi {
         Logger().notice("MySQL StorageClass enabled.");
         dbType_ = mysql;
         int NumSessions = (int) MicroService::instance().ConfigGetInt("storage.type.mysql.maxsessions", 64);
+        CachedStatementBase::SetSessionBudget(NumSessions/2);
         int IdleTime = (int) MicroService::instance().ConfigGetInt("storage.type.mysql.idletime", 60);
         auto Host = MicroService::instance().ConfigGetString("storage.type.mysql.host");
         auto Username = MicroService::instance().ConfigGetString("storage.type.mysql.username");
@@ -114,6 +289,7 @@ namespace OpenWifi {
         Logger().notice("PostgreSQL StorageClass enabled.");
         dbType_ = pgsql;
         int NumSessions = (int) MicroService::instance().ConfigGetInt("storage.type.postgresql.maxsessions", 64);
+        CachedStatementBase::SetSessionBudget(NumSessions/2);
         int IdleTime = (int) MicroService::instance().ConfigGetInt("storage.type.postgresql.idletime", 60);
         auto Host = MicroService::instance().ConfigGetString("storage.type.postgresql.host");
         auto Username = MicroService::instance().ConfigGetString("storage.type.postgresql.username");
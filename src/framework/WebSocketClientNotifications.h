@@ -69,35 +69,78 @@ namespace OpenWifi {
 		}
 	};
 
-	inline void WebSocketClientNotificationDeviceConfigurationChange(const std::string &SerialNumber, uint64_t oldUUID, uint64_t newUUID) {
+	inline void WebSocketClientNotificationDeviceConfigurationChange(const std::string &SerialNumber, uint64_t oldUUID, uint64_t newUUID, const std::string &Venue="") {
 		WebSocketNotification<WebNotificationSingleDeviceConfigurationChange>	N;
 		N.content.serialNumber = SerialNumber;
 		N.content.oldUUID = oldUUID;
 		N.content.newUUID = newUUID;
 		N.type = "device_configuration_upgrade";
-		WebSocketClientServer()->SendNotification(N);
+		WebSocketClientServer()->SendNotification(N, SerialNumber, Venue);
 	}
 
-	inline void WebSocketClientNotificationDeviceFirmwareUpdated(const std::string &SerialNumber, const std::string &Firmware) {
+	inline void WebSocketClientNotificationDeviceFirmwareUpdated(const std::string &SerialNumber, const std::string &Firmware, const std::string &Venue="") {
 		WebSocketNotification<WebNotificationSingleDeviceFirmwareChange>	N;
 		N.content.serialNumber = SerialNumber;
 		N.content.newFirmware = Firmware;
 		N.type = "device_firmware_upgrade";
-		WebSocketClientServer()->SendNotification(N);
+		WebSocketClientServer()->SendNotification(N, SerialNumber, Venue);
 	}
 
-	inline void WebSocketClientNotificationDeviceConnected(const std::string &SerialNumber) {
+	inline void WebSocketClientNotificationDeviceConnected(const std::string &SerialNumber, const std::string &Venue="") {
 		WebSocketNotification<WebNotificationSingleDevice>	N;
 		N.content.serialNumber = SerialNumber;
 		N.type = "device_connection";
-		WebSocketClientServer()->SendNotification(N);
+		WebSocketClientServer()->SendNotification(N, SerialNumber, Venue);
 	}
 
-	inline void WebSocketClientNotificationDeviceDisconnected(const std::string & SerialNumber) {
+	inline void WebSocketClientNotificationDeviceDisconnected(const std::string & SerialNumber, const std::string &Venue="") {
 		WebSocketNotification<WebNotificationSingleDevice>	N;
 		N.content.serialNumber = SerialNumber;
 		N.type = "device_disconnection";
-		WebSocketClientServer()->SendNotification(N);
+		WebSocketClientServer()->SendNotification(N, SerialNumber, Venue);
+	}
+
+	struct WebNotificationDeviceStatistics {
+		std::string		serialNumber;
+		uint64_t 		associations_2G=0;
+		uint64_t 		associations_5G=0;
+		uint64_t 		rxBytes=0;
+		uint64_t 		txBytes=0;
+		uint64_t 		updates=0;
+		uint64_t 		lastContact=0;
+
+		inline void to_json(Poco::JSON::Object &Obj) const {
+			RESTAPI_utils::field_to_json(Obj,"serialNumber", serialNumber);
+			RESTAPI_utils::field_to_json(Obj,"associations_2G", associations_2G);
+			RESTAPI_utils::field_to_json(Obj,"associations_5G", associations_5G);
+			RESTAPI_utils::field_to_json(Obj,"rxBytes", rxBytes);
+			RESTAPI_utils::field_to_json(Obj,"txBytes", txBytes);
+			RESTAPI_utils::field_to_json(Obj,"updates", updates);
+			RESTAPI_utils::field_to_json(Obj,"lastContact", lastContact);
+		}
+
+		inline bool from_json(const Poco::JSON::Object::Ptr &Obj) {
+			try {
+				RESTAPI_utils::field_from_json(Obj,"serialNumber", serialNumber);
+				RESTAPI_utils::field_from_json(Obj,"associations_2G", associations_2G);
+				RESTAPI_utils::field_from_json(Obj,"associations_5G", associations_5G);
+				RESTAPI_utils::field_from_json(Obj,"rxBytes", rxBytes);
+				RESTAPI_utils::field_from_json(Obj,"txBytes", txBytes);
+				RESTAPI_utils::field_from_json(Obj,"updates", updates);
+				RESTAPI_utils::field_from_json(Obj,"lastContact", lastContact);
+				return true;
+			} catch (...) {
+
+			}
+			return false;
+		}
+	};
+
+	inline void WebSocketClientNotificationDeviceStatistics(const std::string & SerialNumber, const std::string &Venue="") {
+		WebSocketNotification<WebNotificationSingleDevice>	N;
+		N.content.serialNumber = SerialNumber;
+		N.type = "device_statistics";
+		WebSocketClientServer()->SendNotification(N, SerialNumber, Venue);
 	}
 
     struct WebSocketNotificationJobContent {
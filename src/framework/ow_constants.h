@@ -195,6 +195,7 @@ namespace OpenWifi::RESTAPI::Errors {
 	static const struct msg MustHaveAtLeastOneRadiusServer{1141,"Must have at least one RADIUS server."};
 	static const struct msg InvalidRadiusServerEntry{1142,"RADIUS Server IP address invalid or port missing."};
 	static const struct msg InvalidRadiusServerWeigth{1143,"RADIUS Server IP weight cannot be 0."};
+	static const struct msg InvalidCursor{1144,"Invalid or corrupt cursor."};
 
 }
 
@@ -266,6 +267,7 @@ namespace OpenWifi::RESTAPI::Protocol {
 	static const char * PROCESSORS = "processors";
 	static const char * REASON = "reason";
 	static const char * RELOAD = "reload";
+	static const char * DRAIN = "drain";
 	static const char * SUBSYSTEMS = "subsystems";
 	static const char * FILEUUID = "uuid";
 	static const char * USERID = "userId";
@@ -281,6 +283,9 @@ namespace OpenWifi::RESTAPI::Protocol {
 	static const char * VALUE = "value";
 	static const char * LASTONLY = "lastOnly";
 	static const char * NEWEST = "newest";
+	static const char * CURSOR = "cursor";
+	static const char * NEXTCURSOR = "nextCursor";
+	static const char * MISSING = "missing";
 	static const char * ACTIVESCAN = "activeScan";
 	static const char * OVERRIDEDFS = "override_dfs";
 	static const char * LIST = "list";
@@ -369,6 +374,9 @@ namespace OpenWifi::uCentralProtocol {
     static const char *REBOOT = "reboot";
     static const char *WHEN = "when";
     static const char *CONFIG = "config";
+    static const char *CONFIG_PATCH = "config_patch";
+    static const char *BASE = "base";
+    static const char *PATCH = "patch";
     static const char *EMPTY_JSON_DOC = "{}";
     static const char *RESULT = "result";
 	static const char *RESULT_64 = "result_64";
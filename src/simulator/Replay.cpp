@@ -0,0 +1,394 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include "Poco/Buffer.h"
+#include "Poco/DirectoryIterator.h"
+#include "Poco/File.h"
+#include "Poco/JSON/Stringifier.h"
+#include "Poco/Net/HTTPRequest.h"
+#include "Poco/Net/HTTPResponse.h"
+#include "Poco/Net/HTTPSClientSession.h"
+#include "Poco/Net/NetException.h"
+#include "Poco/Path.h"
+
+#include "fmt/format.h"
+
+#include "../FrameCapture.h"
+#include "Replay.h"
+
+namespace OpenWifi::Simulator {
+
+	static const uint64_t				MaxSpeedBatch = 16;			//	frames sent to one device per turn at maximum speed
+	static const std::chrono::seconds	PongGrace{10};				//	how long the last answers are waited for
+
+	static inline uint64_t Microseconds(TimePoint From, TimePoint To) {
+		return To > From ? (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(To - From).count() : 0;
+	}
+
+	static std::string Field(const std::string &Payload, const std::string &Name) {
+		auto Key = "\"" + Name + "\":\"";
+		auto Start = Payload.find(Key);
+		if(Start==std::string::npos)
+			return "";
+		Start += Key.size();
+		auto End = Payload.find('"', Start);
+		return End==std::string::npos ? "" : Payload.substr(Start, End - Start);
+	}
+
+	//	what the latency of a frame is reported under
+	static std::string FrameType(int Flags, const std::string &Payload) {
+		switch(Flags & Poco::Net::WebSocket::FRAME_OP_BITMASK) {
+			case Poco::Net::WebSocket::FRAME_OP_TEXT: {
+				auto Method = Field(Payload, "method");
+				if(!Method.empty())
+					return Method;
+				return Payload.find("\"result\"")!=std::string::npos ? "result" : "text";
+			}
+			case Poco::Net::WebSocket::FRAME_OP_BINARY:
+				return "binary";
+			case Poco::Net::WebSocket::FRAME_OP_PING:
+				return "ws-ping";
+			case Poco::Net::WebSocket::FRAME_OP_CONT:
+				return "continuation";
+			default:
+				return "";
+		}
+	}
+
+	TimePoint ReplayDevice::Due(const ReplayConfig &Config, TimePoint Start) const {
+		if(Done())
+			return TimePoint::max();
+		if(Config.Speed<=0.0)
+			return Start;
+		return Start + std::chrono::microseconds((uint64_t)((double)Frames_[Next_].Offset / Config.Speed));
+	}
+
+	bool ReplayDevice::Connect(Poco::Net::Context::Ptr Context, const ReplayConfig &Config) {
+		Poco::Net::HTTPSClientSession	Session(Config.Host, Config.Port, Context);
+		Poco::Net::HTTPRequest			Request(Poco::Net::HTTPRequest::HTTP_GET, "/", Poco::Net::HTTPMessage::HTTP_1_1);
+		Poco::Net::HTTPResponse			Response;
+		WS_ = std::make_unique<Poco::Net::WebSocket>(Session, Request, Response);
+		WS_->setNoDelay(true);
+		WS_->setKeepAlive(true);
+		WS_->setReceiveTimeout(Poco::Timespan(10, 0));
+		AwaitingPong_.clear();
+		Greeted_ = false;
+		return true;
+	}
+
+	void ReplayDevice::Disconnect() {
+		if(WS_) {
+			try {
+				WS_->shutdown();
+				WS_->close();
+			} catch (...) {
+			}
+			WS_.reset();
+		}
+		AwaitingPong_.clear();
+	}
+
+	//	like the simulator, every frame is followed by a ping so its pong gives the time the gateway took to process it
+	void ReplayDevice::Send(const std::string &Type, int Flags, const std::string &Payload) {
+		WS_->sendFrame(Payload.data(), (int) Payload.size(), Flags);
+		WS_->sendFrame("", 0, (int)Poco::Net::WebSocket::FRAME_OP_PING | (int)Poco::Net::WebSocket::FRAME_FLAG_FIN);
+		AwaitingPong_.emplace_back(Type, Clock::now());
+	}
+
+	void ReplayDevice::Service(Poco::Net::Context::Ptr Context, const ReplayConfig &Config, TimePoint Start, TimePoint Now,
+							   LatencyMap &Latencies, uint64_t &Bytes, uint64_t &Failures) {
+		uint64_t Batch = 0;
+		while(!Done() && Due(Config, Start) <= Now && (Config.Speed>0.0 || Batch++ < MaxSpeedBatch)) {
+			auto &F = Frames_[Next_];
+			try {
+				if(!WS_) {
+					auto Before = Clock::now();
+					Connect(Context, Config);
+					Latencies["connect"].Add(Microseconds(Before, Clock::now()));
+				}
+				//	a capture may start after the device connected: the gateway wants a connect first
+				if(!Greeted_ && F.Type!="connect") {
+					Send("connect-event", Poco::Net::WebSocket::FRAME_TEXT,
+						 fmt::format(R"({{"jsonrpc":"2.0","method":"connect","params":{{"serial":"{}","uuid":1,"firmware":"replay","capabilities":{{}}}}}})", Serial_));
+				}
+				Greeted_ = true;
+				if(Config.Speed>0.0)
+					Latencies["schedule-lag"].Add(Microseconds(Due(Config, Start), Clock::now()));
+				Send(F.Type, F.Flags, F.Payload);
+				Bytes += F.Payload.size();
+				Next_++;
+			} catch (const Poco::Exception &) {
+				//	the frame is skipped rather than retried: a replay must not stall on a device the gateway refuses
+				Failures++;
+				Next_++;
+				Disconnect();
+			}
+		}
+	}
+
+	void ReplayDevice::OnReadable(LatencyMap &Latencies) {
+		try {
+			do {
+				Poco::Buffer<char>	Frame(0);
+				int Flags = 0;
+				auto Size = WS_->receiveFrame(Frame, Flags);
+				if(Size==0 && Flags==0) {
+					Disconnect();
+					return;
+				}
+				switch(Flags & Poco::Net::WebSocket::FRAME_OP_BITMASK) {
+					case Poco::Net::WebSocket::FRAME_OP_PONG: {
+						if(!AwaitingPong_.empty()) {
+							Latencies[AwaitingPong_.front().first].Add(Microseconds(AwaitingPong_.front().second, Clock::now()));
+							AwaitingPong_.pop_front();
+						}
+					} break;
+					case Poco::Net::WebSocket::FRAME_OP_PING: {
+						WS_->sendFrame("", 0, (int)Poco::Net::WebSocket::FRAME_OP_PONG | (int)Poco::Net::WebSocket::FRAME_FLAG_FIN);
+					} break;
+					case Poco::Net::WebSocket::FRAME_OP_CLOSE: {
+						Disconnect();
+						return;
+					}
+					default:
+						//	commands from the gateway are not answered: the captured answers are replayed instead
+						break;
+				}
+			} while(WS_ && WS_->available() > 0);
+		} catch (const Poco::Exception &) {
+			Disconnect();
+		}
+	}
+
+	void ReplayWorker::Start() {
+		Running_ = true;
+		Thread_ = std::thread([this]() { run(); });
+	}
+
+	void ReplayWorker::Stop() {
+		Running_ = false;
+		if(Thread_.joinable())
+			Thread_.join();
+	}
+
+	void ReplayWorker::Collect(LatencyMap &L, uint64_t &Sent, uint64_t &Bytes, uint64_t &Connected, uint64_t &Failures) {
+		std::lock_guard	G(Mutex_);
+		for(const auto &[Type,H]:Latencies_)
+			L[Type].Merge(H);
+		Sent += Sent_;
+		Bytes += Bytes_;
+		Connected += Connected_;
+		Failures += Failures_;
+	}
+
+	void ReplayWorker::run() {
+		LatencyMap	Pending;
+		std::map<poco_socket_t, ReplayDevice *>	BySocket;
+		uint64_t Bytes = 0, Failures = 0;
+		auto AllSent = TimePoint::max();
+
+		while(Running_) {
+			auto Now = Clock::now();
+			auto NextDue = TimePoint::max();
+			for(auto &D:Devices_) {
+				D->Service(Context_, Config_, Start_, Now, Pending, Bytes, Failures);
+				NextDue = std::min(NextDue, D->Due(Config_, Start_));
+			}
+
+			Poco::Net::Socket::SocketList	Readable, Writable, Errors;
+			BySocket.clear();
+			for(auto &D:Devices_) {
+				if(D->Socket()) {
+					Readable.push_back(*D->Socket());
+					BySocket[D->Socket()->impl()->sockfd()] = D.get();
+				}
+			}
+			//	wait for the gateway until the next frame is due, and never long enough to fall behind the schedule
+			auto Wait = std::min(Microseconds(Clock::now(), NextDue), (uint64_t) 20000);
+			if(Readable.empty()) {
+				std::this_thread::sleep_for(std::chrono::microseconds(Wait));
+			} else {
+				Poco::Net::Socket::select(Readable, Writable, Errors, Poco::Timespan(0, (long) Wait));
+				for(auto &S:Readable) {
+					auto Hint = BySocket.find(S.impl()->sockfd());
+					if(Hint!=BySocket.end() && Hint->second->Socket())
+						Hint->second->OnReadable(Pending);
+				}
+			}
+
+			uint64_t Sent = 0, Connected = 0;
+			bool Done = true, Idle = true;
+			for(auto &D:Devices_) {
+				Sent += D->Sent();
+				Connected += D->Socket()!=nullptr;
+				Done = Done && D->Done();
+				Idle = Idle && D->Done() && (D->Idle() || !D->Socket());
+			}
+			if(Done && AllSent==TimePoint::max())
+				AllSent = Clock::now();
+
+			std::lock_guard	G(Mutex_);
+			for(auto &[Type,H]:Pending)
+				Latencies_[Type].Merge(H);
+			Pending.clear();
+			Sent_ = Sent;
+			Bytes_ = Bytes;
+			Connected_ = Connected;
+			Failures_ = Failures;
+			if(Idle || (Done && Clock::now() - AllSent > PongGrace))
+				Done_ = true;
+		}
+
+		for(auto &D:Devices_)
+			D->Disconnect();
+	}
+
+	bool Replay::Load(std::vector<std::unique_ptr<ReplayDevice>> &Devices) {
+		std::vector<std::string>	Files;
+		for(const auto &Name:Config_.Captures) {
+			Poco::File	F(Name);
+			if(!F.exists()) {
+				std::cerr << fmt::format("{} does not exist.", Name) << std::endl;
+				return false;
+			}
+			if(F.isDirectory()) {
+				std::vector<std::string>	InDirectory;
+				for(Poco::DirectoryIterator It(Name), End; It!=End; ++It)
+					if(It->isFile() && Poco::Path(It->path()).getExtension()=="owcap")
+						InDirectory.push_back(It->path());
+				//	capture file names sort in the order they were written
+				std::sort(InDirectory.begin(), InDirectory.end());
+				Files.insert(Files.end(), InDirectory.begin(), InDirectory.end());
+			} else {
+				Files.push_back(Name);
+			}
+		}
+
+		std::map<std::string, std::unique_ptr<ReplayDevice>>	BySerial;
+		uint64_t First = UINT64_MAX, Skipped = 0;
+		FrameCapture::Record	R;
+		for(const auto &Name:Files) {
+			std::ifstream	IS(Name, std::ios::binary);
+			if(!FrameCapture::ReadHeader(IS)) {
+				std::cerr << fmt::format("{} is not a capture file.", Name) << std::endl;
+				return false;
+			}
+			while(FrameCapture::Read(IS, R)) {
+				auto Type = FrameType(R.Flags, R.Payload);
+				auto Serial = R.Serial.empty() ? Field(R.Payload, "serial") : R.Serial;
+				//	pongs and closes only make sense on the original connection
+				if(Type.empty() || Serial.empty()) {
+					Skipped++;
+					continue;
+				}
+				auto &D = BySerial[Serial];
+				if(!D)
+					D = std::make_unique<ReplayDevice>(Serial);
+				First = std::min(First, R.Timestamp);
+				//	absolute for now, made relative to the first frame once every file was read
+				D->Add(ReplayDevice::Frame{.Offset = R.Timestamp, .Flags = R.Flags, .Type = Type, .Payload = std::move(R.Payload)});
+				Frames_++;
+			}
+		}
+
+		for(auto &[Serial,D]:BySerial) {
+			D->Rebase(First);
+			Devices.push_back(std::move(D));
+		}
+		Devices_ = Devices.size();
+		std::cout << fmt::format("Loaded {} frames of {} devices from {} files, {} frames skipped.", Frames_, Devices_,
+								 Files.size(), Skipped) << std::endl;
+		return Frames_>0;
+	}
+
+	int Replay::Run() {
+		std::vector<std::unique_ptr<ReplayDevice>>	Devices;
+		if(!Load(Devices))
+			return 1;
+
+		Poco::Net::Context::Ptr Context = new Poco::Net::Context(
+			Poco::Net::Context::TLS_CLIENT_USE, Config_.KeyFile, Config_.CertFile, Config_.RootCA,
+			Config_.RootCA.empty() ? Poco::Net::Context::VERIFY_NONE : Poco::Net::Context::VERIFY_RELAXED);
+
+		auto Start = Clock::now();
+		auto Threads = std::max((uint64_t)1, std::min(Config_.Threads, (uint64_t)Devices.size()));
+		for(uint64_t i=0;i<Threads;i++)
+			Workers_.push_back(std::make_unique<ReplayWorker>(Config_, Context, Start));
+		for(std::size_t i=0;i<Devices.size();i++)
+			Workers_[i % Threads]->Add(std::move(Devices[i]));
+
+		std::cout << fmt::format("Replaying against {}:{} with {} threads at {}.", Config_.Host, Config_.Port, Threads,
+								 Config_.Speed>0.0 ? fmt::format("{}x the captured pace", Config_.Speed) : "maximum speed") << std::endl;
+		for(auto &W:Workers_)
+			W->Start();
+
+		auto NextReport = Start + std::chrono::seconds(Config_.ReportInterval);
+		while(Running_) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(250));
+			auto Now = Clock::now();
+			if(std::all_of(Workers_.begin(), Workers_.end(), [](const auto &W) { return W->Done(); }))
+				break;
+			if(Config_.ReportInterval && Now >= NextReport) {
+				Report(false, std::chrono::duration<double>(Now - Start).count());
+				NextReport = Now + std::chrono::seconds(Config_.ReportInterval);
+			}
+		}
+
+		for(auto &W:Workers_)
+			W->Stop();
+		Report(true, std::chrono::duration<double>(Clock::now() - Start).count());
+		return 0;
+	}
+
+	void Replay::Report(bool Final, double Elapsed) {
+		LatencyMap	Latencies;
+		uint64_t Sent=0, Bytes=0, Connected=0, Failures=0;
+		for(auto &W:Workers_)
+			W->Collect(Latencies, Sent, Bytes, Connected, Failures);
+
+		auto Rate = Elapsed > 0.0 ? (double) Sent / Elapsed : 0.0;
+		std::cout << fmt::format("{:.1f}s: {}/{} frames sent ({:.0f} frames/s, {:.2f} MB), {} connected, {} failures",
+								 Elapsed, Sent, Frames_, Rate, (double) Bytes / (1024.0 * 1024.0), Connected, Failures) << std::endl;
+		std::cout << fmt::format("  {:<20} {:>10} {:>10} {:>10} {:>10} {:>10} {:>10}", "type", "count", "mean(ms)", "p50(ms)", "p90(ms)", "p99(ms)", "max(ms)") << std::endl;
+		for(const auto &[Type,H]:Latencies) {
+			std::cout << fmt::format("  {:<20} {:>10} {:>10.3f} {:>10.3f} {:>10.3f} {:>10.3f} {:>10.3f}", Type, H.Count(),
+									 H.Mean() / 1000.0, H.Percentile(50) / 1000.0, H.Percentile(90) / 1000.0,
+									 H.Percentile(99) / 1000.0, H.Max() / 1000.0) << std::endl;
+		}
+
+		if(!Final || Config_.JSONReport.empty())
+			return;
+
+		Poco::JSON::Object	Report, Types;
+		Report.set("devices", Devices_);
+		Report.set("frames", Frames_);
+		Report.set("sent", Sent);
+		Report.set("bytes", Bytes);
+		Report.set("seconds", Elapsed);
+		Report.set("framesPerSecond", Rate);
+		Report.set("speed", Config_.Speed);
+		Report.set("failures", Failures);
+		for(const auto &[Type,H]:Latencies) {
+			Poco::JSON::Object	Entry;
+			Entry.set("count", H.Count());
+			Entry.set("minUs", H.Min());
+			Entry.set("meanUs", H.Mean());
+			Entry.set("p50Us", H.Percentile(50));
+			Entry.set("p90Us", H.Percentile(90));
+			Entry.set("p99Us", H.Percentile(99));
+			Entry.set("maxUs", H.Max());
+			Types.set(Type, Entry);
+		}
+		Report.set("latencies", Types);
+		std::ofstream	OF(Config_.JSONReport, std::ios::trunc);
+		Poco::JSON::Stringifier::stringify(Report, OF, 2);
+	}
+}
@@ -0,0 +1,117 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#pragma once
+
+#include <algorithm>
+
+#include "Simulator.h"
+
+namespace OpenWifi::Simulator {
+
+	struct ReplayConfig {
+		std::string					Host{"localhost"};
+		uint16_t					Port = 15002;
+		std::string					CertFile, KeyFile, RootCA;
+		std::vector<std::string>	Captures;			//	capture files or directories of capture files
+		double 						Speed = 1.0;		//	1 replays at the captured pace, 2 twice as fast, 0 as fast as possible
+		uint64_t					Threads = 4;
+		uint64_t					ReportInterval = 10;
+		std::string					JSONReport;
+	};
+
+	//	One captured device: its frames, relative to the start of the capture, and the connection replaying them.
+	class ReplayDevice {
+	  public:
+		struct Frame {
+			uint64_t 		Offset = 0;		//	microseconds since the first captured frame
+			int 			Flags = 0;
+			std::string 	Type;			//	method of a JSON-RPC event, "result" for a command answer
+			std::string 	Payload;
+		};
+
+		explicit ReplayDevice(std::string Serial) : Serial_(std::move(Serial)) {}
+
+		inline void Add(Frame &&F) { Frames_.push_back(std::move(F)); }
+		//	turns capture timestamps into offsets from First
+		inline void Rebase(uint64_t First) {
+			std::stable_sort(Frames_.begin(), Frames_.end(), [](const Frame &L, const Frame &R) { return L.Offset < R.Offset; });
+			for(auto &F:Frames_)
+				F.Offset -= First;
+		}
+		[[nodiscard]] inline bool Done() const { return Next_>=Frames_.size(); }
+		[[nodiscard]] inline uint64_t Sent() const { return Next_; }
+		[[nodiscard]] inline uint64_t Frames() const { return Frames_.size(); }
+		//	every frame was sent and the gateway processed all of them
+		[[nodiscard]] inline bool Idle() const { return Done() && AwaitingPong_.empty(); }
+		[[nodiscard]] inline Poco::Net::WebSocket * Socket() { return WS_.get(); }
+
+		//	sends every frame due at Now, or up to a batch of frames at maximum speed
+		void Service(Poco::Net::Context::Ptr Context, const ReplayConfig &Config, TimePoint Start, TimePoint Now,
+					 LatencyMap &Latencies, uint64_t &Bytes, uint64_t &Failures);
+		void OnReadable(LatencyMap &Latencies);
+		void Disconnect();
+		[[nodiscard]] TimePoint Due(const ReplayConfig &Config, TimePoint Start) const;
+
+	  private:
+		std::string 							Serial_;
+		std::vector<Frame>						Frames_;
+		std::size_t 							Next_ = 0;
+		std::unique_ptr<Poco::Net::WebSocket>	WS_;
+		bool 									Greeted_ = false;	//	a connect went out on this connection
+		std::deque<std::pair<std::string, TimePoint>>	AwaitingPong_;
+
+		bool Connect(Poco::Net::Context::Ptr Context, const ReplayConfig &Config);
+		void Send(const std::string &Type, int Flags, const std::string &Payload);
+	};
+
+	class ReplayWorker {
+	  public:
+		ReplayWorker(const ReplayConfig &C, Poco::Net::Context::Ptr Context, TimePoint Start) :
+			Config_(C), Context_(std::move(Context)), Start_(Start) {
+		}
+
+		inline void Add(std::unique_ptr<ReplayDevice> D) { Devices_.push_back(std::move(D)); }
+		void Start();
+		void Stop();
+		[[nodiscard]] inline bool Done() const { return Done_; }
+		void Collect(LatencyMap &L, uint64_t &Sent, uint64_t &Bytes, uint64_t &Connected, uint64_t &Failures);
+
+	  private:
+		const ReplayConfig 			&Config_;
+		Poco::Net::Context::Ptr		Context_;
+		TimePoint 					Start_;
+		std::vector<std::unique_ptr<ReplayDevice>>	Devices_;
+		std::thread 				Thread_;
+		std::atomic_bool 			Running_ = false;
+		std::atomic_bool 			Done_ = false;
+		std::mutex 					Mutex_;			//	protects what Collect reads
+		LatencyMap 					Latencies_;
+		uint64_t 					Sent_ = 0, Bytes_ = 0, Connected_ = 0, Failures_ = 0;
+
+		void run();
+	};
+
+	//	Pushes captured device traffic (FrameRecorder captures) back into a gateway, one connection per device.
+	class Replay {
+	  public:
+		explicit Replay(ReplayConfig C) : Config_(std::move(C)) {}
+
+		//	returns once every frame was sent or Stop() was called
+		int Run();
+		inline void Stop() { Running_ = false; }
+
+	  private:
+		ReplayConfig 								Config_;
+		std::vector<std::unique_ptr<ReplayWorker>>	Workers_;
+		std::atomic_bool 							Running_ = true;
+		uint64_t 									Devices_ = 0, Frames_ = 0;
+
+		bool Load(std::vector<std::unique_ptr<ReplayDevice>> &Devices);
+		void Report(bool Final, double Elapsed);
+	};
+}
@@ -0,0 +1,572 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "Poco/Base64Encoder.h"
+#include "Poco/Buffer.h"
+#include "Poco/JSON/Array.h"
+#include "Poco/JSON/Parser.h"
+#include "Poco/JSON/Stringifier.h"
+#include "Poco/Net/HTTPRequest.h"
+#include "Poco/Net/HTTPResponse.h"
+#include "Poco/Net/HTTPSClientSession.h"
+#include "Poco/Net/NetException.h"
+
+#include "fmt/format.h"
+
+#include "Simulator.h"
+
+namespace OpenWifi::Simulator {
+
+	static const std::chrono::seconds	RetryDelay{5};		//	after a failed connection or a lost socket
+	static const std::chrono::seconds	RebootDelay{10};	//	a "rebooted" device comes back after this
+
+	static inline uint64_t Microseconds(TimePoint From, TimePoint To) {
+		return (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(To - From).count();
+	}
+
+	static inline std::string MAC(uint64_t Value) {
+		return fmt::format("{:02x}:{:02x}:{:02x}:{:02x}:{:02x}:{:02x}",
+						   (Value >> 40) & 0xff, (Value >> 32) & 0xff, (Value >> 24) & 0xff,
+						   (Value >> 16) & 0xff, (Value >> 8) & 0xff, Value & 0xff);
+	}
+
+	static inline std::string Base64(const std::string &S) {
+		std::ostringstream OS;
+		Poco::Base64Encoder E(OS);
+		E.rdbuf()->setLineLength(0);
+		E << S;
+		E.close();
+		return OS.str();
+	}
+
+	std::size_t LatencyHistogram::Bucket(uint64_t Us) {
+		if(Us < SubBuckets)
+			return Us;
+		auto Msb = 63 - __builtin_clzll(Us);
+		auto Shift = Msb - 3;
+		return (Shift + 1) * SubBuckets + ((Us >> Shift) & (SubBuckets - 1));
+	}
+
+	uint64_t LatencyHistogram::BucketValue(std::size_t Bucket) {
+		if(Bucket < SubBuckets)
+			return Bucket;
+		auto Shift = Bucket / SubBuckets - 1;
+		return (SubBuckets + Bucket % SubBuckets) << Shift;
+	}
+
+	uint64_t LatencyHistogram::Percentile(double P) const {
+		if(Count_==0)
+			return 0;
+		auto Target = std::max((uint64_t)1, (uint64_t)(P / 100.0 * (double)Count_ + 0.5));
+		uint64_t Seen = 0;
+		for(std::size_t i=0;i<Buckets_.size();i++) {
+			Seen += Buckets_[i];
+			if(Seen>=Target)
+				return std::min(Max_, std::max(Min_, BucketValue(i)));
+		}
+		return Max_;
+	}
+
+	Device::Device(const Config &C, uint64_t Serial, std::mt19937_64 &Random) :
+		Config_(C),
+		Serial_(fmt::format("{:012x}", Serial)),
+		UUID_(1),
+		Random_(Random) {
+
+		Capabilities_ = fmt::format(
+			R"({{"compatible":"edgecore_eap101","model":"EdgeCore EAP101","platform":"ap",)"
+			R"("label_macaddr":"{}","macaddr":{{"lan":"{}","wan":"{}"}},)"
+			R"("network":{{"lan":["eth1","eth2"],"wan":["eth0"]}},)"
+			R"("wifi":{{"platform/soc/c000000.wifi":{{"band":["2G"],"channels":[1,2,3,4,5,6,7,8,9,10,11],"ht_capa":6639,"tx_ant":3,"rx_ant":3}},)"
+			R"("platform/soc/c000000.wifi+1":{{"band":["5G"],"channels":[36,40,44,48,52,56,60,64,100,104,108,112,116,132,136,140,144,149,153,157,161,165],"ht_capa":6639,"vht_capa":865696178,"tx_ant":3,"rx_ant":3}}}}}})",
+			MAC(Serial), MAC(Serial + 1), MAC(Serial + 2));
+
+		//	the state document is built once per device: clients are added until it reaches the requested size
+		std::string Associations;
+		static const uint64_t BaseStateSize = 1200, AssociationSize = 330;
+		auto Clients = Config_.StateSize > BaseStateSize ? (Config_.StateSize - BaseStateSize) / AssociationSize : 0;
+		std::uniform_int_distribution<int> Rssi(-85, -40);
+		std::uniform_int_distribution<uint64_t> Bytes(1000, 100000000);
+		for(uint64_t i=0;i<Clients;i++) {
+			if(i)
+				Associations += ',';
+			Associations += fmt::format(
+				R"({{"bssid":"{}","station":"{}","rssi":{},"connected":{},"inactive":{},)"
+				R"("rx_bytes":{},"tx_bytes":{},"rx_packets":{},"tx_packets":{},)"
+				R"("rx_rate":{{"bitrate":866700,"mcs":9,"nss":2,"chwidth":80,"vht":true,"sgi":true}},)"
+				R"("tx_rate":{{"bitrate":780000,"mcs":8,"nss":2,"chwidth":80,"vht":true,"sgi":true}}}})",
+				MAC(Serial + 16), MAC(0x020000000000 + (Serial << 8) + i), Rssi(Random_), 100 + i, i % 10,
+				Bytes(Random_), Bytes(Random_), Bytes(Random_) / 1000, Bytes(Random_) / 1000);
+		}
+		State_ = fmt::format(
+			R"({{"unit":{{"load":[0.12,0.08,0.05],"memory":{{"total":973139968,"free":640557056,"cached":86351872,"buffered":9641984}},"uptime":86400,"localtime":1640000000}},)"
+			R"("radios":[{{"channel":6,"channel_width":"20","tx_power":20,"noise":-95,"active_ms":86400000,"busy_ms":8640000,"receive_ms":4320000,"transmit_ms":2160000,"phy":"platform/soc/c000000.wifi"}},)"
+			R"({{"channel":36,"channel_width":"80","tx_power":23,"noise":-98,"active_ms":86400000,"busy_ms":17280000,"receive_ms":8640000,"transmit_ms":4320000,"phy":"platform/soc/c000000.wifi+1"}}],)"
+			R"("interfaces":[{{"name":"up0v0","uptime":86400,"ipv4":{{"addresses":["10.0.0.2/24"],"leasetime":43200}},)"
+			R"("counters":{{"collisions":0,"multicast":1234,"rx_bytes":123456789,"rx_dropped":0,"rx_errors":0,"rx_packets":234567,"tx_bytes":987654321,"tx_dropped":0,"tx_errors":0,"tx_packets":345678}},)"
+			R"("ssids":[{{"bssid":"{}","iface":"wlan1","mode":"ap","ssid":"OpenWifi","phy":"platform/soc/c000000.wifi+1","radio":{{"$ref":"#/radios/1"}},"associations":[{}]}}]}}]}})",
+			MAC(Serial + 16), Associations);
+
+		LogText_ = "daemon.notice hostapd: wlan1: STA " + MAC(Serial + 32) + " IEEE 802.11: associated ";
+		while(LogText_.size() < Config_.LogSize)
+			LogText_ += "(simulated log line padding) ";
+		LogText_.resize(std::max((std::size_t)Config_.LogSize, (std::size_t)1));
+
+		NextConnect_ = Clock::now();
+	}
+
+	Clock::time_point Device::Jitter(TimePoint Now, uint64_t Interval) {
+		if(Interval==0)
+			return TimePoint::max();
+		//	spread the first message over a whole interval so the devices do not all report in lock step
+		std::uniform_int_distribution<uint64_t> Offset(0, Interval * 1000);
+		return Now + std::chrono::milliseconds(Offset(Random_));
+	}
+
+	void Device::Connect(Poco::Net::Context::Ptr Context, TimePoint Now, LatencyMap &Latencies) {
+		try {
+			Poco::Net::HTTPSClientSession	Session(Config_.Host, Config_.Port, Context);
+			Poco::Net::HTTPRequest			Request(Poco::Net::HTTPRequest::HTTP_GET, "/", Poco::Net::HTTPMessage::HTTP_1_1);
+			Poco::Net::HTTPResponse			Response;
+			if(Config_.DeflateWindowBits)
+				Request.set("Sec-WebSocket-Extensions",
+							PerMessageDeflate::Offer((int) Config_.DeflateWindowBits, Config_.DeflateNoContextTakeover));
+			WS_ = std::make_unique<Poco::Net::WebSocket>(Session, Request, Response);
+			Deflater_.reset();
+			PerMessageDeflate::Parameters	Agreed;
+			if(Config_.DeflateWindowBits && PerMessageDeflate::Accept(Response.get("Sec-WebSocket-Extensions", ""), Agreed)) {
+				//	the gateway may lower the window or turn context takeover off, never the other way around
+				Deflater_ = std::make_unique<PerMessageDeflate::Deflater>(std::min(Agreed.ClientMaxWindowBits, (int) Config_.DeflateWindowBits));
+				DeflateReset_ = Agreed.ClientNoContextTakeover;
+			}
+			WS_->setNoDelay(true);
+			WS_->setKeepAlive(true);
+			WS_->setReceiveTimeout(Poco::Timespan(10, 0));
+			Connections_++;
+			auto Connected = Clock::now();
+			Latencies["connect"].Add(Microseconds(Now, Connected));
+
+			AwaitingPong_.clear();
+			Send("connect-event", fmt::format(
+								R"({{"jsonrpc":"2.0","method":"connect","params":{{"serial":"{}","uuid":{},"firmware":"OpenWrt 21.02-SNAPSHOT r16399+120-c67509efd7 / TIP-v2.5.0-simulated","wanip":["10.0.0.2:54322"],"capabilities":{}{}}}}})",
+								Serial_, UUID_, Capabilities_, Config_.ConfigPatch ? R"(,"config_patch":true)" : ""), Connected);
+			NextState_ = Jitter(Connected, Config_.StateInterval);
+			NextHealthCheck_ = Jitter(Connected, Config_.HealthCheckInterval);
+			NextLog_ = Jitter(Connected, Config_.LogInterval);
+			NextPing_ = Jitter(Connected, Config_.PingInterval);
+		} catch (const Poco::Exception &) {
+			Failures_++;
+			Disconnect(Now + RetryDelay);
+		}
+	}
+
+	void Device::Disconnect(TimePoint ReconnectAt) {
+		if(WS_) {
+			try {
+				WS_->shutdown();
+				WS_->close();
+			} catch (...) {
+			}
+			WS_.reset();
+		}
+		AwaitingPong_.clear();
+		NextConnect_ = ReconnectAt;
+	}
+
+	//	every message is followed by a ping: the gateway handles the frames of a connection in order, so the pong
+	//	arrives once the message has been processed, which gives a true round trip per message type
+	void Device::Send(const std::string &Type, const std::string &Message, TimePoint Now) {
+		PayloadBytes_ += Message.size();
+		if(Deflater_ && Deflater_->Deflate(Message.data(), Message.size(), Compressed_, DeflateReset_)) {
+			WS_->sendFrame(Compressed_.data(), (int) Compressed_.size(),
+						   Poco::Net::WebSocket::FRAME_TEXT | PerMessageDeflate::FlagCompressed);
+			WireBytes_ += Compressed_.size();
+		} else {
+			WS_->sendFrame(Message.data(), (int) Message.size(), Poco::Net::WebSocket::FRAME_TEXT);
+			WireBytes_ += Message.size();
+		}
+		WS_->sendFrame("", 0, (int)Poco::Net::WebSocket::FRAME_OP_PING | (int)Poco::Net::WebSocket::FRAME_FLAG_FIN);
+		AwaitingPong_.emplace_back(Type, Now);
+	}
+
+	std::string Device::StateMessage(const std::string &RequestUUID) const {
+		return fmt::format(R"({{"jsonrpc":"2.0","method":"state","params":{{"serial":"{}","uuid":{},"request_uuid":"{}","state":{}}}}})",
+						   Serial_, UUID_, RequestUUID, State_);
+	}
+
+	std::string Device::HealthCheckMessage(const std::string &RequestUUID) const {
+		return fmt::format(R"({{"jsonrpc":"2.0","method":"healthcheck","params":{{"serial":"{}","uuid":{},"request_uuid":"{}","sanity":100,"data":{{}}}}}})",
+						   Serial_, UUID_, RequestUUID);
+	}
+
+	void Device::Service(Poco::Net::Context::Ptr Context, TimePoint Now, LatencyMap &Latencies) {
+		if(!WS_) {
+			if(Now >= NextConnect_)
+				Connect(Context, Now, Latencies);
+			return;
+		}
+		try {
+			if(Now >= NextState_) {
+				Send("state", StateMessage(""), Now);
+				NextState_ = Now + std::chrono::seconds(Config_.StateInterval);
+			}
+			if(Now >= NextHealthCheck_) {
+				Send("healthcheck", HealthCheckMessage(""), Now);
+				NextHealthCheck_ = Now + std::chrono::seconds(Config_.HealthCheckInterval);
+			}
+			if(Now >= NextLog_) {
+				Send("log", fmt::format(R"({{"jsonrpc":"2.0","method":"log","params":{{"serial":"{}","log":"{}","severity":6,"data":{{}}}}}})",
+										Serial_, LogText_), Now);
+				NextLog_ = Now + std::chrono::seconds(Config_.LogInterval);
+			}
+			if(Now >= NextPing_) {
+				Send("ping", fmt::format(R"({{"jsonrpc":"2.0","method":"ping","params":{{"serial":"{}","uuid":{}}}}})", Serial_, UUID_), Now);
+				NextPing_ = Now + std::chrono::seconds(Config_.PingInterval);
+			}
+		} catch (const Poco::Exception &) {
+			Failures_++;
+			Disconnect(Now + RetryDelay);
+		}
+	}
+
+	std::string Device::ScanResult() {
+		std::uniform_int_distribution<int> Signal(-90, -35);
+		std::string Scan;
+		for(int i=0;i<20;i++) {
+			auto Channel = i < 10 ? 1 + (i % 3) * 5 : 36 + (i % 4) * 4;
+			auto Frequency = Channel < 15 ? 2407 + Channel * 5 : 5000 + Channel * 5;
+			auto SSID = fmt::format("Neighbour-{}", i);
+			if(i)
+				Scan += ',';
+			Scan += fmt::format(
+				R"({{"bssid":"{}","ssid":"{}","frequency":{},"channel":{},"signal":{},"tsf":{},"last_seen":{},"capability":1073,)"
+				R"("ies":[{{"type":0,"data":"{}"}},{{"type":1,"data":"{}"}},{{"type":3,"data":"{}"}}]}})",
+				MAC(0x0a0000000000 + i), SSID, Frequency, Channel, Signal(Random_), 1000000 + i, 100 + i,
+				Base64(SSID), Base64(std::string("\x82\x84\x8b\x96\x0c\x12\x18\x24", 8)),
+				Base64(std::string(1, (char)Channel)));
+		}
+		return "[" + Scan + "]";
+	}
+
+	void Device::Answer(const Poco::JSON::Object::Ptr &Request, TimePoint Now, LatencyMap &Latencies) {
+		auto Method = Request->get("method").toString();
+		auto Params = Request->getObject("params");
+
+		Poco::JSON::Object	Result, Status;
+		Status.set("error", 0);
+		Status.set("text", "");
+		Status.set("when", 0);
+		Result.set("serial", Serial_);
+
+		bool Reboot = false;
+		std::string FollowUp, RequestUUID, Type{"rpc-" + Method};
+		if(Method=="configure") {
+			//	a patch only applies to the configuration it was made from
+			if(Params && Params->has("patch")) {
+				Type = "rpc-configure-patch";
+				if(!Config_.ConfigPatch || Params->optValue<uint64_t>("base", 0) != UUID_) {
+					Status.set("error", 2);
+					Status.set("text", "The patch does not apply to the running configuration.");
+				} else if(Params->has("uuid")) {
+					UUID_ = Params->get("uuid");
+				}
+			} else if(Params && Params->has("uuid")) {
+				UUID_ = Params->get("uuid");
+			}
+			Result.set("uuid", UUID_);
+			Result.set("status", Status);
+		} else if(Method=="reboot") {
+			Reboot = true;
+			Result.set("status", Status);
+		} else if(Method=="wifiscan") {
+			//	the gateway decodes the IEs of status.scan, which is where devices put the scan
+			Poco::JSON::Parser	P;
+			Status.set("scan", P.parse(ScanResult()).extract<Poco::JSON::Array::Ptr>());
+			Result.set("status", Status);
+		} else if(Method=="ping") {
+			Result.set("uuid", UUID_);
+			Result.set("deviceUTCTime", (uint64_t) std::chrono::duration_cast<std::chrono::milliseconds>(
+											 std::chrono::system_clock::now().time_since_epoch()).count());
+		} else if(Method=="request") {
+			if(Params) {
+				FollowUp = Params->optValue<std::string>("message", "");
+				RequestUUID = Params->optValue<std::string>("request_uuid", "");
+			}
+			Result.set("status", Status);
+		} else {
+			Status.set("error", 1);
+			Status.set("text", "Command not supported by the simulator.");
+			Result.set("status", Status);
+		}
+
+		Poco::JSON::Object	Answer;
+		Answer.set("jsonrpc", "2.0");
+		Answer.set("id", Request->get("id"));
+		Answer.set("result", Result);
+		std::ostringstream OS;
+		Poco::JSON::Stringifier::condense(Answer, OS);
+		auto Text = OS.str();
+		WS_->sendFrame(Text.data(), (int) Text.size(), Poco::Net::WebSocket::FRAME_TEXT);
+		//	how long the device took to answer, from the moment the command was read
+		Latencies[Type].Add(Microseconds(Now, Clock::now()));
+
+		if(FollowUp=="state")
+			Send("state", StateMessage(RequestUUID), Clock::now());
+		else if(FollowUp=="healthcheck")
+			Send("healthcheck", HealthCheckMessage(RequestUUID), Clock::now());
+
+		if(Reboot)
+			Disconnect(Now + RebootDelay);
+	}
+
+	void Device::OnReadable(TimePoint Now, LatencyMap &Latencies) {
+		try {
+			//	TLS may hold more than one frame once the socket was readable
+			do {
+				Poco::Buffer<char>	Frame(0);
+				int Flags = 0;
+				auto Size = WS_->receiveFrame(Frame, Flags);
+				auto Op = Flags & Poco::Net::WebSocket::FRAME_OP_BITMASK;
+				if(Size==0 && Flags==0) {
+					Disconnect(Now + RetryDelay);
+					return;
+				}
+				switch(Op) {
+					case Poco::Net::WebSocket::FRAME_OP_PONG: {
+						if(!AwaitingPong_.empty()) {
+							Latencies[AwaitingPong_.front().first].Add(Microseconds(AwaitingPong_.front().second, Clock::now()));
+							AwaitingPong_.pop_front();
+						}
+					} break;
+					case Poco::Net::WebSocket::FRAME_OP_PING: {
+						WS_->sendFrame("", 0, (int)Poco::Net::WebSocket::FRAME_OP_PONG | (int)Poco::Net::WebSocket::FRAME_FLAG_FIN);
+					} break;
+					case Poco::Net::WebSocket::FRAME_OP_TEXT: {
+						Poco::JSON::Parser	P;
+						auto Request = P.parse(std::string(Frame.begin(), Frame.size())).extract<Poco::JSON::Object::Ptr>();
+						if(Request->has("method") && Request->has("id"))
+							Answer(Request, Clock::now(), Latencies);
+					} break;
+					case Poco::Net::WebSocket::FRAME_OP_CLOSE: {
+						Disconnect(Now + RetryDelay);
+						return;
+					}
+					default:
+						break;
+				}
+			} while(WS_ && WS_->available() > 0);
+		} catch (const Poco::Exception &) {
+			Failures_++;
+			Disconnect(Now + RetryDelay);
+		}
+	}
+
+	Worker::Worker(const Config &C, Poco::Net::Context::Ptr Context, uint64_t FirstSerial, uint64_t Count, uint64_t Seed) :
+		Config_(C),
+		Context_(std::move(Context)),
+		Random_(Seed) {
+		for(uint64_t i=0;i<Count;i++)
+			Devices_.push_back(std::make_unique<Device>(Config_, FirstSerial + i, Random_));
+	}
+
+	void Worker::Start() {
+		Running_ = true;
+		Thread_ = std::thread([this]() { run(); });
+	}
+
+	void Worker::Stop() {
+		Running_ = false;
+		if(Thread_.joinable())
+			Thread_.join();
+	}
+
+	void Worker::Collect(LatencyMap &L, uint64_t &Connected, uint64_t &Connections, uint64_t &Failures, uint64_t &PayloadBytes,
+						 uint64_t &WireBytes) {
+		std::lock_guard	G(Mutex_);
+		for(const auto &[Type,H]:Latencies_)
+			L[Type].Merge(H);
+		Connected += Connected_;
+		Connections += Connections_;
+		Failures += Failures_;
+		PayloadBytes += PayloadBytes_;
+		WireBytes += WireBytes_;
+	}
+
+	uint64_t Worker::Reconnections() {
+		std::lock_guard	G(Mutex_);
+		return Reconnections_;
+	}
+
+	void Worker::run() {
+		LatencyMap	Pending;
+		std::map<poco_socket_t, Device *>	BySocket;
+		std::uniform_real_distribution<double>	Draw(0.0, 1.0);
+
+		while(Running_) {
+			auto Now = Clock::now();
+			if(StormRequested_.exchange(false)) {
+				for(auto &D:Devices_)
+					if(D->Connected() && Draw(Random_) < Config_.StormFraction)
+						D->Disconnect(Now);
+			}
+			for(auto &D:Devices_)
+				D->Service(Context_, Now, Pending);
+
+			Poco::Net::Socket::SocketList	Readable, Writable, Errors;
+			BySocket.clear();
+			for(auto &D:Devices_) {
+				if(D->Socket()) {
+					Readable.push_back(*D->Socket());
+					BySocket[D->Socket()->impl()->sockfd()] = D.get();
+				}
+			}
+			if(Readable.empty()) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			} else {
+				Poco::Net::Socket::select(Readable, Writable, Errors, Poco::Timespan(0, 20000));
+				Now = Clock::now();
+				for(auto &S:Readable) {
+					auto Hint = BySocket.find(S.impl()->sockfd());
+					if(Hint!=BySocket.end() && Hint->second->Connected())
+						Hint->second->OnReadable(Now, Pending);
+				}
+			}
+
+			uint64_t Connected=0, Connections=0, Failures=0, Reconnections=0, PayloadBytes=0, WireBytes=0;
+			for(auto &D:Devices_) {
+				Connected += D->Connected();
+				Connections += D->Connections();
+				Failures += D->Failures();
+				Reconnections += D->Connections() ? D->Connections() - 1 : 0;
+				PayloadBytes += D->PayloadBytes();
+				WireBytes += D->WireBytes();
+			}
+			std::lock_guard	G(Mutex_);
+			for(auto &[Type,H]:Pending)
+				Latencies_[Type].Merge(H);
+			Pending.clear();
+			Connected_ = Connected;
+			Connections_ = Connections;
+			Failures_ = Failures;
+			Reconnections_ = Reconnections;
+			PayloadBytes_ = PayloadBytes;
+			WireBytes_ = WireBytes;
+		}
+
+		for(auto &D:Devices_)
+			D->Disconnect(TimePoint::max());
+	}
+
+	Simulator::Simulator(Config C) :
+		Config_(std::move(C)) {
+	}
+
+	int Simulator::Run() {
+		Poco::Net::Context::Ptr Context = new Poco::Net::Context(
+			Poco::Net::Context::TLS_CLIENT_USE, Config_.KeyFile, Config_.CertFile, Config_.RootCA,
+			Config_.RootCA.empty() ? Poco::Net::Context::VERIFY_NONE : Poco::Net::Context::VERIFY_RELAXED);
+
+		auto Threads = std::max((uint64_t)1, std::min(Config_.Threads, Config_.Devices));
+		uint64_t Next = Config_.SerialBase;
+		for(uint64_t i=0;i<Threads;i++) {
+			auto Count = Config_.Devices / Threads + (i < Config_.Devices % Threads ? 1 : 0);
+			Workers_.push_back(std::make_unique<Worker>(Config_, Context, Next, Count, Next));
+			Next += Count;
+		}
+
+		std::cout << fmt::format("Simulating {} devices ({:012x} to {:012x}) against {}:{} with {} threads.",
+								 Config_.Devices, Config_.SerialBase, Next - 1, Config_.Host, Config_.Port, Threads) << std::endl;
+
+		for(auto &W:Workers_)
+			W->Start();
+
+		auto Start = Clock::now();
+		auto NextReport = Start + std::chrono::seconds(Config_.ReportInterval);
+		auto NextStorm = Config_.StormInterval ? Start + std::chrono::seconds(Config_.StormInterval) : TimePoint::max();
+		auto NextSample = Start + std::chrono::seconds(1);
+		uint64_t LastReconnections = 0;
+		while(Running_) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(250));
+			auto Now = Clock::now();
+			if(Now >= NextSample) {
+				//	how hard a storm or a gateway restart hits the gateway
+				uint64_t Reconnections = 0;
+				for(auto &W:Workers_)
+					Reconnections += W->Reconnections();
+				PeakReconnectRate_ = std::max(PeakReconnectRate_, Reconnections - LastReconnections);
+				LastReconnections = Reconnections;
+				NextSample += std::chrono::seconds(1);
+			}
+			auto Elapsed = (uint64_t) std::chrono::duration_cast<std::chrono::seconds>(Now - Start).count();
+			if(Config_.Duration && Elapsed >= Config_.Duration)
+				break;
+			if(Config_.ReportInterval && Now >= NextReport) {
+				Report(false, Elapsed);
+				NextReport = Now + std::chrono::seconds(Config_.ReportInterval);
+			}
+			if(Now >= NextStorm) {
+				std::cout << "Reconnect storm." << std::endl;
+				for(auto &W:Workers_)
+					W->Storm();
+				NextStorm = Now + std::chrono::seconds(Config_.StormInterval);
+			}
+		}
+
+		for(auto &W:Workers_)
+			W->Stop();
+		Report(true, (uint64_t) std::chrono::duration_cast<std::chrono::seconds>(Clock::now() - Start).count());
+		return 0;
+	}
+
+	void Simulator::Report(bool Final, uint64_t Elapsed) {
+		LatencyMap	Latencies;
+		uint64_t Connected=0, Connections=0, Failures=0, PayloadBytes=0, WireBytes=0;
+		for(auto &W:Workers_)
+			W->Collect(Latencies, Connected, Connections, Failures, PayloadBytes, WireBytes);
+
+		std::cout << fmt::format("{}s: {} connected, {} connections, {} failures, peak of {} reconnections/s", Elapsed,
+								 Connected, Connections, Failures, PeakReconnectRate_) << std::endl;
+		std::cout << fmt::format("  {} bytes of messages sent as {} bytes ({:.1f}%)", PayloadBytes, WireBytes,
+								 PayloadBytes ? 100.0 * (double) WireBytes / (double) PayloadBytes : 100.0) << std::endl;
+		std::cout << fmt::format("  {:<20} {:>10} {:>10} {:>10} {:>10} {:>10} {:>10}", "type", "count", "mean(ms)", "p50(ms)", "p90(ms)", "p99(ms)", "max(ms)") << std::endl;
+		for(const auto &[Type,H]:Latencies) {
+			std::cout << fmt::format("  {:<20} {:>10} {:>10.3f} {:>10.3f} {:>10.3f} {:>10.3f} {:>10.3f}", Type, H.Count(),
+									 H.Mean() / 1000.0, H.Percentile(50) / 1000.0, H.Percentile(90) / 1000.0,
+									 H.Percentile(99) / 1000.0, H.Max() / 1000.0) << std::endl;
+		}
+
+		if(!Final || Config_.JSONReport.empty())
+			return;
+
+		Poco::JSON::Object	Report, Types;
+		Report.set("devices", Config_.Devices);
+		Report.set("seconds", Elapsed);
+		Report.set("connections", Connections);
+		Report.set("failures", Failures);
+		Report.set("peakReconnectRate", PeakReconnectRate_);
+		Report.set("payloadBytes", PayloadBytes);
+		Report.set("wireBytes", WireBytes);
+		for(const auto &[Type,H]:Latencies) {
+			Poco::JSON::Object	Entry;
+			Entry.set("count", H.Count());
+			Entry.set("minUs", H.Min());
+			Entry.set("meanUs", H.Mean());
+			Entry.set("p50Us", H.Percentile(50));
+			Entry.set("p90Us", H.Percentile(90));
+			Entry.set("p99Us", H.Percentile(99));
+			Entry.set("maxUs", H.Max());
+			Types.set(Type, Entry);
+		}
+		Report.set("latencies", Types);
+		std::ofstream	OF(Config_.JSONReport, std::ios::trunc);
+		Poco::JSON::Stringifier::stringify(Report, OF, 2);
+	}
+}
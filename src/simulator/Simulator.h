@@ -0,0 +1,183 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Poco/JSON/Object.h"
+#include "Poco/Net/Context.h"
+#include "Poco/Net/WebSocket.h"
+
+#include "../PerMessageDeflate.h"
+
+namespace OpenWifi::Simulator {
+
+	typedef std::chrono::steady_clock		Clock;
+	typedef Clock::time_point				TimePoint;
+
+	struct Config {
+		std::string		Host{"localhost"};
+		uint16_t		Port = 15002;
+		std::string		CertFile, KeyFile, RootCA;
+		uint64_t		Devices = 10;
+		uint64_t		Threads = 4;
+		uint64_t		SerialBase = 0x53494d000000;	//	the gateway only lets simulator serial numbers in with a simulator certificate
+		uint64_t		Duration = 60;					//	seconds, 0 runs until interrupted
+		uint64_t		StateInterval = 60;				//	seconds between messages of each type for every device, 0 never sends it
+		uint64_t		HealthCheckInterval = 60;
+		uint64_t		LogInterval = 0;
+		uint64_t		PingInterval = 0;
+		uint64_t		StateSize = 4000;				//	approximate payload sizes, in bytes
+		uint64_t		LogSize = 200;
+		uint64_t		StormInterval = 0;				//	seconds between reconnect storms, 0 never
+		double			StormFraction = 0.5;			//	share of the connected devices dropped by each storm
+		uint64_t		DeflateWindowBits = 0;			//	offers permessage-deflate with this client window, 0 sends uncompressed
+		bool			DeflateNoContextTakeover = false;	//	compress every message on its own
+		bool			ConfigPatch = false;			//	advertises config_patch, and checks the base of the patches received
+		uint64_t		ReportInterval = 10;
+		std::string		JSONReport;						//	file receiving the final report, empty for none
+	};
+
+	//	Log-linear latency histogram in microseconds: 8 sub buckets per power of two, so percentiles are within 12.5%.
+	class LatencyHistogram {
+	  public:
+		inline void Add(uint64_t Us) {
+			Buckets_[Bucket(Us)]++;
+			Count_++;
+			Sum_ += Us;
+			Min_ = std::min(Min_, Us);
+			Max_ = std::max(Max_, Us);
+		}
+
+		inline void Merge(const LatencyHistogram &H) {
+			for(std::size_t i=0;i<Buckets_.size();i++)
+				Buckets_[i] += H.Buckets_[i];
+			Count_ += H.Count_;
+			Sum_ += H.Sum_;
+			Min_ = std::min(Min_, H.Min_);
+			Max_ = std::max(Max_, H.Max_);
+		}
+
+		[[nodiscard]] uint64_t Percentile(double P) const;
+		[[nodiscard]] inline uint64_t Count() const { return Count_; }
+		[[nodiscard]] inline uint64_t Min() const { return Count_ ? Min_ : 0; }
+		[[nodiscard]] inline uint64_t Max() const { return Max_; }
+		[[nodiscard]] inline uint64_t Mean() const { return Count_ ? Sum_ / Count_ : 0; }
+
+	  private:
+		static constexpr std::size_t SubBuckets = 8;
+		std::array<uint64_t, 64 * SubBuckets>	Buckets_{};
+		uint64_t	Count_ = 0, Sum_ = 0, Min_ = UINT64_MAX, Max_ = 0;
+
+		static std::size_t Bucket(uint64_t Us);
+		static uint64_t BucketValue(std::size_t Bucket);
+	};
+
+	typedef std::map<std::string, LatencyHistogram>	LatencyMap;
+
+	//	One simulated access point: its connection, its message schedule and its answers to gateway commands.
+	class Device {
+	  public:
+		Device(const Config &C, uint64_t Serial, std::mt19937_64 &Random);
+
+		//	connect when due and send every message that is due
+		void Service(Poco::Net::Context::Ptr Context, TimePoint Now, LatencyMap &Latencies);
+		void OnReadable(TimePoint Now, LatencyMap &Latencies);
+		void Disconnect(TimePoint ReconnectAt);
+
+		[[nodiscard]] inline Poco::Net::WebSocket * Socket() { return WS_.get(); }
+		[[nodiscard]] inline bool Connected() const { return WS_ != nullptr; }
+		[[nodiscard]] inline uint64_t Connections() const { return Connections_; }
+		[[nodiscard]] inline uint64_t Failures() const { return Failures_; }
+		[[nodiscard]] inline uint64_t PayloadBytes() const { return PayloadBytes_; }
+		[[nodiscard]] inline uint64_t WireBytes() const { return WireBytes_; }
+
+	  private:
+		const Config 							&Config_;
+		std::string 							Serial_;
+		uint64_t 								UUID_;
+		std::string 							Capabilities_;
+		std::string 							State_;
+		std::string 							LogText_;
+		std::unique_ptr<Poco::Net::WebSocket>	WS_;
+		std::deque<std::pair<std::string, TimePoint>>	AwaitingPong_;
+		TimePoint 								NextConnect_, NextState_, NextHealthCheck_, NextLog_, NextPing_;
+		uint64_t 								Connections_ = 0, Failures_ = 0;
+		uint64_t 								PayloadBytes_ = 0, WireBytes_ = 0;	//	messages sent, before and after compression
+		std::unique_ptr<PerMessageDeflate::Deflater>	Deflater_;		//	set while permessage-deflate is agreed
+		bool 									DeflateReset_ = false;
+		std::string 							Compressed_;
+		std::mt19937_64 						&Random_;
+
+		void Connect(Poco::Net::Context::Ptr Context, TimePoint Now, LatencyMap &Latencies);
+		void Send(const std::string &Type, const std::string &Message, TimePoint Now);
+		void Answer(const Poco::JSON::Object::Ptr &Request, TimePoint Now, LatencyMap &Latencies);
+		std::string StateMessage(const std::string &RequestUUID) const;
+		std::string HealthCheckMessage(const std::string &RequestUUID) const;
+		std::string ScanResult();
+		TimePoint Jitter(TimePoint Now, uint64_t Interval);
+	};
+
+	//	A thread driving a share of the devices: it polls their sockets and services their schedules.
+	class Worker {
+	  public:
+		Worker(const Config &C, Poco::Net::Context::Ptr Context, uint64_t FirstSerial, uint64_t Count, uint64_t Seed);
+
+		void Start();
+		void Stop();
+		inline void Storm() { StormRequested_ = true; }
+
+		//	adds this worker's latencies to L
+		void Collect(LatencyMap &L, uint64_t &Connected, uint64_t &Connections, uint64_t &Failures, uint64_t &PayloadBytes,
+					 uint64_t &WireBytes);
+		//	connections made after a device's first one
+		[[nodiscard]] uint64_t Reconnections();
+
+	  private:
+		const Config 				&Config_;
+		Poco::Net::Context::Ptr		Context_;
+		std::mt19937_64				Random_;
+		std::vector<std::unique_ptr<Device>>	Devices_;
+		std::thread 				Thread_;
+		std::atomic_bool 			Running_ = false;
+		std::atomic_bool 			StormRequested_ = false;
+		std::mutex 					Mutex_;			//	protects Latencies_ and the device counters read by Collect
+		LatencyMap 					Latencies_;
+		uint64_t 					Connected_ = 0, Connections_ = 0, Failures_ = 0, Reconnections_ = 0;
+		uint64_t 					PayloadBytes_ = 0, WireBytes_ = 0;
+
+		void run();
+	};
+
+	class Simulator {
+	  public:
+		explicit Simulator(Config C);
+
+		//	returns once Duration has elapsed or Stop() was called
+		int Run();
+		inline void Stop() { Running_ = false; }
+
+	  private:
+		Config 										Config_;
+		std::vector<std::unique_ptr<Worker>>		Workers_;
+		std::atomic_bool 							Running_ = true;
+		uint64_t 									PeakReconnectRate_ = 0;		//	most reconnections in one second
+
+		void Report(bool Final, uint64_t Elapsed);
+	};
+}
@@ -0,0 +1,105 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#include <csignal>
+#include <iostream>
+
+#include "Poco/Net/SSLManager.h"
+#include "Poco/Util/Application.h"
+#include "Poco/Util/HelpFormatter.h"
+#include "Poco/Util/Option.h"
+#include "Poco/Util/OptionSet.h"
+
+#include "Replay.h"
+
+namespace OpenWifi::Simulator {
+
+	static Replay *Running = nullptr;
+
+	static void OnSignal(int) {
+		if(Running)
+			Running->Stop();
+	}
+
+	class ReplayApp : public Poco::Util::Application {
+	  protected:
+		void defineOptions(Poco::Util::OptionSet &Options) override {
+			Application::defineOptions(Options);
+			Options.addOption(Poco::Util::Option("help", "h", "display this help.").required(false).repeatable(false)
+								  .callback(Poco::Util::OptionCallback<ReplayApp>(this, &ReplayApp::HandleHelp)));
+			auto Add = [&](const std::string &Name, const std::string &Description, const std::string &Argument) {
+				Options.addOption(Poco::Util::Option(Name, "", Description).required(false).repeatable(false)
+									  .argument(Argument).binding("replay." + Name));
+			};
+			Add("host", "gateway host name (localhost).", "host");
+			Add("port", "gateway device port (15002).", "port");
+			Add("cert", "client certificate, a simulator certificate for anonymized captures.", "file");
+			Add("key", "client key.", "file");
+			Add("rootca", "CA used to check the gateway certificate, not checked if omitted.", "file");
+			Add("speed", "1 replays at the captured pace, 10 ten times faster, 0 as fast as possible (1).", "factor");
+			Add("threads", "number of threads driving the connections (4).", "count");
+			Add("report", "seconds between reports (10).", "seconds");
+			Add("json", "file receiving the final report as JSON.", "file");
+		}
+
+		void HandleHelp([[maybe_unused]] const std::string &Name, [[maybe_unused]] const std::string &Value) {
+			Poco::Util::HelpFormatter Help(options());
+			Help.setCommand(commandName());
+			Help.setUsage("OPTIONS capture-file-or-directory...");
+			Help.setHeader("Replays device traffic captured by a gateway (openwifi.capture.enable) against a gateway.");
+			Help.format(std::cout);
+			stopOptionsProcessing();
+			HelpRequested_ = true;
+		}
+
+		int main(const std::vector<std::string> &Args) override {
+			if(HelpRequested_)
+				return EXIT_OK;
+
+			auto &C = config();
+			ReplayConfig	Settings;
+			Settings.Host = C.getString("replay.host", Settings.Host);
+			Settings.Port = (uint16_t) C.getUInt("replay.port", Settings.Port);
+			Settings.CertFile = C.getString("replay.cert", "");
+			Settings.KeyFile = C.getString("replay.key", "");
+			Settings.RootCA = C.getString("replay.rootca", "");
+			Settings.Speed = C.getDouble("replay.speed", Settings.Speed);
+			Settings.Threads = C.getUInt64("replay.threads", Settings.Threads);
+			Settings.ReportInterval = C.getUInt64("replay.report", Settings.ReportInterval);
+			Settings.JSONReport = C.getString("replay.json", "");
+			Settings.Captures = Args;
+
+			if(Settings.CertFile.empty() || Settings.KeyFile.empty()) {
+				std::cerr << "A client certificate and key are required (--cert, --key)." << std::endl;
+				return EXIT_USAGE;
+			}
+			if(Settings.Captures.empty()) {
+				std::cerr << "No capture file or directory given." << std::endl;
+				return EXIT_USAGE;
+			}
+
+			Poco::Net::initializeSSL();
+			int Result;
+			{
+				Replay	R(Settings);
+				Running = &R;
+				std::signal(SIGINT, OnSignal);
+				std::signal(SIGTERM, OnSignal);
+				std::signal(SIGPIPE, SIG_IGN);
+				Result = R.Run();
+				Running = nullptr;
+			}
+			Poco::Net::uninitializeSSL();
+			return Result ? EXIT_DATAERR : EXIT_OK;
+		}
+
+	  private:
+		bool 	HelpRequested_ = false;
+	};
+}
+
+POCO_APP_MAIN(OpenWifi::Simulator::ReplayApp)
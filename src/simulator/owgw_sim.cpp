@@ -0,0 +1,132 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#include <csignal>
+#include <iostream>
+
+#include "Poco/Net/SSLManager.h"
+#include "Poco/Util/Application.h"
+#include "Poco/Util/HelpFormatter.h"
+#include "Poco/Util/Option.h"
+#include "Poco/Util/OptionSet.h"
+
+#include "Simulator.h"
+
+namespace OpenWifi::Simulator {
+
+	static Simulator *Running = nullptr;
+
+	static void OnSignal(int) {
+		if(Running)
+			Running->Stop();
+	}
+
+	class SimulatorApp : public Poco::Util::Application {
+	  protected:
+		void defineOptions(Poco::Util::OptionSet &Options) override {
+			Application::defineOptions(Options);
+			Options.addOption(Poco::Util::Option("help", "h", "display this help.").required(false).repeatable(false)
+								  .callback(Poco::Util::OptionCallback<SimulatorApp>(this, &SimulatorApp::HandleHelp)));
+			auto Add = [&](const std::string &Name, const std::string &Description, const std::string &Argument) {
+				Options.addOption(Poco::Util::Option(Name, "", Description).required(false).repeatable(false)
+									  .argument(Argument).binding("simulator." + Name));
+			};
+			Add("host", "gateway host name (localhost).", "host");
+			Add("port", "gateway device port (15002).", "port");
+			Add("cert", "simulator client certificate, its CN must be the gateway's simulatorid.", "file");
+			Add("key", "simulator client key.", "file");
+			Add("rootca", "CA used to check the gateway certificate, not checked if omitted.", "file");
+			Add("devices", "number of simulated devices (10).", "count");
+			Add("threads", "number of threads driving the devices (4).", "count");
+			Add("serialbase", "first serial number, in hex (53494d000000).", "serial");
+			Add("duration", "seconds to run, 0 until interrupted (60).", "seconds");
+			Add("state", "seconds between state messages of a device, 0 for none (60).", "seconds");
+			Add("healthcheck", "seconds between healthcheck messages of a device, 0 for none (60).", "seconds");
+			Add("log", "seconds between log messages of a device, 0 for none (0).", "seconds");
+			Add("ping", "seconds between ping messages of a device, 0 for none (0).", "seconds");
+			Add("statesize", "approximate size of a state message in bytes (4000).", "bytes");
+			Add("logsize", "size of a log line in bytes (200).", "bytes");
+			Add("storm", "seconds between reconnect storms, 0 for none (0).", "seconds");
+			Add("stormfraction", "share of the devices dropped by a storm (0.5).", "fraction");
+			Add("deflate", "offer permessage-deflate with this window size in bits, 9 to 15, 0 to send uncompressed (0).", "bits");
+			Add("deflatenocontext", "with --deflate, compress every message on its own: 0 or 1 (0).", "flag");
+			Add("configpatch", "tell the gateway the devices accept configurations as patches: 0 or 1 (0).", "flag");
+			Add("report", "seconds between reports (10).", "seconds");
+			Add("json", "file receiving the final report as JSON.", "file");
+		}
+
+		void HandleHelp([[maybe_unused]] const std::string &Name, [[maybe_unused]] const std::string &Value) {
+			Poco::Util::HelpFormatter Help(options());
+			Help.setCommand(commandName());
+			Help.setUsage("OPTIONS");
+			Help.setHeader("Simulates a fleet of uCentral access points connecting to a gateway.");
+			Help.format(std::cout);
+			stopOptionsProcessing();
+			HelpRequested_ = true;
+		}
+
+		int main([[maybe_unused]] const std::vector<std::string> &Args) override {
+			if(HelpRequested_)
+				return EXIT_OK;
+
+			auto &C = config();
+			Config	Settings;
+			Settings.Host = C.getString("simulator.host", Settings.Host);
+			Settings.Port = (uint16_t) C.getUInt("simulator.port", Settings.Port);
+			Settings.CertFile = C.getString("simulator.cert", "");
+			Settings.KeyFile = C.getString("simulator.key", "");
+			Settings.RootCA = C.getString("simulator.rootca", "");
+			Settings.Devices = C.getUInt64("simulator.devices", Settings.Devices);
+			Settings.Threads = C.getUInt64("simulator.threads", Settings.Threads);
+			Settings.SerialBase = std::stoull(C.getString("simulator.serialbase", "53494d000000"), nullptr, 16);
+			Settings.Duration = C.getUInt64("simulator.duration", Settings.Duration);
+			Settings.StateInterval = C.getUInt64("simulator.state", Settings.StateInterval);
+			Settings.HealthCheckInterval = C.getUInt64("simulator.healthcheck", Settings.HealthCheckInterval);
+			Settings.LogInterval = C.getUInt64("simulator.log", Settings.LogInterval);
+			Settings.PingInterval = C.getUInt64("simulator.ping", Settings.PingInterval);
+			Settings.StateSize = C.getUInt64("simulator.statesize", Settings.StateSize);
+			Settings.LogSize = C.getUInt64("simulator.logsize", Settings.LogSize);
+			Settings.StormInterval = C.getUInt64("simulator.storm", Settings.StormInterval);
+			Settings.StormFraction = C.getDouble("simulator.stormfraction", Settings.StormFraction);
+			Settings.DeflateWindowBits = C.getUInt64("simulator.deflate", Settings.DeflateWindowBits);
+			Settings.DeflateNoContextTakeover = C.getBool("simulator.deflatenocontext", Settings.DeflateNoContextTakeover);
+			Settings.ConfigPatch = C.getBool("simulator.configpatch", Settings.ConfigPatch);
+			Settings.ReportInterval = C.getUInt64("simulator.report", Settings.ReportInterval);
+			Settings.JSONReport = C.getString("simulator.json", "");
+
+			if(Settings.DeflateWindowBits && (Settings.DeflateWindowBits < PerMessageDeflate::MinWindowBits ||
+											  Settings.DeflateWindowBits > PerMessageDeflate::MaxWindowBits)) {
+				std::cerr << "--deflate takes a window size of 9 to 15 bits." << std::endl;
+				return EXIT_USAGE;
+			}
+
+			if(Settings.CertFile.empty() || Settings.KeyFile.empty()) {
+				std::cerr << "A simulator certificate and key are required (--cert, --key)." << std::endl;
+				return EXIT_USAGE;
+			}
+
+			Poco::Net::initializeSSL();
+			int Result;
+			{
+				Simulator	Sim(Settings);
+				Running = &Sim;
+				std::signal(SIGINT, OnSignal);
+				std::signal(SIGTERM, OnSignal);
+				std::signal(SIGPIPE, SIG_IGN);
+				Result = Sim.Run();
+				Running = nullptr;
+			}
+			Poco::Net::uninitializeSSL();
+			return Result;
+		}
+
+	  private:
+		bool 	HelpRequested_ = false;
+	};
+}
+
+POCO_APP_MAIN(OpenWifi::Simulator::SimulatorApp)
@@ -55,8 +55,107 @@ namespace OpenWifi {
 		R.set<3>(D.author);
 	}
 
-	static std::set<std::string>	BlackListDevices;
-	static std::recursive_mutex		BlackListMutex;
+	//	The black list is read on every device connection and almost never changes. Readers see an immutable snapshot,
+	//	replaced as a whole on every change, behind a bloom filter: the common "not black listed" answer only reads a
+	//	few atomic words, with no lock and no allocation. Hex serial numbers of up to 15 digits are keyed by their value
+	//	with their length in the top 4 bits, so "00abc" and "abc" stay apart; any other serial number is kept as a
+	//	string.
+	struct BlackListSnapshot {
+		std::vector<uint64_t>		Serials;
+		std::vector<std::string>	Others;
+
+		[[nodiscard]] inline std::size_t size() const { return Serials.size() + Others.size(); }
+	};
+
+	static constexpr std::size_t	BlackListBloomBits = 1 << 18;
+	static constexpr std::size_t	BlackListBloomWords = BlackListBloomBits / 64;
+	static std::array<std::atomic_uint64_t,BlackListBloomWords>	BlackListBloom;
+	static std::shared_ptr<const BlackListSnapshot>	BlackListDevices = std::make_shared<BlackListSnapshot>();
+	static std::mutex		BlackListMutex;		//	serializes writers only
+
+	static inline bool BlackListKey(const std::string &SerialNumber, uint64_t &Key) {
+		if(SerialNumber.empty() || SerialNumber.size()>15)
+			return false;
+		Key = 0;
+		for(auto c:SerialNumber) {
+			if(c>='0' && c<='9')
+				Key = (Key << 4) | (c - '0');
+			else if(c>='a' && c<='f')
+				Key = (Key << 4) | (c - 'a' + 10);
+			else if(c>='A' && c<='F')
+				Key = (Key << 4) | (c - 'A' + 10);
+			else
+				return false;
+		}
+		Key |= (uint64_t) SerialNumber.size() << 60;
+		return true;
+	}
+
+	static inline uint64_t BlackListBloomKey(const std::string &SerialNumber) {
+		uint64_t Key;
+		if(BlackListKey(SerialNumber,Key))
+			return Key;
+		Key = 14695981039346656037ULL;
+		for(auto c:SerialNumber) {
+			Key ^= (unsigned char) std::tolower(c);
+			Key *= 1099511628211ULL;
+		}
+		return Key;
+	}
+
+	//	three probes derived from one splitmix64 mix of the key
+	template <typename F> static inline void BlackListProbes(uint64_t Key, F f) {
+		Key += 0x9e3779b97f4a7c15ULL;
+		Key = (Key ^ (Key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		Key = (Key ^ (Key >> 27)) * 0x94d049bb133111ebULL;
+		Key ^= Key >> 31;
+		for(auto i=0;i<3;i++) {
+			auto Bit = (Key >> (i*21)) & (BlackListBloomBits-1);
+			f(Bit / 64, 1ULL << (Bit % 64));
+		}
+	}
+
+	//	Must be called with BlackListMutex held. The new bits are ORed into the filter before the snapshot is published,
+	//	so whichever snapshot a reader gets, the filter already holds its members. The bits of removed members are only
+	//	dropped once the new snapshot is out. A racing reader can see a stale positive but never miss a member.
+	static void PublishBlackList(std::shared_ptr<BlackListSnapshot> Snapshot) {
+		std::sort(Snapshot->Serials.begin(),Snapshot->Serials.end());
+		Snapshot->Serials.erase(std::unique(Snapshot->Serials.begin(),Snapshot->Serials.end()),Snapshot->Serials.end());
+		std::sort(Snapshot->Others.begin(),Snapshot->Others.end());
+		Snapshot->Others.erase(std::unique(Snapshot->Others.begin(),Snapshot->Others.end()),Snapshot->Others.end());
+
+		std::vector<uint64_t>	Bloom(BlackListBloomWords,0);
+		auto Set = [&](std::size_t Word, uint64_t Mask) { Bloom[Word] |= Mask; };
+		for(const auto &Serial:Snapshot->Serials)
+			BlackListProbes(Serial,Set);
+		for(const auto &Serial:Snapshot->Others)
+			BlackListProbes(BlackListBloomKey(Serial),Set);
+
+		for(std::size_t i=0;i<BlackListBloomWords;i++)
+			BlackListBloom[i].fetch_or(Bloom[i],std::memory_order_release);
+		std::atomic_store(&BlackListDevices, std::shared_ptr<const BlackListSnapshot>(std::move(Snapshot)));
+		for(std::size_t i=0;i<BlackListBloomWords;i++)
+			BlackListBloom[i].store(Bloom[i],std::memory_order_release);
+	}
+
+	static void ChangeBlackList(const std::string &SerialNumber, bool Add) {
+		std::lock_guard	G(BlackListMutex);
+		auto Snapshot = std::make_shared<BlackListSnapshot>(*std::atomic_load(&BlackListDevices));
+		uint64_t Key;
+		if(BlackListKey(SerialNumber,Key)) {
+			if(Add)
+				Snapshot->Serials.push_back(Key);
+			else
+				Snapshot->Serials.erase(std::remove(Snapshot->Serials.begin(),Snapshot->Serials.end(),Key),Snapshot->Serials.end());
+		} else {
+			auto Serial = Poco::toLower(SerialNumber);
+			if(Add)
+				Snapshot->Others.push_back(Serial);
+			else
+				Snapshot->Others.erase(std::remove(Snapshot->Others.begin(),Snapshot->Others.end(),Serial),Snapshot->Others.end());
+		}
+		PublishBlackList(Snapshot);
+	}
 
 	bool Storage::InitializeBlackListCache() {
 		try {
@@ -68,12 +167,19 @@ namespace OpenWifi {
 
 			Poco::Data::RecordSet   RSet(Select);
 
+			auto Snapshot = std::make_shared<BlackListSnapshot>();
 			bool More = RSet.moveFirst();
 			while(More) {
 				auto SerialNumber = RSet[0].convert<std::string>();
-				BlackListDevices.insert(SerialNumber);
+				uint64_t Key;
+				if(BlackListKey(SerialNumber,Key))
+					Snapshot->Serials.push_back(Key);
+				else
+					Snapshot->Others.push_back(Poco::toLower(SerialNumber));
 				More = RSet.moveNext();
 			}
+			std::lock_guard	G(BlackListMutex);
+			PublishBlackList(Snapshot);
 			return true;
 		} catch(const Poco::Exception &E) {
 			Logger().warning(fmt::format("{}: Failed with: {}", std::string(__func__), E.displayText()));
@@ -81,8 +187,23 @@ namespace OpenWifi {
 		return false;
 	}
 
+	void Storage::GetBlackListCache(std::vector<uint64_t> &Serials, std::vector<std::string> &Others) {
+		auto Snapshot = std::atomic_load(&BlackListDevices);
+		Serials = Snapshot->Serials;
+		Others = Snapshot->Others;
+	}
+
+	void Storage::SetBlackListCache(std::vector<uint64_t> Serials, std::vector<std::string> Others) {
+		auto Snapshot = std::make_shared<BlackListSnapshot>();
+		Snapshot->Serials = std::move(Serials);
+		Snapshot->Others = std::move(Others);
+		std::lock_guard	G(BlackListMutex);
+		PublishBlackList(Snapshot);
+	}
+
 	bool Storage::AddBlackListDevice(GWObjects::BlackListedDevice &  Device) {
 		try {
+			std::shared_lock	CacheGuard(CacheMutex_);
 			Poco::Data::Session Sess = Pool_->get();
 			Poco::Data::Statement Insert(Sess);
 
@@ -94,8 +215,8 @@ namespace OpenWifi {
 				Poco::Data::Keywords::use(T);
 			Insert.execute();
 
-			std::lock_guard	G(BlackListMutex);
-			BlackListDevices.insert(Device.serialNumber);
+			ChangeBlackList(Device.serialNumber,true);
+			BumpCacheGeneration();
 
 			return true;
 		} catch (const Poco::Exception &E) {
@@ -118,6 +239,7 @@ namespace OpenWifi {
 
 	bool Storage::DeleteBlackListDevice(std::string &SerialNumber) {
 		try {
+			std::shared_lock	CacheGuard(CacheMutex_);
 			Poco::Data::Session Sess = Pool_->get();
 			Poco::Data::Statement Delete(Sess);
 
@@ -128,8 +250,8 @@ namespace OpenWifi {
 				Poco::Data::Keywords::use(SerialNumber);
 			Delete.execute();
 
-			std::lock_guard	G(BlackListMutex);
-			BlackListDevices.erase(SerialNumber);
+			ChangeBlackList(SerialNumber,false);
+			BumpCacheGeneration();
 			return true;
 		} catch (const Poco::Exception &E) {
 			Logger().warning(fmt::format("{}: Failed with: {}", std::string(__func__), E.displayText()));
@@ -208,12 +330,21 @@ namespace OpenWifi {
 	}
 
 	uint64_t Storage::GetBlackListDeviceCount() {
-		std::lock_guard	G(BlackListMutex);
-		return BlackListDevices.size();
+		return std::atomic_load(&BlackListDevices)->size();
 	}
 
 	bool Storage::IsBlackListed(std::string &SerialNumber) {
-		std::lock_guard	G(BlackListMutex);
-		return BlackListDevices.find(SerialNumber) != BlackListDevices.end();
+		bool Candidate = true;
+		BlackListProbes(BlackListBloomKey(SerialNumber), [&](std::size_t Word, uint64_t Mask) {
+			Candidate = Candidate && (BlackListBloom[Word].load(std::memory_order_acquire) & Mask);
+		});
+		if(!Candidate)
+			return false;
+
+		auto Snapshot = std::atomic_load(&BlackListDevices);
+		uint64_t Key;
+		if(BlackListKey(SerialNumber,Key))
+			return std::binary_search(Snapshot->Serials.begin(),Snapshot->Serials.end(),Key);
+		return std::binary_search(Snapshot->Others.begin(),Snapshot->Others.end(),Poco::toLower(SerialNumber));
 	}
-}
\ No newline at end of file
+}
@@ -16,6 +16,7 @@
 #include "DeviceRegistry.h"
 #include "StorageService.h"
 #include "FileUploader.h"
+#include "framework/ow_constants.h"
 
 namespace OpenWifi {
 
@@ -127,6 +128,8 @@ typedef Poco::Tuple<
 	}
 
 	bool Storage::AddCommand(std::string &SerialNumber, GWObjects::CommandDetails &Command, CommandExecutionType Type) {
+		static auto &Latency = WriteLatency("command");
+		Metrics::ScopedTimer	Timer(Latency);
 		try {
 			uint64_t Now = time(nullptr);
 
@@ -157,6 +160,11 @@ typedef Poco::Tuple<
 
 			CommandDetailsRecordTuple R;
 			ConvertCommandRecord(Command, R);
+			//	configure commands keep a reference to their configuration, stored once for all the devices
+			std::string Compacted;
+			if (Command.Command == uCentralProtocol::CONFIGURE &&
+				CompactCommandDetails(SerialNumber, Command.Details, Compacted))
+				R.set<6>(Compacted);
 
 			Insert << ConvertParams(St),
 				Poco::Data::Keywords::use(R);
@@ -208,6 +216,7 @@ typedef Poco::Tuple<
 			for (const auto &i : Records) {
 				GWObjects::CommandDetails R;
 				ConvertCommandRecord(i, R);
+				ExpandCommandDetails(R);
 				Commands.push_back(R);
 			}
 			return true;
@@ -217,6 +226,61 @@ typedef Poco::Tuple<
 		return false;
 	}
 
+	bool Storage::GetCommands(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate,
+							  const PageCursor & After, uint64_t HowMany,
+							  std::vector<GWObjects::CommandDetails> &Commands, PageCursor & Next) {
+		try {
+			CommandDetailsRecordList Records;
+			Poco::Data::Session Sess = Pool_->get();
+
+			std::string Where;
+			auto AddCondition = [&Where](const std::string &C) { Where += (Where.empty() ? " WHERE " : " AND ") + C; };
+			if(!SerialNumber.empty())
+				AddCondition("SerialNumber='" + SerialNumber + "'");
+			if(FromDate)
+				AddCondition("Submitted>=" + std::to_string(FromDate));
+			if(ToDate)
+				AddCondition("Submitted<=" + std::to_string(ToDate));
+
+			//	(Submitted, UUID) is unique, so the next page starts strictly after the last row returned
+			std::string LastUUID = After.Key;
+			if(After.Valid)
+				AddCondition("(Submitted>" + std::to_string(After.Timestamp) + " OR (Submitted=" +
+							 std::to_string(After.Timestamp) + " AND UUID>?))");
+
+			Poco::Data::Statement Select(Sess);
+			std::string FullQuery = "SELECT " + DB_Command_SelectFields + " FROM CommandList " + Where +
+					" ORDER BY Submitted ASC, UUID ASC " + ComputeRange(0, HowMany);
+
+			if(After.Valid) {
+				Select << 	ConvertParams(FullQuery),
+					Poco::Data::Keywords::into(Records),
+					Poco::Data::Keywords::use(LastUUID);
+			} else {
+				Select << 	FullQuery,
+					Poco::Data::Keywords::into(Records);
+			}
+			Select.execute();
+			for (const auto &i : Records) {
+				GWObjects::CommandDetails R;
+				ConvertCommandRecord(i, R);
+				ExpandCommandDetails(R);
+				Commands.push_back(R);
+			}
+
+			Next = PageCursor{};
+			if(!Commands.empty() && Commands.size()==HowMany) {
+				Next.Timestamp = Commands.back().Submitted;
+				Next.Key = Commands.back().UUID;
+				Next.Valid = true;
+			}
+			return true;
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
+		}
+		return false;
+	}
+
 	bool Storage::DeleteCommands(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate) {
 		try {
 			Poco::Data::Session Sess = Pool_->get();
@@ -271,8 +335,10 @@ typedef Poco::Tuple<
 					Offset++;
 					GWObjects::CommandDetails R;
 					ConvertCommandRecord(i,R);
-					if (DeviceRegistry()->Connected(R.SerialNumber))
+					if (DeviceRegistry()->Connected(R.SerialNumber)) {
+						ExpandCommandDetails(R);
 						Commands.push_back(R);
+					}
 				}
 
 				//	If we could not return enough commands, we are done.
@@ -346,8 +412,9 @@ typedef Poco::Tuple<
 			Select << ConvertParams(St),
 				Poco::Data::Keywords::into(R),
 				Poco::Data::Keywords::use(UUID);
-			ConvertCommandRecord(R,Command);
 			Select.execute();
+			ConvertCommandRecord(R,Command);
+			ExpandCommandDetails(Command);
 			return true;
 		} catch (const Poco::Exception &E) {
 			Logger().log(E);
@@ -390,6 +457,7 @@ typedef Poco::Tuple<
 			for (auto i : Records) {
 				GWObjects::CommandDetails R;
 				ConvertCommandRecord(i,R);
+				ExpandCommandDetails(R);
 				Commands.push_back(R);
 			}
 			return true;
@@ -423,8 +491,10 @@ typedef Poco::Tuple<
 			for(const auto &i : Records) {
 				GWObjects::CommandDetails R;
 				ConvertCommandRecord(i,R);
-				if (DeviceRegistry()->Connected(R.SerialNumber))
+				if (DeviceRegistry()->Connected(R.SerialNumber)) {
+					ExpandCommandDetails(R);
 					Commands.push_back(R);
+				}
 			}
 			return true;
 		} catch (const Poco::Exception &E) {
@@ -458,6 +528,8 @@ typedef Poco::Tuple<
 	bool Storage::CommandCompleted(std::string &UUID, const Poco::JSON::Object & ReturnVars,
 								   const std::chrono::duration<double, std::milli> & execution_time,
 								   bool FullCommand) {
+		static auto &Latency = WriteLatency("command-result");
+		Metrics::ScopedTimer	Timer(Latency);
 		try {
 
 			uint64_t Now = FullCommand ? time(nullptr) : 0;
@@ -600,7 +672,9 @@ typedef Poco::Tuple<
 		return false;
 	}
 */
-	bool Storage::AttachFileDataToCommand(std::string & UUID, const std::stringstream & FileContent) {
+	//	The content itself is already in the file store, FileUploads only records that it exists: an empty
+	//	FileContent means "look in the store". Rows written before the store existed still carry their BLOB.
+	bool Storage::AttachFileDataToCommand(std::string & UUID, uint64_t Size) {
 		try {
 			Poco::Data::Session Sess = Pool_->get();
 			uint64_t Now = OpenWifi::Now();
@@ -608,8 +682,6 @@ typedef Poco::Tuple<
 
 			Poco::Data::Statement Update(Sess);
 
-			uint64_t Size = FileContent.str().size();
-
 			std::string St{
 				"UPDATE CommandList SET WaitingForFile=?, AttachDate=?, AttachSize=? WHERE UUID=?"};
 
@@ -620,27 +692,19 @@ typedef Poco::Tuple<
 				Poco::Data::Keywords::use(UUID);
 			Update.execute();
 
-			if (Size < FileUploader()->MaxSize()) {
-
-				Poco::Data::BLOB 		TheBlob;
-
-				TheBlob.appendRaw((const unsigned char *)FileContent.str().c_str(),FileContent.str().size());
-
-				Poco::Data::Statement Insert(Sess);
-				std::string FileType{"trace"};
+			Poco::Data::BLOB 		NoContent;
+			Poco::Data::Statement Insert(Sess);
+			std::string FileType{"trace"};
 
-				std::string St2{
-					"INSERT INTO FileUploads (UUID,Type,Created,FileContent) VALUES(?,?,?,?)"};
+			std::string St2{
+				"INSERT INTO FileUploads (UUID,Type,Created,FileContent) VALUES(?,?,?,?)"};
 
-				Insert << ConvertParams(St2), Poco::Data::Keywords::use(UUID),
-					Poco::Data::Keywords::use(FileType),
-					Poco::Data::Keywords::use(Now),
-					Poco::Data::Keywords::use(TheBlob);
-				Insert.execute();
-				return true;
-			} else {
-				Logger().warning(fmt::format("File {} is too large.", UUID));
-			}
+			Insert << ConvertParams(St2), Poco::Data::Keywords::use(UUID),
+				Poco::Data::Keywords::use(FileType),
+				Poco::Data::Keywords::use(Now),
+				Poco::Data::Keywords::use(NoContent);
+			Insert.execute();
+			return true;
 		} catch (const Poco::Exception &E) {
 			Logger().log(E);
 		}
@@ -729,17 +793,13 @@ typedef Poco::Tuple<
 		return false;
 	}
 
+	typedef Poco::Tuple<uint64_t, std::string, std::string>	CommandResultTuple;
+	static CachedStatement<CommandResultTuple>	UpdateCommandResult{"UPDATE CommandList SET Completed=?, Results=? WHERE UUID=?"};
+
 	bool Storage::SetCommandResult(std::string &UUID, std::string &Result) {
 		try {
-			Poco::Data::Session Sess = Pool_->get();
-			Poco::Data::Statement Update(Sess);
-
 			uint64_t Now = time(nullptr);
-			std::string St{"UPDATE CommandList SET Completed=?, Results=? WHERE UUID=?"};
-
-			Update << ConvertParams(St), Poco::Data::Keywords::use(Now),
-				Poco::Data::Keywords::use(Result), Poco::Data::Keywords::use(UUID);
-			Update.execute();
+			UpdateCommandResult.Execute(*Pool_, dbType_, CommandResultTuple(Now, Result, UUID));
 			return true;
 
 		} catch (const Poco::Exception &E) {
@@ -757,6 +817,7 @@ typedef Poco::Tuple<
 
 			Delete << ConvertParams(St), Poco::Data::Keywords::use(UUID);
 			Delete.execute();
+			FileUploader()->Store().Remove(UUID);
 
 			return true;
 
@@ -775,7 +836,7 @@ typedef Poco::Tuple<
 			std::string St1{"delete from CommandList where Submitted<?"};
 			Delete << ConvertParams(St1), Poco::Data::Keywords::use(Date);
 			Delete.execute();
-			return true;
+			return RemoveConfigurationsOlderThan(Date);
 		} catch (const Poco::Exception &E) {
 			Logger().log(E);
 		}
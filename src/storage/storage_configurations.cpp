@@ -0,0 +1,296 @@
+//
+//	License type: BSD 3-Clause License
+//	License copy: https://github.com/Telecominfraproject/wlan-cloud-ucentralgw/blob/master/LICENSE
+//
+//	Arilia Wireless Inc.
+//
+
+#include "Poco/JSON/Parser.h"
+#include "Poco/SHA2Engine.h"
+
+#include "StorageService.h"
+#include "framework/Metrics.h"
+#include "framework/ow_constants.h"
+
+//	Configurations are stored once per distinct content in ConfigurationBlobs, keyed by the SHA-256 of their condensed
+//	text without the uuid field: the uuid is all that differs between the devices receiving the same configuration.
+//	The configure commands in CommandList keep the hash and the uuid in place of the configuration, and are expanded
+//	back when read. DeviceConfigurations remembers which configuration each device was sent under each UUID, so a
+//	patch can be made against the configuration a device runs.
+
+namespace OpenWifi {
+
+	static const std::string	ConfigHashField{"configHash"};
+	static const std::string	ConfigUuidField{"configUuid"};
+
+	static Metrics::Counter & StoredBytes(bool Deduplicated) {
+		return Metrics::GetCounter("owgw_configuration_store_bytes_total",
+								   "Configuration text of configure commands, written to the database or found already there.",
+								   {{"outcome", Deduplicated ? "deduplicated" : "stored"}});
+	}
+
+	std::shared_ptr<const std::string> Storage::CachedBlob(const std::string &Hash) {
+		std::lock_guard	G(BlobMutex_);
+		auto Hint = Blobs_.find(Hash);
+		return Hint == Blobs_.end() ? nullptr : Hint->second;
+	}
+
+	void Storage::CacheBlob(const std::string &Hash, const std::string &Configuration) {
+		std::lock_guard	G(BlobMutex_);
+		if (Blobs_.size() >= MaxCachedBlobs)
+			Blobs_.erase(Blobs_.begin());
+		Blobs_[Hash] = std::make_shared<const std::string>(Configuration);
+	}
+
+	bool Storage::AddConfigurationBlob(const std::string &Configuration, std::string &Hash) {
+		static auto &Deduplicated = StoredBytes(true);
+		static auto &Stored = StoredBytes(false);
+
+		Poco::SHA2Engine	SHA2;
+		SHA2.update(Configuration);
+		Hash = Utils::ToHex(SHA2.digest());
+
+		//	no shortcut through Blobs_: another gateway's archiver may have removed the row since it was cached
+		try {
+			Poco::Data::Session 	Sess = Pool_->get();
+			Poco::Data::Statement 	Select(Sess);
+
+			uint64_t 	Count = 0;
+			std::string St{"SELECT COUNT(*) FROM ConfigurationBlobs WHERE Hash=?"};
+			Select << ConvertParams(St),
+				Poco::Data::Keywords::into(Count),
+				Poco::Data::Keywords::use(Hash);
+			Select.execute();
+
+			if (Count == 0) {
+				Poco::Data::Statement 	Insert(Sess);
+				uint64_t 	Size = Configuration.size(), Now = OpenWifi::Now();
+				std::string St2{"INSERT INTO ConfigurationBlobs (Hash, Configuration, Size, Created) VALUES(?,?,?,?)"};
+				Insert << ConvertParams(St2),
+					Poco::Data::Keywords::use(Hash),
+					Poco::Data::Keywords::use(const_cast<std::string &>(Configuration)),
+					Poco::Data::Keywords::use(Size),
+					Poco::Data::Keywords::use(Now);
+				Insert.execute();
+				Stored.Add(Configuration.size());
+			} else {
+				//	Created is when the configuration was last stored: the archiver leaves it alone until it ages
+				Poco::Data::Statement 	Update(Sess);
+				uint64_t 	Now = OpenWifi::Now();
+				std::string St2{"UPDATE ConfigurationBlobs SET Created=? WHERE Hash=?"};
+				Update << ConvertParams(St2),
+					Poco::Data::Keywords::use(Now),
+					Poco::Data::Keywords::use(Hash);
+				Update.execute();
+				Deduplicated.Add(Configuration.size());
+			}
+			CacheBlob(Hash, Configuration);
+			return true;
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
+		}
+		return false;
+	}
+
+	bool Storage::GetConfigurationBlob(const std::string &Hash, std::string &Configuration) {
+		if (auto Cached = CachedBlob(Hash)) {
+			Configuration = *Cached;
+			return true;
+		}
+
+		try {
+			Poco::Data::Session 	Sess = Pool_->get();
+			Poco::Data::Statement 	Select(Sess);
+
+			std::string St{"SELECT Configuration FROM ConfigurationBlobs WHERE Hash=?"};
+			Select << ConvertParams(St),
+				Poco::Data::Keywords::into(Configuration),
+				Poco::Data::Keywords::use(const_cast<std::string &>(Hash));
+			Select.execute();
+			if (Select.rowsExtracted() == 0)
+				return false;
+			CacheBlob(Hash, Configuration);
+			return true;
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
+		}
+		return false;
+	}
+
+	bool Storage::AddDeviceConfiguration(const std::string &SerialNumber, uint64_t UUID, const std::string &Hash) {
+		try {
+			Poco::Data::Session 	Sess = Pool_->get();
+			Poco::Data::Statement 	Select(Sess);
+
+			//	a command is stored again as it progresses
+			uint64_t 	Count = 0;
+			std::string St{"SELECT COUNT(*) FROM DeviceConfigurations WHERE SerialNumber=? AND UUID=?"};
+			Select << ConvertParams(St),
+				Poco::Data::Keywords::into(Count),
+				Poco::Data::Keywords::use(const_cast<std::string &>(SerialNumber)),
+				Poco::Data::Keywords::use(UUID);
+			Select.execute();
+			if (Count)
+				return true;
+
+			Poco::Data::Statement 	Insert(Sess);
+			uint64_t 	Now = OpenWifi::Now();
+			std::string St2{"INSERT INTO DeviceConfigurations (SerialNumber, UUID, Hash, Created) VALUES(?,?,?,?)"};
+			Insert << ConvertParams(St2),
+				Poco::Data::Keywords::use(const_cast<std::string &>(SerialNumber)),
+				Poco::Data::Keywords::use(UUID),
+				Poco::Data::Keywords::use(const_cast<std::string &>(Hash)),
+				Poco::Data::Keywords::use(Now);
+			Insert.execute();
+			return true;
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
+		}
+		return false;
+	}
+
+	bool Storage::GetDeviceConfiguration(const std::string &SerialNumber, uint64_t UUID, std::string &Configuration) {
+		try {
+			Poco::Data::Session 	Sess = Pool_->get();
+			Poco::Data::Statement 	Select(Sess);
+
+			std::string Hash;
+			std::string St{"SELECT Hash FROM DeviceConfigurations WHERE SerialNumber=? AND UUID=?"};
+			Select << ConvertParams(St),
+				Poco::Data::Keywords::into(Hash),
+				Poco::Data::Keywords::use(const_cast<std::string &>(SerialNumber)),
+				Poco::Data::Keywords::use(UUID);
+			Select.execute();
+			if (Select.rowsExtracted() == 0 || !GetConfigurationBlob(Hash, Configuration))
+				return false;
+
+			Poco::JSON::Parser	P;
+			auto Config = P.parse(Configuration).extract<Poco::JSON::Object::Ptr>();
+			Config->set(uCentralProtocol::UUID, UUID);
+			std::ostringstream OS;
+			Poco::JSON::Stringifier::condense(Config, OS);
+			Configuration = OS.str();
+			return true;
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
+		}
+		return false;
+	}
+
+	bool Storage::CompactCommandDetails(const std::string &SerialNumber, const std::string &Details, std::string &Compacted) {
+		try {
+			Poco::JSON::Parser	P;
+			auto Params = P.parse(Details).extract<Poco::JSON::Object::Ptr>();
+			if (!Params->isObject(uCentralProtocol::CONFIG))
+				return false;
+
+			//	the parser sorts the keys, so the same configuration always hashes the same
+			auto Config = Params->getObject(uCentralProtocol::CONFIG);
+			uint64_t UUID = Config->optValue<uint64_t>(uCentralProtocol::UUID, 0);
+			Config->remove(uCentralProtocol::UUID);
+			std::ostringstream OS;
+			Poco::JSON::Stringifier::condense(Config, OS);
+
+			std::string Hash;
+			if (!AddConfigurationBlob(OS.str(), Hash))
+				return false;
+			if (UUID)
+				AddDeviceConfiguration(SerialNumber, UUID, Hash);
+
+			Params->remove(uCentralProtocol::CONFIG);
+			Params->set(ConfigHashField, Hash);
+			Params->set(ConfigUuidField, UUID);
+			std::ostringstream OS2;
+			Poco::JSON::Stringifier::stringify(Params, OS2);
+			Compacted = OS2.str();
+			return true;
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
+		}
+		return false;
+	}
+
+	void Storage::ExpandCommandDetails(GWObjects::CommandDetails &Command) {
+		if (Command.Command != uCentralProtocol::CONFIGURE || Command.Details.find(ConfigHashField) == std::string::npos)
+			return;
+		try {
+			Poco::JSON::Parser	P;
+			auto Params = P.parse(Command.Details).extract<Poco::JSON::Object::Ptr>();
+			if (!Params->has(ConfigHashField))
+				return;
+
+			std::string Configuration;
+			auto Hash = Params->get(ConfigHashField).toString();
+			if (!GetConfigurationBlob(Hash, Configuration)) {
+				poco_warning(Logger(), fmt::format("COMMAND({}): configuration {} is gone.", Command.UUID, Hash));
+				return;
+			}
+			Poco::JSON::Parser	P2;
+			auto Config = P2.parse(Configuration).extract<Poco::JSON::Object::Ptr>();
+			uint64_t UUID = Params->optValue<uint64_t>(ConfigUuidField, 0);
+			if (UUID)
+				Config->set(uCentralProtocol::UUID, UUID);
+
+			Params->remove(ConfigHashField);
+			Params->remove(ConfigUuidField);
+			Params->set(uCentralProtocol::CONFIG, Config);
+			std::ostringstream OS;
+			Poco::JSON::Stringifier::stringify(Params, OS);
+			Command.Details = OS.str();
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
+		}
+	}
+
+	//	keeps what every device was last sent, whatever its age, and the configurations still referenced by a device
+	//	or by a command the archiver kept
+	bool Storage::RemoveConfigurationsOlderThan(uint64_t Date) {
+		try {
+			Poco::Data::Session 	Sess = Pool_->get();
+			Poco::Data::Statement 	Delete(Sess);
+
+			std::string St1{"DELETE FROM DeviceConfigurations WHERE Created<? AND NOT EXISTS (SELECT 1 FROM Devices WHERE "
+							"Devices.SerialNumber=DeviceConfigurations.SerialNumber AND Devices.UUID=DeviceConfigurations.UUID)"};
+			Delete << ConvertParams(St1), Poco::Data::Keywords::use(Date);
+			Delete.execute();
+
+			//	commands without a configuration UUID have no DeviceConfigurations row: their Details hold the hash
+			std::vector<std::string>	Candidates;
+			Poco::Data::Statement 	Select(Sess);
+			std::string St2{"SELECT Hash FROM ConfigurationBlobs WHERE Created<? AND Hash NOT IN (SELECT Hash FROM DeviceConfigurations)"};
+			Select << ConvertParams(St2),
+				Poco::Data::Keywords::into(Candidates),
+				Poco::Data::Keywords::use(Date);
+			Select.execute();
+
+			for (auto &Hash : Candidates) {
+				uint64_t 	Count = 0;
+				std::string Command{uCentralProtocol::CONFIGURE}, Pattern{"%" + Hash + "%"};
+				Poco::Data::Statement 	Referenced(Sess);
+				std::string St3{"SELECT COUNT(*) FROM CommandList WHERE Command=? AND Details LIKE ?"};
+				Referenced << ConvertParams(St3),
+					Poco::Data::Keywords::into(Count),
+					Poco::Data::Keywords::use(Command),
+					Poco::Data::Keywords::use(Pattern);
+				Referenced.execute();
+				if (Count)
+					continue;
+
+				//	Created is checked again: a command may have stored the same configuration since the select
+				Poco::Data::Statement 	Delete2(Sess);
+				std::string St4{"DELETE FROM ConfigurationBlobs WHERE Hash=? AND Created<?"};
+				Delete2 << ConvertParams(St4),
+					Poco::Data::Keywords::use(Hash),
+					Poco::Data::Keywords::use(Date);
+				Delete2.execute();
+			}
+
+			std::lock_guard	G(BlobMutex_);
+			Blobs_.clear();
+			return true;
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
+		}
+		return false;
+	}
+}
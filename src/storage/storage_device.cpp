@@ -190,6 +190,31 @@ namespace OpenWifi {
 		return false;
 	}
 
+	bool Storage::GetDeviceSerialNumbers(const PageCursor & After, uint64_t HowMany, std::vector<std::string> &SerialNumbers, PageCursor & Next) {
+		try {
+			Poco::Data::Session Sess = Pool_->get();
+			Poco::Data::Statement   Select(Sess);
+
+			std::string LastSerialNumber = After.Key;
+			std::string st{"SELECT SerialNumber From Devices WHERE SerialNumber>? ORDER BY SerialNumber ASC "};
+
+			Select << 	ConvertParams(st) + ComputeRange(0, HowMany),
+				Poco::Data::Keywords::into(SerialNumbers),
+				Poco::Data::Keywords::use(LastSerialNumber);
+			Select.execute();
+
+			Next = PageCursor{};
+			if(!SerialNumbers.empty() && SerialNumbers.size()==HowMany) {
+				Next.Key = SerialNumbers.back();
+				Next.Valid = true;
+			}
+			return true;
+		} catch (const Poco::Exception &E ) {
+			Logger().log(E);
+		}
+		return false;
+	}
+
 	bool Storage::UpdateDeviceConfiguration(std::string &SerialNumber, std::string &Configuration, uint64_t &NewUUID) {
 		try {
 
@@ -199,6 +224,7 @@ namespace OpenWifi {
 				return false;
 			}
 
+			std::shared_lock	CacheGuard(CacheMutex_);
 			Poco::Data::Session 	Sess = Pool_->get();
 			Poco::Data::Statement   Select(Sess);
 
@@ -211,7 +237,6 @@ namespace OpenWifi {
 			if (Cfg.SetUUID(NewUUID)) {
 				Poco::Data::Statement   Update(Sess);
 				D.Configuration = Cfg.get();
-				SetCurrentConfigurationID(SerialNumber, NewUUID);
 
 				DeviceRecordTuple R;
 				ConvertDeviceRecord(D,R);
@@ -220,6 +245,8 @@ namespace OpenWifi {
 					Poco::Data::Keywords::use(R),
 					Poco::Data::Keywords::use(SerialNumber);
 				Update.execute();
+				SetCurrentConfigurationID(SerialNumber, NewUUID);
+				BumpCacheGeneration();
 				poco_information(Logger(),fmt::format("DEVICE-CONFIGURATION-UPDATED({}): New UUID is {}", SerialNumber, NewUUID));
 				Configuration = D.Configuration;
 				return true;
@@ -235,6 +262,7 @@ namespace OpenWifi {
 	bool Storage::CreateDevice(GWObjects::Device &DeviceDetails) {
 		std::string SerialNumber;
 		try {
+			std::shared_lock	CacheGuard(CacheMutex_);
 
 			Poco::Data::Session     Sess = Pool_->get();
 			Poco::Data::Statement   Select(Sess);
@@ -263,7 +291,6 @@ namespace OpenWifi {
 										DB_DeviceSelectFields + " ) " +
 										DB_DeviceInsertValues };
 
-					SetCurrentConfigurationID(DeviceDetails.SerialNumber, DeviceDetails.UUID);
 					DeviceRecordTuple R;
 					ConvertDeviceRecord(DeviceDetails, R);
 					Insert  << ConvertParams(St2),
@@ -271,6 +298,7 @@ namespace OpenWifi {
 					Insert.execute();
 					SetCurrentConfigurationID(DeviceDetails.SerialNumber, DeviceDetails.UUID);
 					SerialNumberCache()->AddSerialNumber(DeviceDetails.SerialNumber);
+					BumpCacheGeneration();
 					return true;
 				} else {
 					poco_warning(Logger(),"Cannot create device: invalid configuration.");
@@ -433,6 +461,7 @@ namespace OpenWifi {
 
 	bool Storage::DeleteDevice(std::string &SerialNumber) {
 		try {
+			std::shared_lock	CacheGuard(CacheMutex_);
 			std::vector<std::string>	DBList{"Devices", "Statistics", "CommandList", "HealthChecks", "LifetimeStats", "Capabilities", "DeviceLogs"};
 
 			for(const auto &i:DBList) {
@@ -451,6 +480,7 @@ namespace OpenWifi {
 			}
 
 			SerialNumberCache()->DeleteSerialNumber(SerialNumber);
+			BumpCacheGeneration();
 
 			if(KafkaManager()->Enabled()) {
 				nlohmann::json 	Message;
@@ -467,21 +497,13 @@ namespace OpenWifi {
 		return false;
 	}
 
+	static CachedStatement<std::string, DeviceRecordTuple>	SelectDevice{"SELECT " + DB_DeviceSelectFields +
+																" FROM Devices WHERE SerialNumber=?"};
+
 	bool Storage::GetDevice(std::string &SerialNumber, GWObjects::Device &DeviceDetails) {
 		try {
-			Poco::Data::Session     Sess = Pool_->get();
-			Poco::Data::Statement   Select(Sess);
-
-			std::string St{"SELECT " + DB_DeviceSelectFields +
-						   " FROM Devices WHERE SerialNumber=?"};
-
 			DeviceRecordTuple R;
-			Select << 	ConvertParams(St),
-						Poco::Data::Keywords::into(R),
-						Poco::Data::Keywords::use(SerialNumber);
-			Select.execute();
-
-			if (Select.rowsExtracted()==0)
+			if (SelectDevice.Execute(*Pool_, dbType_, SerialNumber, &R)==0)
 				return false;
 			ConvertDeviceRecord(R,DeviceDetails);
 			return true;
@@ -492,6 +514,55 @@ namespace OpenWifi {
 		return false;
 	}
 
+	//	Fetch a set of devices in as few round trips as possible. Devices are returned in the requested order,
+	//	serial numbers that do not exist are reported in Missing.
+	bool Storage::GetDevices(const std::vector<std::string> &SerialNumbers, std::vector<GWObjects::Device> &Devices, std::vector<std::string> &Missing) {
+		static const std::size_t MaxParametersPerQuery = 250;
+		try {
+			std::vector<std::string> Unique{SerialNumbers};
+			std::sort(Unique.begin(),Unique.end());
+			Unique.erase(std::unique(Unique.begin(),Unique.end()),Unique.end());
+
+			std::map<std::string,GWObjects::Device>	Found;
+			Poco::Data::Session     Sess = Pool_->get();
+			for(std::size_t Start=0;Start<Unique.size();Start+=MaxParametersPerQuery) {
+				std::vector<std::string> Chunk(Unique.begin()+Start,
+											   Unique.begin()+std::min(Unique.size(),Start+MaxParametersPerQuery));
+				std::string Parameters;
+				for(std::size_t i=0;i<Chunk.size();++i)
+					Parameters += i ? ",?" : "?";
+
+				Poco::Data::Statement   Select(Sess);
+				DeviceRecordList		Records;
+				std::string St{"SELECT " + DB_DeviceSelectFields + " FROM Devices WHERE SerialNumber IN (" + Parameters + ")"};
+				Select << ConvertParams(St), Poco::Data::Keywords::into(Records);
+				for(auto &SerialNumber:Chunk)
+					Select, Poco::Data::Keywords::use(SerialNumber);
+				Select.execute();
+
+				for(const auto &i:Records) {
+					GWObjects::Device D;
+					ConvertDeviceRecord(i, D);
+					auto Key = D.SerialNumber;
+					Found[Key] = std::move(D);
+				}
+			}
+
+			for(const auto &SerialNumber:SerialNumbers) {
+				auto Hint = Found.find(SerialNumber);
+				if(Hint==Found.end())
+					Missing.push_back(SerialNumber);
+				else
+					Devices.push_back(Hint->second);
+			}
+			return true;
+		}
+		catch (const Poco::Exception &E) {
+			Logger().log(E);
+		}
+		return false;
+	}
+
 	bool Storage::DeviceExists(std::string &SerialNumber) {
 		try {
 			Poco::Data::Session     Sess = Pool_->get();
@@ -517,8 +588,12 @@ namespace OpenWifi {
 		return false;
 	}
 
-	bool Storage::UpdateDevice(GWObjects::Device &NewDeviceDetails) {
+	//	NewConfiguration: the UUID of the device changed, the configuration cache follows
+	bool Storage::UpdateDevice(GWObjects::Device &NewDeviceDetails, bool NewConfiguration) {
 		try {
+			std::shared_lock	CacheGuard(CacheMutex_, std::defer_lock);
+			if(NewConfiguration)
+				CacheGuard.lock();
 			Poco::Data::Session     Sess = Pool_->get();
 			Poco::Data::Statement   Update(Sess);
 
@@ -535,6 +610,10 @@ namespace OpenWifi {
 				Poco::Data::Keywords::use(NewDeviceDetails.SerialNumber);
 			Update.execute();
 			// GetDevice(NewDeviceDetails.SerialNumber,NewDeviceDetails);
+			if(NewConfiguration) {
+				SetCurrentConfigurationID(NewDeviceDetails.SerialNumber, NewDeviceDetails.UUID);
+				BumpCacheGeneration();
+			}
 			return true;
 		}
 		catch (const Poco::Exception &E) {
@@ -573,6 +652,42 @@ namespace OpenWifi {
 		return false;
 	}
 
+	bool Storage::GetDevices(const PageCursor & After, uint64_t HowMany, std::vector<GWObjects::Device> &Devices, PageCursor & Next) {
+		DeviceRecordList Records;
+		try {
+			Poco::Data::Session     Sess = Pool_->get();
+			Poco::Data::Statement   Select(Sess);
+
+			//	SerialNumber is the primary key: seek past the last device returned rather than counting an OFFSET
+			std::string LastSerialNumber = After.Key;
+			std::string st = fmt::format("SELECT {} FROM Devices WHERE SerialNumber>? ORDER BY SerialNumber ASC {}",
+				DB_DeviceSelectFields,
+				ComputeRange(0, HowMany));
+
+			Select << 	ConvertParams(st),
+						Poco::Data::Keywords::into(Records),
+						Poco::Data::Keywords::use(LastSerialNumber);
+			Select.execute();
+
+			for (auto &i: Records) {
+				GWObjects::Device D;
+				ConvertDeviceRecord(i, D);
+				Devices.push_back(D);
+			}
+
+			Next = PageCursor{};
+			if(!Devices.empty() && Devices.size()==HowMany) {
+				Next.Key = Devices.back().SerialNumber;
+				Next.Valid = true;
+			}
+			return true;
+		}
+		catch (const Poco::Exception &E) {
+			Logger().log(E);
+		}
+		return false;
+	}
+
 	bool Storage::ExistingConfiguration(std::string &SerialNumber, [[maybe_unused]] uint64_t CurrentConfig, std::string &NewConfig, uint64_t & NewUUID) {
 		std::string SS;
 		try {
@@ -611,26 +726,33 @@ namespace OpenWifi {
 		return false;
 	}
 
+	//	one scan fills both the serial number cache and the configuration cache
 	bool Storage::UpdateSerialNumberCache() {
 		try {
 			Poco::Data::Session     Sess = Pool_->get();
 			Poco::Data::Statement   Select(Sess);
 
-			Select << "SELECT SerialNumber FROM Devices";
+			Select << "SELECT SerialNumber, UUID FROM Devices";
 			Select.execute();
 
 			Poco::Data::RecordSet   RSet(Select);
 
-			uint64_t NumberOfDevices = 0 ;
+			std::vector<std::string>	SerialNumbers;
+			std::vector<std::pair<uint64_t,uint64_t>>	Configurations;
+			SerialNumbers.reserve(RSet.rowCount());
+			Configurations.reserve(RSet.rowCount());
 
 			bool More = RSet.moveFirst();
 			while(More) {
 				auto SerialNumber = RSet[0].convert<std::string>();
-				SerialNumberCache()->AddSerialNumber(SerialNumber);
-				NumberOfDevices++;
+				Configurations.emplace_back(Utils::SerialNumberToInt(SerialNumber), RSet[1].convert<uint64_t>());
+				SerialNumbers.push_back(std::move(SerialNumber));
 				More = RSet.moveNext();
 			}
-			Logger().information(fmt::format("Added {} serial numbers to cache.", NumberOfDevices));
+			SerialNumberCache()->SetSerialNumbers(SerialNumbers);
+			std::sort(Configurations.begin(), Configurations.end());
+			ConfigurationCache::instance().Load(Configurations);
+			Logger().information(fmt::format("Added {} serial numbers to cache.", SerialNumbers.size()));
 			return true;
 
 		} catch(const Poco::Exception &E) {
@@ -639,6 +761,48 @@ namespace OpenWifi {
 		return false;
 	}
 
+	bool Storage::GetCacheMarker(CacheMarker &Marker) {
+		try {
+			Poco::Data::Session     Sess = Pool_->get();
+			Poco::Data::Statement   SelectDevices(Sess);
+
+			if(CacheGenerationLost_)
+				return false;
+
+			SelectDevices << "SELECT COUNT(*) FROM Devices",
+				Poco::Data::Keywords::into(Marker.Devices);
+			SelectDevices.execute();
+
+			Poco::Data::Statement   SelectBlackList(Sess);
+			SelectBlackList << "SELECT COUNT(*) FROM BlackList",
+				Poco::Data::Keywords::into(Marker.BlackListed);
+			SelectBlackList.execute();
+
+			Poco::Data::Statement   SelectGeneration(Sess);
+			SelectGeneration << "SELECT Generation FROM CacheGeneration WHERE Id=0",
+				Poco::Data::Keywords::into(Marker.Generation);
+			SelectGeneration.execute();
+			return SelectGeneration.rowsExtracted()==1;
+		} catch(const Poco::Exception &E) {
+			Logger().log(E);
+		}
+		return false;
+	}
+
+	//	Called with CacheMutex_ held shared, after the database change and before the lock is released.
+	void Storage::BumpCacheGeneration() {
+		try {
+			Poco::Data::Session     Sess = Pool_->get();
+			Poco::Data::Statement   Update(Sess);
+			Update << "UPDATE CacheGeneration SET Generation=Generation+1 WHERE Id=0";
+			Update.execute();
+			return;
+		} catch(const Poco::Exception &E) {
+			Logger().log(E);
+		}
+		CacheGenerationLost_ = true;
+	}
+
 	static std::string ComputeCertificateTag( GWObjects::CertificateValidation V) {
 		switch(V) {
 		case GWObjects::NO_CERTIFICATE: return "no certificate";
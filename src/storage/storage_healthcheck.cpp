@@ -38,22 +38,19 @@ namespace OpenWifi {
 		R.set<4>(H.Recorded);
 	}
 
+	static CachedStatement<HealthCheckRecordTuple>	InsertHealthCheck{"INSERT INTO HealthChecks ( " +
+															DB_HealthCheckSelectFields +
+															" ) VALUES( " +
+															DB_HealthCheckInsertValues +
+															" )"};
+
 	bool Storage::AddHealthCheckData(const GWObjects::HealthCheck &Check) {
+		static auto &Latency = WriteLatency("healthcheck");
+		Metrics::ScopedTimer	Timer(Latency);
 		try {
-			Poco::Data::Session Sess = Pool_->get();
-			Poco::Data::Statement   Insert(Sess);
-
-			std::string St{"INSERT INTO HealthChecks ( " +
-				DB_HealthCheckSelectFields +
-				" ) VALUES( " +
-				DB_HealthCheckInsertValues +
-				" )"};
-
 			HealthCheckRecordTuple 		R;
 			ConvertHealthCheckRecord(Check, R);
-			Insert  << 	ConvertParams(St),
-				Poco::Data::Keywords::use(R);
-			Insert.execute();
+			InsertHealthCheck.Execute(*Pool_, dbType_, R);
 			return true;
 		}
 		catch (const Poco::Exception &E) {
@@ -43,23 +43,18 @@ namespace OpenWifi {
 		R.set<6>(Log.UUID);
 	}
 
+	static CachedStatement<DeviceLogsRecordTuple>	InsertLog{"INSERT INTO DeviceLogs (" +
+														DB_LogsSelectFields +
+														") values( " +
+														DB_LogsInsertValues + " )"};
+
 	bool Storage::AddLog(const GWObjects::DeviceLog & Log) {
+		static auto &Latency = WriteLatency("log");
+		Metrics::ScopedTimer	Timer(Latency);
 		try {
-
-			Poco::Data::Session     Sess = Pool_->get();
-			Poco::Data::Statement   Insert(Sess);
-
-			std::string St{"INSERT INTO DeviceLogs (" +
-				DB_LogsSelectFields +
-				") values( " +
-				DB_LogsInsertValues + " )"};
-
 			DeviceLogsRecordTuple	R;
 			ConvertLogsRecord(Log, R);
-
-			Insert << ConvertParams(St) ,
-				Poco::Data::Keywords::use(R);
-			Insert.execute();
+			InsertLog.Execute(*Pool_, dbType_, R);
 			return true;
 		}
 		catch (const Poco::Exception &E) {
@@ -114,6 +109,46 @@ namespace OpenWifi {
 		return false;
 	}
 
+	bool Storage::GetLogData(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate, const PageCursor & After,
+							 uint64_t HowMany, std::vector<GWObjects::DeviceLog> &Stats, uint64_t Type, PageCursor & Next) {
+		try {
+			DeviceLogsRecordList Records;
+			Poco::Data::Session Sess = Pool_->get();
+
+			std::string Where;
+			auto AddCondition = [&Where](const std::string &C) { Where += (Where.empty() ? " WHERE " : " AND ") + C; };
+			if(!SerialNumber.empty())
+				AddCondition("SerialNumber='" + SerialNumber + "'");
+			if(FromDate)
+				AddCondition("Recorded>=" + std::to_string(FromDate));
+			if(ToDate)
+				AddCondition("Recorded<=" + std::to_string(ToDate));
+			AddCondition("LogType=" + std::to_string(Type));
+			//	logs are listed newest first, so the cursor bounds the upper end of the range
+			if(After.Valid)
+				AddCondition(TimeSeriesCondition(After, true));
+
+			Poco::Data::Statement   Select(Sess);
+			Select << "SELECT " + DB_LogsSelectFields + " FROM DeviceLogs " + Where +
+						" ORDER BY Recorded DESC, SerialNumber DESC, UUID DESC " +
+						ComputeRange(After.Valid ? After.Skip : 0, HowMany),
+				Poco::Data::Keywords::into(Records);
+			Select.execute();
+
+			for (const auto &i: Records) {
+				GWObjects::DeviceLog R;
+				ConvertLogsRecord(i,R);
+				Stats.push_back(R);
+			}
+			NextTimeSeriesCursor(After, HowMany, Stats, Next);
+			return true;
+		}
+		catch (const Poco::Exception &E) {
+			Logger().warning(fmt::format("{}: Failed with: {}", std::string(__func__), E.displayText()));
+		}
+		return false;
+	}
+
 	bool Storage::DeleteLogData(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate, uint64_t Type) {
 		try {
 			Poco::Data::Session Sess = Pool_->get();
@@ -35,22 +35,20 @@ namespace OpenWifi {
 		R.set<3>(Stats.Recorded);
 	}
 
+	static CachedStatement<StatsRecordTuple>	InsertStatistics{"INSERT INTO Statistics ( " +
+													DB_StatsSelectFields +
+													" ) VALUES ( " +
+													DB_StatsInsertValues + " )"};
+
 	bool Storage::AddStatisticsData(const GWObjects::Statistics & Stats) {
 		DeviceRegistry()->SetStatistics(Stats.SerialNumber, Stats.Data);
+		static auto &Latency = WriteLatency("statistics");
+		Metrics::ScopedTimer	Timer(Latency);
 		try {
-			Poco::Data::Session Sess = Pool_->get();
-			Poco::Data::Statement   Insert(Sess);
-
 			poco_debug(Logger(),"Device:" + Stats.SerialNumber + " Stats size:" + std::to_string(Stats.Data.size()));
-			std::string St{"INSERT INTO Statistics ( " +
-								DB_StatsSelectFields +
-								" ) VALUES ( " +
-								DB_StatsInsertValues + " )"};
 			StatsRecordTuple R;
 			ConvertStatsRecord(Stats, R);
-			Insert << ConvertParams(St),
-				Poco::Data::Keywords::use(R);
-			Insert.execute();
+			InsertStatistics.Execute(*Pool_, dbType_, R);
 			return true;
 		}
 		catch (const Poco::Exception &E) {
@@ -102,6 +100,46 @@ namespace OpenWifi {
 		return false;
 	}
 
+	bool Storage::GetStatisticsData(std::string &SerialNumber, uint64_t FromDate, uint64_t ToDate, const PageCursor & After,
+									uint64_t HowMany, std::vector<GWObjects::Statistics> &Stats, PageCursor & Next) {
+		try {
+			Poco::Data::Session     Sess = Pool_->get();
+			Poco::Data::Statement   Select(Sess);
+
+			StatsRecordList         Records;
+
+			//	seek on the (SerialNumber, Recorded) index instead of walking an OFFSET from the start of the range
+			std::string Where;
+			auto AddCondition = [&Where](const std::string &C) { Where += (Where.empty() ? " WHERE " : " AND ") + C; };
+			if(!SerialNumber.empty())
+				AddCondition("SerialNumber='" + SerialNumber + "'");
+			if(FromDate)
+				AddCondition("Recorded>=" + std::to_string(FromDate));
+			if(ToDate)
+				AddCondition("Recorded<=" + std::to_string(ToDate));
+			if(After.Valid)
+				AddCondition(TimeSeriesCondition(After, false));
+
+			Select << "SELECT " + DB_StatsSelectFields + " FROM Statistics " + Where +
+						" ORDER BY Recorded ASC, SerialNumber ASC, UUID ASC " +
+						ComputeRange(After.Valid ? After.Skip : 0, HowMany),
+				Poco::Data::Keywords::into(Records);
+			Select.execute();
+
+			for (const auto &i: Records) {
+				GWObjects::Statistics R;
+				ConvertStatsRecord(i,R);
+				Stats.push_back(R);
+			}
+			NextTimeSeriesCursor(After, HowMany, Stats, Next);
+			return true;
+		}
+		catch (const Poco::Exception &E) {
+			Logger().warning(fmt::format("{}: Failed with: {}", std::string(__func__), E.displayText()));
+		}
+		return false;
+	}
+
 	bool Storage::GetNewestStatisticsData(std::string &SerialNumber, uint64_t HowMany, std::vector<GWObjects::Statistics> &Stats) {
 		try {
 			StatsRecordList         Records;
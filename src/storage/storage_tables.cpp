@@ -10,6 +10,14 @@
 
 namespace OpenWifi {
 
+	//	MySQL has no CREATE INDEX IF NOT EXISTS: an index added after the table was first created fails once it exists
+	static void CreateMySQLIndex(Poco::Data::Session &Sess, const std::string &Statement) {
+		try {
+			Sess << Statement, Poco::Data::Keywords::now;
+		} catch (const Poco::Exception &) {
+		}
+	}
+
 	int Storage::Create_Tables() {
 
 		Create_Statistics();
@@ -21,6 +29,8 @@ namespace OpenWifi {
 		Create_CommandList();
 		Create_BlackList();
 		Create_FileUploads();
+		Create_Configurations();
+		Create_CacheGeneration();
 
 		return 0;
 	}
@@ -38,6 +48,8 @@ namespace OpenWifi {
 					Poco::Data::Keywords::now;
 				Sess << "CREATE INDEX IF NOT EXISTS StatsSerial ON Statistics (SerialNumber ASC, Recorded ASC)",
 					Poco::Data::Keywords::now;
+				Sess << "CREATE INDEX IF NOT EXISTS StatsSerialPage ON Statistics (SerialNumber ASC, Recorded ASC, UUID ASC)",
+					Poco::Data::Keywords::now;
 			} else if (dbType_ == mysql) {
 				Sess << "CREATE TABLE IF NOT EXISTS Statistics ("
 						"SerialNumber VARCHAR(30), "
@@ -46,6 +58,7 @@ namespace OpenWifi {
 						"Recorded BIGINT, "
 						"INDEX StatSerial (SerialNumber ASC, Recorded ASC))",
 					Poco::Data::Keywords::now;
+				CreateMySQLIndex(Sess, "CREATE INDEX StatsSerialPage ON Statistics (SerialNumber ASC, Recorded ASC, UUID ASC)");
 			}
 			return 0;
 		} catch(const Poco::Exception &E) {
@@ -200,6 +213,7 @@ namespace OpenWifi {
 						"UUID	        BIGINT, "
 						"INDEX LogSerial (SerialNumber ASC, Recorded ASC)"
 						")", Poco::Data::Keywords::now;
+				CreateMySQLIndex(Sess, "CREATE INDEX LogSerialPage ON DeviceLogs (SerialNumber ASC, Recorded ASC, UUID ASC)");
 			} else if(dbType_==pgsql || dbType_==sqlite) {
 				Sess << "CREATE TABLE IF NOT EXISTS DeviceLogs ("
 						"SerialNumber   VARCHAR(30), "
@@ -211,6 +225,7 @@ namespace OpenWifi {
 						"UUID	        BIGINT  "
 						")", Poco::Data::Keywords::now;
 				Sess << "CREATE INDEX IF NOT EXISTS LogSerial ON DeviceLogs (SerialNumber ASC, Recorded ASC)", Poco::Data::Keywords::now;
+				Sess << "CREATE INDEX IF NOT EXISTS LogSerialPage ON DeviceLogs (SerialNumber ASC, Recorded ASC, UUID ASC)", Poco::Data::Keywords::now;
 			}
 
 			return 0;
@@ -365,4 +380,74 @@ namespace OpenWifi {
 		return -1;
 	}
 
-}
\ No newline at end of file
+	int Storage::Create_Configurations() {
+		try {
+			Poco::Data::Session Sess = Pool_->get();
+
+			if(dbType_==mysql) {
+				Sess << "CREATE TABLE IF NOT EXISTS ConfigurationBlobs ("
+						"Hash			VARCHAR(64) PRIMARY KEY, "
+						"Configuration	TEXT, "
+						"Size			BIGINT, "
+						"Created		BIGINT"
+						") ", Poco::Data::Keywords::now;
+				Sess << "CREATE TABLE IF NOT EXISTS DeviceConfigurations ("
+						"SerialNumber	VARCHAR(30), "
+						"UUID			BIGINT, "
+						"Hash			VARCHAR(64), "
+						"Created		BIGINT, "
+						"INDEX DeviceConfigurationsIndex (SerialNumber ASC, UUID ASC)"
+						") ", Poco::Data::Keywords::now;
+			} else if(dbType_==pgsql || dbType_==sqlite) {
+				Sess << "CREATE TABLE IF NOT EXISTS ConfigurationBlobs ("
+						"Hash			VARCHAR(64) PRIMARY KEY, "
+						"Configuration	TEXT, "
+						"Size			BIGINT, "
+						"Created		BIGINT"
+						") ", Poco::Data::Keywords::now;
+				Sess << "CREATE TABLE IF NOT EXISTS DeviceConfigurations ("
+						"SerialNumber	VARCHAR(30), "
+						"UUID			BIGINT, "
+						"Hash			VARCHAR(64), "
+						"Created		BIGINT"
+						") ", Poco::Data::Keywords::now;
+				Sess << "CREATE INDEX IF NOT EXISTS DeviceConfigurationsIndex ON DeviceConfigurations (SerialNumber ASC, UUID ASC)",
+					Poco::Data::Keywords::now;
+			}
+			return 0;
+		} catch(const Poco::Exception &E) {
+			Logger().log(E);
+		}
+		return -1;
+	}
+
+	//	One row, counting the changes to the devices, their configuration UUIDs and the black list. Every gateway using
+	//	the database bumps it, connects do not.
+	int Storage::Create_CacheGeneration() {
+		try {
+			Poco::Data::Session Sess = Pool_->get();
+
+			if(dbType_==mysql || dbType_==pgsql || dbType_==sqlite) {
+				Sess << "CREATE TABLE IF NOT EXISTS CacheGeneration ("
+						"Id				INT PRIMARY KEY, "
+						"Generation		BIGINT"
+						")", Poco::Data::Keywords::now;
+
+				uint64_t Count = 0;
+				Sess << "SELECT COUNT(*) FROM CacheGeneration", Poco::Data::Keywords::into(Count), Poco::Data::Keywords::now;
+				if(Count==0) {
+					try {
+						Sess << "INSERT INTO CacheGeneration (Id, Generation) VALUES(0, 0)", Poco::Data::Keywords::now;
+					} catch (const Poco::Exception &) {
+						//	another gateway created it first
+					}
+				}
+			}
+			return 0;
+		} catch(const Poco::Exception &E) {
+			Logger().log(E);
+		}
+		return -1;
+	}
+
+}